@@ -0,0 +1,224 @@
+// Blip_Buffer micro-benchmark. Times the synthesis and reading loops and checks
+// that the vector versions match plain C++ versions of the same loops.
+//
+// Not part of the library. Built by CMake as blip_bench, or from this
+// directory with, for example:
+//   c++ -O2 -I../gme -o blip_bench Blip_Buffer_bench.cpp ../gme/Blip_Buffer.cpp
+//   ../gme/Multi_Buffer.cpp ../gme/blargg_common.cpp ../gme/blargg_errors.cpp
+// Add -msse4.1 (or -mavx) on x86 to also vectorize Blip_Synth. With "check" as
+// argument, only compares reading, which is what ctest runs.
+
+// Blip_Buffer $vers. http://www.slack.net/~ant/
+
+#include "Multi_Buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int const sample_rate = 44100;
+int const clock_rate  = 1789773;
+int const frame_clocks = clock_rate / 60;
+int const frames = 3000; // about 50 seconds of sound
+
+static double now()
+{
+	return (double) clock() / CLOCKS_PER_SEC;
+}
+
+static void report( const char* name, double secs, int samples )
+{
+	printf( "%-24s %8.3f ms  %8.1f Msamples/s\n", name, secs * 1000,
+			(secs > 0 ? samples / secs / 1e6 : 0.0) );
+}
+
+// Adds square waves with unrelated periods, like several APU oscillators
+template<class Synth>
+static void synth_frame( Synth& synth, Blip_Buffer& buf, int* phase, int voices )
+{
+	for ( int v = 0; v < voices; v++ )
+	{
+		int const period = 37 + v * 29;
+		int amp = (v & 1 ? 6 : -6);
+		for ( blip_time_t t = phase [v]; t < frame_clocks; t += period )
+		{
+			synth.offset( t, amp, &buf );
+			amp = -amp;
+		}
+		phase [v] = (phase [v] + frame_clocks) % period;
+	}
+}
+
+// Plain C++ version of Blip_Buffer::read_samples(), for comparison
+static int read_samples_ref( Blip_Buffer& buf, blip_sample_t out [], int max_samples, int step )
+{
+	int count = buf.samples_avail();
+	if ( count > max_samples )
+		count = max_samples;
+	int const bass = buf.highpass_shift();
+	Blip_Buffer::delta_t const* in = buf.read_pos();
+	int sum = buf.integrator();
+	for ( int i = 0; i < count; i++ )
+	{
+		int s = sum >> Blip_Buffer::delta_bits;
+		sum -= sum >> bass;
+		sum += in [i];
+		BLIP_CLAMP( s, s );
+		out [i * step] = (blip_sample_t) s;
+	}
+	buf.set_integrator( sum );
+	buf.remove_samples( count );
+	return count;
+}
+
+template<class Synth>
+static void bench_synth( const char* name, int voices )
+{
+	Blip_Buffer buf;
+	if ( buf.set_sample_rate( sample_rate, 1000 / 30 ) )
+		exit( EXIT_FAILURE );
+	buf.clock_rate( clock_rate );
+
+	Synth synth;
+	synth.volume( 0.5 );
+	synth.treble_eq( -8.0 );
+
+	int phase [16] = { 0 };
+	double start = now();
+	int samples = 0;
+	for ( int f = 0; f < frames; f++ )
+	{
+		synth_frame( synth, buf, phase, voices );
+		buf.end_frame( frame_clocks );
+		samples += buf.samples_avail();
+		buf.remove_samples( buf.samples_avail() );
+	}
+	report( name, now() - start, samples );
+}
+
+// Plays a few voices for a short time then reads the result, so that reading
+// dominates. Returns checksum of output. Stereo is read into the right channel,
+// and output ends at end of its allocation, so a memory checker catches vector
+// stores that go past it.
+static unsigned read_pass( const char* name, bool plain, int step )
+{
+	Blip_Buffer buf;
+	if ( buf.set_sample_rate( sample_rate, 1000 / 30 ) )
+		exit( EXIT_FAILURE );
+	buf.clock_rate( clock_rate );
+	buf.bass_freq( 16 );
+
+	Blip_Synth_Norm synth;
+	synth.volume( 3.0 ); // loud enough to clip
+
+	int const mem_size = 4096;
+	blip_sample_t* const mem = (blip_sample_t*) malloc( mem_size * sizeof *mem );
+	if ( !mem )
+		exit( EXIT_FAILURE );
+	memset( mem, 0x55, mem_size * sizeof *mem );
+	int phase [16] = { 0 };
+	unsigned sum = 0;
+	int samples = 0;
+	double start = now();
+	for ( int f = 0; f < frames * 4; f++ )
+	{
+		if ( f % 32 == 0 )
+			synth_frame( synth, buf, phase, 2 );
+		buf.end_frame( frame_clocks );
+
+		// last sample read is last of mem
+		int const avail = buf.samples_avail();
+		blip_sample_t* const out = mem + mem_size - ((avail - 1) * step + 1);
+
+		int n;
+		if ( plain )
+			n = read_samples_ref( buf, out, avail, step );
+		else
+			n = buf.read_samples( out, avail, step == 2 );
+		samples += n;
+
+		if ( f % 16 == 0 ) // checksum only some frames, to keep it out of timing
+			for ( int i = 0; i < n; i++ )
+				sum = sum * 31 + (unsigned short) out [i * step];
+	}
+	report( name, now() - start, samples );
+	free( mem );
+	return sum;
+}
+
+static int bench_read( int step )
+{
+	unsigned a = read_pass( (step == 1 ? "read_samples mono" : "read_samples stereo"), false, step );
+	unsigned b = read_pass( "  plain C++", true, step );
+	return a != b;
+}
+
+static void bench_stereo_buffer( bool stereo )
+{
+	Stereo_Buffer sb;
+	if ( sb.set_sample_rate( sample_rate, 1000 / 30 ) )
+		exit( EXIT_FAILURE );
+	sb.clock_rate( clock_rate );
+
+	Blip_Synth_Norm synth;
+	synth.volume( 0.5 );
+
+	static blip_sample_t out [8192];
+	int phase [3] [16] = { { 0 } };
+	int samples = 0;
+	double start = now();
+	for ( int f = 0; f < frames * 4; f++ )
+	{
+		if ( f % 32 == 0 )
+		{
+			synth_frame( synth, *sb.center(), phase [2], 2 );
+			if ( stereo )
+			{
+				synth_frame( synth, *sb.left (), phase [0], 1 );
+				synth_frame( synth, *sb.right(), phase [1], 1 );
+			}
+		}
+		sb.end_frame( frame_clocks );
+		samples += sb.read_samples( out, 8192 ) / 2;
+	}
+	report( (stereo ? "Stereo_Buffer stereo" : "Stereo_Buffer mono"), now() - start, samples );
+}
+
+int main( int argc, char* argv [] )
+{
+	bool const check = argc > 1 && !strcmp( argv [1], "check" );
+	
+	#if BLIP_SIMD_MUL
+		printf( "Blip_Synth: vector\n" );
+	#else
+		printf( "Blip_Synth: plain C++\n" );
+	#endif
+	#if BLIP_SSE2 || BLIP_NEON
+		printf( "Reading: vector\n\n" );
+	#else
+		printf( "Reading: plain C++\n\n" );
+	#endif
+
+	if ( !check )
+	{
+		bench_synth<Blip_Synth_Fast>( "Blip_Synth_Fast x8", 8 );
+		bench_synth<Blip_Synth_Norm>( "Blip_Synth_Norm x8", 8 );
+		bench_synth<Blip_Synth_Good>( "Blip_Synth_Good x8", 8 );
+	}
+
+	int errors = bench_read( 1 ) + bench_read( 2 );
+
+	if ( !check )
+	{
+		bench_stereo_buffer( false );
+		bench_stereo_buffer( true );
+	}
+
+	if ( errors )
+	{
+		printf( "\nVector output differed from plain C++ version\n" );
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
@@ -0,0 +1,495 @@
+// CPU core micro-benchmark. Times instructions per second of one CPU core and
+// checks that computed goto dispatch matches the switch statement.
+//
+// Not part of the library. Built by CMake as nes_bench, hes_bench, z80_bench and
+// gb_bench, or from this directory once for each CPU:
+//   c++ -O2 -I../gme -DBENCH_NES -o nes_bench Cpu_bench.cpp ../gme/Nes_Cpu.cpp ../gme/Spin_Detector.cpp
+//   c++ -O2 -I../gme -DBENCH_HES -o hes_bench Cpu_bench.cpp ../gme/Spin_Detector.cpp
+//   c++ -O2 -I../gme -DBENCH_Z80 -o z80_bench Cpu_bench.cpp ../gme/Z80_Cpu.cpp ../gme/Spin_Detector.cpp
+//   c++ -O2 -I../gme -DBENCH_GB  -o gb_bench  Cpu_bench.cpp ../gme/Gb_Cpu.cpp  ../gme/Spin_Detector.cpp
+// Build again with -DGME_DISABLE_COMPUTED_GOTO for the switch version. Both
+// builds must print the same state hash. With "check" as argument, skips timing
+// and prints only the hash, which ctest compares between the two builds.
+//
+// Each CPU runs a generated program of common instructions (loads, stores,
+// arithmetic, read-modify-write, stack, short branches and subroutine calls)
+// that loops forever over RAM.
+
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "blargg_common.h"
+#include "blargg_endian.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "blargg_source.h"
+
+typedef unsigned char byte;
+
+static int const code_addr = 0x4000;
+static int const seconds   = 3;
+
+static byte mem [0x10000 + 0x100];
+
+static unsigned rand_state = 1;
+
+static int next_rand( int range )
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return (rand_state >> 8) % range;
+}
+
+// Generated program
+static byte* out;
+
+static void emit( int n )                   { *out++ = (byte) n; }
+static void emit16( int n )                 { emit( n & 0xFF ); emit( n >> 8 ); }
+static int  out_addr()                      { return (int) (out - mem); }
+
+#if defined (BENCH_NES) || defined (BENCH_HES)
+
+#ifdef BENCH_NES
+	#include "Nes_Cpu.h"
+	typedef Nes_Cpu Bench_Cpu;
+	static char const cpu_name [] = "6502";
+#else
+	#include "Hes_Cpu.h"
+	typedef Hes_Cpu Bench_Cpu;
+	static char const cpu_name [] = "HuC6280";
+#endif
+
+// RAM used by program. Pointers for (zp),Y are in $F0-$FF, which are never
+// written.
+static int const zp_ptrs  = 0xF0;
+static int const data_mem = 0x0200;
+
+// Emits one instruction that's harmless anywhere in the program
+static void emit_instr()
+{
+	static byte const implied [] = {
+		0xAA, 0x8A, 0xA8, 0x98, 0xE8, 0xC8, 0xCA, 0x88,
+		0x18, 0x38, 0x0A, 0x4A, 0x2A, 0x6A, 0xEA, 0xB8
+	};
+	static byte const imm [] = { 0xA9, 0xA2, 0xA0, 0x69, 0xE9, 0x29, 0x09, 0x49, 0xC9, 0xE0, 0xC0 };
+	static byte const zp  [] = { 0xA5, 0x85, 0xE6, 0xC6, 0x65, 0x06, 0x26, 0xA6, 0x86, 0xA4, 0x84, 0x45, 0xC5, 0x24 };
+	static byte const zpx [] = { 0xB5, 0x75, 0x55, 0x35 }; // reads only, since X is arbitrary
+	static byte const abs [] = { 0xAD, 0x8D, 0xEE, 0x6D, 0xCD, 0x2D, 0xAE, 0x8E };
+	static byte const abx [] = { 0xBD, 0x9D, 0xB9, 0x99, 0x7D, 0xFE };
+	static byte const iny [] = { 0xB1, 0x91, 0x71, 0xD1 };
+	static byte const br  [] = { 0x10, 0x30, 0x50, 0x70, 0x90, 0xB0, 0xD0, 0xF0 };
+	
+	int kind = next_rand( 20 );
+	if ( kind < 4 )
+	{
+		emit( implied [next_rand( sizeof implied )] );
+	}
+	else if ( kind < 8 )
+	{
+		emit( imm [next_rand( sizeof imm )] );
+		emit( next_rand( 0x100 ) );
+	}
+	else if ( kind < 11 )
+	{
+		emit( zp [next_rand( sizeof zp )] );
+		emit( next_rand( 0xE0 ) );
+	}
+	else if ( kind < 12 )
+	{
+		emit( zpx [next_rand( sizeof zpx )] );
+		emit( next_rand( 0x100 ) );
+	}
+	else if ( kind < 14 )
+	{
+		emit( abs [next_rand( sizeof abs )] );
+		emit16( data_mem + next_rand( 0x400 ) );
+	}
+	else if ( kind < 16 )
+	{
+		emit( abx [next_rand( sizeof abx )] );
+		emit16( data_mem + next_rand( 0x400 ) );
+	}
+	else if ( kind < 17 )
+	{
+		emit( iny [next_rand( sizeof iny )] );
+		emit( zp_ptrs + next_rand( 8 ) * 2 );
+	}
+	else if ( kind < 18 )
+	{
+		// PHA/PLA pair
+		emit( 0x48 );
+		emit( 0x68 );
+	}
+	else
+	{
+		// Branch over a two-byte instruction
+		emit( br [next_rand( sizeof br )] );
+		emit( 2 );
+		emit( 0xA9 );
+		emit( next_rand( 0x100 ) );
+	}
+}
+
+static void generate()
+{
+	for ( int i = 0; i < 8; i++ )
+		set_le16( &mem [zp_ptrs + i * 2], data_mem + 0x400 + i * 0x100 );
+	
+	// Subroutines, each called from main loop
+	int const sub_count = 16;
+	int subs [sub_count];
+	out = mem + code_addr + 0x2000;
+	for ( int s = 0; s < sub_count; s++ )
+	{
+		subs [s] = out_addr();
+		for ( int n = 0; n < 16; n++ )
+			emit_instr();
+		emit( 0x60 ); // RTS
+	}
+	
+	// Main loop
+	out = mem + code_addr;
+	while ( out_addr() < code_addr + 0x1F00 )
+	{
+		if ( next_rand( 32 ) == 0 )
+		{
+			emit( 0x20 ); // JSR
+			emit16( subs [next_rand( sub_count )] );
+		}
+		else
+		{
+			emit_instr();
+		}
+	}
+	emit( 0x4C ); // JMP
+	emit16( code_addr );
+}
+
+#define READ_LOW(  addr       ) (mem [addr])
+#define WRITE_LOW( addr, data ) (mem [addr] = data)
+#define READ_MEM(  addr       ) (mem [addr])
+#define WRITE_MEM( addr, data ) (mem [addr] = data)
+
+#ifdef BENCH_HES
+	#define READ_FAST(  addr, out  ) (out = mem [addr])
+	#define WRITE_FAST( addr, data ) (mem [addr] = data)
+	#define WRITE_VDP(  addr, data ) ((void) 0)
+	#define SET_MMR(    reg, bank  ) ((void) 0)
+#endif
+
+#define CPU cpu
+
+#define CPU_BEGIN \
+static void run_cpu( Bench_Cpu& cpu, int end )\
+{\
+	cpu.set_end_time( end );
+
+	#ifdef BENCH_NES
+		#include "Nes_Cpu_run.h"
+	#else
+		#include "Hes_Cpu_run.h"
+	#endif
+}
+
+static void reset_cpu( Bench_Cpu& cpu )
+{
+	#ifdef BENCH_NES
+		cpu.reset( mem );
+		cpu.map_code( 0, 0x10000, mem );
+	#else
+		cpu.reset();
+		for ( int i = 0; i < 8; i++ )
+			cpu.set_mmr( i, i, mem + i * cpu.page_size );
+	#endif
+	cpu.r.pc = code_addr;
+	cpu.r.sp = 0xFF;
+	cpu.r.flags = 0x04;
+}
+
+// Runs for at least clocks and returns number actually run
+static int run_for( Bench_Cpu& cpu, int clocks )
+{
+	cpu.set_time( 0 );
+	run_cpu( cpu, clocks );
+	return cpu.time();
+}
+
+static unsigned state_hash( Bench_Cpu const& cpu )
+{
+	unsigned h = 2166136261u;
+	byte const regs [] = { (byte) (cpu.r.pc >> 8), (byte) cpu.r.pc,
+			cpu.r.a, cpu.r.x, cpu.r.y, cpu.r.flags, cpu.r.sp };
+	for ( unsigned i = 0; i < sizeof regs; i++ )
+		h = (h ^ regs [i]) * 16777619u;
+	for ( int i = 0; i < 0x1000; i++ )
+		h = (h ^ mem [i]) * 16777619u;
+	return h;
+}
+
+#endif
+
+#if defined (BENCH_Z80) || defined (BENCH_GB)
+
+#ifdef BENCH_Z80
+	#include "Z80_Cpu.h"
+	typedef Z80_Cpu Bench_Cpu;
+	static char const cpu_name [] = "Z80";
+#else
+	#include "Gb_Cpu.h"
+	typedef Gb_Cpu Bench_Cpu;
+	static char const cpu_name [] = "LR35902";
+#endif
+
+// RAM used by program. HL and IX always point into it, so only A, B, C, D and
+// E are changed.
+static int const data_mem = 0x8000;
+static int const hl_addr  = data_mem + 0x400;
+static int const ix_addr  = data_mem + 0x800;
+
+// Emits one instruction that's harmless anywhere in the program
+static void emit_instr()
+{
+	static byte const implied [] = {
+		0x78, 0x79, 0x7A, 0x7B, 0x47, 0x4F, 0x57, 0x5F, 0x41, 0x48, 0x50, 0x59, // LD r,r
+		0x80, 0x81, 0x82, 0x83, 0x87, 0x88, 0x90, 0x91, 0x98, 0xA0, 0xA1, 0xA8, // ALU A,r
+		0xB0, 0xB1, 0xB8, 0xB9,
+		0x04, 0x0C, 0x14, 0x1C, 0x3C, 0x05, 0x0D, 0x15, 0x1D, 0x3D, // INC DEC r
+		0x03, 0x13, 0x0B, 0x1B, // INC DEC BC DE
+		0x07, 0x0F, 0x17, 0x1F, 0x2F, 0x37, 0x3F, 0x00  // RLCA RRCA RLA RRA CPL SCF CCF NOP
+	};
+	static byte const hl  [] = { 0x7E, 0x46, 0x4E, 0x86, 0xBE, 0xA6, 0x77, 0x70, 0x71, 0x34, 0x35 };
+	static byte const imm [] = {
+		0x06, 0x0E, 0x16, 0x1E, 0x3E, // LD r,n
+		0xC6, 0xCE, 0xD6, 0xDE, 0xE6, 0xEE, 0xF6, 0xFE, // ALU A,n
+		0x36 // LD (HL),n
+	};
+	static byte const br  [] = { 0x20, 0x28, 0x30, 0x38 }; // JR NZ Z NC C
+	
+	int kind = next_rand( 20 );
+	if ( kind < 6 )
+	{
+		emit( implied [next_rand( sizeof implied )] );
+	}
+	else if ( kind < 8 )
+	{
+		emit( hl [next_rand( sizeof hl )] );
+	}
+	else if ( kind < 11 )
+	{
+		emit( imm [next_rand( sizeof imm )] );
+		emit( next_rand( 0x100 ) );
+	}
+	else if ( kind < 12 )
+	{
+		#ifdef BENCH_Z80
+			emit( next_rand( 2 ) ? 0x3A : 0x32 ); // LD A,(nn) LD (nn),A
+		#else
+			emit( next_rand( 2 ) ? 0xFA : 0xEA );
+		#endif
+		emit16( data_mem + next_rand( 0x400 ) );
+	}
+	else if ( kind < 14 )
+	{
+		// Shift, rotate or bit operation on any register but H and L
+		int op = next_rand( 0x100 );
+		if ( (op & 6) == 4 )
+			op |= 3;
+		emit( 0xCB );
+		emit( op );
+	}
+	else if ( kind < 15 )
+	{
+		#ifdef BENCH_Z80
+			static byte const ix [] = { 0x7E, 0x46, 0x4E, 0x86, 0xBE, 0x77, 0x70, 0x71, 0x34 };
+			emit( 0xDD ); // (IX+d)
+			emit( ix [next_rand( sizeof ix )] );
+			emit( next_rand( 0x100 ) );
+		#else
+			emit( next_rand( 2 ) ? 0xF0 : 0xE0 ); // LDH A,(n) LDH (n),A
+			emit( 0x80 + next_rand( 0x7F ) );
+		#endif
+	}
+	else if ( kind < 16 )
+	{
+		// PUSH/POP pair
+		emit( next_rand( 2 ) ? 0xC5 : 0xD5 );
+		emit( next_rand( 2 ) ? 0xC1 : 0xD1 );
+	}
+	else
+	{
+		// Branch over a two-byte instruction
+		#ifdef BENCH_Z80
+			if ( kind == 16 )
+				emit( 0x10 ); // DJNZ
+			else
+		#endif
+				emit( br [next_rand( sizeof br )] );
+		emit( 2 );
+		emit( 0x3E );
+		emit( next_rand( 0x100 ) );
+	}
+}
+
+static void generate()
+{
+	// Subroutines, each called from main loop
+	int const sub_count = 16;
+	int subs [sub_count];
+	out = mem + code_addr + 0x2000;
+	for ( int s = 0; s < sub_count; s++ )
+	{
+		subs [s] = out_addr();
+		for ( int n = 0; n < 16; n++ )
+			emit_instr();
+		emit( 0xC9 ); // RET
+	}
+	
+	// Main loop
+	out = mem + code_addr;
+	while ( out_addr() < code_addr + 0x1F00 )
+	{
+		if ( next_rand( 32 ) == 0 )
+		{
+			emit( 0xCD ); // CALL
+			emit16( subs [next_rand( sub_count )] );
+		}
+		else
+		{
+			emit_instr();
+		}
+	}
+	emit( 0xC3 ); // JP
+	emit16( code_addr );
+}
+
+#ifdef BENCH_Z80
+	#define OUT_PORT( addr, data ) ((void) 0)
+	#define IN_PORT(  addr       ) 0xFF
+#else
+	#define READ_MEM(  addr       ) (mem [addr])
+	#define WRITE_MEM( addr, data ) (mem [addr] = data)
+	#define READ_IO(   addr, out  ) (out = mem [0xFF00 + (addr)])
+	#define WRITE_IO(  addr, data ) (mem [0xFF00 + (addr)] = data)
+	#define READ_FAST( addr, out  ) (out = mem [addr])
+#endif
+
+#define CPU cpu
+
+#ifdef BENCH_Z80
+
+#define CPU_BEGIN \
+static void run_cpu( Bench_Cpu& cpu, int end )\
+{\
+	cpu.set_end_time( end );
+
+	#include "Z80_Cpu_run.h"
+}
+
+#else
+
+// Runs until time reaches 0
+#define CPU_BEGIN \
+static void run_cpu( Bench_Cpu& cpu )\
+{
+
+	#include "Gb_Cpu_run.h"
+}
+
+#endif
+
+static void reset_cpu( Bench_Cpu& cpu )
+{
+	#ifdef BENCH_Z80
+		cpu.reset( mem, mem );
+		cpu.map_mem( 0, 0x10000, mem, mem );
+		cpu.r.ix = ix_addr;
+		cpu.r.iy = ix_addr;
+		cpu.r.w.hl = hl_addr;
+	#else
+		cpu.reset( mem );
+		cpu.map_code( 0, 0x10000, mem );
+		cpu.r.hl = hl_addr;
+	#endif
+	cpu.r.pc = code_addr;
+	cpu.r.sp = 0xF000;
+}
+
+// Runs for at least clocks and returns number actually run
+static int run_for( Bench_Cpu& cpu, int clocks )
+{
+	#ifdef BENCH_Z80
+		cpu.set_time( 0 );
+		run_cpu( cpu, clocks );
+		return cpu.time();
+	#else
+		cpu.set_time( -clocks );
+		run_cpu( cpu );
+		return cpu.time() + clocks;
+	#endif
+}
+
+static unsigned state_hash( Bench_Cpu const& cpu )
+{
+	#ifdef BENCH_Z80
+		Z80_Cpu::pairs_t const& rp = cpu.r.w;
+	#else
+		Gb_Cpu::core_regs_t const& rp = cpu.r;
+	#endif
+	unsigned h = 2166136261u;
+	int const regs [] = { cpu.r.pc, cpu.r.sp, rp.bc, rp.de, rp.hl, rp.fa };
+	for ( unsigned i = 0; i < sizeof regs / sizeof *regs; i++ )
+		h = (h ^ regs [i]) * 16777619u;
+	for ( int i = data_mem; i < data_mem + 0x1000; i++ )
+		h = (h ^ mem [i]) * 16777619u;
+	return h;
+}
+
+#endif
+
+int main( int argc, char* argv [] )
+{
+	bool const check = argc > 1 && !strcmp( argv [1], "check" );
+	
+	generate();
+	static byte initial_mem [sizeof mem];
+	memcpy( initial_mem, mem, sizeof mem );
+	
+	static Bench_Cpu cpu;
+	int const chunk = 0x100000;
+	if ( !check )
+	{
+		reset_cpu( cpu );
+		
+		// Count instructions by running one at a time
+		long const counted = 1000000;
+		double clocks = 0;
+		for ( long n = counted; n--; )
+			clocks += run_for( cpu, 1 );
+		double clocks_per_instr = clocks / counted;
+		
+		// Time long runs
+		memcpy( mem, initial_mem, sizeof mem );
+		reset_cpu( cpu );
+		clocks = 0;
+		clock_t start = clock();
+		do
+		{
+			clocks += run_for( cpu, chunk );
+		}
+		while ( clock() - start < seconds * CLOCKS_PER_SEC );
+		double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+		
+		printf( "%s: %.1f M instructions/s (%.2f clocks each)\n", cpu_name,
+				clocks / clocks_per_instr / elapsed / 1e6, clocks_per_instr );
+	}
+	
+	// Fixed-length run for comparing dispatch methods
+	memcpy( mem, initial_mem, sizeof mem );
+	reset_cpu( cpu );
+	for ( int n = 100; n--; )
+		run_for( cpu, chunk );
+	printf( "state hash %08X\n", state_hash( cpu ) );
+	
+	return 0;
+}
@@ -0,0 +1,106 @@
+// Fir_Resampler micro-benchmark. Times resampling at several widths and ratios
+// and prints a checksum of the output, which should be the same whether built
+// with vector or plain C++ versions of the FIR loop.
+//
+// Not part of the library. Built by CMake as fir_bench and fir_bench_ref, or
+// from this directory with, for example:
+//   c++ -O2 -I../gme -o fir_bench Fir_Resampler_bench.cpp ../gme/Fir_Resampler.cpp
+//   ../gme/Resampler.cpp ../gme/blargg_common.cpp ../gme/blargg_errors.cpp
+// then again with -DFIR_RESAMPLER_NO_SIMD and compare checksums. With "check" as
+// argument, prints only checksums, which ctest compares between the two builds.
+
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Fir_Resampler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef Resampler::sample_t sample_t;
+
+int const out_size = 4096;
+int const passes   = 2000;
+
+static bool check; // fewer passes and no timing
+
+static double now()
+{
+	return (double) clock() / CLOCKS_PER_SEC;
+}
+
+// Fills n stereo pairs with a square wave and a sawtooth, loud enough that
+// sums wrap around
+static void fill( sample_t out [], int n, int* phase )
+{
+	for ( int i = 0; i < n; i++ )
+	{
+		int p = *phase + i;
+		out [i * 2    ] = (sample_t) ((p / 37 & 1) ? 32767 : -32768);
+		out [i * 2 + 1] = (sample_t) ((p * 1031) & 0xFFFF);
+	}
+	*phase += n;
+}
+
+// Returns checksum of output
+static unsigned bench( int width, double in_rate, double out_rate )
+{
+	Fir_Resampler_Norm r;
+	if ( r.set_width( width ) || r.set_rate( in_rate / out_rate ) ||
+			r.resize_buffer( out_size * 4 ) )
+		exit( EXIT_FAILURE );
+	
+	static sample_t out [out_size];
+	unsigned sum = 0;
+	int samples = 0;
+	int phase = 0;
+	double time = 0;
+	for ( int n = (check ? passes / 10 : passes); n--; )
+	{
+		int count = r.buffer_free() >> 1;
+		fill( r.buffer(), count, &phase );
+		r.write( count * 2 );
+		
+		double start = now();
+		int got = r.read( out, out_size );
+		time += now() - start;
+		
+		samples += got >> 1;
+		for ( int i = 0; i < got; i++ )
+			sum = sum * 31 + (unsigned short) out [i];
+	}
+	
+	if ( check )
+		printf( "%2d points %6.0f to %6.0f Hz  %08X\n", width, in_rate, out_rate, sum );
+	else
+		printf( "%2d points %6.0f to %6.0f Hz %8.1f Msamples/s  %08X\n", width,
+				in_rate, out_rate, (time > 0 ? samples / time / 1e6 : 0.0), sum );
+	return sum;
+}
+
+int main( int argc, char* argv [] )
+{
+	check = argc > 1 && !strcmp( argv [1], "check" );
+	
+	if ( !check )
+	{
+		#if FIR_RESAMPLER_NO_SIMD
+			printf( "FIR: plain C++\n\n" );
+		#else
+			printf( "FIR: vector if supported\n\n" );
+		#endif
+	}
+	
+	static int const widths [] = { 8, 16, 24, 32 };
+	unsigned sum = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		sum = sum * 31 + bench( widths [i], 44100, 44100 );
+		sum = sum * 31 + bench( widths [i], 44100, 48000 );
+		sum = sum * 31 + bench( widths [i], 53267, 44100 );
+		sum = sum * 31 + bench( widths [i], 32000, 44100 );
+	}
+	printf( "\nChecksum %08X\n", sum );
+	return 0;
+}
@@ -0,0 +1,127 @@
+// Seek checkpoint benchmark. Times seeks to several points in an NSF track
+// with and without seek checkpoints, and compares the sound played after each
+// checkpoint seek with that after a plain seek to the same point, which must
+// be the same.
+//
+// Usage: seek_bench [check] [file [track]]
+// With "check", only compares, and exits with failure if any seek differs.
+// Default file is test.nsf in the source tree. Built by CMake from the NSF
+// emulator's sources directly, like the kernel benchmarks.
+
+#include "Nsf_Emu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#ifndef GME_BENCH_CORPUS
+	#define GME_BENCH_CORPUS "."
+#endif
+
+int const sample_rate = 44100;
+int const play_msec   = 1000; // length played and compared after each seek
+int const chunk       = 1024;
+
+// Backwards and forwards, to points that are and aren't near checkpoints
+static int const seek_msec [] = { 20000, 2300, 12000, 7777, 15010, 3100, 21500, 500 };
+int const seek_count = sizeof seek_msec / sizeof seek_msec [0];
+
+static void check_err( blargg_err_t err )
+{
+	if ( err )
+	{
+		fprintf( stderr, "Error: %s\n", err );
+		exit( EXIT_FAILURE );
+	}
+}
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration<double>( steady_clock::now().time_since_epoch() ).count();
+}
+
+static void open_track( Nsf_Emu& emu, const char* path, int track, bool checkpoints )
+{
+	check_err( emu.set_sample_rate( sample_rate ) );
+	check_err( emu.load_file( path ) );
+	emu.ignore_silence();
+	if ( checkpoints )
+		emu.set_seek_checkpoints( 1000, 16 * 1024 * 1024 );
+	check_err( emu.start_track( track ) );
+}
+
+static void play( Nsf_Emu& emu, std::vector<short>& out )
+{
+	for ( size_t pos = 0; pos < out.size(); pos += chunk )
+	{
+		int n = (int) (out.size() - pos < (size_t) chunk ? out.size() - pos : chunk);
+		check_err( emu.play( n, &out [pos] ) );
+	}
+}
+
+// Seeks plain from start of track, as done without checkpoints
+static void seek_plain( Nsf_Emu& emu, int track, int msec )
+{
+	check_err( emu.start_track( track ) );
+	check_err( emu.seek( msec ) );
+}
+
+int main( int argc, char* argv [] )
+{
+	bool check = argc > 1 && !strcmp( argv [1], "check" );
+	if ( check )
+	{
+		argc--;
+		argv++;
+	}
+	const char* path = (argc > 1 ? argv [1] : GME_BENCH_CORPUS "/test.nsf");
+	int track = (argc > 2 ? atoi( argv [2] ) : 0);
+
+	Nsf_Emu cp, plain;
+	open_track( cp,    path, track, true );
+	open_track( plain, path, track, false );
+
+	std::vector<short> cp_out  ( sample_rate * play_msec / 1000 * 2 );
+	std::vector<short> plain_out( cp_out.size() );
+
+	int failed = 0;
+	double cp_time = 0, plain_time = 0;
+	for ( int i = 0; i < seek_count; i++ )
+	{
+		int msec = seek_msec [i];
+
+		double start = now();
+		check_err( cp.seek( msec ) );
+		cp_time += now() - start;
+
+		start = now();
+		seek_plain( plain, track, msec );
+		plain_time += now() - start;
+
+		play( cp, cp_out );
+		play( plain, plain_out );
+
+		int diffs = 0;
+		for ( size_t n = 0; n < cp_out.size(); n++ )
+			diffs += (cp_out [n] != plain_out [n]);
+		if ( diffs )
+		{
+			printf( "Seek to %d ms: %d of %d samples differ\n", msec, diffs, (int) cp_out.size() );
+			failed++;
+		}
+	}
+
+	if ( !check )
+		printf( "%d seeks: %.1f ms with checkpoints, %.1f ms without\n", seek_count,
+				cp_time * 1000, plain_time * 1000 );
+
+	if ( failed )
+		return EXIT_FAILURE;
+
+	if ( check )
+		printf( "%d checkpoint seeks match plain seeks\n", seek_count );
+	return 0;
+}
@@ -0,0 +1,19 @@
+# Runs FIRST and SECOND with "check" and fails unless both succeed and print
+# the same output. Used by ctest to compare vector and plain C builds of a
+# kernel benchmark.
+execute_process(COMMAND ${FIRST} check
+    RESULT_VARIABLE first_result OUTPUT_VARIABLE first_output)
+execute_process(COMMAND ${SECOND} check
+    RESULT_VARIABLE second_result OUTPUT_VARIABLE second_output)
+
+if(NOT first_result EQUAL 0)
+    message(FATAL_ERROR "${FIRST} failed:\n${first_output}")
+endif()
+if(NOT second_result EQUAL 0)
+    message(FATAL_ERROR "${SECOND} failed:\n${second_output}")
+endif()
+if(NOT first_output STREQUAL second_output)
+    message(FATAL_ERROR "Output differs\n${FIRST}:\n${first_output}\n${SECOND}:\n${second_output}")
+endif()
+
+message("${first_output}")
@@ -0,0 +1,518 @@
+// Throughput benchmark for game music emulators. Renders each file of a corpus
+// for a fixed length, several times, and reports samples per second and
+// real-time factor, optionally as JSON for tracking between versions.
+//
+// Usage: gme_bench [options] [file or directory ...]
+//  -s secs    seconds of audio to render per run (default 30)
+//  -r count   timed runs per file (default 5), after one untimed warm-up run
+//  -t track   track to play (default 0)
+//  -R rate    sample rate (default 44100)
+//  -c cpu     pin benchmark thread to CPU number
+//  -j path    write JSON results to path ("-" for standard output)
+//  -a         use all files given, rather than one per emulator type
+//
+// By default the corpus is one file per emulator type in gme_type_list(), the
+// first found in sorted order. VGM files are kept one per set of chips used.
+// Each VGM file is also played once with chip profiling on, and the time spent
+// in each chip is summarized per chip, so files using several chips give
+// figures for each rather than crediting the whole file to all of them.
+
+#include "gme/gme.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <io.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+	#include <sched.h>
+#endif
+
+#ifdef HAVE_ZLIB_H
+	#include <zlib.h>
+#endif
+
+#ifndef GME_BENCH_CORPUS
+	#define GME_BENCH_CORPUS "."
+#endif
+
+#ifndef GME_BENCH_VERSION
+	#define GME_BENCH_VERSION ""
+#endif
+
+using std::string;
+using std::vector;
+
+struct options_t
+{
+	double secs;
+	int repeats;
+	int track;
+	int rate;
+	int cpu;
+	const char* json;
+	bool all_files;
+};
+
+struct chip_time_t
+{
+	string name;
+	double secs;            // per run, summed over chips of this type
+};
+
+struct result_t
+{
+	string path;
+	string system;
+	string chips;           // VGM only, space-separated
+	double load_ms;
+	long samples;           // per run, stereo pairs
+	vector<double> runs;    // samples per second of each run
+	bool ended;             // track ended before full length was rendered
+	double mean, stddev, min, max;
+	vector<chip_time_t> chip_times; // VGM only
+};
+
+static void handle_error( const char* str )
+{
+	if ( str )
+	{
+		fprintf( stderr, "Error: %s\n", str );
+		exit( EXIT_FAILURE );
+	}
+}
+
+static double now()
+{
+	using namespace std::chrono;
+	return duration<double>( steady_clock::now().time_since_epoch() ).count();
+}
+
+static bool pin_to_cpu( int cpu )
+{
+	#if defined (__linux__)
+		cpu_set_t set;
+		CPU_ZERO( &set );
+		CPU_SET( cpu, &set );
+		return sched_setaffinity( 0, sizeof set, &set ) == 0;
+	#elif defined (_WIN32)
+		return SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR) 1 << cpu ) != 0;
+	#else
+		(void) cpu;
+		return false;
+	#endif
+}
+
+// Corpus
+
+static bool is_dir( const char path [] )
+{
+	#ifdef _WIN32
+		DWORD attr = GetFileAttributesA( path );
+		return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+	#else
+		struct stat st;
+		return stat( path, &st ) == 0 && S_ISDIR( st.st_mode );
+	#endif
+}
+
+static void list_dir( string const& dir, vector<string>& out )
+{
+	vector<string> names;
+	#ifdef _WIN32
+		struct _finddata_t fd;
+		intptr_t h = _findfirst( (dir + "/*").c_str(), &fd );
+		if ( h != -1 )
+		{
+			do
+				if ( !(fd.attrib & _A_SUBDIR) )
+					names.push_back( fd.name );
+			while ( _findnext( h, &fd ) == 0 );
+			_findclose( h );
+		}
+	#else
+		if ( DIR* d = opendir( dir.c_str() ) )
+		{
+			while ( struct dirent* e = readdir( d ) )
+				if ( e->d_name [0] != '.' )
+					names.push_back( e->d_name );
+			closedir( d );
+		}
+	#endif
+	std::sort( names.begin(), names.end() );
+	for ( size_t i = 0; i < names.size(); i++ )
+		out.push_back( dir + "/" + names [i] );
+}
+
+// Reads start of file, decompressing if it's gzipped
+static int read_header( const char path [], unsigned char* out, int size )
+{
+	#ifdef HAVE_ZLIB_H
+		gzFile in = gzopen( path, "rb" );
+		if ( !in )
+			return 0;
+		int n = gzread( in, out, size );
+		gzclose( in );
+		return n < 0 ? 0 : n;
+	#else
+		FILE* in = fopen( path, "rb" );
+		if ( !in )
+			return 0;
+		int n = (int) fread( out, 1, size, in );
+		fclose( in );
+		return n;
+	#endif
+}
+
+static unsigned get_le32( unsigned char const* p )
+{
+	return p [0] | p [1] << 8 | p [2] << 16 | (unsigned) p [3] << 24;
+}
+
+// Names of chips with a non-zero clock in VGM header, or "" if not a VGM file
+static string vgm_chips( const char path [] )
+{
+	static struct { int offset; const char* name; } const clocks [] = {
+		{0x0C,"SN76489"}, {0x10,"YM2413"},  {0x2C,"YM2612"},  {0x30,"YM2151"},
+		{0x38,"SegaPCM"}, {0x40,"RF5C68"},  {0x44,"YM2203"},  {0x48,"YM2608"},
+		{0x4C,"YM2610"},  {0x50,"YM3812"},  {0x54,"YM3526"},  {0x58,"Y8950"},
+		{0x5C,"YMF262"},  {0x60,"YMF278B"}, {0x64,"YMF271"},  {0x68,"YMZ280B"},
+		{0x6C,"RF5C164"}, {0x70,"PWM"},     {0x74,"AY8910"},  {0x80,"GB DMG"},
+		{0x84,"NES APU"}, {0x88,"MultiPCM"},{0x8C,"uPD7759"}, {0x90,"OKIM6258"},
+		{0x98,"OKIM6295"},{0x9C,"K051649"}, {0xA0,"K054539"}, {0xA4,"HuC6280"},
+		{0xA8,"C140"},    {0xAC,"K053260"}, {0xB0,"Pokey"},   {0xB4,"QSound"}
+	};
+
+	unsigned char h [0xC0];
+	int size = read_header( path, h, sizeof h );
+	if ( size < 0x40 || memcmp( h, "Vgm ", 4 ) )
+		return "";
+
+	// Fields past start of data aren't part of header
+	unsigned version = get_le32( h + 0x08 );
+	if ( version >= 0x150 && get_le32( h + 0x34 ) )
+		size = std::min( size, (int) (0x34 + get_le32( h + 0x34 )) );
+	else
+		size = 0x40;
+
+	string chips;
+	for ( unsigned i = 0; i < sizeof clocks / sizeof *clocks; i++ )
+	{
+		int offset = clocks [i].offset;
+		// Before 1.10, YM2612 and YM2151 used YM2413 clock
+		if ( version < 0x110 && (offset == 0x2C || offset == 0x30) )
+			offset = 0x10;
+		if ( offset + 4 <= size && (get_le32( h + offset ) & 0x3FFFFFFF) )
+		{
+			if ( !chips.empty() )
+				chips += ' ';
+			chips += clocks [i].name;
+		}
+	}
+	return chips;
+}
+
+// Picks one file per emulator type, and one per chip set for VGM
+static void select_corpus( vector<string> const& in, bool all, vector<result_t>& out )
+{
+	vector<std::pair<gme_type_t, string> > seen;
+	for ( size_t i = 0; i < in.size(); i++ )
+	{
+		gme_type_t type = 0;
+		gme_identify_file( in [i].c_str(), &type );
+		if ( !type )
+			continue;
+
+		result_t r = result_t();
+		r.path   = in [i];
+		r.system = gme_type_system( type );
+		r.chips  = vgm_chips( in [i].c_str() );
+
+		std::pair<gme_type_t, string> key( type, r.chips );
+		if ( !all && std::find( seen.begin(), seen.end(), key ) != seen.end() )
+			continue;
+		seen.push_back( key );
+		out.push_back( r );
+	}
+}
+
+// Benchmark
+
+static void run_file( result_t& r, options_t const& opt )
+{
+	gme_t* emu;
+	double start = now();
+	handle_error( gme_open_file( r.path.c_str(), &emu, opt.rate ) );
+	r.load_ms = (now() - start) * 1000;
+
+	// Play the full length regardless of silence, so every run does equal work
+	gme_ignore_silence( emu, 1 );
+
+	r.samples = (long) (opt.secs * opt.rate);
+	int const buf_size = 4096;
+	static short buf [buf_size];
+
+	for ( int run = -1; run < opt.repeats; run++ )
+	{
+		handle_error( gme_start_track( emu, opt.track ) );
+		start = now();
+		for ( long n = r.samples * 2; n > 0; n -= buf_size )
+			handle_error( gme_play( emu, (int) std::min( n, (long) buf_size ), buf ) );
+		double elapsed = now() - start;
+		r.ended = r.ended || gme_track_ended( emu );
+		if ( run >= 0 ) // first run only warms caches
+			r.runs.push_back( elapsed > 0 ? r.samples / elapsed : 0 );
+	}
+
+	// One more run with chip profiling, so it doesn't slow the timed runs.
+	// Only VGM files give a profile.
+	if ( !gme_enable_profile( emu, 1 ) )
+	{
+		handle_error( gme_start_track( emu, opt.track ) );
+		for ( long n = r.samples * 2; n > 0; n -= buf_size )
+			handle_error( gme_play( emu, (int) std::min( n, (long) buf_size ), buf ) );
+
+		int const max_chips = 64;
+		gme_chip_profile_t prof [max_chips];
+		int count = std::min( gme_get_profile( emu, prof, max_chips ), max_chips );
+		for ( int i = 0; i < count; i++ )
+		{
+			size_t j = 0;
+			while ( j < r.chip_times.size() && r.chip_times [j].name != prof [i].name )
+				j++;
+			if ( j == r.chip_times.size() )
+			{
+				chip_time_t t = { prof [i].name, 0 };
+				r.chip_times.push_back( t );
+			}
+			r.chip_times [j].secs += prof [i].nanoseconds * 1e-9;
+		}
+	}
+	gme_delete( emu );
+
+	double sum = 0;
+	r.min = r.max = r.runs [0];
+	for ( size_t i = 0; i < r.runs.size(); i++ )
+	{
+		sum += r.runs [i];
+		r.min = std::min( r.min, r.runs [i] );
+		r.max = std::max( r.max, r.runs [i] );
+	}
+	r.mean = sum / r.runs.size();
+
+	double var = 0;
+	for ( size_t i = 0; i < r.runs.size(); i++ )
+		var += (r.runs [i] - r.mean) * (r.runs [i] - r.mean);
+	r.stddev = r.runs.size() > 1 ? sqrt( var / (r.runs.size() - 1) ) : 0;
+}
+
+static string base_name( string const& path )
+{
+	size_t pos = path.find_last_of( "/\\" );
+	return pos == string::npos ? path : path.substr( pos + 1 );
+}
+
+static void print_result( FILE* out, result_t const& r, int rate )
+{
+	fprintf( out, "%-24s %-18s %10.0f %8.1fx %6.2f%%  %s%s\n",
+			base_name( r.path ).c_str(), r.system.c_str(), r.mean, r.mean / rate,
+			(r.mean > 0 ? r.stddev / r.mean * 100 : 0.0), r.chips.c_str(),
+			(r.ended ? " (ended early)" : "") );
+}
+
+// Samples per second a chip would render at if it were the only work done
+static double chip_rate( result_t const& r, chip_time_t const& t )
+{
+	return t.secs > 0 ? r.samples / t.secs : 0;
+}
+
+// Per-chip summary, averaging each chip's own rate over files that use it
+struct chip_total_t
+{
+	string name;
+	double sum;
+	int files;
+};
+
+static void chip_totals( vector<result_t> const& results, vector<chip_total_t>& out )
+{
+	for ( size_t i = 0; i < results.size(); i++ )
+	{
+		for ( size_t k = 0; k < results [i].chip_times.size(); k++ )
+		{
+			chip_time_t const& t = results [i].chip_times [k];
+			size_t j = 0;
+			while ( j < out.size() && out [j].name != t.name )
+				j++;
+			if ( j == out.size() )
+			{
+				chip_total_t c = { t.name, 0, 0 };
+				out.push_back( c );
+			}
+			out [j].sum += chip_rate( results [i], t );
+			out [j].files++;
+		}
+	}
+}
+
+// JSON output
+
+static void json_string( FILE* out, string const& s )
+{
+	putc( '"', out );
+	for ( size_t i = 0; i < s.size(); i++ )
+	{
+		unsigned char c = s [i];
+		if ( c == '"' || c == '\\' )
+			fprintf( out, "\\%c", c );
+		else if ( c < 0x20 )
+			fprintf( out, "\\u%04x", c );
+		else
+			putc( c, out );
+	}
+	putc( '"', out );
+}
+
+static void write_json( FILE* out, vector<result_t> const& results,
+		vector<chip_total_t> const& chips, options_t const& opt )
+{
+	fprintf( out, "{\n  \"version\": " );
+	json_string( out, GME_BENCH_VERSION );
+	fprintf( out, ",\n  \"sample_rate\": %d,\n  \"seconds\": %g,\n  \"repeats\": %d,\n"
+			"  \"track\": %d,\n  \"cpu\": %d,\n  \"files\": [\n",
+			opt.rate, opt.secs, opt.repeats, opt.track, opt.cpu );
+
+	for ( size_t i = 0; i < results.size(); i++ )
+	{
+		result_t const& r = results [i];
+		fprintf( out, "    {\n      \"file\": " );
+		json_string( out, base_name( r.path ) );
+		fprintf( out, ",\n      \"system\": " );
+		json_string( out, r.system );
+		fprintf( out, ",\n      \"chips\": [" );
+		for ( size_t j = 0; j < r.chip_times.size(); j++ )
+		{
+			fprintf( out, "%s{ \"chip\": ", (j ? ", " : "") );
+			json_string( out, r.chip_times [j].name );
+			fprintf( out, ", \"seconds\": %.6f, \"samples_per_sec\": %.1f }",
+					r.chip_times [j].secs, chip_rate( r, r.chip_times [j] ) );
+		}
+		fprintf( out, "],\n      \"load_ms\": %.3f,\n      \"samples\": %ld,\n"
+				"      \"samples_per_sec\": { \"mean\": %.1f, \"stddev\": %.1f, \"min\": %.1f, \"max\": %.1f },\n"
+				"      \"realtime_factor\": %.3f,\n      \"ended_early\": %s,\n      \"runs\": [",
+				r.load_ms, r.samples, r.mean, r.stddev, r.min, r.max, r.mean / opt.rate,
+				(r.ended ? "true" : "false") );
+		for ( size_t j = 0; j < r.runs.size(); j++ )
+			fprintf( out, "%s%.1f", (j ? ", " : ""), r.runs [j] );
+		fprintf( out, "]\n    }%s\n", (i + 1 < results.size() ? "," : "") );
+	}
+
+	fprintf( out, "  ],\n  \"chips\": [\n" );
+	for ( size_t i = 0; i < chips.size(); i++ )
+	{
+		double mean = chips [i].sum / chips [i].files;
+		fprintf( out, "    { \"chip\": " );
+		json_string( out, chips [i].name );
+		fprintf( out, ", \"files\": %d, \"samples_per_sec\": %.1f, \"realtime_factor\": %.3f }%s\n",
+				chips [i].files, mean, mean / opt.rate, (i + 1 < chips.size() ? "," : "") );
+	}
+	fprintf( out, "  ]\n}\n" );
+}
+
+static void usage()
+{
+	fprintf( stderr, "Usage: gme_bench [-s secs] [-r count] [-t track] [-R rate] [-c cpu]\n"
+			"                 [-j out.json] [-a] [file or directory ...]\n" );
+	exit( EXIT_FAILURE );
+}
+
+int main( int argc, char* argv [] )
+{
+	options_t opt = { 30, 5, 0, 44100, -1, NULL, false };
+	vector<string> paths;
+	for ( int i = 1; i < argc; i++ )
+	{
+		string a = argv [i];
+		if ( a == "-a" )
+			opt.all_files = true;
+		else if ( a.size() == 2 && a [0] == '-' && i + 1 < argc )
+		{
+			const char* v = argv [++i];
+			switch ( a [1] )
+			{
+			case 's': opt.secs    = atof( v ); break;
+			case 'r': opt.repeats = atoi( v ); break;
+			case 't': opt.track   = atoi( v ); break;
+			case 'R': opt.rate    = atoi( v ); break;
+			case 'c': opt.cpu     = atoi( v ); break;
+			case 'j': opt.json    = v; break;
+			default: usage();
+			}
+		}
+		else if ( a [0] == '-' )
+			usage();
+		else if ( is_dir( a.c_str() ) )
+			list_dir( a, paths );
+		else
+			paths.push_back( a );
+	}
+	if ( opt.secs <= 0 || opt.repeats < 1 || opt.rate < 8000 )
+		usage();
+
+	if ( paths.empty() )
+		list_dir( GME_BENCH_CORPUS, paths );
+
+	vector<result_t> results;
+	select_corpus( paths, opt.all_files, results );
+	if ( results.empty() )
+		handle_error( "No music files found" );
+
+	if ( opt.cpu >= 0 && !pin_to_cpu( opt.cpu ) )
+		fprintf( stderr, "Warning: couldn't pin to CPU %d\n", opt.cpu );
+
+	// Table goes to stderr when JSON is on stdout
+	FILE* log = (opt.json && !strcmp( opt.json, "-" )) ? stderr : stdout;
+	fprintf( log, "%.0f seconds at %d Hz, %d runs\n\n", opt.secs, opt.rate, opt.repeats );
+	fprintf( log, "%-24s %-18s %10s %9s %7s  %s\n", "File", "System", "Samples/s", "Realtime", "RSD", "Chips" );
+	for ( size_t i = 0; i < results.size(); i++ )
+	{
+		run_file( results [i], opt );
+		print_result( log, results [i], opt.rate );
+	}
+
+	vector<chip_total_t> chips;
+	chip_totals( results, chips );
+	if ( !chips.empty() )
+	{
+		fprintf( log, "\n%-24s %10s %9s  %s\n", "Chip", "Samples/s", "Realtime", "Files" );
+		for ( size_t i = 0; i < chips.size(); i++ )
+		{
+			double mean = chips [i].sum / chips [i].files;
+			fprintf( log, "%-24s %10.0f %8.1fx  %d\n", chips [i].name.c_str(), mean,
+					mean / opt.rate, chips [i].files );
+		}
+	}
+
+	if ( opt.json )
+	{
+		FILE* out = strcmp( opt.json, "-" ) ? fopen( opt.json, "w" ) : stdout;
+		if ( !out )
+			handle_error( "Couldn't open JSON output file" );
+		write_json( out, results, chips, opt );
+		if ( out != stdout )
+			fclose( out );
+	}
+	return 0;
+}
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////
+//
+// qmix benchmark - times the QSound mixer and checks that its vector loops
+// match the plain C ones
+//
+// Not part of the library. Built by CMake as qmix_bench and qmix_bench_ref,
+// or from this directory with, for example:
+//   cc -O2 -DHAVE_STDINT_H -I../gme -o qmix_bench qmix_bench.c
+// and again with -DQMIX_NO_SIMD for the scalar reference build. Both builds
+// must print the same output hash. With "check" as argument, renders fewer
+// seconds and leaves out timing, so ctest can compare the two builds' output.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "qmix.c"
+
+#include <string.h>
+#include <time.h>
+
+#define ROMSIZE  (0x100000)
+#define RATE     (44100)
+#define SECONDS  (60)
+
+static uint32 rand_state = 1;
+
+static uint32 next_rand(void) {
+  rand_state = rand_state * 1103515245 + 12345;
+  return rand_state >> 8;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Runs kernels on random input, including extremes, and returns number of
+// mismatches
+//
+static int check_kernels(void) {
+  sint32 in[RENDERMAX], l[RENDERMAX], r[RENDERMAX];
+  sint32 l_c[RENDERMAX], r_c[RENDERMAX];
+  sint16 out[RENDERMAX * 2], out_c[RENDERMAX * 2];
+  int errors = 0;
+  int pass;
+  for(pass = 0; pass < 1000; pass++) {
+    uint32 n = next_rand() % (RENDERMAX + 1);
+    sint32 vol_l = (pass & 1) ? 0x7FFF : (sint32)(next_rand() % 0x8000);
+    sint32 vol_r = (pass & 2) ? 0 : (sint32)(next_rand() % 0x8000);
+    uint32 s;
+    for(s = 0; s < n; s++) {
+      in[s] = (sint32)(next_rand() % 65441) - 32720;
+      if(pass & 4) in[s] = (s & 1) ? 32720 : -32720;
+      l[s] = l_c[s] = (sint32)(next_rand() % 0x100000) - 0x80000;
+      r[s] = r_c[s] = (sint32)(next_rand() % 0x2000) - 0x1000;
+    }
+    mix_voice(l, r, in, n, vol_l, vol_r);
+    mix_voice_c(l_c, r_c, in, n, vol_l, vol_r);
+    if(memcmp(l, l_c, n * 4) || memcmp(r, r_c, n * 4)) errors++;
+
+    write_output(out, l, r, n);
+    write_output_c(out_c, l, r, n);
+    if(memcmp(out, out_c, n * 4)) errors++;
+  }
+  return errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Keys voices on and off with random settings, like a busy CPS2 track
+//
+static void random_commands(void *state) {
+  int n;
+  for(n = 0; n < 4; n++) {
+    uint32 ch = next_rand() % 16;
+    uint32 start = next_rand() & 0xFFFF;
+    _qmix_command(state, (uint8)(((ch + 15) & 15) * 8 + 0), (uint16)(next_rand() % (ROMSIZE >> 16)));
+    _qmix_command(state, (uint8)(ch * 8 + 1), (uint16)start);
+    _qmix_command(state, (uint8)(ch * 8 + 2), (uint16)(0x400 + next_rand() % 0x2000));
+    _qmix_command(state, (uint8)(ch * 8 + 4), (uint16)(next_rand() % 0x1000));
+    _qmix_command(state, (uint8)(ch * 8 + 5), (uint16)(start + 0x800 + next_rand() % 0x4000));
+    _qmix_command(state, (uint8)(0x80 + ch), (uint16)(0x110 + next_rand() % 0x21));
+    _qmix_command(state, (uint8)(ch * 8 + 6), (uint16)((next_rand() % 8) ? next_rand() % 0x10000 : 0));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  static uint8 rom[ROMSIZE];
+  sint16 buf[RENDERMAX * 2];
+  void *state;
+  uint64 hash = 1469598103934665603ULL;
+  clock_t start;
+  uint32 i;
+  int errors;
+  int check = argc > 1 && !strcmp(argv[1], "check");
+  uint32 seconds = check ? 5 : SECONDS;
+
+  errors = check_kernels();
+  printf("kernel mismatches: %d\n", errors);
+
+  for(i = 0; i < ROMSIZE; i++) rom[i] = (uint8)(next_rand() >> 4);
+  state = malloc(_qmix_get_state_size());
+  _qmix_clear_state(state);
+  _qmix_set_sample_rate(state, RATE);
+  _qmix_set_sample_rom(state, rom, ROMSIZE);
+
+  start = clock();
+  for(i = 0; i < RATE * seconds / RENDERMAX; i++) {
+    uint32 s;
+    if(i % 20 == 0) random_commands(state);
+    _qmix_render(state, buf, RENDERMAX);
+    for(s = 0; s < RENDERMAX * 2; s++) {
+      hash ^= (uint16)buf[s];
+      hash *= 1099511628211ULL;
+    }
+  }
+  if(check) {
+    printf("%u s rendered, output hash %08X%08X\n", seconds,
+      (uint32)(hash >> 32), (uint32)hash);
+  } else {
+    printf("%u s rendered in %.3f s, output hash %08X%08X\n", seconds,
+      (double)(clock() - start) / CLOCKS_PER_SEC,
+      (uint32)(hash >> 32), (uint32)hash);
+  }
+
+  free(state);
+  return errors != 0;
+}
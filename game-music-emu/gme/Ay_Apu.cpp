@@ -1,6 +1,7 @@
 // $package. http://www.slack.net/~ant/
 
 #include "Ay_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -410,3 +411,16 @@ void Ay_Apu::run_until( blip_time_t final_end_time )
 	
 	last_time = final_end_time;
 }
+
+void Ay_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( last_time );
+	copier( addr_ );
+	copier( regs );
+	copier( noise_delay );
+	copier( noise_lfsr );
+	copier( env_delay );
+	copier( env_wave ); // points into env_modes
+	copier( env_pos );
+}
@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 class Ay_Apu {
 public:
@@ -49,6 +50,9 @@ public:
 	// Resets sound chip
 	void reset();
 	
+	// Saves/restores emulation state (see State_Copier.h)
+	void copy_state( State_Copier& );
+	
 	// Number of registers
 	enum { reg_count = 16 };
 	
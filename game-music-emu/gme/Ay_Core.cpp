@@ -24,6 +24,7 @@ inline void Ay_Core::disable_beeper()
 Ay_Core::Ay_Core()
 {
 	beeper_output = NULL;
+	loop_detector = NULL;
 	disable_beeper();
 }
 
@@ -188,3 +189,19 @@ void Ay_Core::end_frame( time_t* end )
 	cpu.adjust_time( -*end );
 	apu_.end_frame( *end );
 }
+
+void Ay_Core::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	apu_.copy_state( copier );
+	copier( mem_.ram );
+	copier( beeper_delta );
+	copier( last_beeper );
+	copier( beeper_mask );
+	copier( play_addr );
+	copier( play_period );
+	copier( next_play );
+	copier( cpc_latch );
+	copier( spectrum_mode );
+	copier( cpc_mode );
+}
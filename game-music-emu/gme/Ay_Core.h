@@ -6,6 +6,7 @@
 
 #include "Z80_Cpu.h"
 #include "Ay_Apu.h"
+class Loop_Detector;
 
 class Ay_Core {
 public:
@@ -39,6 +40,16 @@ public:
 	// emulated. Until Spectrum/CPC mode is determined, *end is HALVED.
 	void end_frame( time_t* end );
 	
+	// Saves/restores CPU, memory and sound chip state between time frames
+	// (see State_Copier.h)
+	void copy_state( State_Copier& );
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
+	
 	// Called when CPC hardware is first accessed. AY file format doesn't specify
 	// which sound hardware is used, so it must be determined during playback
 	// based on which sound port is first used.
@@ -62,6 +73,7 @@ private:
 	int  cpc_latch;
 	bool spectrum_mode;
 	bool cpc_mode;
+	Loop_Detector* loop_detector;
 	
 	// large items
 	Z80_Cpu cpu;
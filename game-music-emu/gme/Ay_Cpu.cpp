@@ -2,6 +2,7 @@
 
 #include "Ay_Core.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 //#include "z80_cpu_log.h"
 
@@ -20,6 +21,9 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
 void Ay_Core::cpu_out( time_t time, addr_t addr, int data )
 {
+	if ( loop_detector )
+		loop_detector->write( time, addr, data );
+	
 	if ( (addr & 0xFF) == 0xFE )
 	{
 		check( !cpc_mode );
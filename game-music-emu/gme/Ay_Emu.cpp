@@ -339,6 +339,24 @@ blargg_err_t Ay_Emu::run_clocks( blip_time_t& duration, int )
 	return blargg_ok;
 }
 
+bool Ay_Emu::copy_core_state( State_Copier& copier )
+{
+	core.copy_state( copier );
+	return true;
+}
+
+bool Ay_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core.set_loop_detector( d );
+	return true;
+}
+
+void Ay_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core.spin_detector().hits();
+	*clocks_skipped = core.spin_detector().clocks_skipped();
+}
+
 inline void Ay_Emu::enable_cpc()
 {
 	change_clock_rate( cpc_clock );
@@ -2,6 +2,8 @@
 
 #include "Blip_Buffer.h"
 
+#include "State_Copier.h"
+
 #include <math.h>
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
@@ -160,51 +162,131 @@ int Blip_Buffer::read_samples( blip_sample_t out_ [], int max_samples, bool ster
 	
 	if ( count )
 	{
-		int const bass = highpass_shift();
-		delta_t const* reader = read_pos() + count;
-		int reader_sum = integrator();
-		
-		blip_sample_t* BLARGG_RESTRICT out = out_ + count;
-		if ( stereo )
-			out += count;
-		int offset = -count;
+		#if BLIP_SIMD
+			// Integrator is inherently serial, so run it first and overwrite
+			// deltas with samples, since they're removed below anyway. Clamping
+			// and storing can then be done in a vector loop.
+			int const bass = highpass_shift();
+			delta_t* BLARGG_RESTRICT reader = read_pos() + count;
+			int reader_sum = integrator();
 		
-		if ( !stereo )
-		{
+			int offset = -count;
 			do
 			{
 				int s = reader_sum >> delta_bits;
-				
+			
 				reader_sum -= reader_sum >> bass;
 				reader_sum += reader [offset];
-				
-				BLIP_CLAMP( s, s );
-				out [offset] = (blip_sample_t) s;
+			
+				reader [offset] = s;
 			}
 			while ( ++offset );
-		}
-		else
-		{
-			do
+		
+			set_integrator( reader_sum );
+		
+			blip_clamp_samples_( read_pos(), out_, count, (stereo ? 2 : 1) );
+		
+		#else
+			int const bass = highpass_shift();
+			delta_t const* reader = read_pos() + count;
+			int reader_sum = integrator();
+		
+			blip_sample_t* BLARGG_RESTRICT out = out_ + count;
+			if ( stereo )
+				out += count;
+			int offset = -count;
+		
+			if ( !stereo )
 			{
-				int s = reader_sum >> delta_bits;
+				do
+				{
+					int s = reader_sum >> delta_bits;
 				
-				reader_sum -= reader_sum >> bass;
-				reader_sum += reader [offset];
+					reader_sum -= reader_sum >> bass;
+					reader_sum += reader [offset];
 				
-				BLIP_CLAMP( s, s );
-				out [offset * 2] = (blip_sample_t) s;
+					BLIP_CLAMP( s, s );
+					out [offset] = (blip_sample_t) s;
+				}
+				while ( ++offset );
+			}
+			else
+			{
+				do
+				{
+					int s = reader_sum >> delta_bits;
+				
+					reader_sum -= reader_sum >> bass;
+					reader_sum += reader [offset];
+				
+					BLIP_CLAMP( s, s );
+					out [offset * 2] = (blip_sample_t) s;
+				}
+				while ( ++offset );
 			}
-			while ( ++offset );
-		}
 		
-		set_integrator( reader_sum );
+			set_integrator( reader_sum );
+		#endif
 		
 		remove_samples( count );
 	}
 	return count;
 }
 
+void blip_clamp_samples_( int const in [], blip_sample_t out [], int count, int step )
+{
+	int i = 0;
+	
+	#if BLIP_SSE2
+		if ( step == 1 )
+		{
+			for ( ; i <= count - 8; i += 8 )
+			{
+				__m128i a = _mm_loadu_si128( (__m128i const*) &in [i    ] );
+				__m128i b = _mm_loadu_si128( (__m128i const*) &in [i + 4] );
+				_mm_storeu_si128( (__m128i*) &out [i], _mm_packs_epi32( a, b ) );
+			}
+		}
+		else
+		{
+			// Replace low half of each 32-bit pair in out. Each store also
+			// rewrites the following sample, so the last one is left to the
+			// scalar loop in case out is offset by one into a stereo buffer.
+			__m128i const mask = _mm_set1_epi32( 0xFFFF );
+			for ( ; i < count - 4; i += 4 )
+			{
+				__m128i s = _mm_loadu_si128( (__m128i const*) &in [i] );
+				s = _mm_packs_epi32( s, s );
+				s = _mm_and_si128( _mm_unpacklo_epi16( s, s ), mask );
+				__m128i* p = (__m128i*) &out [i * 2];
+				_mm_storeu_si128( p, _mm_or_si128( s, _mm_andnot_si128( mask, _mm_loadu_si128( p ) ) ) );
+			}
+		}
+	#elif BLIP_NEON
+		if ( step == 1 )
+		{
+			for ( ; i <= count - 4; i += 4 )
+				vst1_s16( &out [i], vqmovn_s32( vld1q_s32( &in [i] ) ) );
+		}
+		else
+		{
+			for ( ; i < count - 4; i += 4 )
+			{
+				int16x4x2_t p = vld2_s16( &out [i * 2] );
+				p.val [0] = vqmovn_s32( vld1q_s32( &in [i] ) );
+				vst2_s16( &out [i * 2], p );
+			}
+		}
+	#endif
+	
+	for ( ; i < count; i++ )
+	{
+		int s = in [i];
+		BLIP_CLAMP( s, s );
+		out [i * step] = (blip_sample_t) s;
+	}
+}
+
 void Blip_Buffer::mix_samples( blip_sample_t const in [], int count )
 {
 	delta_t* out = buffer_center_ + (offset_ >> BLIP_BUFFER_ACCURACY);
@@ -238,6 +320,15 @@ void Blip_Buffer::load_state( blip_buffer_state_t const& in )
 	memcpy( buffer_, in.buf, sizeof in.buf );
 }
 
+void Blip_Buffer::copy_state( State_Copier& copier )
+{
+	copier( offset_ );
+	copier( reader_accum_ );
+	copier( modified_ );
+	if ( buffer_ )
+		copier.copy( buffer_, (buffer_size_ + blip_buffer_extra_) * sizeof *buffer_ );
+}
+
 
 //// Blip_Synth_
 
@@ -7,6 +7,8 @@
 #include "blargg_common.h"
 #include "Blip_Buffer_impl.h"
 
+class State_Copier;
+
 typedef int blip_time_t;                    // Source clocks in current time frame
 typedef BOOST::int16_t blip_sample_t;       // 16-bit signed output sample
 int const blip_default_length = 1000 / 4;   // Default Blip_Buffer length (1/4 second)
@@ -94,6 +96,10 @@ public:
 	// settings during same run of program; states can NOT be stored on disk.
 	// Clears buffer before loading state.
 	void load_state( const blip_buffer_state_t& in );
+	
+	// Saves/restores entire state, including unread samples and tails of
+	// deltas past the end of the frame (see State_Copier.h)
+	void copy_state( State_Copier& );
 
 private:
 	// noncopyable
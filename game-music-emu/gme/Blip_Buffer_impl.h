@@ -30,6 +30,29 @@ class Blip_Buffer;
 	#define BLIP_MAX_QUALITY 2
 #endif
 
+// Vector versions of inner loops, for SSE2 and NEON. Other targets, including
+// the WebAssembly build, use the plain C++ versions, as does defining
+// BLIP_BUFFER_NO_SIMD. BLIP_SIMD_MUL is set when 32-bit multiply is available,
+// which SSE2 lacks.
+#if !BLIP_BUFFER_NO_SIMD
+	#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <emmintrin.h>
+		#define BLIP_SSE2 1
+		#if defined (__SSE4_1__) || defined (__AVX__)
+			#include <smmintrin.h>
+			#define BLIP_SIMD_MUL 1
+		#endif
+	#elif (defined (__ARM_NEON) || defined (__ARM_NEON__)) && !defined (__ARM_BIG_ENDIAN)
+		#include <arm_neon.h>
+		#define BLIP_NEON 1
+		#define BLIP_SIMD_MUL 1
+	#endif
+	
+	#if BLIP_SSE2 || BLIP_NEON
+		#define BLIP_SIMD 1
+	#endif
+#endif
+
 int const blip_res           = 1 << BLIP_PHASE_BITS;
 int const blip_buffer_extra_ = BLIP_MAX_QUALITY + 2;
 
@@ -79,6 +79,11 @@ int const blip_reader_idx_factor = sizeof (Blip_Buffer::delta_t);
 #define BLIP_CLAMP( sample, out )\
 	{ if ( BLIP_CLAMP_( (sample) ) ) (out) = ((sample) >> 31) ^ 0x7FFF; }
 
+// Clamps count samples from in to blip_sample_t range and writes them to out [0],
+// out [step], out [step * 2]... Step must be 1 or 2. Leaves other samples in out
+// unchanged.
+void blip_clamp_samples_( int const in [], blip_sample_t out [], int count, int step );
+
 
 //// Blip_Synth
 
@@ -90,6 +95,57 @@ int const blip_reader_idx_factor = sizeof (Blip_Buffer::delta_t);
 #define BLIP_PTR_OFF_SH( T, ptr, off, sh ) \
 	((T*) (BLIP_SH_AND_MUL( off, sh, -1, sizeof (T) ) + (char*) (ptr)))
 
+#if BLIP_SIMD_MUL
+
+// Adds imp [i] * delta to out [i], for i = 0 to n-1
+inline void blip_add_imp_( int* BLARGG_RESTRICT out, short const* imp, int delta, int n )
+{
+	int i = 0;
+	#if BLIP_SSE2
+		__m128i const vdelta = _mm_set1_epi32( delta );
+		for ( ; i <= n - 4; i += 4 )
+		{
+			__m128i x = _mm_cvtepi16_epi32( _mm_loadl_epi64( (__m128i const*) &imp [i] ) );
+			__m128i o = _mm_loadu_si128( (__m128i const*) &out [i] );
+			_mm_storeu_si128( (__m128i*) &out [i], _mm_add_epi32( o, _mm_mullo_epi32( x, vdelta ) ) );
+		}
+	#elif BLIP_NEON
+		for ( ; i <= n - 4; i += 4 )
+		{
+			int32x4_t x = vmovl_s16( vld1_s16( &imp [i] ) );
+			vst1q_s32( &out [i], vmlaq_n_s32( vld1q_s32( &out [i] ), x, delta ) );
+		}
+	#endif
+	for ( ; i < n; i++ )
+		out [i] += imp [i] * delta;
+}
+
+// Adds imp [n-1-i] * delta to out [i], for i = 0 to n-1
+inline void blip_add_imp_rev_( int* BLARGG_RESTRICT out, short const* imp, int delta, int n )
+{
+	int i = 0;
+	#if BLIP_SSE2
+		__m128i const vdelta = _mm_set1_epi32( delta );
+		for ( ; i <= n - 4; i += 4 )
+		{
+			__m128i x = _mm_cvtepi16_epi32( _mm_loadl_epi64( (__m128i const*) &imp [n - 4 - i] ) );
+			x = _mm_shuffle_epi32( x, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+			__m128i o = _mm_loadu_si128( (__m128i const*) &out [i] );
+			_mm_storeu_si128( (__m128i*) &out [i], _mm_add_epi32( o, _mm_mullo_epi32( x, vdelta ) ) );
+		}
+	#elif BLIP_NEON
+		for ( ; i <= n - 4; i += 4 )
+		{
+			int32x4_t x = vmovl_s16( vrev64_s16( vld1_s16( &imp [n - 4 - i] ) ) );
+			vst1q_s32( &out [i], vmlaq_n_s32( vld1q_s32( &out [i] ), x, delta ) );
+		}
+	#endif
+	for ( ; i < n; i++ )
+		out [i] += imp [n - 1 - i] * delta;
+}
+
+#endif
+
 template<int quality,int range>
 inline void Blip_Synth<quality,range>::offset_resampled( blip_resampled_time_t time,
 		int delta, Blip_Buffer* blip_buf ) const
@@ -128,13 +184,21 @@ inline void Blip_Synth<quality,range>::offset_resampled( blip_resampled_time_t t
 #else
 	
 	int const fwd = -quality / 2;
-	int const rev = fwd + quality - 2;
 	
 	coeff_t const* BLARGG_RESTRICT imp = (coeff_t const*) ((char const*) phases + phase);
 	int const phase2 = phase + phase - (blip_res - 1) * half_width * sizeof (coeff_t);
 	
 	#define BLIP_MID_IMP imp = (coeff_t const*) ((char const*) imp - phase2);
 	
+	#if BLIP_SIMD_MUL
+		// Vector version for any quality
+		blip_add_imp_( buf + fwd, imp, delta, half_width );
+		BLIP_MID_IMP
+		blip_add_imp_rev_( buf + fwd + half_width, imp, delta, half_width );
+	#else
+	
+	int const rev = fwd + quality - 2;
+	
 	#if BLIP_MAX_QUALITY > 16
 		// General version for any quality
 		if ( quality != 8 && quality != 12 && quality != 16 )
@@ -231,6 +295,7 @@ inline void Blip_Synth<quality,range>::offset_resampled( blip_resampled_time_t t
 		buf [rev + 1] = t1;
 	#endif
 	
+	#endif // BLIP_SIMD_MUL
 #endif
 }
 
@@ -0,0 +1,21 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Chip_Profile.h"
+
+#if __cplusplus >= 201103L || (defined (_MSC_VER) && _MSC_VER >= 1900)
+	#include <chrono>
+#else
+	#include <time.h>
+#endif
+
+#include "blargg_source.h"
+
+double Chip_Profile::now()
+{
+	#if __cplusplus >= 201103L || (defined (_MSC_VER) && _MSC_VER >= 1900)
+		using namespace std::chrono;
+		return duration<double, std::nano>( steady_clock::now().time_since_epoch() ).count();
+	#else
+		return (double) clock() * (1000000000.0 / CLOCKS_PER_SEC);
+	#endif
+}
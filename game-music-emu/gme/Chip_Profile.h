@@ -0,0 +1,23 @@
+// Sound chip emulation time and work counters, for finding which chips are slow
+
+// Game_Music_Emu $vers
+#ifndef CHIP_PROFILE_H
+#define CHIP_PROFILE_H
+
+// Time spent emulating a chip and the work it did, while profiling is enabled
+struct Chip_Profile {
+	double nanoseconds; // spent running chip
+	long samples;       // generated by chip, at its own rate
+	long writes;        // to chip's registers
+	
+	Chip_Profile()                      { clear(); }
+	void clear()                        { nanoseconds = 0; samples = 0; writes = 0; }
+	
+	// Adds time since start, which was returned by now()
+	void add_time( double start )       { nanoseconds += now() - start; }
+	
+	// Current time in nanoseconds, from a steady clock if available
+	static double now();
+};
+
+#endif
@@ -0,0 +1,148 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Chip_Resampler.h"
+
+#include "blargg_source.h"
+
+Chip_Resampler::Chip_Resampler()
+{
+	chip_count            = 0;
+	group_                = this;
+	last_time             = 0;
+	out                   = NULL;
+	frame_begin           = NULL;
+	separate              = NULL;
+	log                   = NULL;
+	sample_buf_size       = 0;
+	oversamples_per_frame = 0;
+	resampler_size        = 0;
+	profiling             = false;
+}
+
+blargg_err_t Chip_Resampler::setup( double oversample, double gain, void* chip, run_t run )
+{
+	group_ = this;
+	chip_count = 1;
+	chips [0].chip = chip;
+	chips [0].run  = run;
+	chips [0].gain = (int) ((1 << gain_bits) * gain);
+	chips [0].profile = &profile_;
+	profile_.clear();
+
+	RETURN_ERR( resampler.set_rate( oversample ) );
+
+	int pairs;
+	double rate = resampler.rate();
+	if ( rate >= 1.0 ) pairs = 64.0 * rate;
+	else pairs = 64.0 / rate;
+	RETURN_ERR( sample_buf.resize( (pairs + (pairs >> 2)) * 2 ) );
+	sample_buf_size = pairs * 2;
+	oversamples_per_frame = int (pairs * rate) * 2 + 2;
+	resampler_size = oversamples_per_frame + (oversamples_per_frame >> 2);
+	return resampler.resize_buffer( resampler_size );
+}
+
+bool Chip_Resampler::merge( Chip_Resampler& other )
+{
+	if ( &other == this || group_ != this || other.group_ != &other ||
+			other.rate() != rate() || chip_count + other.chip_count > max_chips )
+		return false;
+
+	if ( mix_buf.size() < (size_t) resampler_size && mix_buf.resize( resampler_size ) )
+		return false;
+
+	for ( int i = 0; i < other.chip_count; i++ )
+		chips [chip_count++] = other.chips [i];
+	other.group_ = this;
+	return true;
+}
+
+void Chip_Resampler::clear()
+{
+	resampler.clear();
+}
+
+void Chip_Resampler::begin_frame( short* buf, Chip_Output_Log* log )
+{
+	out = frame_begin = buf;
+	this->log = log;
+	last_time = 0;
+}
+
+// Runs chip for pair_count pairs, and counts the time it took if profiling
+inline void Chip_Resampler::run_chip( chip_t const& c, int pair_count, dsample_t* out )
+{
+	if ( !profiling )
+	{
+		c.run( c.chip, pair_count, out );
+		return;
+	}
+	
+	double start = Chip_Profile::now();
+	c.run( c.chip, pair_count, out );
+	c.profile->add_time( start );
+	c.profile->samples += pair_count;
+}
+
+// Runs chips for count samples into out and scales them by their gains. Output
+// of several chips is summed at full precision then clamped.
+void Chip_Resampler::run_chips( dsample_t* out, int count )
+{
+	memset( out, 0, count * sizeof *out );
+	if ( chip_count == 1 )
+	{
+		chip_t const& c = chips [0];
+		run_chip( c, count >> 1, out );
+		for ( int i = 0; i < count; i++ )
+			out [i] = (out [i] * c.gain) >> gain_bits;
+		return;
+	}
+
+	int* mix = mix_buf.begin();
+	memset( mix, 0, count * sizeof *mix );
+	for ( int n = 0; n < chip_count; n++ )
+	{
+		chip_t const& c = chips [n];
+		if ( n )
+			memset( out, 0, count * sizeof *out );
+		run_chip( c, count >> 1, out );
+		for ( int i = 0; i < count; i++ )
+			mix [i] += (out [i] * c.gain) >> gain_bits;
+	}
+
+	for ( int i = 0; i < count; i++ )
+	{
+		int s = mix [i];
+		if ( (short) s != s )
+			s = 0x7FFF ^ (s >> 31);
+		out [i] = s;
+	}
+}
+
+void Chip_Resampler::run_until( int time )
+{
+	int count = time - last_time;
+	while ( count > 0 )
+	{
+		last_time = time;
+
+		// Keep resampler input topped up to a frame's worth
+		int sample_count = oversamples_per_frame - resampler.written() + resampler_extra;
+		run_chips( resampler.buffer(), sample_count );
+		resampler.write( sample_count );
+
+		int max_read = count * 2 > sample_buf_size ? sample_buf_size : count * 2;
+		sample_count = resampler.read( sample_buf.begin(), max_read ) >> 1;
+		if ( !sample_count )
+			return;
+
+		if ( log )
+			log->add( out - frame_begin, sample_buf.begin(), sample_count );
+		else
+			chip_mix_samples( out, sample_buf.begin(), sample_count );
+		if ( separate )
+			memcpy( separate + (out - frame_begin), sample_buf.begin(), sample_count * 2 * sizeof *separate );
+		out += sample_count * 2;
+		count -= sample_count;
+	}
+}
@@ -7,141 +7,194 @@
 #include "blargg_source.h"
 
 #include "Fir_Resampler.h"
+#include "Chip_Profile.h"
 typedef Fir_Resampler_Norm Chip_Resampler_Downsampler;
 
 int const resampler_extra = 0; //34;
 
-template<class Emu>
-class Chip_Resampler_Emu : public Emu {
-	int last_time;
-	short* out;
+// Adds count stereo pairs from in to out, clamping each sum
+inline void chip_mix_samples( short* out, short const* in, int count )
+{
+	for ( unsigned i = 0; i < count * 2; i++ )
+	{
+		int sample = in[i];
+		sample += out[i];
+		if ((short)sample != sample) sample = 0x7FFF ^ (sample >> 31);
+		out[i] = sample;
+	}
+}
+
+// Records what a chip outputs during a frame instead of writing it, so that
+// chips can be run on separate threads and their output applied afterwards in
+// the order a single thread would have
+class Chip_Output_Log {
+public:
+	struct segment_t {
+		int seq;        // order to apply in
+		int offset;     // position in frame, in samples
+		int count;      // pairs
+		int pos;        // position in samples
+	};
+
+	// Makes room for frame of up to pairs, and empties log
+	blargg_err_t resize( int pairs )
+	{
+		segment_count = sample_count = 0;
+		if ( samples.size() < (size_t) pairs * 2 )
+		{
+			RETURN_ERR( segments.resize( pairs * 2 + 2 ) );
+			RETURN_ERR( samples.resize( pairs * 2 ) );
+		}
+		return blargg_ok;
+	}
+
+	// Sequence number given to following segments
+	void set_seq( int n )               { seq = n; }
+
+	void add( int offset, short const* in, int count )
+	{
+		segment_t& s = segments [segment_count++];
+		s.seq    = seq;
+		s.offset = offset;
+		s.count  = count;
+		s.pos    = sample_count;
+		memcpy( &samples [sample_count], in, count * sizeof(short) * 2 );
+		sample_count += count * 2;
+	}
+
+	int count() const                   { return segment_count; }
+	segment_t const& operator [] ( int i ) const { return segments [i]; }
+
+	// Mixes segment into frame
+	void apply( segment_t const& s, short* frame ) const
+	{
+		chip_mix_samples( frame + s.offset, &samples [s.pos], s.count );
+	}
+
+	Chip_Output_Log()                   { segment_count = sample_count = seq = 0; }
+
+private:
+	blargg_vector<segment_t> segments;
+	blargg_vector<short> samples;
+	int segment_count;
+	int sample_count;
+	int seq;
+};
+
+// Resamples the summed output of one or more chips running at the same rate,
+// and mixes it into the output buffer
+class Chip_Resampler {
+public:
 	typedef short dsample_t;
-	enum { disabled_time = -1 };
+
+	// Adds pair_count stereo pairs of chip's output to out
+	typedef void (*run_t)( void* chip, int pair_count, dsample_t* out );
+
+	// Sets ratio of chip rate to output rate, and makes chip the only one
+	// resampled, with its output scaled by gain
+	blargg_err_t setup( double oversample, double gain, void* chip, run_t );
+
+	// Has other's chips summed and resampled along with this one's, rather than
+	// by other. Returns false if rates differ or there are too many chips.
+	bool merge( Chip_Resampler& other );
+
+	// Resampler that runs this one's chips; this one unless merged into another
+	Chip_Resampler& group()             { return *group_; }
+
+	double rate() const                 { return resampler.rate(); }
+
+	// Sets number of points in FIR, or 0 for default, without changing rate
+	blargg_err_t set_width( int points ) { return resampler.set_width( points ); }
+
+	void clear();
+
+	// Output is logged rather than written to buf if log isn't NULL
+	void begin_frame( short* buf, Chip_Output_Log* log = NULL );
+
+	// Also copies output to separate buf, at the same position as in frame, if
+	// not NULL. Can be changed between begin_frame() and running.
+	void set_separate( short* buf )     { separate = buf; }
+
+	// Runs chips and writes resampled output up to time
+	void run_until( int time );
+
+	// Profile of chip this was set up with. Its time and samples are only
+	// counted while profiling is enabled on the resampler that runs it.
+	Chip_Profile& profile()             { return profile_; }
+	void set_profiling( bool b )        { profiling = b; }
+
+public:
+	Chip_Resampler();
+
+private:
+	enum { max_chips = 8 };
 	enum { gain_bits = 14 };
+	struct chip_t
+	{
+		void* chip;
+		run_t run;
+		int gain;
+		Chip_Profile* profile;
+	};
+	chip_t chips [max_chips];
+	int chip_count;
+	Chip_Resampler* group_;
+	Chip_Profile profile_;
+	bool profiling;
+
+	int last_time;
+	short* out;
+	short* frame_begin;
+	short* separate;
+	Chip_Output_Log* log;
 	blargg_vector<dsample_t> sample_buf;
 	int sample_buf_size;
 	int oversamples_per_frame;
-	int buf_pos;
-	int buffered;
 	int resampler_size;
-	int gain_;
-
+	blargg_vector<int> mix_buf;
 	Chip_Resampler_Downsampler resampler;
 
-	void mix_samples( short * buf, int count )
+	void run_chip( chip_t const&, int pair_count, dsample_t* out );
+	void run_chips( dsample_t* out, int count );
+};
+
+template<class Emu>
+class Chip_Resampler_Emu : public Emu {
+	Chip_Resampler resampler_;
+	bool enabled_;
+
+	static void run_chip( void* self, int pair_count, short* out )
 	{
-        dsample_t * inptr = sample_buf.begin();
-		for ( unsigned i = 0; i < count * 2; i++ )
-		{
-			int sample = inptr[i];
-			sample += buf[i];
-			if ((short)sample != sample) sample = 0x7FFF ^ (sample >> 31);
-			buf[i] = sample;
-		}
+		STATIC_CAST(Chip_Resampler_Emu*,self)->Emu::run( pair_count, out );
 	}
 
 public:
-	Chip_Resampler_Emu()      { last_time = disabled_time; out = NULL; }
+	Chip_Resampler_Emu()            { enabled_ = false; }
 	blargg_err_t setup( double oversample, double rolloff, double gain )
 	{
-		gain_ = (int) ((1 << gain_bits) * gain);
-		RETURN_ERR( resampler.set_rate( oversample ) );
-		return reset_resampler();
+		return resampler_.setup( oversample, gain, this, run_chip );
 	}
 
 	blargg_err_t reset()
 	{
 		Emu::reset();
-		resampler.clear();
-		return blargg_ok;
-	}
-
-	blargg_err_t reset_resampler()
-	{
-		unsigned int pairs;
-		double rate = resampler.rate();
-		if ( rate >= 1.0 ) pairs = 64.0 * rate;
-		else pairs = 64.0 / rate;
-		RETURN_ERR( sample_buf.resize( (pairs + (pairs >> 2)) * 2 ) );
-		resize( pairs );
-		resampler_size = oversamples_per_frame + (oversamples_per_frame >> 2);
-		RETURN_ERR( resampler.resize_buffer( resampler_size ) );
+		resampler_.group().clear();
 		return blargg_ok;
 	}
 
-	void resize( int pairs )
-	{
-		int new_sample_buf_size = pairs * 2;
-		//new_sample_buf_size = new_sample_buf_size / 4 * 4; // TODO: needed only for 3:2 downsampler
-		if ( sample_buf_size != new_sample_buf_size )
-		{
-			if ( (unsigned) new_sample_buf_size > sample_buf.size() )
-			{
-				check( false );
-				return;
-			}
-			sample_buf_size = new_sample_buf_size;
-			oversamples_per_frame = int (pairs * resampler.rate()) * 2 + 2;
-			clear();
-		}
-	}
-
-	void clear()
-	{
-		buf_pos = buffered = 0;
-		resampler.clear();
-	}
+	// Chip's own resampler, which might be merged into another chip's
+	Chip_Resampler& resampler()     { return resampler_; }
 
-	void enable( bool b = true )    { last_time = b ? 0 : disabled_time; }
-	bool enabled() const            { return last_time != disabled_time; }
-	void begin_frame( short* buf )  { out = buf; last_time = 0; }
+	void enable( bool b = true )    { enabled_ = b; }
+	bool enabled() const            { return enabled_; }
 
 	int run_until( int time )
 	{
-		int count = time - last_time;
-		while ( count > 0 )
-		{
-			if ( last_time < 0 )
-				return false;
-			last_time = time;
-			if ( buffered )
-			{
-				int samples_to_copy = buffered;
-				if ( samples_to_copy > count ) samples_to_copy = count;
-				memcpy( out, sample_buf.begin(), samples_to_copy * sizeof(short) * 2 );
-				memcpy( sample_buf.begin(), sample_buf.begin() + samples_to_copy * 2, ( buffered - samples_to_copy ) * 2 * sizeof(short) );
-				buffered -= samples_to_copy;
-				count -= samples_to_copy;
-				continue;
-			}
-			int sample_count = oversamples_per_frame - resampler.written() + resampler_extra;
-			memset( resampler.buffer(), 0, sample_count * sizeof(*resampler.buffer()) );
-			Emu::run( sample_count >> 1, resampler.buffer() );
-			for ( unsigned i = 0; i < sample_count; i++ )
-			{
-                dsample_t * ptr = resampler.buffer() + i;
-				*ptr = ( *ptr * gain_ ) >> gain_bits;
-			}
-			short* p = out;
-			resampler.write( sample_count );
-			sample_count = resampler.read( sample_buf.begin(), count * 2 > sample_buf_size ? sample_buf_size : count * 2 ) >> 1;
-			if ( sample_count > count )
-			{
-				out += count * Emu::out_chan_count;
-				mix_samples( p, count );
-				memmove( sample_buf.begin(), sample_buf.begin() + count * 2, (sample_count - count) * 2 * sizeof(short) );
-				buffered = sample_count - count;
-				return true;
-			}
-			else if (!sample_count) return true;
-			out += sample_count * Emu::out_chan_count;
-			mix_samples( p, sample_count );
-			count -= sample_count;
-		}
+		if ( !enabled_ )
+			return false;
+		resampler_.group().run_until( time );
 		return true;
 	}
 };
 
-
-
 #endif
@@ -2,7 +2,10 @@
 
 #include "Classic_Emu.h"
 
+#include "Loop_Detector.h"
 #include "Multi_Buffer.h"
+#include "State_Copier.h"
+#include "Voice_Buffer.h"
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -20,8 +23,12 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 Classic_Emu::Classic_Emu()
 {
 	buf           = NULL;
+	main_buf      = NULL;
 	stereo_buffer = NULL;
+	voice_buf     = NULL;
+	use_voice_buf = false;
 	voice_types   = NULL;
+	loop_detector = NULL;
 	
 	// avoid inconsistency in our duplicated constants
 	assert( (int) wave_type  == (int) Multi_Buffer::wave_type );
@@ -32,6 +39,7 @@ Classic_Emu::Classic_Emu()
 Classic_Emu::~Classic_Emu()
 {
 	delete stereo_buffer;
+	delete voice_buf;
 	delete effects_buffer_;
 	effects_buffer_ = NULL;
 }
@@ -40,8 +48,10 @@ void Classic_Emu::set_equalizer_( equalizer_t const& eq )
 {
 	Music_Emu::set_equalizer_( eq );
 	update_eq( eq.treble );
-	if ( buf )
-		buf->bass_freq( (int) equalizer().bass );
+	if ( main_buf )
+		main_buf->bass_freq( (int) equalizer().bass );
+	if ( voice_buf )
+		voice_buf->bass_freq( (int) equalizer().bass );
 }
 	
 blargg_err_t Classic_Emu::set_sample_rate_( int rate )
@@ -50,9 +60,9 @@ blargg_err_t Classic_Emu::set_sample_rate_( int rate )
 	{
 		if ( !stereo_buffer )
 			CHECK_ALLOC( stereo_buffer = BLARGG_NEW Stereo_Buffer );
-		buf = stereo_buffer;
+		buf = main_buf = stereo_buffer;
 	}
-	return buf->set_sample_rate( rate, 1000 / 20 );
+	return main_buf->set_sample_rate( rate, 1000 / 20 );
 }
 
 void Classic_Emu::mute_voices_( int mask )
@@ -77,18 +87,60 @@ void Classic_Emu::mute_voices_( int mask )
 void Classic_Emu::change_clock_rate( int rate )
 {
 	clock_rate_ = rate;
-	buf->clock_rate( rate );
+	main_buf->clock_rate( rate );
+	if ( voice_buf )
+		voice_buf->clock_rate( rate );
+	if ( loop_detector )
+		loop_detector->set_clock_rate( rate );
 }
 
 blargg_err_t Classic_Emu::setup_buffer( int rate )
 {
 	change_clock_rate( rate );
-	RETURN_ERR( buf->set_channel_count( voice_count(), voice_types ) );
+	RETURN_ERR( main_buf->set_channel_count( voice_count(), voice_types ) );
+	if ( voice_buf )
+		RETURN_ERR( voice_buf->set_channel_count( voice_count(), voice_types ) );
 	set_equalizer( equalizer() );
 	buf_changed_count = buf->channels_changed_count();
+	set_output_count( voice_count() );
 	return blargg_ok;
 }
 
+blargg_err_t Classic_Emu::setup_voice_buf()
+{
+	RETURN_ERR( voice_buf->set_sample_rate( main_buf->sample_rate(), main_buf->length() ) );
+	voice_buf->clock_rate( clock_rate_ );
+	voice_buf->bass_freq( (int) equalizer().bass );
+	return voice_buf->set_channel_count( voice_count(), voice_types );
+}
+
+blargg_err_t Classic_Emu::set_outputs_( bool enabled )
+{
+	if ( enabled && !voice_buf )
+	{
+		CHECK_ALLOC( voice_buf = BLARGG_NEW Voice_Buffer );
+		blargg_err_t err = setup_voice_buf();
+		if ( err )
+		{
+			delete voice_buf;
+			voice_buf = NULL;
+			return err;
+		}
+	}
+	use_voice_buf = enabled;
+	return blargg_ok;
+}
+
+// Moves voices to voice_buf if outputs are wanted, or back to main_buf. Only
+// done once current buffer has been read to its end, so that nothing is lost.
+void Classic_Emu::switch_buf()
+{
+	buf = (use_voice_buf ? voice_buf : main_buf);
+	buf->clear();
+	buf_changed_count = buf->channels_changed_count();
+	remute_voices();
+}
+
 blargg_err_t Classic_Emu::start_track_( int track )
 {
 	RETURN_ERR( Music_Emu::start_track_( track ) );
@@ -103,9 +155,18 @@ blargg_err_t Classic_Emu::play_( int count, sample_t out [] )
 	while ( remain )
 	{
 		buf->disable_immediate_removal();
-		remain -= buf->read_samples( &out [count - remain], remain );
+		int n;
+		if ( buf == voice_buf )
+			n = voice_buf->read_voices( &out [count - remain], remain, outputs(), outputs_pos() );
+		else
+			n = buf->read_samples( &out [count - remain], remain );
+		outputs_played( n );
+		remain -= n;
 		if ( remain )
 		{
+			if ( use_voice_buf != (buf == voice_buf) )
+				switch_buf();
+			
 			if ( buf_changed_count != buf->channels_changed_count() )
 			{
 				buf_changed_count = buf->channels_changed_count();
@@ -122,3 +183,53 @@ blargg_err_t Classic_Emu::play_( int count, sample_t out [] )
 	}
 	return blargg_ok;
 }
+
+bool Classic_Emu::copy_state_( State_Copier& copier )
+{
+	// buffer contents are only valid for the same buffer and channel setup
+	Multi_Buffer* saved_buf = buf;
+	unsigned changed_count = buf->channels_changed_count();
+	copier( saved_buf );
+	copier( changed_count );
+	if ( copier.loading() && (saved_buf != buf || changed_count != buf->channels_changed_count()) )
+		return false;
+	
+	if ( !copy_core_state( copier ) || !buf->copy_state( copier ) )
+		return false;
+	
+	if ( copier.loading() )
+	{
+		buf_changed_count = buf->channels_changed_count();
+		remute_voices();
+	}
+	return true;
+}
+
+bool Classic_Emu::set_dry_run_( Loop_Detector* d )
+{
+	if ( !set_loop_detector( d ) )
+		return false;
+	
+	loop_detector = d;
+	if ( d )
+	{
+		// voices without outputs only update their state
+		d->reset( clock_rate_ );
+		for ( int i = voice_count(); i--; )
+			set_voice( i, NULL, NULL, NULL );
+	}
+	else
+	{
+		buf->clear();
+		remute_voices();
+	}
+	return true;
+}
+
+blargg_err_t Classic_Emu::dry_run_( int msec )
+{
+	blip_time_t clocks_emulated = msec * clock_rate_ / 1000;
+	RETURN_ERR( run_clocks( clocks_emulated, msec ) );
+	loop_detector->end_frame( clocks_emulated );
+	return blargg_ok;
+}
@@ -7,6 +7,8 @@
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
 #include "Music_Emu.h"
+class Loop_Detector;
+class Voice_Buffer;
 
 class Classic_Emu : public Music_Emu {
 protected:
@@ -43,6 +45,15 @@ protected:
 	// actually run for. After returning, Blip_Buffers have time frame of time_io clocks
 	// ended.
 	virtual blargg_err_t run_clocks( blip_time_t& time_io, int msec )   BLARGG_PURE( ; )
+	
+	// Save or restore state of sound chips, CPU and memory, or return false if not
+	// supported. Buffers are saved along with it, and voice outputs re-applied
+	// after restoring.
+	virtual bool copy_core_state( State_Copier& )                       BLARGG_PURE( ; )
+	
+	// Log sound chip register writes to detector, or stop logging if NULL. Return
+	// false if not supported, in which case dry runs aren't either.
+	virtual bool set_loop_detector( Loop_Detector* )                    BLARGG_PURE( ; )
 
 // Internal
 public:
@@ -55,19 +66,30 @@ protected:
 	virtual void mute_voices_( int );
 	virtual void set_equalizer_( equalizer_t const& );
 	virtual blargg_err_t play_( int, sample_t [] );
+	virtual bool copy_state_( State_Copier& );
+	virtual bool set_dry_run_( Loop_Detector* );
+	virtual blargg_err_t dry_run_( int msec );
+	virtual blargg_err_t set_outputs_( bool );
 
 private:
-	Multi_Buffer* buf;
+	Multi_Buffer* buf;           // main_buf, or voice_buf while generating outputs
+	Multi_Buffer* main_buf;
 	Multi_Buffer* stereo_buffer; // NULL if using custom buffer
+	Voice_Buffer* voice_buf;     // NULL until outputs are first generated
+	bool use_voice_buf;
 	int clock_rate_;
 	unsigned buf_changed_count;
 	int const* voice_types;
+	Loop_Detector* loop_detector;
+	
+	blargg_err_t setup_voice_buf();
+	void switch_buf();
 };
 
 inline void Classic_Emu::set_buffer( Multi_Buffer* new_buf )
 {
 	assert( !buf && new_buf );
-	buf = new_buf;
+	buf = main_buf = new_buf;
 }
 
 inline void Classic_Emu::set_voice( int, Blip_Buffer*, Blip_Buffer*, Blip_Buffer* ) { }
@@ -76,4 +98,8 @@ inline void Classic_Emu::update_eq( blip_eq_t const& )
 
 inline blargg_err_t Classic_Emu::run_clocks( blip_time_t&, int )                    { return blargg_ok; }
 
+inline bool Classic_Emu::copy_core_state( State_Copier& )                           { return false; }
+
+inline bool Classic_Emu::set_loop_detector( Loop_Detector* )                        { return false; }
+
 #endif
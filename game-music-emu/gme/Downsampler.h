@@ -10,6 +10,10 @@ class Downsampler : public Resampler {
 public:
 	Downsampler();
 
+	// Makes next output sample fall at the same point between input samples as
+	// in other, which must have the same rate
+	void sync_phase( Downsampler const& other ) { pos = other.pos; }
+
 protected:
 	virtual blargg_err_t set_rate_( double );
 	virtual void clear_();
@@ -15,14 +15,31 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
 #include "blargg_source.h"
 
-// TODO: fix this. hack since resampler holds back some output.
-int const resampler_extra = 34;
-
 int const stereo = 2;
 
-Dual_Resampler::Dual_Resampler() { }
+// TODO: fix this. hack since resampler holds back some output.
+int Dual_Resampler::resampler_extra() const
+{
+#if GME_VGM_FAST_RESAMPLER
+	return 34;
+#else
+	return resampler.input_latency() - 2;
+#endif
+}
 
-Dual_Resampler::~Dual_Resampler() { }
+Dual_Resampler::Dual_Resampler()
+{
+	width_         = 0;
+	oversample_    = 1.0;
+	streams        = NULL;
+	stream_count_  = 0;
+	output_count   = 0;
+}
+
+Dual_Resampler::~Dual_Resampler()
+{
+	delete [] streams;
+}
 
 blargg_err_t Dual_Resampler::reset( int pairs )
 {
@@ -35,6 +52,18 @@ blargg_err_t Dual_Resampler::reset( int pairs )
 	return blargg_ok;
 }
 
+blargg_err_t Dual_Resampler::set_width( int points )
+{
+#if GME_VGM_FAST_RESAMPLER
+	return blargg_ok;
+#else
+	width_ = points;
+	for ( int i = 0; i < stream_count_; i++ )
+		RETURN_ERR( streams [i].set_width( points ) );
+	return resampler.set_width( points );
+#endif
+}
+
 void Dual_Resampler::resize( int pairs )
 {
 	int new_sample_buf_size = pairs * 2;
@@ -56,6 +85,46 @@ void Dual_Resampler::clear()
 {
 	buf_pos = buffered = 0;
 	resampler.clear();
+	for ( int i = 0; i < stream_count_; i++ )
+		streams [i].clear();
+}
+
+blargg_err_t Dual_Resampler::set_outputs( int buf_count, int stream_count )
+{
+	delete [] streams;
+	streams       = NULL;
+	stream_count_ = 0;
+	output_count  = 0;
+	if ( !buf_count && !stream_count )
+		return blargg_ok;
+	
+	// Samples already buffered weren't generated separately, so are silent
+	RETURN_ERR( output_bufs.resize( (buf_count + stream_count) * sample_buf.size() ) );
+	memset( output_bufs.begin(), 0, output_bufs.size() * sizeof output_bufs [0] );
+	
+	if ( stream_count )
+	{
+		CHECK_ALLOC( streams = BLARGG_NEW Dual_Resampler_Downsampler [stream_count] );
+		for ( int i = 0; i < stream_count; i++ )
+		{
+			Dual_Resampler_Downsampler& r = streams [i];
+		#if !GME_VGM_FAST_RESAMPLER
+			RETURN_ERR( r.set_width( width_ ) );
+			r.set_exact_ratio( true );
+		#endif
+			RETURN_ERR( r.set_rate( oversample_ ) );
+			RETURN_ERR( r.resize_buffer( resampler_size ) );
+			
+			// Start in step with mix, as if stream had been silent until now
+			r.sync_phase( resampler );
+			int n = resampler.written();
+			memset( r.buffer(), 0, n * sizeof (dsample_t) );
+			r.write( n );
+		}
+	}
+	stream_count_ = stream_count;
+	output_count  = buf_count + stream_count;
+	return blargg_ok;
 }
 
 
@@ -63,7 +132,7 @@ int Dual_Resampler::play_frame_( Stereo_Buffer& stereo_buf, dsample_t out [], St
 {
 	int pair_count = sample_buf_size >> 1;
 	blip_time_t blip_time = stereo_buf.center()->count_clocks( pair_count );
-    int sample_count = oversamples_per_frame - resampler.written() + resampler_extra;
+    int sample_count = oversamples_per_frame - resampler.written() + resampler_extra();
 	
 	int new_count = set_callback.f( set_callback.data, blip_time, sample_count, resampler.buffer() );
 	assert( new_count < resampler_size );
@@ -82,9 +151,19 @@ int Dual_Resampler::play_frame_( Stereo_Buffer& stereo_buf, dsample_t out [], St
     }
 
 	resampler.write( new_count );
+	for ( int i = 0; i < stream_count_; i++ )
+		streams [i].write( new_count );
 	
 	int count = resampler.read( sample_buf.begin(), sample_buf_size );
 	
+	if ( output_count )
+	{
+		int const buf_count = output_count - stream_count_;
+		for ( int i = 0; i < buf_count; i++ )
+			read_buf( i ? *secondary_buf_set [i - 1] : stereo_buf, output_buf( i ), count );
+		read_streams( output_buf( buf_count ), count );
+	}
+	
     mix_samples( stereo_buf, out, count, secondary_buf_set, secondary_buf_set_count );
 
 	pair_count = count >> 1;
@@ -102,12 +181,15 @@ int Dual_Resampler::play_frame_( Stereo_Buffer& stereo_buf, dsample_t out [], St
             second_buf->center()->remove_samples( pair_count );
         }
 	}
-
+	
 	return count;
 }
 
-void Dual_Resampler::dual_play( int count, dsample_t out [], Stereo_Buffer& stereo_buf, Stereo_Buffer** secondary_buf_set, int secondary_buf_set_count )
+void Dual_Resampler::dual_play( int count, dsample_t out [], Stereo_Buffer& stereo_buf, Stereo_Buffer** secondary_buf_set, int secondary_buf_set_count,
+		dsample_t* const outputs [] )
 {
+	dsample_t const* const out_begin = out;
+	
 	// empty extra buffer
 	int remain = buffered - buf_pos;
 	if ( remain )
@@ -116,6 +198,7 @@ void Dual_Resampler::dual_play( int count, dsample_t out [], Stereo_Buffer& ster
 			remain = count;
 		count -= remain;
 		memcpy( out, &sample_buf [buf_pos], remain * sizeof *out );
+		copy_outputs( outputs, 0, buf_pos, remain );
 		out += remain;
 		buf_pos += remain;
 	}
@@ -124,10 +207,11 @@ void Dual_Resampler::dual_play( int count, dsample_t out [], Stereo_Buffer& ster
 	while ( count >= sample_buf_size )
 	{
         buf_pos = buffered = play_frame_( stereo_buf, out, secondary_buf_set, secondary_buf_set_count );
+		copy_outputs( outputs, out - out_begin, 0, buffered );
 		out += buffered;
 		count -= buffered;
 	}
-
+	
 	while (count > 0)
 	{
         buffered = play_frame_( stereo_buf, sample_buf.begin(), secondary_buf_set, secondary_buf_set_count );
@@ -135,18 +219,85 @@ void Dual_Resampler::dual_play( int count, dsample_t out [], Stereo_Buffer& ster
 		{
 			buf_pos = count;
 			memcpy( out, sample_buf.begin(), count * sizeof *out );
+			copy_outputs( outputs, out - out_begin, 0, count );
 			out += count;
 			count = 0;
 		}
 		else
 		{
 			memcpy( out, sample_buf.begin(), buffered * sizeof *out );
+			copy_outputs( outputs, out - out_begin, 0, buffered );
 			out += buffered;
 			count -= buffered;
 		}
 	}
 }
 
+// Copies count samples of each output's part of frame from pos to outputs at out_pos
+void Dual_Resampler::copy_outputs( dsample_t* const outputs [], int out_pos, int pos, int count )
+{
+	if ( !outputs )
+		return;
+	
+	for ( int i = 0; i < output_count; i++ )
+		if ( outputs [i] )
+			memcpy( outputs [i] + out_pos, output_buf( i ) + pos, count * sizeof (dsample_t) );
+}
+
+// Reads count samples of buffer into out without ending reading, so that they're
+// still there to be mixed as usual
+void Dual_Resampler::read_buf( Stereo_Buffer& stereo_buf, dsample_t out [], int count )
+{
+	int const bass = BLIP_READER_BASS( *stereo_buf.center() );
+	BLIP_READER_BEGIN( snc, *stereo_buf.center() );
+	BLIP_READER_BEGIN( snl, *stereo_buf.left() );
+	BLIP_READER_BEGIN( snr, *stereo_buf.right() );
+	
+	// same test as mix_samples()
+	bool const sides = ((Tracked_Blip_Buffer*)stereo_buf.left())->non_silent() |
+			((Tracked_Blip_Buffer*)stereo_buf.right())->non_silent();
+	
+	for ( int i = 0; i < count; i += 2 )
+	{
+		int l = BLIP_READER_READ_RAW( snc ) >> (blip_sample_bits - 16);
+		int r = l;
+		if ( sides )
+		{
+			l += BLIP_READER_READ_RAW( snl ) >> (blip_sample_bits - 16);
+			r += BLIP_READER_READ_RAW( snr ) >> (blip_sample_bits - 16);
+		}
+		BLIP_READER_NEXT( snc, bass );
+		BLIP_READER_NEXT( snl, bass );
+		BLIP_READER_NEXT( snr, bass );
+		
+		BLIP_CLAMP( l, l );
+		out [i    ] = (blip_sample_t) l;
+		
+		BLIP_CLAMP( r, r );
+		out [i + 1] = (blip_sample_t) r;
+	}
+}
+
+// Resamples count samples of each stream into out, one after another, and scales
+// them as mix_samples() does
+void Dual_Resampler::read_streams( dsample_t out [], int count )
+{
+	int const gain = gain_;
+	for ( int n = 0; n < stream_count_; n++, out += sample_buf.size() )
+	{
+		int read = streams [n].read( out, count );
+		for ( int i = 0; i < read; i++ )
+		{
+			int s = out [i] * gain >> gain_bits;
+			BLIP_CLAMP( s, s );
+			out [i] = (dsample_t) s;
+		}
+		
+		// stream is kept in step with mix, so this shouldn't happen
+		memset( out + read, 0, (count - read) * sizeof *out );
+	}
+}
+
 void Dual_Resampler::mix_samples( Stereo_Buffer& stereo_buf, dsample_t out_ [], int count, Stereo_Buffer** secondary_buf_set, int secondary_buf_set_count )
 {
 	// lol hax
@@ -248,10 +399,10 @@ void Dual_Resampler::mix_extra_mono( Stereo_Buffer& stereo_buf, dsample_t out_ [
 {
 	int const bass = BLIP_READER_BASS( *stereo_buf.center() );
 	BLIP_READER_BEGIN( sn, *stereo_buf.center() );
-
+	
 	count >>= 1;
 	BLIP_READER_ADJ_( sn, count );
-
+	
 	typedef dsample_t stereo_dsample_t [2];
 	stereo_dsample_t* BLARGG_RESTRICT out = (stereo_dsample_t*) out_ + count;
 	int offset = -count;
@@ -259,18 +410,18 @@ void Dual_Resampler::mix_extra_mono( Stereo_Buffer& stereo_buf, dsample_t out_ [
 	{
 		int s = BLIP_READER_READ_RAW( sn ) >> (blip_sample_bits - 16);
 		BLIP_READER_NEXT_IDX_( sn, bass, offset );
-
+		
 		int l = out [offset] [0] + s;
 		int r = out [offset] [1] + s;
-
+		
 		BLIP_CLAMP( l, l );
 		out [offset] [0] = (blip_sample_t) l;
-
+		
 		BLIP_CLAMP( r, r );
 		out [offset] [1] = (blip_sample_t) r;
 	}
 	while ( ++offset );
-
+	
 	BLIP_READER_END( sn, *stereo_buf.center() );
 }
 
@@ -280,12 +431,12 @@ void Dual_Resampler::mix_extra_stereo( Stereo_Buffer& stereo_buf, dsample_t out_
 	BLIP_READER_BEGIN( snc, *stereo_buf.center() );
 	BLIP_READER_BEGIN( snl, *stereo_buf.left() );
 	BLIP_READER_BEGIN( snr, *stereo_buf.right() );
-
+	
 	count >>= 1;
 	BLIP_READER_ADJ_( snc, count );
 	BLIP_READER_ADJ_( snl, count );
 	BLIP_READER_ADJ_( snr, count );
-
+	
 	typedef dsample_t stereo_dsample_t [2];
 	stereo_dsample_t* BLARGG_RESTRICT out = (stereo_dsample_t*) out_ + count;
 	int offset = -count;
@@ -297,18 +448,18 @@ void Dual_Resampler::mix_extra_stereo( Stereo_Buffer& stereo_buf, dsample_t out_
 		BLIP_READER_NEXT_IDX_( snc, bass, offset );
 		BLIP_READER_NEXT_IDX_( snl, bass, offset );
 		BLIP_READER_NEXT_IDX_( snr, bass, offset );
-
+		
 		int l = out [offset] [0] + sl + sc;
 		int r = out [offset] [1] + sr + sc;
-
+		
 		BLIP_CLAMP( l, l );
 		out [offset] [0] = (blip_sample_t) l;
-
+		
 		BLIP_CLAMP( r, r );
 		out [offset] [1] = (blip_sample_t) r;
 	}
 	while ( ++offset );
-
+	
 	BLIP_READER_END( snc, *stereo_buf.center() );
 	BLIP_READER_END( snl, *stereo_buf.left() );
 	BLIP_READER_END( snr, *stereo_buf.right() );
@@ -20,11 +20,25 @@ public:
 	
 	blargg_err_t setup( double oversample, double rolloff, double gain );
 	double rate() const { return resampler.rate(); }
+	
+	// Sets number of points in FIR, or 0 for default. Has no effect with fast resampler.
+	blargg_err_t set_width( int points );
+	
 	blargg_err_t reset( int max_pairs );
 	void resize( int pairs_per_frame );
 	void clear();
 	
-    void dual_play( int count, dsample_t out [], Stereo_Buffer&, Stereo_Buffer** secondary_buf_set = NULL, int secondary_buf_set_count = 0 );
+    void dual_play( int count, dsample_t out [], Stereo_Buffer&, Stereo_Buffer** secondary_buf_set = NULL, int secondary_buf_set_count = 0,
+			dsample_t* const outputs [] = NULL );
+	
+	// Has dual_play() also write each of its buffers, and each of stream_count
+	// streams the callback writes to stream_buffer(), to its own output, or stop
+	// if both are 0. Outputs are the primary buffer, then secondary buffers, then
+	// streams, and NULL ones are skipped. Each stream is resampled separately,
+	// along with their mix that callback writes as usual.
+	blargg_err_t set_outputs( int buf_count, int stream_count );
+	int stream_count() const { return stream_count_; }
+	dsample_t* stream_buffer( int i ) { return streams [i].buffer(); }
 	
 	blargg_callback<int (*)( void*, blip_time_t, int, dsample_t* )> set_callback;
 
@@ -44,17 +58,34 @@ private:
 	int gain_;
 	
 	Dual_Resampler_Downsampler resampler;
+	int width_;
+	double oversample_;
+	
+	// Separate outputs
+	Dual_Resampler_Downsampler* streams;
+	int stream_count_;
+	int output_count;
+	blargg_vector<dsample_t> output_bufs; // part of sample_buf from each output
+	dsample_t* output_buf( int i ) { return &output_bufs [i * sample_buf.size()]; }
+	void read_buf( Stereo_Buffer&, dsample_t [], int );
+	void read_streams( dsample_t [], int );
+	void copy_outputs( dsample_t* const [], int out_pos, int pos, int count );
     void mix_samples( Stereo_Buffer&, dsample_t [], int, Stereo_Buffer**, int );
 	void mix_mono( Stereo_Buffer&, dsample_t [], int );
 	void mix_stereo( Stereo_Buffer&, dsample_t [], int );
 	void mix_extra_mono( Stereo_Buffer&, dsample_t [], int );
     void mix_extra_stereo( Stereo_Buffer&, dsample_t [], int );
     int play_frame_( Stereo_Buffer&, dsample_t [], Stereo_Buffer**, int );
+	int resampler_extra() const;
 };
 
 inline blargg_err_t Dual_Resampler::setup( double oversample, double rolloff, double gain )
 {
 	gain_ = (int) ((1 << gain_bits) * gain);
+	oversample_ = oversample;
+#if !GME_VGM_FAST_RESAMPLER
+	resampler.set_exact_ratio( true );
+#endif
 	return resampler.set_rate( oversample );
 }
 
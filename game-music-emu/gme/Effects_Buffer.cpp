@@ -2,6 +2,8 @@
 
 #include "Effects_Buffer.h"
 
+#include "State_Copier.h"
+
 /* Copyright (C) 2006-2007 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -156,6 +158,19 @@ void Effects_Buffer::clear()
 	clear_echo();
 }
 
+// Configuration isn't saved, so it must be the same when loading
+bool Effects_Buffer::copy_state( State_Copier& copier )
+{
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].copy_state( copier );
+	copier( mixer.samples_read );
+	copier( s.low_pass );
+	copier( echo_pos );
+	if ( echo.size() )
+		copier.copy( echo.begin(), echo.size() * sizeof echo [0] );
+	return true;
+}
+
 Effects_Buffer::channel_t Effects_Buffer::channel( int i )
 {
 	i += extra_chans;
@@ -493,9 +508,90 @@ int Effects_Buffer::read_samples( blip_sample_t out [], int out_size )
 	return out_size;
 }
 
-void Effects_Buffer::mix_effects( blip_sample_t out_ [], int pair_count )
+// Buffer integrators and echo low-pass filters are inherently serial, so they
+// run a block at a time into a temporary array; scaling by volume and clamping
+// to 16 bits then use vector instructions
+int const mix_block = 256;
+
+#if BLIP_SSE2
+	// Low 32 bits of products, which don't depend on signedness
+	static inline __m128i mul_lo32( __m128i a, __m128i b )
+	{
+		#if BLIP_SIMD_MUL
+			return _mm_mullo_epi32( a, b );
+		#else
+			__m128i even = _mm_mul_epu32( a, b );
+			__m128i odd  = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+			return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+					_mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+		#endif
+	}
+#endif
+
+// Adds in [i] * vol_0 and in [i] * vol_1 to pair i of out
+static void mix_pairs( int out [], int const in [], int count, int vol_0, int vol_1 )
+{
+	int i = 0;
+	
+	#if BLIP_SSE2
+		__m128i const vol = _mm_set_epi32( vol_1, vol_0, vol_1, vol_0 );
+		for ( ; i <= count - 4; i += 4 )
+		{
+			__m128i s = _mm_loadu_si128( (__m128i const*) &in [i] );
+			__m128i* p = (__m128i*) &out [i * 2];
+			__m128i lo = mul_lo32( _mm_unpacklo_epi32( s, s ), vol );
+			__m128i hi = mul_lo32( _mm_unpackhi_epi32( s, s ), vol );
+			_mm_storeu_si128( p,     _mm_add_epi32( _mm_loadu_si128( p     ), lo ) );
+			_mm_storeu_si128( p + 1, _mm_add_epi32( _mm_loadu_si128( p + 1 ), hi ) );
+		}
+	#elif BLIP_NEON
+		int32x2_t const vol_pair = vset_lane_s32( vol_1, vdup_n_s32( vol_0 ), 1 );
+		int32x4_t const vol = vcombine_s32( vol_pair, vol_pair );
+		for ( ; i <= count - 4; i += 4 )
+		{
+			int32x4_t s = vld1q_s32( &in [i] );
+			int32x4x2_t d = vzipq_s32( s, s );
+			int* p = &out [i * 2];
+			vst1q_s32( p,     vmlaq_s32( vld1q_s32( p     ), d.val [0], vol ) );
+			vst1q_s32( p + 4, vmlaq_s32( vld1q_s32( p + 4 ), d.val [1], vol ) );
+		}
+	#endif
+	
+	for ( ; i < count; i++ )
+	{
+		out [i * 2    ] += in [i] * vol_0;
+		out [i * 2 + 1] += in [i] * vol_1;
+	}
+}
+
+// Converts fixed-point samples to 16 bits
+static void clamp_fixed( int const in [], blip_sample_t out [], int count )
 {
-	typedef fixed_t stereo_fixed_t [stereo];
+	int i = 0;
+	
+	#if BLIP_SSE2
+		for ( ; i <= count - 8; i += 8 )
+		{
+			__m128i a = _mm_srai_epi32( _mm_loadu_si128( (__m128i const*) &in [i    ] ), fixed_shift );
+			__m128i b = _mm_srai_epi32( _mm_loadu_si128( (__m128i const*) &in [i + 4] ), fixed_shift );
+			_mm_storeu_si128( (__m128i*) &out [i], _mm_packs_epi32( a, b ) );
+		}
+	#elif BLIP_NEON
+		for ( ; i <= count - 4; i += 4 )
+			vst1_s16( &out [i], vqshrn_n_s32( vld1q_s32( &in [i] ), fixed_shift ) );
+	#endif
+	
+	for ( ; i < count; i++ )
+	{
+		int s = FROM_FIXED( in [i] );
+		BLIP_CLAMP( s, s );
+		out [i] = (blip_sample_t) s;
+	}
+}
+
+void Effects_Buffer::mix_effects( blip_sample_t out [], int pair_count )
+{
+	int temp [mix_block];
 	
 	// add channels with echo, do echo, add channels without echo, then convert to 16-bit and output
 	int echo_phase = 1;
@@ -509,12 +605,10 @@ void Effects_Buffer::mix_effects( blip_sample_t out_ [], int pair_count )
 			{
 				if ( buf->non_silent() && buf->echo == echo_phase )
 				{
-					stereo_fixed_t* BLARGG_RESTRICT out = (stereo_fixed_t*) &echo [echo_pos];
+					fixed_t* BLARGG_RESTRICT pos = &echo [echo_pos];
 					int const bass = BLIP_READER_BASS( *buf );
 					BLIP_READER_BEGIN( in, *buf );
 					BLIP_READER_ADJ_( in, mixer.samples_read );
-					fixed_t const vol_0 = buf->vol [0];
-					fixed_t const vol_1 = buf->vol [1];
 					
 					int count = (unsigned) (echo_size - echo_pos) / stereo;
 					int remain = pair_count;
@@ -523,21 +617,21 @@ void Effects_Buffer::mix_effects( blip_sample_t out_ [], int pair_count )
 					do
 					{
 						remain -= count;
-						BLIP_READER_ADJ_( in, count );
-						
-						out += count;
-						int offset = -count;
 						do
 						{
-							fixed_t s = BLIP_READER_READ( in );
-							BLIP_READER_NEXT_IDX_( in, bass, offset );
-							
-							out [offset] [0] += s * vol_0;
-							out [offset] [1] += s * vol_1;
+							int const n = min( count, mix_block );
+							for ( int i = 0; i < n; i++ )
+							{
+								temp [i] = BLIP_READER_READ( in );
+								BLIP_READER_NEXT( in, bass );
+							}
+							mix_pairs( pos, temp, n, buf->vol [0], buf->vol [1] );
+							pos   += n * stereo;
+							count -= n;
 						}
-						while ( ++offset );
+						while ( count );
 						
-						out = (stereo_fixed_t*) echo.begin();
+						pos = echo.begin();
 						count = remain;
 					}
 					while ( remain );
@@ -555,86 +649,75 @@ void Effects_Buffer::mix_effects( blip_sample_t out_ [], int pair_count )
 			fixed_t const feedback = s.feedback;
 			fixed_t const treble   = s.treble;
 			
-			int i = 1;
-			do
+			// Both channels are filtered in the same loop, so that their
+			// independent filters overlap. They use alternate samples, so
+			// neither writes where the other reads.
+			fixed_t const* echo_end [stereo];
+			fixed_t const* in_pos   [stereo];
+			fixed_t*       out_pos  [stereo];
+			for ( int i = stereo; --i >= 0; )
 			{
-				fixed_t low_pass = s.low_pass [i];
-				
-				fixed_t* echo_end = &echo [echo_size + i];
-				fixed_t const* BLARGG_RESTRICT in_pos = &echo [echo_pos + i];
+				echo_end [i] = &echo [echo_size + i];
+				in_pos   [i] = &echo [echo_pos + i];
 				int out_offset = echo_pos + i + s.delay [i];
 				if ( out_offset >= echo_size )
 					out_offset -= echo_size;
 				assert( out_offset < echo_size );
-				fixed_t* BLARGG_RESTRICT out_pos = &echo [out_offset];
+				out_pos  [i] = &echo [out_offset];
+			}
+			
+			fixed_t low_pass_0 = s.low_pass [0];
+			fixed_t low_pass_1 = s.low_pass [1];
+			
+			// break into chunks to avoid having to handle wrap-around in middle
+			// of core loop
+			int remain = pair_count;
+			do
+			{
+				int count = remain;
+				for ( int i = stereo; --i >= 0; )
+				{
+					fixed_t const* pos = in_pos [i];
+					if ( pos < out_pos [i] )
+						pos = out_pos [i];
+					int n = (int) (echo_end [i] - pos) / stereo;
+					if ( count > n )
+						count = n;
+				}
+				remain -= count;
 				
-				// break into up to three chunks to avoid having to handle wrap-around
-				// in middle of core loop
-				int remain = pair_count;
-				do
+				fixed_t const* BLARGG_RESTRICT in_0  = in_pos  [0];
+				fixed_t const* BLARGG_RESTRICT in_1  = in_pos  [1];
+				fixed_t*       BLARGG_RESTRICT out_0 = out_pos [0];
+				fixed_t*       BLARGG_RESTRICT out_1 = out_pos [1];
+				for ( int n = 0; n < count * stereo; n += stereo )
 				{
-					fixed_t const* pos = in_pos;
-					if ( pos < out_pos )
-						pos = out_pos;
-					int count = (unsigned) ((char*) echo_end - (char const*) pos) /
-							(unsigned) (stereo * sizeof (fixed_t));
-					if ( count > remain )
-						count = remain;
-					remain -= count;
-					
-					in_pos  += count * stereo;
-					out_pos += count * stereo;
-					int offset = -count;
-					do
-					{
-						low_pass += FROM_FIXED( in_pos [offset * stereo] - low_pass ) * treble;
-						out_pos [offset * stereo] = FROM_FIXED( low_pass ) * feedback;
-					}
-					while ( ++offset );
-					
-					if (  in_pos >= echo_end )  in_pos -= echo_size;
-					if ( out_pos >= echo_end ) out_pos -= echo_size;
+					low_pass_0 += FROM_FIXED( in_0 [n] - low_pass_0 ) * treble;
+					low_pass_1 += FROM_FIXED( in_1 [n] - low_pass_1 ) * treble;
+					out_0 [n] = FROM_FIXED( low_pass_0 ) * feedback;
+					out_1 [n] = FROM_FIXED( low_pass_1 ) * feedback;
 				}
-				while ( remain );
 				
-				s.low_pass [i] = low_pass;
+				for ( int i = stereo; --i >= 0; )
+				{
+					in_pos  [i] += count * stereo;
+					out_pos [i] += count * stereo;
+					if (  in_pos [i] >= echo_end [i] )  in_pos [i] -= echo_size;
+					if ( out_pos [i] >= echo_end [i] ) out_pos [i] -= echo_size;
+				}
 			}
-			while ( --i >= 0 );
+			while ( remain );
+			
+			s.low_pass [0] = low_pass_0;
+			s.low_pass [1] = low_pass_1;
 		}
 	}
 	while ( --echo_phase >= 0 );
 	
 	// clamp to 16 bits
 	{
-		stereo_fixed_t const* BLARGG_RESTRICT in = (stereo_fixed_t*) &echo [echo_pos];
-		typedef blip_sample_t stereo_blip_sample_t [stereo];
-		stereo_blip_sample_t* BLARGG_RESTRICT out = (stereo_blip_sample_t*) out_;
-		int count = (unsigned) (echo_size - echo_pos) / (unsigned) stereo;
-		int remain = pair_count;
-		if ( count > remain )
-			count = remain;
-		do
-		{
-			remain -= count;
-			in  += count;
-			out += count;
-			int offset = -count;
-			do
-			{
-				fixed_t in_0 = FROM_FIXED( in [offset] [0] );
-				fixed_t in_1 = FROM_FIXED( in [offset] [1] );
-				
-				BLIP_CLAMP( in_0, in_0 );
-				out [offset] [0] = (blip_sample_t) in_0;
-				
-				BLIP_CLAMP( in_1, in_1 );
-				out [offset] [1] = (blip_sample_t) in_1;
-			}
-			while ( ++offset );
-			
-			in = (stereo_fixed_t*) echo.begin();
-			count = remain;
-		}
-		while ( remain );
+		int count = min( pair_count * stereo, echo_size - echo_pos );
+		clamp_fixed( &echo [echo_pos], out, count );
+		clamp_fixed( echo.begin(), out + count, pair_count * stereo - count );
 	}
 }
@@ -65,6 +65,7 @@ public:
 	void end_frame( blip_time_t );
 	int read_samples( blip_sample_t [], int );
 	int samples_avail() const { return (bufs [0].samples_avail() - mixer.samples_read) * 2; }
+	bool copy_state( State_Copier& );
 	enum { stereo = 2 };
 	typedef int fixed_t;
 
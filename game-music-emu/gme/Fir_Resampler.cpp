@@ -2,8 +2,22 @@
 
 #include "Fir_Resampler.h"
 
+#include "State_Copier.h"
+
 #include <math.h>
 
+// SSE2 and NEON versions of the FIR loop, which give exactly the same output.
+// Define FIR_RESAMPLER_NO_SIMD to use only the plain C++ version.
+#if !FIR_RESAMPLER_NO_SIMD
+	#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <emmintrin.h>
+		#define FIR_SSE2 1
+	#elif (defined (__ARM_NEON) || defined (__ARM_NEON__)) && !defined (__ARM_BIG_ENDIAN)
+		#include <arm_neon.h>
+		#define FIR_NEON 1
+	#endif
+#endif
+
 /* Copyright (C) 2004-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -49,29 +63,61 @@ static void gen_sinc( double rolloff, int width, double offset, double spacing,
 	}
 }
 
-Fir_Resampler_::Fir_Resampler_( int width, sample_t impulses_ [] ) :
-	width_( width ),
-	impulses( impulses_ )
+Fir_Resampler_::Fir_Resampler_( int width ) :
+	default_width( adjust_width( width ) )
+{
+	width_ = default_width;
+	exact_ratio = false;
+	factor = 0.0;
+	imp    = NULL;
+}
+
+int Fir_Resampler_::adjust_width( int points )
 {
-	imp = NULL;
+	if ( points < 4 )
+		points = 4;
+	return points / 4 * 4 + 2;
 }
 
 void Fir_Resampler_::clear_()
 {
-	imp = impulses;
+	imp = impulses.begin();
 	Resampler::clear_();
 }
 
+void Fir_Resampler_::copy_state_( State_Copier& copier )
+{
+	copier( imp );
+}
+
+blargg_err_t Fir_Resampler_::set_width( int points )
+{
+	int new_width = (points ? adjust_width( points ) : default_width);
+	if ( new_width != width_ && rate() )
+	{
+		// keep old width if new impulses can't be allocated
+		int old_width = width_;
+		width_ = new_width;
+		blargg_err_t err = set_rate_( factor );
+		if ( err )
+			width_ = old_width;
+		return err;
+	}
+	width_ = new_width;
+	return blargg_ok;
+}
+
 blargg_err_t Fir_Resampler_::set_rate_( double new_factor )
 {
 	double const rolloff = 0.999;
 	double const gain = 1.0;
+	double const exact = 1e-9;
 	
 	// determine number of sub-phases that yield lowest error
 	double ratio_ = 0.0;
 	int res = -1;
+	double least_error = 2;
 	{
-		double least_error = 2;
 		double pos = 0;
 		for ( int r = 1; r <= max_res; r++ )
 		{
@@ -86,7 +132,23 @@ blargg_err_t Fir_Resampler_::set_rate_( double new_factor )
 			}
 		}
 	}
+	
+	// use more sub-phases if that gives ratio exactly, as for 44100 to 48000 Hz
+	for ( int r = max_res + 1; exact_ratio && least_error > exact && r <= max_exact_res; r++ )
+	{
+		double pos = new_factor * r;
+		double nearest = floor( pos + 0.5 );
+		if ( fabs( pos - nearest ) <= exact )
+		{
+			res = r;
+			ratio_ = nearest / res;
+			least_error = 0;
+		}
+	}
+	
+	RETURN_ERR( impulses.resize( res * (width_ + 2) ) );
 	RETURN_ERR( Resampler::set_rate_( ratio_ ) );
+	factor = new_factor;
 	
 	// how much of input is used for each output sample
 	int const step = stereo * (int) floor( ratio_ );
@@ -94,8 +156,7 @@ blargg_err_t Fir_Resampler_::set_rate_( double new_factor )
 	
 	double const filter = (ratio_ < 1.0) ? 1.0 : 1.0 / ratio_;
 	double pos = 0.0;
-	//int input_per_cycle = 0;
-	sample_t* out = impulses;
+	sample_t* out = impulses.begin();
 	for ( int n = res; --n >= 0; )
 	{
 		gen_sinc( rolloff, int (width_ * filter + 1) & ~1, pos, filter,
@@ -111,13 +172,119 @@ blargg_err_t Fir_Resampler_::set_rate_( double new_factor )
 		}
 		
 		*out++ = (cur_step - width_ * 2 + 4) * sizeof (sample_t);
-		*out++ = 4 * sizeof (sample_t);
-		//input_per_cycle += cur_step;
+		*out++ = 0;
 	}
-	// last offset moves back to beginning of impulses
-	out [-1] -= (char*) out - (char*) impulses;
 	
-	imp = impulses;
+	imp = impulses.begin();
 	
 	return blargg_ok;
 }
+
+Resampler::sample_t const* Fir_Resampler_::resample_( sample_t** out_,
+		sample_t const* out_end, sample_t const in [], int in_size )
+{
+	in_size -= width_ * stereo;
+	if ( in_size > 0 )
+	{
+		sample_t* BLARGG_RESTRICT out = *out_;
+		sample_t const* const in_end = in + in_size;
+		sample_t const* const imp_end = impulses.end();
+		sample_t const* imp = this->imp;
+		int const width = width_;
+		
+		do
+		{
+			if ( out >= out_end )
+				break;
+			
+			// accumulate in extended precision
+			int l, r;
+		#if FIR_SSE2
+			// Each 16-bit multiply-add sums two points of one channel, so
+			// swap middle samples of each group of four to put L L R R
+			__m128i sum = _mm_setzero_si128();
+			sample_t const* i = in;
+			sample_t const* p = imp;
+			for ( int n = (width - 2) / 4; n; --n )
+			{
+				__m128i s = _mm_loadu_si128( (__m128i const*) i );
+				s = _mm_shufflelo_epi16( s, 0xD8 );
+				s = _mm_shufflehi_epi16( s, 0xD8 );
+				__m128i k = _mm_loadl_epi64( (__m128i const*) p );
+				k = _mm_unpacklo_epi32( k, k );
+				sum = _mm_add_epi32( sum, _mm_madd_epi16( s, k ) );
+				i += 8;
+				p += 4;
+			}
+			
+			// last two points; the two values loaded after them in impulse
+			// are multiplied by zero
+			__m128i s = _mm_shufflelo_epi16( _mm_loadl_epi64( (__m128i const*) i ), 0xD8 );
+			__m128i k = _mm_loadl_epi64( (__m128i const*) p );
+			k = _mm_unpacklo_epi32( k, k );
+			sum = _mm_add_epi32( sum, _mm_madd_epi16( s, k ) );
+			
+			sum = _mm_add_epi32( sum, _mm_srli_si128( sum, 8 ) );
+			l = _mm_cvtsi128_si32( sum );
+			r = _mm_cvtsi128_si32( _mm_srli_si128( sum, 4 ) );
+		#elif FIR_NEON
+			int32x4_t suml = vdupq_n_s32( 0 );
+			int32x4_t sumr = vdupq_n_s32( 0 );
+			sample_t const* i = in;
+			sample_t const* p = imp;
+			for ( int n = (width - 2) / 4; n; --n )
+			{
+				int16x4x2_t s = vld2_s16( i );
+				int16x4_t k = vld1_s16( p );
+				suml = vmlal_s16( suml, s.val [0], k );
+				sumr = vmlal_s16( sumr, s.val [1], k );
+				i += 8;
+				p += 4;
+			}
+			int32x2_t lr = vpadd_s32(
+					vadd_s32( vget_low_s32( suml ), vget_high_s32( suml ) ),
+					vadd_s32( vget_low_s32( sumr ), vget_high_s32( sumr ) ) );
+			l = vget_lane_s32( lr, 0 ) + p [0] * i [0] + p [1] * i [2];
+			r = vget_lane_s32( lr, 1 ) + p [0] * i [1] + p [1] * i [3];
+		#else
+			sample_t const* i = in;
+			sample_t const* p = imp;
+			int pt = p [0];
+			l = pt * i [0];
+			r = pt * i [1];
+			for ( int n = (width - 2) / 2; n; --n )
+			{
+				pt = p [1];
+				l += pt * i [2];
+				r += pt * i [3];
+				
+				// pre-increment more efficient on some RISC processors
+				p += 2;
+				pt = p [0];
+				r += pt * i [5];
+				i += 4;
+				l += pt * i [0];
+			}
+			pt = p [1];
+			l += pt * i [2];
+			r += pt * i [3];
+		#endif
+			
+			// the "sample" after the end of the impulse gives the proper
+			// offset to the next input sample
+			in = (sample_t const*) ((char const*) (in + width * stereo - 4) + imp [width]);
+			imp += width + 2;
+			if ( imp >= imp_end )
+				imp = impulses.begin();
+			
+			out [0] = sample_t (l >> 15);
+			out [1] = sample_t (r >> 15);
+			out += 2;
+		}
+		while ( in < in_end );
+		
+		this->imp = imp;
+		*out_ = out;
+	}
+	return in;
+}
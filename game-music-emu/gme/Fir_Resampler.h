@@ -16,86 +16,60 @@ typedef Fir_Resampler<24> Fir_Resampler_Good;
 
 // Implementation
 class Fir_Resampler_ : public Resampler {
+public:
+	// Sets number of points in FIR, or 0 for the width resampler was created
+	// with. Takes effect immediately if rate has already been set, without
+	// changing rate().
+	blargg_err_t set_width( int points );
+
+	// Number of input samples held back until enough input follows them
+	int input_latency() const       { return width_ * stereo; }
+
+	// If true, set_rate() uses up to max_exact_res phases when that gives the
+	// ratio exactly, rather than approximating it with at most max_res. Meant for
+	// the final resampler to the output rate. Takes effect at next set_rate().
+	void set_exact_ratio( bool b )  { exact_ratio = b; }
+
+	// Makes next output sample fall at the same point between input samples as
+	// in other, which must have the same rate and width
+	void sync_phase( Fir_Resampler_ const& other ) { imp = impulses.begin() + (other.imp - other.impulses.begin()); }
+
 protected:
 	virtual blargg_err_t set_rate_( double );
 	virtual void clear_();
+	virtual void copy_state_( State_Copier& );
+	virtual sample_t const* resample_( sample_t**, sample_t const*, sample_t const [], int );
 
 protected:
 	enum { stereo = 2 };
-	enum { max_res = 32 }; // TODO: eliminate and keep impulses on freestore?
+
+	// Ratios that aren't a fraction with at most max_exact_res as denominator,
+	// or any ratio without set_exact_ratio(), are approximated by one with at
+	// most max_res
+	enum { max_res = 32 };
+	enum { max_exact_res = 512 };
+
+	Fir_Resampler_( int width );
+
+private:
+	// Each phase is width_ points followed by amount to move input by in bytes,
+	// then padding
+	blargg_vector<sample_t> impulses;
 	sample_t const* imp;
-	int const width_;
-	sample_t* impulses;
-	
-	Fir_Resampler_( int width, sample_t [] );
+	int const default_width;
+	int width_;
+	bool exact_ratio;
+	double factor; // rate requested, which rate() approximates
+
+	static int adjust_width( int points );
 };
 
 // Width is number of points in FIR. More points give better quality and
 // rolloff effectiveness, and take longer to calculate.
 template<int width>
 class Fir_Resampler : public Fir_Resampler_ {
-	enum { min_width = (width < 4 ? 4 : width) };
-	enum { adj_width = min_width / 4 * 4 + 2 };
-	enum { write_offset = adj_width * stereo };
-	short impulses [max_res * (adj_width + 2)];
 public:
-	Fir_Resampler() : Fir_Resampler_( adj_width, impulses ) { }
-
-protected:
-	virtual sample_t const* resample_( sample_t**, sample_t const*, sample_t const [], int );
+	Fir_Resampler() : Fir_Resampler_( width ) { }
 };
 
-template<int width>
-Resampler::sample_t const* Fir_Resampler<width>::resample_( sample_t** out_,
-		sample_t const* out_end, sample_t const in [], int in_size )
-{
-	in_size -= write_offset;
-	if ( in_size > 0 )
-	{
-		sample_t* BLARGG_RESTRICT out = *out_;
-		sample_t const* const in_end = in + in_size;
-		sample_t const* imp = this->imp;
-		
-		do
-		{
-			// accumulate in extended precision
-			int pt = imp [0];
-			int l = pt * in [0];
-			int r = pt * in [1];
-			if ( out >= out_end )
-				break;
-			for ( int n = (adj_width - 2) / 2; n; --n )
-			{
-				pt = imp [1];
-				l += pt * in [2];
-				r += pt * in [3];
-				
-				// pre-increment more efficient on some RISC processors
-				imp += 2;
-				pt = imp [0];
-				r += pt * in [5];
-				in += 4;
-				l += pt * in [0];
-			}
-			pt = imp [1];
-			l += pt * in [2];
-			r += pt * in [3];
-			
-			// these two "samples" after the end of the impulse give the
-			// proper offsets to the next input sample and next impulse
-			in  = (sample_t const*) ((char const*) in  + imp [2]); // some negative value
-			imp = (sample_t const*) ((char const*) imp + imp [3]); // small positive or large negative
-			
-			out [0] = sample_t (l >> 15);
-			out [1] = sample_t (r >> 15);
-			out += 2;
-		}
-		while ( in < in_end );
-		
-		this->imp = imp;
-		*out_ = out;
-	}
-	return in;
-}
-
 #endif
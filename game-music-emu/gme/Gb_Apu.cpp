@@ -1,6 +1,7 @@
 // Gb_Snd_Emu $vers. http://www.slack.net/~ant/
 
 #include "Gb_Apu.h"
+#include "State_Copier.h"
 
 //#include "gb_apu_logger.h"
 
@@ -405,3 +406,16 @@ int Gb_Apu::read_register( blip_time_t time, int addr )
 	
 	return data;
 }
+
+void Gb_Apu::copy_state( State_Copier& copier )
+{
+	copier( square1 );
+	copier( square2 );
+	copier( wave );
+	copier( noise );
+	copier( last_time );
+	copier( frame_period );
+	copier( frame_time );
+	copier( frame_phase );
+	copier( regs );
+}
@@ -5,6 +5,7 @@
 #define GB_APU_H
 
 #include "Gb_Oscs.h"
+#include "State_Copier.h"
 
 struct gb_apu_state_t;
 
@@ -83,6 +84,10 @@ public:
 	
 	// Loads state. You should call reset() BEFORE this.
 	blargg_err_t load_state( gb_apu_state_t const& in );
+	
+	// Saves/restores exact emulation state to/from same object, without any
+	// conversion (see State_Copier.h)
+	void copy_state( State_Copier& );
 
 private:
 	// noncopyable
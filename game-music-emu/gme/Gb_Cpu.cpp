@@ -35,6 +35,7 @@ void Gb_Cpu::reset( void* unmapped )
 		set_code_page( i, unmapped );
 	
 	memset( &r, 0, sizeof r );
+	spin.reset();
 	
 	blargg_verify_byte_order();
 }
@@ -5,6 +5,8 @@
 #define GB_CPU_H
 
 #include "blargg_common.h"
+#include "State_Copier.h"
+#include "Spin_Detector.h"
 
 class Gb_Cpu {
 public:
@@ -39,6 +41,9 @@ public:
 	// Base address for RST vectors, to simplify GBS player (normally 0)
 	addr_t rst_base;
 	
+	// Finds busy-wait loops so their time can be skipped. Cleared by reset().
+	Spin_Detector spin;
+	
 	// Current time.
 	int time() const { return cpu_state->time; }
 	
@@ -46,6 +51,10 @@ public:
 	// Should be negative, because emulation stops once it becomes >= 0.
 	void set_time( int t ) { cpu_state->time = t; }
 	
+	// Saves/restores registers, memory mapping and timing. Must not be called
+	// during emulation.
+	void copy_state( State_Copier& );
+	
 	// Emulator reads this many bytes past end of a page
 	enum { cpu_padding = 8 };
 
@@ -79,4 +88,12 @@ inline BOOST::uint8_t* Gb_Cpu::get_code( addr_t addr )
 	return cpu_state_.code_map [GB_CPU_PAGE( addr )] + GB_CPU_OFFSET( addr );
 }
 
+inline void Gb_Cpu::copy_state( State_Copier& copier )
+{
+	assert( cpu_state == &cpu_state_ );
+	copier( r );
+	copier( rst_base );
+	copier( cpu_state_ );
+}
+
 #endif
@@ -20,6 +20,11 @@ so they must NOT be parenthesized.
 
 	// Often-used instructions use this instead of READ_MEM
 	void READ_FAST( addr_t, int& out );
+	
+	// True if reading any address from first to last has no side effects and gives
+	// the same value until CPU writes there, so busy-wait loops reading them can be
+	// skipped. Optional; defaults to false.
+	bool CAN_SKIP_READS( addr_t first, addr_t last );
 
 // The following can be used within macros:
 	
@@ -68,6 +73,10 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 #define CODE_PAGE( addr )   s.code_map [GB_CPU_PAGE( addr )]
 #define READ_CODE( addr )   (CODE_PAGE( addr ) [GB_CPU_OFFSET( addr )])
 
+#ifndef CAN_SKIP_READS
+	#define CAN_SKIP_READS( first, last ) 0
+#endif
+
 // Flags with hex value for clarity when used as mask.
 // Stored in indicated variable during emulation.
 int const z80 = 0x80; // cz
@@ -145,6 +154,12 @@ int const c10 = 0x10; // cz
 	
 	int time = s.time;
 	
+	// Busy-wait loop detection. Any jump other than a short one backwards clears
+	// spin_key, so while it's unchanged, CPU has only run forward through loop.
+	int spin_end   = 0;  // end of last instruction that jumped back
+	int spin_key   = -1; // identifies loop CPU is in
+	int spin_count = 0;  // passes until its registers are checked
+	
 loop:
 	
 	check( (unsigned) pc < 0x10000 + 1 ); // +1 so emulator can catch wrap-around
@@ -229,8 +244,11 @@ loop:
 	pc++;\
 	if ( !(cond) )\
 		goto loop;\
+	spin_end = pc;\
 	pc = WORD( pc + SBYTE( data ) );\
 	time += clocks;\
+	if ( SBYTE( data ) < 0 )\
+		goto jumped_back;\
 	goto loop;\
 }
 
@@ -335,6 +353,7 @@ loop:
 		data = pc + 2;
 		pc = GET_ADDR();
 	push: {
+		spin_key = -1;
 		int addr = WORD( sp - 1 );
 		WRITE_MEM( addr, (data >> 8) );
 		sp = WORD( sp - 2 );
@@ -353,6 +372,7 @@ loop:
 		int addr = sp + 1;
 		sp = WORD( sp + 2 );
 		pc += 0x100 * READ_MEM( addr );
+		spin_key = -1;
 		goto loop;
 	}
 	
@@ -1066,10 +1086,14 @@ loop:
 	
 	case 0xE9: // LD PC,HL
 		pc = rp.hl;
+		spin_key = -1;
 		goto loop;
 
 	case 0xC3: // JP (next-most-common)
+		spin_end = pc + 2;
 		pc = GET_ADDR();
+		if ( pc < spin_end )
+			goto jumped_back;
 		goto loop;
 	
 	case 0xC2: // JP NZ
@@ -1087,8 +1111,11 @@ loop:
 		goto loop;
 	
 	jp_taken:
+		spin_end = pc;
 		pc -= 2;
 		pc = GET_ADDR();
+		if ( pc < spin_end )
+			goto jumped_back;
 		goto loop;
 	
 	case 0xD2: // JP NC
@@ -1165,6 +1192,54 @@ loop:
 	
 	// If this fails then an opcode isn't handled above
 	assert( false );
+	goto stop;
+	
+jumped_back:
+	// Every few passes of a short loop, checks whether it's only waiting for the
+	// end of emulation, and if so skips its whole periods
+	if ( (unsigned) (spin_end - pc) <= Spin_Detector::max_size )
+	{
+		int key = (spin_end - pc) << 16 | pc;
+		if ( spin_key != key )
+		{
+			spin_key   = key;
+			spin_count = Spin_Detector::check_interval - 1;
+			CPU.spin.forget();
+		}
+		
+		if ( --spin_count < 0 )
+		{
+			spin_count = Spin_Detector::check_interval - 1;
+			int const regs [] = { rp.bc, rp.de, rp.hl, rg.a, sp, cz, ph };
+			if ( CPU.spin.repeated( regs, sizeof regs / sizeof *regs, time ) )
+			{
+				// Instructions must have no side effects, and branches within
+				// loop must go to one of them
+				int addr = pc;
+				unsigned starts  = 0;
+				unsigned targets = 0;
+				while ( addr < spin_end )
+				{
+					Spin_Detector::instr_t in = Spin_Detector::decode_lr35902( addr, &READ_CODE( addr ) );
+					if ( !in.size )
+						break;
+					if ( in.read == Spin_Detector::mem_read &&
+							!CAN_SKIP_READS( in.addr, in.addr + in.span - 1 ) )
+						break;
+					starts |= 1u << (addr - pc);
+					if ( (unsigned) (in.target - pc) < (unsigned) (spin_end - pc) )
+						targets |= 1u << (in.target - pc);
+					addr += in.size;
+				}
+				
+				if ( addr == spin_end && !(targets & ~starts) )
+					time += CPU.spin.skip( -time );
+				else
+					spin_count = INT_MAX; // don't check again
+			}
+		}
+	}
+	goto loop;
 	
 stop:
 	pc--;
@@ -24,6 +24,7 @@ int const bank_size = 0x4000;
 Gbs_Core::Gbs_Core() : rom( bank_size )
 {
 	tempo = tempo_unit;
+	loop_detector = NULL;
 	assert( offsetof (header_t,copyright [32]) == header_t::size );
 }
 
@@ -43,7 +44,11 @@ bool Gbs_Core::header_t::valid_tag() const
 
 blargg_err_t Gbs_Core::load_( Data_Reader& in )
 {
-	RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
+	// Use file data in place if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( rom.borrow( file_begin(), file_size(), header_.size, &header_, 0 ) );
+	else
+		RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
 	
 	if ( !header_.valid_tag() )
 		return blargg_err_file_type;
@@ -206,3 +211,13 @@ blargg_err_t Gbs_Core::end_frame( int end )
 	
 	return blargg_ok;
 }
+
+void Gbs_Core::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	apu_.copy_state( copier );
+	copier( ram );
+	copier( end_time );
+	copier( play_period_ );
+	copier( next_play );
+}
@@ -8,6 +8,7 @@
 #include "Rom_Data.h"
 #include "Gb_Cpu.h"
 #include "Gb_Apu.h"
+class Loop_Detector;
 
 class Gbs_Core : public Gme_Loader {
 public:
@@ -54,8 +55,18 @@ public:
 	typedef int time_t; // clock count
 	blargg_err_t end_frame( time_t t );
 	
+	// Saves/restores CPU, memory and sound chip state between time frames
+	// (see State_Copier.h)
+	void copy_state( State_Copier& );
+	
 	// Clocks between calls to play routine
 	time_t play_period() const          { return play_period_; }
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
 	
 protected:
 	typedef int addr_t;
@@ -92,6 +103,7 @@ private:
 	time_t    end_time;
 	time_t    play_period_;
 	time_t    next_play;
+	Loop_Detector* loop_detector;
 	header_t  header_;
 	Gb_Cpu    cpu;
 	Gb_Apu    apu_;
@@ -2,6 +2,7 @@
 
 #include "Gbs_Core.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 
 //#include "gb_cpu_log.h"
@@ -42,7 +43,11 @@ int Gbs_Core::read_mem( addr_t addr )
 inline void Gbs_Core::write_io_inline( int offset, int data, int base )
 {
 	if ( (unsigned) (offset - (apu_.io_addr - base)) < apu_.io_size )
+	{
+		if ( loop_detector )
+			loop_detector->write( time(), offset + base, data );
 		apu_.write_register( time(), offset + base, data & 0xFF );
+	}
 	else if ( (unsigned) (offset - (0xFF06 - base)) < 2 )
 		update_timer();
 	else if ( offset == io_base - base )
@@ -119,6 +124,9 @@ int Gbs_Core::read_io( int offset )
 		check( out == read_mem( addr ) );\
 }
 
+// anything but I/O registers
+#define CAN_SKIP_READS( first, last ) ((unsigned) (last) < 0xFF00 || (first) >= 0xFF80)
+
 #define READ_MEM(  addr       ) read_mem( addr )
 #define WRITE_MEM( addr, data ) write_mem( addr, data )
 
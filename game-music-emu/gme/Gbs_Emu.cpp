@@ -109,7 +109,11 @@ gme_type_t_ const gme_gbs_type [1] = {{ "Game Boy", 0, &new_gbs_emu, &new_gbs_fi
 
 blargg_err_t Gbs_Emu::load_( Data_Reader& in )
 {
-	RETURN_ERR( core_.load( in ) );
+	// Core can use file data in place too if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( core_.load_mem( file_begin(), file_size() ) );
+	else
+		RETURN_ERR( core_.load( in ) );
 	set_warning( core_.warning() );
 	set_track_count( header().track_count );
 	set_voice_count( Gb_Apu::osc_count );
@@ -160,6 +164,24 @@ blargg_err_t Gbs_Emu::run_clocks( blip_time_t& duration, int )
 	return core_.end_frame( duration );
 }
 
+bool Gbs_Emu::copy_core_state( State_Copier& copier )
+{
+	core_.copy_state( copier );
+	return true;
+}
+
+bool Gbs_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core_.set_loop_detector( d );
+	return true;
+}
+
+void Gbs_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core_.spin_detector().hits();
+	*clocks_skipped = core_.spin_detector().clocks_skipped();
+}
+
 blargg_err_t Gbs_Emu::hash_( Hash_Function& out ) const
 {
 	hash_gbs_file( header(), core_.rom_().begin(), core_.rom_().file_size(), out );
@@ -0,0 +1,264 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Gme_Batch.h"
+
+#include "Music_Emu.h"
+#include <string.h>
+
+#if !GME_DISABLE_THREADS
+	#include <thread>
+#endif
+
+#include "blargg_source.h"
+
+// Samples per play() call. Smaller values measure length more precisely,
+// since a track only ends at a call boundary.
+int const buf_size = 1024;
+
+#if !GME_DISABLE_THREADS
+	#define LOCK_WORKER( w ) std::lock_guard<std::mutex> lock_( (w).mutex )
+#else
+	#define LOCK_WORKER( w )
+#endif
+
+Gme_Batch::Gme_Batch()
+{
+	memset( &setup_, 0, sizeof setup_ );
+	workers      = NULL;
+	worker_count = 0;
+	handler      = NULL;
+}
+
+Gme_Batch::~Gme_Batch()
+{
+	free_workers();
+}
+
+void Gme_Batch::free_workers()
+{
+	for ( int i = 0; i < worker_count; i++ )
+		delete workers [i].emu;
+	delete [] workers;
+	workers      = NULL;
+	worker_count = 0;
+}
+
+bool Gme_Batch::take_job( int w, int* job )
+{
+	for ( int i = 0; i < worker_count; i++ )
+	{
+		worker_t& v = workers [(w + i) % worker_count];
+		LOCK_WORKER( v );
+		if ( v.next < v.end )
+		{
+			*job = (i == 0 ? v.next++ : --v.end);
+			return true;
+		}
+	}
+	return false;
+}
+
+void Gme_Batch::work( int w )
+{
+	int job;
+	while ( take_job( w, &job ) )
+		(this->*handler)( workers [w], job );
+}
+
+void Gme_Batch::run_jobs( int count, handler_t h )
+{
+	handler = h;
+	for ( int i = 0; i < worker_count; i++ )
+	{
+		workers [i].next = (int) ((long long) count * i / worker_count);
+		workers [i].end  = (int) ((long long) count * (i + 1) / worker_count);
+	}
+
+#if !GME_DISABLE_THREADS
+	// Jobs of any threads that can't be started are stolen by the others
+	int started = 0;
+	std::thread* threads = BLARGG_NEW std::thread [worker_count];
+	while ( threads && started < worker_count - 1 )
+	{
+		#if __cpp_exceptions || __EXCEPTIONS || _CPPUNWIND
+			try {
+				threads [started] = std::thread( &Gme_Batch::work, this, started + 1 );
+			}
+			catch ( ... ) {
+				break;
+			}
+		#else
+			threads [started] = std::thread( &Gme_Batch::work, this, started + 1 );
+		#endif
+		started++;
+	}
+
+	work( 0 );
+
+	for ( int i = 0; i < started; i++ )
+		threads [i].join();
+	delete [] threads;
+#else
+	work( 0 );
+#endif
+}
+
+blargg_err_t Gme_Batch::load_file( worker_t& w, int index )
+{
+	if ( w.loaded == index )
+		return blargg_ok;
+	w.loaded = -1;
+
+	file_t const& f = setup_.files [index];
+	gme_type_t type = NULL;
+	if ( f.data && f.size >= 4 )
+		type = gme_identify_extension( gme_identify_header( f.data ) );
+	if ( !type )
+		return blargg_err_file_type;
+
+	// Reuse emulator if it's the right type
+	if ( !w.emu || w.emu->type() != type )
+	{
+		delete w.emu;
+		CHECK_ALLOC( w.emu = gme_new_emu( type, setup_.sample_rate ) );
+	}
+
+	Mem_File_Reader in( f.data, f.size );
+	RETURN_ERR( w.emu->load( in ) );
+	w.loaded = index;
+	return blargg_ok;
+}
+
+void Gme_Batch::count_tracks( worker_t& w, int file )
+{
+	blargg_err_t err = load_file( w, file );
+	file_errors  [file] = err;
+	track_counts [file] = (err ? 0 : w.emu->track_count());
+}
+
+blargg_err_t Gme_Batch::play_track_( worker_t& w, result_t& r )
+{
+	RETURN_ERR( load_file( w, r.file ) );
+	Music_Emu& emu = *w.emu;
+
+	track_info_t info;
+	RETURN_ERR( emu.track_info( &info, r.track ) );
+	if ( info.loop_length > 0 )
+	{
+		r.loop_start  = info.intro_length;
+		r.loop_length = info.loop_length;
+	}
+	else
+	{
+		// find loop from sound chip writes if emulator can, as estimate_length()
+		// does, but without playing track a second time if it can't
+		Music_Emu::length_estimate_t est;
+		est.method = gme_length_limit;
+		bool supported;
+		RETURN_ERR( emu.dry_run_estimate( r.track, setup_.max_length, &est, &supported ) );
+		if ( supported && est.method == gme_length_looped )
+		{
+			r.loop_start  = est.loop_start;
+			r.loop_length = est.loop_length;
+		}
+	}
+
+	RETURN_ERR( emu.start_track( r.track ) );
+	Music_Emu::sample_t buf [buf_size];
+	while ( !emu.track_ended() && emu.tell() < setup_.max_length )
+		RETURN_ERR( emu.play( buf_size, buf ) );
+
+	int silence;
+	if ( emu.ended_on_silence( &silence ) )
+	{
+		r.ended_on_silence = true;
+		r.length = silence;
+	}
+	else if ( !emu.track_ended() )
+	{
+		r.reached_limit = true;
+		r.length = setup_.max_length;
+	}
+	else
+	{
+		r.length = emu.tell();
+	}
+	return blargg_ok;
+}
+
+void Gme_Batch::play_track( worker_t& w, int index )
+{
+	result_t& r = results [index];
+	if ( r.track >= 0 )
+		r.error = play_track_( w, r );
+}
+
+blargg_err_t Gme_Batch::run( setup_t const& s )
+{
+	free_workers();
+	results.clear();
+	setup_ = s;
+
+	int n = s.thread_count;
+	#if GME_DISABLE_THREADS
+		n = 1;
+	#else
+		if ( n <= 0 )
+			n = std::thread::hardware_concurrency();
+	#endif
+	if ( n < 1 )
+		n = 1;
+	CHECK_ALLOC( workers = BLARGG_NEW worker_t [n] );
+	worker_count = n;
+	for ( int i = 0; i < n; i++ )
+	{
+		workers [i].emu    = NULL;
+		workers [i].loaded = -1;
+	}
+
+	// Load each file to find its track count
+	RETURN_ERR( file_errors.resize( s.file_count ) );
+	RETURN_ERR( track_counts.resize( s.file_count ) );
+	run_jobs( s.file_count, &Gme_Batch::count_tracks );
+
+	// One result per track, or one for a file that couldn't be loaded
+	int total = 0;
+	for ( int i = 0; i < s.file_count; i++ )
+		total += (file_errors [i] ? 1 : track_counts [i]);
+	RETURN_ERR( results.resize( total ) );
+
+	result_t* r = results.begin();
+	for ( int i = 0; i < s.file_count; i++ )
+	{
+		int tracks = (file_errors [i] ? 1 : track_counts [i]);
+		for ( int t = 0; t < tracks; t++, r++ )
+		{
+			memset( r, 0, sizeof *r );
+			r->file        = i;
+			r->track       = (file_errors [i] ? -1 : t);
+			r->error       = file_errors [i];
+			r->length      = -1;
+			r->loop_start  = -1;
+			r->loop_length = -1;
+		}
+	}
+
+	run_jobs( total, &Gme_Batch::play_track );
+	return blargg_ok;
+}
+
+blargg_err_t Gme_Batch::take_results( result_t** out, int* count )
+{
+	*out   = NULL;
+	*count = 0;
+	if ( !results.size() )
+		return blargg_ok;
+
+	result_t* p = (result_t*) malloc( results.size() * sizeof *p );
+	CHECK_ALLOC( p );
+	memcpy( p, results.begin(), results.size() * sizeof *p );
+	*out   = p;
+	*count = (int) results.size();
+	results.clear();
+	return blargg_ok;
+}
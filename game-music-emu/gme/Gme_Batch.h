@@ -0,0 +1,76 @@
+// Plays many files on a pool of threads to measure their tracks
+
+// Game_Music_Emu $vers
+#ifndef GME_BATCH_H
+#define GME_BATCH_H
+
+#include "blargg_common.h"
+#include "gme.h"
+
+#if !GME_DISABLE_THREADS
+	#include <mutex>
+#endif
+
+class Gme_Batch {
+public:
+	typedef gme_batch_file_t file_t;
+	typedef gme_track_analysis_t result_t;
+
+	struct setup_t {
+		file_t const* files;    // must remain valid until run() returns
+		int file_count;
+		int sample_rate;
+		int max_length;         // msec
+		int thread_count;       // 0 for one per processor
+	};
+
+	// Plays every track of every file until it ends or reaches max_length.
+	// Results are ordered by file then track.
+	blargg_err_t run( setup_t const& );
+
+	// Moves results into a malloc()ed array, which is NULL if there are none
+	blargg_err_t take_results( result_t** out, int* count );
+
+public:
+	Gme_Batch();
+	~Gme_Batch();
+
+private:
+	// Each worker has a range of jobs, taken in order so that it can reuse its
+	// emulator for consecutive tracks of a file. Idle workers steal jobs from
+	// the end of others' ranges.
+	struct worker_t {
+		int next;
+		int end;
+		gme_t* emu;
+		int loaded;         // file currently in emu, or -1
+	#if !GME_DISABLE_THREADS
+		std::mutex mutex;
+	#endif
+	};
+
+	typedef void (Gme_Batch::*handler_t)( worker_t&, int job );
+
+	setup_t setup_;
+	worker_t* workers;
+	int worker_count;
+	handler_t handler;
+	blargg_vector<blargg_err_t> file_errors;
+	blargg_vector<int> track_counts;
+	blargg_vector<result_t> results;
+
+	void run_jobs( int count, handler_t );
+	void work( int worker );
+	bool take_job( int worker, int* job );
+	blargg_err_t load_file( worker_t&, int file );
+	void count_tracks( worker_t&, int file );
+	void play_track( worker_t&, int result );
+	blargg_err_t play_track_( worker_t&, result_t& );
+	void free_workers();
+
+	// noncopyable
+	Gme_Batch( const Gme_Batch& );
+	Gme_Batch& operator = ( const Gme_Batch& );
+};
+
+#endif
@@ -135,6 +135,7 @@ extern const gme_type_t_
 	gme_nsf_type [1],
 	gme_nsfe_type [1],
 	gme_sap_type [1],
+	gme_sfm_type [1],
 	gme_sgc_type [1],
 	gme_spc_type [1],
 	gme_vgm_type [1],
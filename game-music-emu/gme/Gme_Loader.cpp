@@ -3,6 +3,7 @@
 #include "Gme_Loader.h"
 
 #include "blargg_endian.h"
+#include <stdio.h>
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -22,11 +23,15 @@ void Gme_Loader::unload()
 	file_begin_ = NULL;
 	file_end_   = NULL;
 	file_data.clear();
+	kept_data.clear();
+	gzip_stream.clear();
 }
 
 Gme_Loader::Gme_Loader()
 {
 	warning_ = NULL;
+	keep_file_data_ = false;
+	stream_gzip_    = false;
 	Gme_Loader::unload();
 	blargg_verify_byte_order(); // used by most emulator types, so save them the trouble
 }
@@ -54,6 +59,17 @@ blargg_err_t Gme_Loader::load_( Data_Reader& in )
 	return load_mem_wrapper( file_data.begin(), file_data.size() );
 }
 
+blargg_err_t Gme_Loader::load_reader( Data_Reader& in )
+{
+	if ( !keep_file_data_ )
+		return load_( in );
+	
+	// read everything, then load from memory so file_begin() stays valid
+	RETURN_ERR( kept_data.resize( in.remain() ) );
+	RETURN_ERR( in.read( kept_data.begin(), kept_data.size() ) );
+	return load_mem_wrapper( kept_data.begin(), kept_data.size() );
+}
+
 blargg_err_t Gme_Loader::post_load_( blargg_err_t err )
 {
 	if ( err )
@@ -71,16 +87,76 @@ blargg_err_t Gme_Loader::load_mem( void const* in, long size )
 	return post_load_( load_mem_wrapper( (byte const*) in, (int) size ) );
 }
 
+blargg_err_t Gme_Loader::load_gzip_( byte const data [], long size, bool borrow )
+{
+	if ( stream_gzip_ && !keep_file_data_ && !gzip_stream.begin( data, size, borrow ) )
+		return load_mem_wrapper( gzip_stream.data(), gzip_stream.size() );
+	
+	// inflate all of it now
+	Mem_File_Reader in( data, size );
+	return load_reader( in );
+}
+
+blargg_err_t Gme_Loader::load_gzip( void const* data, long size )
+{
+	pre_load();
+	return post_load_( load_gzip_( (byte const*) data, size, false ) );
+}
+
+blargg_err_t Gme_Loader::load_gzip_borrowed( void const* data, long size )
+{
+	pre_load();
+	return post_load_( load_gzip_( (byte const*) data, size, true ) );
+}
+
+// Reads gzipped file without inflating it. Leaves out empty if file isn't gzipped.
+static blargg_err_t read_gzip_file( const char path [], blargg_vector<BOOST::uint8_t>& out )
+{
+	FILE* file = fopen( path, "rb" );
+	if ( !file )
+		return blargg_err_file_missing;
+	
+	blargg_err_t err = blargg_ok;
+	BOOST::uint8_t sig [2];
+	if ( fread( sig, sizeof sig, 1, file ) && sig [0] == 0x1F && sig [1] == 0x8B )
+	{
+		long size = -1;
+		if ( !fseek( file, 0, SEEK_END ) )
+			size = ftell( file );
+		
+		err = blargg_err_file_read;
+		if ( size > 0 && !fseek( file, 0, SEEK_SET ) )
+		{
+			err = out.resize( size );
+			if ( !err && !fread( out.begin(), size, 1, file ) )
+				err = blargg_err_file_read;
+		}
+	}
+	fclose( file );
+	return err;
+}
+
 blargg_err_t Gme_Loader::load( Data_Reader& in )
 {
 	pre_load();
-	return post_load_( load_( in ) );
+	return post_load_( load_reader( in ) );
 }
 
 blargg_err_t Gme_Loader::load_file( const char path [] )
 {
 	pre_load();
+	
+	#ifdef HAVE_ZLIB_H
+		if ( stream_gzip_ && !keep_file_data_ )
+		{
+			blargg_vector<byte> gz;
+			RETURN_ERR( read_gzip_file( path, gz ) );
+			if ( gz.size() )
+				return post_load_( load_gzip_( gz.begin(), gz.size(), false ) );
+		}
+	#endif
+	
 	GME_FILE_READER in;
 	RETURN_ERR( in.open( path ) );
-	return post_load_( load_( in ) );
+	return post_load_( load_reader( in ) );
 }
@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Data_Reader.h"
+#include "Gzip_Stream.h"
 
 class Gme_Loader {
 public:
@@ -24,6 +25,14 @@ public:
 	// data; if it does, you MUST NOT free it until you're done with the file.
 	blargg_err_t load_mem( void const* data, long size );
 	
+	// Loads from gzipped file data in memory, which is copied. Emulators that
+	// support it inflate only what they need to start, then the rest as they go.
+	blargg_err_t load_gzip( void const* data, long size );
+	
+	// Same as load_gzip(), but data is used in place and MUST NOT be freed until
+	// you're done with the file
+	blargg_err_t load_gzip_borrowed( void const* data, long size );
+	
 	// Most recent warning string, or NULL if none. Clears current warning after
 	// returning.
 	const char* warning();
@@ -44,6 +53,18 @@ protected:
 	// Sets warning string
 	void set_warning( const char s [] ) { warning_ = s; }
 	
+	// Keeps copy of file data in memory when loading from a file or Data_Reader,
+	// so that file_begin() is always available. Takes effect on next load.
+	void keep_file_data( bool b = true ) { keep_file_data_ = b; }
+	
+	// Lets gzipped files be inflated as they're used rather than all at once.
+	// load_mem_() is then passed the full inflated size, but only the part
+	// file_stream() has made available is valid. Takes effect on next load.
+	void stream_gzip( bool b = true )   { stream_gzip_ = b; }
+	
+	// Inflater of current file if it's being streamed, otherwise NULL
+	Gzip_Stream* file_stream()          { return (gzip_stream.size() ? &gzip_stream : NULL); }
+	
 	// At least one must be overridden
 	virtual blargg_err_t load_( Data_Reader& ); // default loads then calls load_mem_()
 	virtual blargg_err_t load_mem_( byte const data [], int size ); // use data in memory
@@ -63,11 +84,17 @@ public:
 	BLARGG_DISABLE_NOTHROW
 	
 	blargg_vector<byte> file_data; // used only when loading from file to load_mem_()
+	blargg_vector<byte> kept_data; // used only when keep_file_data() is set
+	Gzip_Stream gzip_stream;       // used only when stream_gzip() is set
 	byte const* file_begin_;
 	byte const* file_end_;
 	const char* warning_;
+	bool keep_file_data_;
+	bool stream_gzip_;
 	
+	blargg_err_t load_gzip_( byte const [], long, bool borrow );
 	blargg_err_t load_mem_wrapper( byte const [], int );
+	blargg_err_t load_reader( Data_Reader& );
 	blargg_err_t post_load_( blargg_err_t err );
 };
 
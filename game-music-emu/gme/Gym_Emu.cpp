@@ -153,14 +153,14 @@ struct Gym_File : Gme_Info_
 		get_gym_info( *(Gym_Emu::header_t const*) file_begin(), length, out );
 		return blargg_ok;
 	}
-
+	
 	blargg_err_t hash_( Hash_Function& out ) const
 	{
 		Gym_Emu::header_t const* h = ( Gym_Emu::header_t const* ) file_begin();
 		byte const* data = &file_begin() [data_offset];
-
+		
 		hash_gym_file( *h, data, file_end() - data, out );
-
+		
 		return blargg_ok;
 	}
 };
@@ -220,6 +220,16 @@ void Gym_Emu::mute_voices_( int mask )
 	pcm_synth.volume( (mask & 0x40) ? 0.0 : 0.125 / 256 * fm_gain * gain() );
 }
 
+blargg_err_t Gym_Emu::set_ym2612_core_( int c )
+{
+	return fm.set_core( (Ym2612_Emu::core_t) c );
+}
+
+blargg_err_t Gym_Emu::set_resampler_width_( int points )
+{
+	return resampler.set_width( points );
+}
+
 blargg_err_t Gym_Emu::load_mem_( byte const in [], int size )
 {
 	assert( offsetof (header_t,packed [4]) == header_t::size );
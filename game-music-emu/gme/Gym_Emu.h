@@ -53,6 +53,8 @@ protected:
 	virtual blargg_err_t play_( int count, sample_t [] );
 	virtual void mute_voices_( int );
 	virtual void set_tempo_( double );
+	virtual blargg_err_t set_ym2612_core_( int );
+	virtual blargg_err_t set_resampler_width_( int );
 
 private:
 	// Log
@@ -0,0 +1,131 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Gzip_Stream.h"
+
+#include "blargg_endian.h"
+#include <string.h>
+
+#include "blargg_source.h"
+
+Gzip_Stream::Gzip_Stream()
+{
+	size_  = 0;
+	avail_ = 0;
+	#ifdef HAVE_ZLIB_H
+		zs_open = false;
+	#endif
+}
+
+Gzip_Stream::~Gzip_Stream()
+{
+	clear();
+}
+
+bool Gzip_Stream::is_gzip( void const* data, long size )
+{
+	byte const* p = (byte const*) data;
+	return size >= 18 && p [0] == 0x1F && p [1] == 0x8B;
+}
+
+void Gzip_Stream::clear()
+{
+	#ifdef HAVE_ZLIB_H
+		if ( zs_open )
+			inflateEnd( &zs );
+		zs_open = false;
+	#endif
+	in.clear();
+	out.clear();
+	size_  = 0;
+	avail_ = 0;
+}
+
+blargg_err_t Gzip_Stream::begin( void const* data, long size, bool borrow )
+{
+	clear();
+	if ( !is_gzip( data, size ) )
+		return blargg_err_file_type;
+
+#ifdef HAVE_ZLIB_H
+	// Footer has size of inflated data, modulo 4 GB
+	long out_size = get_le32( (byte const*) data + size - 4 );
+	if ( out_size <= 0 || out_size > 0x7FFFFFFF - min_fill )
+		return blargg_err_file_corrupt;
+
+	// Allocating doesn't touch the memory, so most systems don't commit pages
+	// until they're written
+	RETURN_ERR( out.resize( out_size ) );
+	byte const* in_data = (byte const*) data;
+	if ( !borrow )
+	{
+		RETURN_ERR( in.resize( size ) );
+		memcpy( in.begin(), data, size );
+		in_data = in.begin();
+	}
+
+	memset( &zs, 0, sizeof zs );
+	zs.next_in  = (Bytef*) in_data;
+	zs.avail_in = (uInt) size;
+
+	// Adding 16 tells zlib to expect gzip header
+	if ( inflateInit2( &zs, 16 + MAX_WBITS ) != Z_OK )
+	{
+		clear();
+		return blargg_err_memory;
+	}
+	zs_open = true;
+	size_   = out_size;
+	return blargg_ok;
+#else
+	return blargg_err_file_feature;
+#endif
+}
+
+blargg_err_t Gzip_Stream::fill( long n )
+{
+	if ( n <= avail_ )
+		return blargg_ok;
+
+	n = max( n, avail_ + min_fill );
+	if ( n > size_ )
+		n = size_;
+
+	blargg_err_t err = blargg_ok;
+#ifdef HAVE_ZLIB_H
+	zs.next_out  = out.begin() + avail_;
+	zs.avail_out = (uInt) (n - avail_);
+	while ( zs.avail_out )
+	{
+		int result = inflate( &zs, Z_SYNC_FLUSH );
+		if ( result == Z_STREAM_END )
+			break;
+
+		if ( result != Z_OK )
+		{
+			err = blargg_err_file_corrupt;
+			break;
+		}
+	}
+	avail_ = n - zs.avail_out;
+#endif
+
+	if ( avail_ < n )
+	{
+		// Ended early; zero-fill the rest rather than leave it unset
+		memset( out.begin() + avail_, 0, size_ - avail_ );
+		avail_ = size_;
+		if ( !err )
+			err = blargg_err_file_eof;
+	}
+
+	#ifdef HAVE_ZLIB_H
+		if ( avail_ >= size_ && zs_open )
+		{
+			// Done with compressed data
+			inflateEnd( &zs );
+			zs_open = false;
+			in.clear();
+		}
+	#endif
+	return err;
+}
@@ -0,0 +1,66 @@
+// Inflates gzipped data a piece at a time, as it's needed
+
+// Game_Music_Emu $vers
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include "blargg_common.h"
+
+#ifdef HAVE_ZLIB_H
+	#include <zlib.h>
+#endif
+
+class Gzip_Stream {
+public:
+	typedef BOOST::uint8_t byte;
+
+	// True if data begins with gzip signature
+	static bool is_gzip( void const* data, long size );
+
+	// Begins inflating copy of gzipped data. Inflated size is taken from the gzip
+	// footer and space for all of it is allocated now, so pointers into data()
+	// remain valid as more is inflated. Fails if zlib isn't available. If borrow
+	// is true, data is used in place and MUST remain valid until all of it has
+	// been inflated or clear() is called.
+	blargg_err_t begin( void const* data, long size, bool borrow = false );
+
+	// Inflates until at least the first n bytes are available, or all of them if n
+	// is more than size(). If data is corrupt, the remainder is filled with zero
+	// bytes and an error is returned.
+	blargg_err_t fill( long n );
+
+	// Inflates the remainder
+	blargg_err_t fill_all()             { return fill( size_ ); }
+
+	// Inflated data, of which only the first avail() bytes are valid so far
+	byte const* data() const            { return out.begin(); }
+	long size() const                   { return size_; }
+	long avail() const                  { return avail_; }
+
+	// Frees memory
+	void clear();
+
+public:
+	Gzip_Stream();
+	~Gzip_Stream();
+
+private:
+	// Minimum inflated by fill(), to keep overhead of calls low
+	enum { min_fill = 64 * 1024 };
+
+	blargg_vector<byte> in;
+	blargg_vector<byte> out;
+	long size_;
+	long avail_;
+
+#ifdef HAVE_ZLIB_H
+	z_stream zs;
+	bool zs_open;
+#endif
+
+	// noncopyable
+	Gzip_Stream( const Gzip_Stream& );
+	Gzip_Stream& operator = ( const Gzip_Stream& );
+};
+
+#endif
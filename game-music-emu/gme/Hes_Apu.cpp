@@ -1,6 +1,7 @@
 // Game_Music_Emu $vers. http://www.slack.net/~ant/
 
 #include "Hes_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -359,3 +360,10 @@ void Hes_Apu::end_frame( blip_time_t end_time )
 		check( osc->last_time >= 0 );
 	}
 }
+
+void Hes_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( latch );
+	copier( balance );
+}
@@ -1,6 +1,7 @@
 // Game_Music_Emu $vers. http://www.slack.net/~ant/
 
 #include "Hes_Apu_Adpcm.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -307,3 +308,11 @@ int Hes_Apu_Adpcm::adpcm_decode( int code )
 
 	return state.ad_sample;
 }
+
+void Hes_Apu_Adpcm::copy_state( State_Copier& copier )
+{
+	copier( state );
+	copier( last_time );
+	copier( next_timer );
+	copier( last_amp );
+}
@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 class Hes_Apu_Adpcm {
 public:
@@ -30,6 +31,9 @@ public:
 	// Resets sound chip
 	void reset();
 	
+	// Saves/restores emulation state (see State_Copier.h)
+	void copy_state( State_Copier& );
+	
 	// Same as set_output(), but for a particular channel
 	enum { osc_count = 1 }; // 0 <= chan < osc_count
 	void set_output( int chan, Blip_Buffer* center, Blip_Buffer* left = NULL, Blip_Buffer* right = NULL );
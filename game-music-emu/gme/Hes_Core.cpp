@@ -2,6 +2,7 @@
 
 #include "Hes_Core.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
@@ -27,6 +28,7 @@ int const period_60hz = 262 * 455; // scanlines * clocks per scanline
 Hes_Core::Hes_Core() : rom( Hes_Cpu::page_size )
 {
 	timer.raw_load = 0;
+	loop_detector  = NULL;
 }
 
 Hes_Core::~Hes_Core() { }
@@ -45,7 +47,11 @@ bool Hes_Core::header_t::valid_tag() const
 blargg_err_t Hes_Core::load_( Data_Reader& in )
 {
 	assert( offsetof (header_t,unused [4]) == header_t::size );
-	RETURN_ERR( rom.load( in, header_t::size, &header_, unmapped ) );
+	// Use file data in place if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( rom.borrow( file_begin(), file_size(), header_t::size, &header_, unmapped ) );
+	else
+		RETURN_ERR( rom.load( in, header_t::size, &header_, unmapped ) );
 	
 	if ( !header_.valid_tag() )
 		return blargg_err_file_type;
@@ -197,12 +203,16 @@ void Hes_Core::write_mem_( addr_t addr, int data )
 		// Not a problem for other registers below because they don't write to
 		// Blip_Buffer.
 		time_t t = min( time, cpu.end_time() + 8 );
+		if ( loop_detector )
+			loop_detector->write( t, addr, data );
         apu_.write_data( t, addr, data );
 		return;
 	}
 	if ( (unsigned) (addr - adpcm_.io_addr) < adpcm_.io_size )
 	{
 		time_t t = min( time, cpu.end_time() + 6 );
+		if ( loop_detector )
+			loop_detector->write( t, addr, data );
         adpcm_.write_data( t, addr, data );
 		return;
 	}
@@ -406,3 +416,18 @@ blargg_err_t Hes_Core::end_frame( time_t duration )
 	
 	return blargg_ok;
 }
+
+void Hes_Core::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	apu_.copy_state( copier );
+	adpcm_.copy_state( copier );
+	copier( play_period );
+	copier( timer_base );
+	copier( timer );
+	copier( vdp );
+	copier( irq );
+	copier( write_pages ); // point into ram/sgx
+	copier( ram );
+	copier( sgx );
+}
@@ -9,6 +9,7 @@
 #include "Hes_Apu.h"
 #include "Hes_Apu_Adpcm.h"
 #include "Hes_Cpu.h"
+class Loop_Detector;
 
 class Hes_Core : public Gme_Loader {
 public:
@@ -55,6 +56,16 @@ public:
 	// Ends time frame at time t
 	typedef int time_t;
 	blargg_err_t end_frame( time_t );
+	
+	// Saves/restores CPU, memory and sound chip state between time frames
+	// (see State_Copier.h)
+	void copy_state( State_Copier& );
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
 
 // Implementation
 public:
@@ -74,6 +85,7 @@ private:
 	header_t header_;
 	time_t   play_period;
 	int      timer_base;
+	Loop_Detector* loop_detector;
 	
 	struct {
 		time_t last_time;
@@ -109,6 +109,10 @@ end:
 #define CPU_DONE( result_out )      { FLUSH_TIME(); result_out = cpu_done(); CACHE_TIME(); }
 #define SET_MMR( reg, bank )        set_mmr( reg, bank )
 
+// anything but hardware page
+#define CAN_SKIP_READS( first, last ) \
+	(CPU.mmr [PAGE( first )] != 0xFF && CPU.mmr [PAGE( last )] != 0xFF)
+
 #define CPU         cpu
 #define IDLE_ADDR   idle_addr
 
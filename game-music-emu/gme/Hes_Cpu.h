@@ -5,6 +5,8 @@
 #define HES_CPU_H
 
 #include "blargg_common.h"
+#include "State_Copier.h"
+#include "Spin_Detector.h"
 
 class Hes_Cpu {
 public:
@@ -55,6 +57,13 @@ public:
 	// Subtracts t from all times
 	void end_frame( time_t t );
 	
+	// Finds busy-wait loops so their time can be skipped. Cleared by reset().
+	Spin_Detector spin;
+	
+	// Saves/restores registers, memory mapping and timing. Must not be called
+	// during emulation.
+	void copy_state( State_Copier& );
+	
 	// Can read this many bytes past end of a page
 	enum { cpu_padding = 8 };
 	
@@ -126,6 +135,16 @@ inline void Hes_Cpu::end_frame( time_t t )
 	if ( end_time_ < future_time ) end_time_ -= t;
 }
 
+inline void Hes_Cpu::copy_state( State_Copier& copier )
+{
+	assert( cpu_state == &cpu_state_ );
+	copier( r );
+	copier( mmr );
+	copier( cpu_state_ );
+	copier( irq_time_ );
+	copier( end_time_ );
+}
+
 inline void Hes_Cpu::set_mmr( int reg, int bank, void const* code )
 {
 	assert( (unsigned) reg <= page_count ); // allow page past end to be set
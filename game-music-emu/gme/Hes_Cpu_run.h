@@ -28,6 +28,11 @@ CACHE_TIME() allow the time changing functions to work.
 	// 0 <= addr <= 2
 	// ST0, ST1, ST2 instructions
 	void WRITE_VDP( int addr, int data );
+	
+	// True if reading any address from first to last has no side effects and gives
+	// the same value until CPU writes there, so busy-wait loops reading them can be
+	// skipped. Optional; defaults to false.
+	bool CAN_SKIP_READS( addr_t first, addr_t last );
 
 // The following can be used within macros:
 	
@@ -72,6 +77,7 @@ void Hes_Cpu::reset()
 	cpu_state_.base = 0;
 	irq_time_   = future_time;
 	end_time_   = future_time;
+	spin.reset();
 	
 	r.flags = 0x04;
 	r.sp    = 0;
@@ -98,6 +104,10 @@ void Hes_Cpu::reset()
 #define READ_STACK          READ_LOW
 #define WRITE_STACK         WRITE_LOW
 
+#ifndef CAN_SKIP_READS
+	#define CAN_SKIP_READS( first, last ) 0
+#endif
+
 #define CODE_PAGE( addr )   s.code_map [HES_CPU_PAGE( addr )]
 #define CODE_OFFSET( addr ) HES_CPU_OFFSET( addr )
 #define READ_CODE( addr )   CODE_PAGE( addr ) [CODE_OFFSET( addr )]
@@ -165,6 +175,12 @@ bool illegal_encountered = false;
 		SET_FLAGS( temp );
 	}
 	
+	// Busy-wait loop detection. Any jump other than a short one backwards clears
+	// spin_key, so while it's unchanged, CPU has only run forward through loop.
+	int spin_end   = 0;  // end of last instruction that jumped back
+	int spin_key   = -1; // identifies loop CPU is in
+	int spin_count = 0;  // passes until its registers are checked
+	
 loop:
 	
 	#ifndef NDEBUG
@@ -242,10 +258,55 @@ loop:
 	int data;
 	data = *instr;
 	
+	#if GME_COMPUTED_GOTO
+		// Jump straight to instruction's case below
+		static void* const instrs [256] = {
+			&&op_00, &&op_01, &&op_02, &&op_03, &&op_04, &&op_05, &&op_06, &&op_07,
+			&&op_08, &&op_09, &&op_0A, &&op_default, &&op_0C, &&op_0D, &&op_0E, &&op_0F,
+			&&op_10, &&op_11, &&op_12, &&op_13, &&op_14, &&op_15, &&op_16, &&op_17,
+			&&op_18, &&op_19, &&op_1A, &&op_default, &&op_1C, &&op_1D, &&op_1E, &&op_1F,
+			&&op_20, &&op_21, &&op_22, &&op_23, &&op_24, &&op_25, &&op_26, &&op_27,
+			&&op_28, &&op_29, &&op_2A, &&op_default, &&op_2C, &&op_2D, &&op_2E, &&op_2F,
+			&&op_30, &&op_31, &&op_32, &&op_default, &&op_34, &&op_35, &&op_36, &&op_37,
+			&&op_38, &&op_39, &&op_3A, &&op_default, &&op_3C, &&op_3D, &&op_3E, &&op_3F,
+			&&op_40, &&op_41, &&op_42, &&op_43, &&op_44, &&op_45, &&op_46, &&op_47,
+			&&op_48, &&op_49, &&op_4A, &&op_default, &&op_4C, &&op_4D, &&op_4E, &&op_4F,
+			&&op_50, &&op_51, &&op_52, &&op_53, &&op_54, &&op_55, &&op_56, &&op_57,
+			&&op_58, &&op_59, &&op_5A, &&op_default, &&op_default, &&op_5D, &&op_5E, &&op_5F,
+			&&op_60, &&op_61, &&op_62, &&op_default, &&op_64, &&op_65, &&op_66, &&op_67,
+			&&op_68, &&op_69, &&op_6A, &&op_default, &&op_6C, &&op_6D, &&op_6E, &&op_6F,
+			&&op_70, &&op_71, &&op_72, &&op_73, &&op_74, &&op_75, &&op_76, &&op_77,
+			&&op_78, &&op_79, &&op_7A, &&op_default, &&op_7C, &&op_7D, &&op_7E, &&op_7F,
+			&&op_80, &&op_81, &&op_82, &&op_83, &&op_84, &&op_85, &&op_86, &&op_87,
+			&&op_88, &&op_89, &&op_8A, &&op_default, &&op_8C, &&op_8D, &&op_8E, &&op_8F,
+			&&op_90, &&op_91, &&op_92, &&op_93, &&op_94, &&op_95, &&op_96, &&op_97,
+			&&op_98, &&op_99, &&op_9A, &&op_default, &&op_9C, &&op_9D, &&op_9E, &&op_9F,
+			&&op_A0, &&op_A1, &&op_A2, &&op_A3, &&op_A4, &&op_A5, &&op_A6, &&op_A7,
+			&&op_A8, &&op_A9, &&op_AA, &&op_default, &&op_AC, &&op_AD, &&op_AE, &&op_AF,
+			&&op_B0, &&op_B1, &&op_B2, &&op_B3, &&op_B4, &&op_B5, &&op_B6, &&op_B7,
+			&&op_B8, &&op_B9, &&op_BA, &&op_default, &&op_BC, &&op_BD, &&op_BE, &&op_BF,
+			&&op_C0, &&op_C1, &&op_C2, &&op_C3, &&op_C4, &&op_C5, &&op_C6, &&op_C7,
+			&&op_C8, &&op_C9, &&op_CA, &&op_default, &&op_CC, &&op_CD, &&op_CE, &&op_CF,
+			&&op_D0, &&op_D1, &&op_D2, &&op_D3, &&op_D4, &&op_D5, &&op_D6, &&op_D7,
+			&&op_D8, &&op_D9, &&op_DA, &&op_default, &&op_default, &&op_DD, &&op_DE, &&op_DF,
+			&&op_E0, &&op_E1, &&op_default, &&op_E3, &&op_E4, &&op_E5, &&op_E6, &&op_E7,
+			&&op_E8, &&op_E9, &&op_EA, &&op_default, &&op_EC, &&op_ED, &&op_EE, &&op_EF,
+			&&op_F0, &&op_F1, &&op_F2, &&op_F3, &&op_F4, &&op_F5, &&op_F6, &&op_F7,
+			&&op_F8, &&op_F9, &&op_FA, &&op_default, &&op_default, &&op_FD, &&op_FE, &&op_FF
+		};
+		goto *instrs [opcode];
+	#endif
+	
 	switch ( opcode )
 	{
 // Macros
 
+#if GME_COMPUTED_GOTO
+	#define OP( n ) case 0x##n: op_##n
+#else
+	#define OP( n ) case 0x##n
+#endif
+
 #define GET_MSB()       (instr [1])
 #define ADD_PAGE( out ) (pc++, out = data + 0x100 * GET_MSB());
 #define GET_ADDR()      GET_LE16( instr )
@@ -261,42 +322,45 @@ loop:
 {\
 	pc++;\
 	if ( !(cond) ) goto loop;\
+	spin_end = pc;\
 	pc = (BOOST::uint16_t) (pc + SBYTE( data ));\
 	s_time += adj;\
+	if ( SBYTE( data ) < 0 )\
+		goto jumped_back;\
 	goto loop;\
 }
 
 #define BRANCH( cond ) BRANCH_( cond, 2 )
 
-	case 0xF0: // BEQ
+	OP( F0 ): // BEQ
 		BRANCH( !BYTE( nz ) );
 	
-	case 0xD0: // BNE
+	OP( D0 ): // BNE
 		BRANCH( BYTE( nz ) );
 	
-	case 0x10: // BPL
+	OP( 10 ): // BPL
 		BRANCH( !IS_NEG );
 	
-	case 0x90: // BCC
+	OP( 90 ): // BCC
 		BRANCH( !(c & 0x100) )
 	
-	case 0x30: // BMI
+	OP( 30 ): // BMI
 		BRANCH( IS_NEG )
 	
-	case 0x50: // BVC
+	OP( 50 ): // BVC
 		BRANCH( !(flags & v40) )
 	
-	case 0x70: // BVS
+	OP( 70 ): // BVS
 		BRANCH( flags & v40 )
 	
-	case 0xB0: // BCS
+	OP( B0 ): // BCS
 		BRANCH( c & 0x100 )
 	
-	case 0x80: // BRA
+	OP( 80 ): // BRA
 	branch_taken:
 		BRANCH_( true, 0 );
 	
-	case 0xFF:
+	OP( FF ):
 		#ifdef IDLE_ADDR
 			if ( pc == IDLE_ADDR + 1 )
 				goto idle_done;
@@ -304,21 +368,21 @@ loop:
 
 		pc = (BOOST::uint16_t) pc;
 
-	case 0x0F: // BBRn
-	case 0x1F:
-	case 0x2F:
-	case 0x3F:
-	case 0x4F:
-	case 0x5F:
-	case 0x6F:
-	case 0x7F:
-	case 0x8F: // BBSn
-	case 0x9F:
-	case 0xAF:
-	case 0xBF:
-	case 0xCF:
-	case 0xDF:
-	case 0xEF: {
+	OP( 0F ): // BBRn
+	OP( 1F ):
+	OP( 2F ):
+	OP( 3F ):
+	OP( 4F ):
+	OP( 5F ):
+	OP( 6F ):
+	OP( 7F ):
+	OP( 8F ): // BBSn
+	OP( 9F ):
+	OP( AF ):
+	OP( BF ):
+	OP( CF ):
+	OP( DF ):
+	OP( EF ): {
 		// Make two copies of bits, one negated
 		int t = 0x101 * READ_LOW( data );
 		t ^= 0xFF;
@@ -327,47 +391,53 @@ loop:
 		BRANCH( t & (1 << (opcode >> 4)) )
 	}
 	
-	case 0x4C: // JMP abs
+	OP( 4C ): // JMP abs
+		spin_end = pc + 2;
 		pc = GET_ADDR();
+		if ( pc < spin_end )
+			goto jumped_back;
 		goto loop;
 	
-	case 0x7C: // JMP (ind+X)
+	OP( 7C ): // JMP (ind+X)
 		data += x;
-	case 0x6C:{// JMP (ind)
+	OP( 6C ):{// JMP (ind)
 		data += 0x100 * GET_MSB();
 		pc = GET_LE16( &READ_CODE( data ) );
+		spin_key = -1;
 		goto loop;
 	}
 	
 // Subroutine
 
-	case 0x44: // BSR
+	OP( 44 ): // BSR
 		WRITE_STACK( SP( -1 ), pc >> 8 );
 		sp = SP( -2 );
 		WRITE_STACK( sp, pc );
 		goto branch_taken;
 	
-	case 0x20: { // JSR
+	OP( 20 ): { // JSR
 		int temp = pc + 1;
 		pc = GET_ADDR();
+		spin_key = -1;
 		WRITE_STACK( SP( -1 ), temp >> 8 );
 		sp = SP( -2 );
 		WRITE_STACK( sp, temp );
 		goto loop;
 	}
 	
-	case 0x60: // RTS
+	OP( 60 ): // RTS
 		pc = 1 + READ_STACK( sp );
 		pc += 0x100 * READ_STACK( SP( 1 ) );
 		sp = SP( 2 );
+		spin_key = -1;
 		goto loop;
 	
-	case 0x00: // BRK
+	OP( 00 ): // BRK
 		goto handle_brk;
 	
 // Common
 
-	case 0xBD:{// LDA abs,X
+	OP( BD ):{// LDA abs,X
 		PAGE_PENALTY( data + x );
 		int addr = GET_ADDR() + x;
 		pc += 2;
@@ -376,21 +446,21 @@ loop:
 		goto loop;
 	}
 	
-	case 0x9D:{// STA abs,X
+	OP( 9D ):{// STA abs,X
 		int addr = GET_ADDR() + x;
 		pc += 2;
 		WRITE_FAST( addr, a );
 		goto loop;
 	}
 	
-	case 0x95: // STA zp,x
+	OP( 95 ): // STA zp,x
 		data = BYTE( data + x );
-	case 0x85: // STA zp
+	OP( 85 ): // STA zp
 		pc++;
 		WRITE_LOW( data, a );
 		goto loop;
 	
-	case 0xAE:{// LDX abs
+	OP( AE ):{// LDX abs
 		int addr = GET_ADDR();
 		pc += 2;
 		READ_FAST( addr, nz );
@@ -398,7 +468,7 @@ loop:
 		goto loop;
 	}
 	
-	case 0xA5: // LDA zp
+	OP( A5 ): // LDA zp
 		a = nz = READ_LOW( data );
 		pc++;
 		goto loop;
@@ -407,23 +477,23 @@ loop:
 	
 	{
 		int addr;
-	case 0x91: // STA (ind),Y
+	OP( 91 ): // STA (ind),Y
 		addr = 0x100 * READ_LOW( BYTE( data + 1 ) );
 		addr += READ_LOW( data ) + y;
 		pc++;
 		goto sta_ptr;
 	
-	case 0x81: // STA (ind,X)
+	OP( 81 ): // STA (ind,X)
 		data = BYTE( data + x );
-	case 0x92: // STA (ind)
+	OP( 92 ): // STA (ind)
 		addr = 0x100 * READ_LOW( BYTE( data + 1 ) );
 		addr += READ_LOW( data );
 		pc++;
 		goto sta_ptr;
 	
-	case 0x99: // STA abs,Y
+	OP( 99 ): // STA abs,Y
 		data += y;
-	case 0x8D: // STA abs
+	OP( 8D ): // STA abs
 		addr = data + 0x100 * GET_MSB();
 		pc += 2;
 	sta_ptr:
@@ -433,25 +503,25 @@ loop:
 	
 	{
 		int addr;
-	case 0xA1: // LDA (ind,X)
+	OP( A1 ): // LDA (ind,X)
 		data = BYTE( data + x );
-	case 0xB2: // LDA (ind)
+	OP( B2 ): // LDA (ind)
 		addr = 0x100 * READ_LOW( BYTE( data + 1 ) );
 		addr += READ_LOW( data );
 		pc++;
 		goto a_nz_read_addr;
 	
-	case 0xB1:// LDA (ind),Y
+	OP( B1 ):// LDA (ind),Y
 		addr = READ_LOW( data ) + y;
 		PAGE_PENALTY( addr );
 		addr += 0x100 * READ_LOW( BYTE( data + 1 ) );
 		pc++;
 		goto a_nz_read_addr;
 	
-	case 0xB9: // LDA abs,Y
+	OP( B9 ): // LDA abs,Y
 		data += y;
 		PAGE_PENALTY( data );
-	case 0xAD: // LDA abs
+	OP( AD ): // LDA abs
 		addr = data + 0x100 * GET_MSB();
 		pc += 2;
 	a_nz_read_addr:
@@ -460,7 +530,7 @@ loop:
 		goto loop;
 	}
 
-	case 0xBE:{// LDX abs,y
+	OP( BE ):{// LDX abs,y
 		PAGE_PENALTY( data + y );
 		int addr = GET_ADDR() + y;
 		pc += 2;
@@ -470,12 +540,12 @@ loop:
 		goto loop;
 	}
 	
-	case 0xB5: // LDA zp,x
+	OP( B5 ): // LDA zp,x
 		a = nz = READ_LOW( BYTE( data + x ) );
 		pc++;
 		goto loop;
 	
-	case 0xA9: // LDA #imm
+	OP( A9 ): // LDA #imm
 		pc++;
 		a  = data;
 		nz = data;
@@ -483,9 +553,9 @@ loop:
 
 // Bit operations
 
-	case 0x3C: // BIT abs,x
+	OP( 3C ): // BIT abs,x
 		data += x;
-	case 0x2C:{// BIT abs
+	OP( 2C ):{// BIT abs
 		int addr;
 		ADD_PAGE( addr );
 		FLUSH_TIME();
@@ -493,11 +563,11 @@ loop:
 		CACHE_TIME();
 		goto bit_common;
 	}
-	case 0x34: // BIT zp,x
+	OP( 34 ): // BIT zp,x
 		data = BYTE( data + x );
-	case 0x24: // BIT zp
+	OP( 24 ): // BIT zp
 		data = READ_LOW( data );
-	case 0x89: // BIT imm
+	OP( 89 ): // BIT imm
 		nz = data;
 	bit_common:
 		pc++;
@@ -510,11 +580,11 @@ loop:
 	{
 		int addr;
 		
-	case 0xB3: // TST abs,x
+	OP( B3 ): // TST abs,x
 		addr = GET_MSB() + x;
 		goto tst_abs;
 	
-	case 0x93: // TST abs
+	OP( 93 ): // TST abs
 		addr = GET_MSB();
 	tst_abs:
 		addr += 0x100 * instr [2];
@@ -525,11 +595,11 @@ loop:
 		goto tst_common;
 	}
 	
-	case 0xA3: // TST zp,x
+	OP( A3 ): // TST zp,x
 		nz = READ_LOW( BYTE( GET_MSB() + x ) );
 		goto tst_common;
 	
-	case 0x83: // TST zp
+	OP( 83 ): // TST zp
 		nz = READ_LOW( GET_MSB() );
 	tst_common:
 		pc += 2;
@@ -541,15 +611,15 @@ loop:
 	
 	{
 		int addr;
-	case 0x0C: // TSB abs
-	case 0x1C: // TRB abs
+	OP( 0C ): // TSB abs
+	OP( 1C ): // TRB abs
 		addr = GET_ADDR();
 		pc++;
 		goto txb_addr;
 	
 	// TODO: everyone lists different behaviors for the flags flags, ugh
-	case 0x04: // TSB zp
-	case 0x14: // TRB zp
+	OP( 04 ): // TSB zp
+	OP( 14 ): // TRB zp
 		addr = data + ram_addr;
 	txb_addr:
 		FLUSH_TIME();
@@ -563,35 +633,35 @@ loop:
 		goto loop;
 	}
 	
-	case 0x07: // RMBn
-	case 0x17:
-	case 0x27:
-	case 0x37:
-	case 0x47:
-	case 0x57:
-	case 0x67:
-	case 0x77:
+	OP( 07 ): // RMBn
+	OP( 17 ):
+	OP( 27 ):
+	OP( 37 ):
+	OP( 47 ):
+	OP( 57 ):
+	OP( 67 ):
+	OP( 77 ):
 		pc++;
 		READ_LOW( data ) &= ~(1 << (opcode >> 4));
 		goto loop;
 	
-	case 0x87: // SMBn
-	case 0x97:
-	case 0xA7:
-	case 0xB7:
-	case 0xC7:
-	case 0xD7:
-	case 0xE7:
-	case 0xF7:
+	OP( 87 ): // SMBn
+	OP( 97 ):
+	OP( A7 ):
+	OP( B7 ):
+	OP( C7 ):
+	OP( D7 ):
+	OP( E7 ):
+	OP( F7 ):
 		pc++;
 		READ_LOW( data ) |= 1 << ((opcode >> 4) - 8);
 		goto loop;
 	
 // Load/store
 	
-	case 0x9E: // STZ abs,x
+	OP( 9E ): // STZ abs,x
 		data += x;
-	case 0x9C: // STZ abs
+	OP( 9C ): // STZ abs
 		ADD_PAGE( data );
 		pc++;
 		FLUSH_TIME();
@@ -599,51 +669,51 @@ loop:
 		CACHE_TIME();
 		goto loop;
 	
-	case 0x74: // STZ zp,x
+	OP( 74 ): // STZ zp,x
 		data = BYTE( data + x );
-	case 0x64: // STZ zp
+	OP( 64 ): // STZ zp
 		pc++;
 		WRITE_LOW( data, 0 );
 		goto loop;
 	
-	case 0x94: // STY zp,x
+	OP( 94 ): // STY zp,x
 		data = BYTE( data + x );
-	case 0x84: // STY zp
+	OP( 84 ): // STY zp
 		pc++;
 		WRITE_LOW( data, y );
 		goto loop;
 	
-	case 0x96: // STX zp,y
+	OP( 96 ): // STX zp,y
 		data = BYTE( data + y );
-	case 0x86: // STX zp
+	OP( 86 ): // STX zp
 		pc++;
 		WRITE_LOW( data, x );
 		goto loop;
 	
-	case 0xB6: // LDX zp,y
+	OP( B6 ): // LDX zp,y
 		data = BYTE( data + y );
-	case 0xA6: // LDX zp
+	OP( A6 ): // LDX zp
 		data = READ_LOW( data );
-	case 0xA2: // LDX #imm
+	OP( A2 ): // LDX #imm
 		pc++;
 		x = data;
 		nz = data;
 		goto loop;
 	
-	case 0xB4: // LDY zp,x
+	OP( B4 ): // LDY zp,x
 		data = BYTE( data + x );
-	case 0xA4: // LDY zp
+	OP( A4 ): // LDY zp
 		data = READ_LOW( data );
-	case 0xA0: // LDY #imm
+	OP( A0 ): // LDY #imm
 		pc++;
 		y = data;
 		nz = data;
 		goto loop;
 	
-	case 0xBC: // LDY abs,X
+	OP( BC ): // LDY abs,X
 		data += x;
 		PAGE_PENALTY( data );
-	case 0xAC:{// LDY abs
+	OP( AC ):{// LDY abs
 		int addr = data + 0x100 * GET_MSB();
 		pc += 2;
 		FLUSH_TIME();
@@ -654,10 +724,10 @@ loop:
 	
 	{
 		int temp;
-	case 0x8C: // STY abs
+	OP( 8C ): // STY abs
 		temp = y;
 		if ( 0 )
-	case 0x8E: // STX abs
+	OP( 8E ): // STX abs
 			temp = x;
 		int addr = GET_ADDR();
 		pc += 2;
@@ -669,7 +739,7 @@ loop:
 
 // Compare
 
-	case 0xEC:{// CPX abs
+	OP( EC ):{// CPX abs
 		int addr = GET_ADDR();
 		pc++;
 		FLUSH_TIME();
@@ -678,9 +748,9 @@ loop:
 		goto cpx_data;
 	}
 	
-	case 0xE4: // CPX zp
+	OP( E4 ): // CPX zp
 		data = READ_LOW( data );
-	case 0xE0: // CPX #imm
+	OP( E0 ): // CPX #imm
 	cpx_data:
 		nz = x - data;
 		pc++;
@@ -688,7 +758,7 @@ loop:
 		nz = BYTE( nz );
 		goto loop;
 	
-	case 0xCC:{// CPY abs
+	OP( CC ):{// CPY abs
 		int addr = GET_ADDR();
 		pc++;
 		FLUSH_TIME();
@@ -697,9 +767,9 @@ loop:
 		goto cpy_data;
 	}
 	
-	case 0xC4: // CPY zp
+	OP( C4 ): // CPY zp
 		data = READ_LOW( data );
-	case 0xC0: // CPY #imm
+	OP( C0 ): // CPY #imm
 	cpy_data:
 		nz = y - data;
 		pc++;
@@ -709,68 +779,68 @@ loop:
 	
 // Logical
 
-#define ARITH_ADDR_MODES( op )\
-	case op - 0x04: /* (ind,x) */\
+#define ARITH_ADDR_MODES( hi, next )\
+	OP( hi##1 ): /* (ind,x) */\
 		data = BYTE( data + x );\
-	case op + 0x0D: /* (ind) */\
+	OP( next##2 ): /* (ind) */\
 		data = 0x100 * READ_LOW( BYTE( data + 1 ) ) + READ_LOW( data );\
-		goto ptr##op;\
-	case op + 0x0C:{/* (ind),y */\
+		goto ptr##hi;\
+	OP( next##1 ):{/* (ind),y */\
 		int temp = READ_LOW( data ) + y;\
 		PAGE_PENALTY( temp );\
 		data = temp + 0x100 * READ_LOW( BYTE( data + 1 ) );\
-		goto ptr##op;\
+		goto ptr##hi;\
 	}\
-	case op + 0x10: /* zp,X */\
+	OP( next##5 ): /* zp,X */\
 		data = BYTE( data + x );\
-	case op + 0x00: /* zp */\
+	OP( hi##5 ): /* zp */\
 		data = READ_LOW( data );\
-		goto imm##op;\
-	case op + 0x14: /* abs,Y */\
+		goto imm##hi;\
+	OP( next##9 ): /* abs,Y */\
 		data += y;\
-		goto ind##op;\
-	case op + 0x18: /* abs,X */\
+		goto ind##hi;\
+	OP( next##D ): /* abs,X */\
 		data += x;\
-	ind##op:\
+	ind##hi:\
 		PAGE_PENALTY( data );\
-	case op + 0x08: /* abs */\
+	OP( hi##D ): /* abs */\
 		ADD_PAGE( data );\
-	ptr##op:\
+	ptr##hi:\
 		FLUSH_TIME();\
 		data = READ_MEM( data );\
 		CACHE_TIME();\
-	case op + 0x04: /* imm */\
-	imm##op:
+	OP( hi##9 ): /* imm */\
+	imm##hi:
 
-	ARITH_ADDR_MODES( 0xC5 ) // CMP
+	ARITH_ADDR_MODES( C, D ) // CMP
 		nz = a - data;
 		pc++;
 		c = ~nz;
 		nz = BYTE( nz );
 		goto loop;
 	
-	ARITH_ADDR_MODES( 0x25 ) // AND
+	ARITH_ADDR_MODES( 2, 3 ) // AND
 		nz = (a &= data);
 		pc++;
 		goto loop;
 	
-	ARITH_ADDR_MODES( 0x45 ) // EOR
+	ARITH_ADDR_MODES( 4, 5 ) // EOR
 		nz = (a ^= data);
 		pc++;
 		goto loop;
 	
-	ARITH_ADDR_MODES( 0x05 ) // ORA
+	ARITH_ADDR_MODES( 0, 1 ) // ORA
 		nz = (a |= data);
 		pc++;
 		goto loop;
 	
 // Add/subtract
 
-	ARITH_ADDR_MODES( 0xE5 ) // SBC
+	ARITH_ADDR_MODES( E, F ) // SBC
 		data ^= 0xFF;
 		goto adc_imm;
 	
-	ARITH_ADDR_MODES( 0x65 ) // ADC
+	ARITH_ADDR_MODES( 6, 7 ) // ADC
 	adc_imm: {
 		if ( flags & d08 )
 			dprintf( "Decimal mode not supported\n" );
@@ -785,22 +855,22 @@ loop:
 	
 // Shift/rotate
 
-	case 0x4A: // LSR A
+	OP( 4A ): // LSR A
 		c = 0;
-	case 0x6A: // ROR A
+	OP( 6A ): // ROR A
 		nz = c >> 1 & 0x80;
 		c = a << 8;
 		nz += a >> 1;
 		a = nz;
 		goto loop;
 
-	case 0x0A: // ASL A
+	OP( 0A ): // ASL A
 		nz = a << 1;
 		c = nz;
 		a = BYTE( nz );
 		goto loop;
 
-	case 0x2A: { // ROL A
+	OP( 2A ): { // ROL A
 		nz = a << 1;
 		int temp = c >> 8 & 1;
 		c = nz;
@@ -809,11 +879,11 @@ loop:
 		goto loop;
 	}
 	
-	case 0x5E: // LSR abs,X
+	OP( 5E ): // LSR abs,X
 		data += x;
-	case 0x4E: // LSR abs
+	OP( 4E ): // LSR abs
 		c = 0;
-	case 0x6E: // ROR abs
+	OP( 6E ): // ROR abs
 	ror_abs: {
 		ADD_PAGE( data );
 		FLUSH_TIME();
@@ -823,15 +893,15 @@ loop:
 		goto rotate_common;
 	}
 	
-	case 0x3E: // ROL abs,X
+	OP( 3E ): // ROL abs,X
 		data += x;
 		goto rol_abs;
 	
-	case 0x1E: // ASL abs,X
+	OP( 1E ): // ASL abs,X
 		data += x;
-	case 0x0E: // ASL abs
+	OP( 0E ): // ASL abs
 		c = 0;
-	case 0x2E: // ROL abs
+	OP( 2E ): // ROL abs
 	rol_abs:
 		ADD_PAGE( data );
 		nz = c >> 8 & 1;
@@ -843,19 +913,19 @@ loop:
 		CACHE_TIME();
 		goto loop;
 	
-	case 0x7E: // ROR abs,X
+	OP( 7E ): // ROR abs,X
 		data += x;
 		goto ror_abs;
 	
-	case 0x76: // ROR zp,x
+	OP( 76 ): // ROR zp,x
 		data = BYTE( data + x );
 		goto ror_zp;
 	
-	case 0x56: // LSR zp,x
+	OP( 56 ): // LSR zp,x
 		data = BYTE( data + x );
-	case 0x46: // LSR zp
+	OP( 46 ): // LSR zp
 		c = 0;
-	case 0x66: // ROR zp
+	OP( 66 ): // ROR zp
 	ror_zp: {
 		int temp = READ_LOW( data );
 		nz = (c >> 1 & 0x80) + (temp >> 1);
@@ -863,15 +933,15 @@ loop:
 		goto write_nz_zp;
 	}
 	
-	case 0x36: // ROL zp,x
+	OP( 36 ): // ROL zp,x
 		data = BYTE( data + x );
 		goto rol_zp;
 	
-	case 0x16: // ASL zp,x
+	OP( 16 ): // ASL zp,x
 		data = BYTE( data + x );
-	case 0x06: // ASL zp
+	OP( 06 ): // ASL zp
 		c = 0;
-	case 0x26: // ROL zp
+	OP( 26 ): // ROL zp
 	rol_zp:
 		nz = c >> 8 & 1;
 		nz += (c = READ_LOW( data ) << 1);
@@ -881,33 +951,33 @@ loop:
 
 #define INC_DEC( reg, n ) reg = BYTE( nz = reg + n ); goto loop;
 
-	case 0x1A: // INA
+	OP( 1A ): // INA
 		INC_DEC( a, +1 )
 	
-	case 0xE8: // INX
+	OP( E8 ): // INX
 		INC_DEC( x, +1 )
 	
-	case 0xC8: // INY
+	OP( C8 ): // INY
 		INC_DEC( y, +1 )
 
-	case 0x3A: // DEA
+	OP( 3A ): // DEA
 		INC_DEC( a, -1 )
 	
-	case 0xCA: // DEX
+	OP( CA ): // DEX
 		INC_DEC( x, -1 )
 	
-	case 0x88: // DEY
+	OP( 88 ): // DEY
 		INC_DEC( y, -1 )
 	
-	case 0xF6: // INC zp,x
+	OP( F6 ): // INC zp,x
 		data = BYTE( data + x );
-	case 0xE6: // INC zp
+	OP( E6 ): // INC zp
 		nz = 1;
 		goto add_nz_zp;
 	
-	case 0xD6: // DEC zp,x
+	OP( D6 ): // DEC zp,x
 		data = BYTE( data + x );
-	case 0xC6: // DEC zp
+	OP( C6 ): // DEC zp
 		nz = -1;
 	add_nz_zp:
 		nz += READ_LOW( data );
@@ -916,21 +986,21 @@ loop:
 		WRITE_LOW( data, nz );
 		goto loop;
 	
-	case 0xFE: // INC abs,x
+	OP( FE ): // INC abs,x
 		data = x + GET_ADDR();
 		goto inc_ptr;
 	
-	case 0xEE: // INC abs
+	OP( EE ): // INC abs
 		data = GET_ADDR();
 	inc_ptr:
 		nz = 1;
 		goto inc_common;
 	
-	case 0xDE: // DEC abs,x
+	OP( DE ): // DEC abs,x
 		data = x + GET_ADDR();
 		goto dec_ptr;
 	
-	case 0xCE: // DEC abs
+	OP( CE ): // DEC abs
 		data = GET_ADDR();
 	dec_ptr:
 		nz = -1;
@@ -944,27 +1014,27 @@ loop:
 		
 // Transfer
 
-	case 0xA8: // TAY
+	OP( A8 ): // TAY
 		y = nz = a;
 		goto loop;
 	
-	case 0x98: // TYA
+	OP( 98 ): // TYA
 		a = nz = y;
 		goto loop;
 	
-	case 0xAA: // TAX
+	OP( AA ): // TAX
 		x = nz = a;
 		goto loop;
 		
-	case 0x8A: // TXA
+	OP( 8A ): // TXA
 		a = nz = x;
 		goto loop;
 
-	case 0x9A: // TXS
+	OP( 9A ): // TXS
 		SET_SP( x ); // verified (no flag change)
 		goto loop;
 	
-	case 0xBA: // TSX
+	OP( BA ): // TSX
 		x = nz = GET_SP();
 		goto loop;
 	
@@ -975,54 +1045,55 @@ loop:
 		goto loop;\
 	}
 	
-	case 0x02: // SXY
+	OP( 02 ): // SXY
 		SWAP_REGS( x, y );
 	
-	case 0x22: // SAX
+	OP( 22 ): // SAX
 		SWAP_REGS( a, x );
 	
-	case 0x42: // SAY
+	OP( 42 ): // SAY
 		SWAP_REGS( a, y );
 	
-	case 0x62: // CLA
+	OP( 62 ): // CLA
 		a = 0;
 		goto loop;
 	
-	case 0x82: // CLX
+	OP( 82 ): // CLX
 		x = 0;
 		goto loop;
 	
-	case 0xC2: // CLY
+	OP( C2 ): // CLY
 		y = 0;
 		goto loop;
 	
 // Stack
 	
-	case 0x48: // PHA
+	OP( 48 ): // PHA
 		sp = SP( -1 );
 		WRITE_STACK( sp, a );
 		goto loop;
 		
-	case 0x68: // PLA
+	OP( 68 ): // PLA
 		a = nz = READ_STACK( sp );
 		sp = SP( 1 );
 		goto loop;
 	
-	case 0xDA: // PHX
+	OP( DA ): // PHX
 		sp = SP( -1 );
 		WRITE_STACK( sp, x );
 		goto loop;
 		
-	case 0x5A: // PHY
+	OP( 5A ): // PHY
 		sp = SP( -1 );
 		WRITE_STACK( sp, y );
 		goto loop;
 		
-	case 0x40:{// RTI
+	OP( 40 ):{// RTI
 		pc  = READ_STACK( SP( 1 ) );
 		pc += READ_STACK( SP( 2 ) ) * 0x100;
 		int temp = READ_STACK( sp );
 		sp = SP( 3 );
+		spin_key = -1;
 		data = flags;
 		SET_FLAGS( temp );
 		CPU.r.flags = flags; // update externally-visible I flag
@@ -1038,17 +1109,17 @@ loop:
 		goto loop;
 	}
 	
-	case 0xFA: // PLX
+	OP( FA ): // PLX
 		x = nz = READ_STACK( sp );
 		sp = SP( 1 );
 		goto loop;
 	
-	case 0x7A: // PLY
+	OP( 7A ): // PLY
 		y = nz = READ_STACK( sp );
 		sp = SP( 1 );
 		goto loop;
 	
-	case 0x28:{// PLP
+	OP( 28 ):{// PLP
 		int temp = READ_STACK( sp );
 		sp = SP( 1 );
 		int changed = flags ^ temp;
@@ -1060,7 +1131,7 @@ loop:
 		goto handle_cli;
 	}
 	
-	case 0x08:{// PHP
+	OP( 08 ):{// PHP
 		int temp;
 		GET_FLAGS( temp );
 		sp = SP( -1 );
@@ -1070,27 +1141,27 @@ loop:
 	
 // Flags
 
-	case 0x38: // SEC
+	OP( 38 ): // SEC
 		c = 0x100;
 		goto loop;
 	
-	case 0x18: // CLC
+	OP( 18 ): // CLC
 		c = 0;
 		goto loop;
 		
-	case 0xB8: // CLV
+	OP( B8 ): // CLV
 		flags &= ~v40;
 		goto loop;
 	
-	case 0xD8: // CLD
+	OP( D8 ): // CLD
 		flags &= ~d08;
 		goto loop;
 	
-	case 0xF8: // SED
+	OP( F8 ): // SED
 		flags |= d08;
 		goto loop;
 	
-	case 0x58: // CLI
+	OP( 58 ): // CLI
 		if ( !(flags & i04) )
 			goto loop;
 		flags &= ~i04;
@@ -1124,7 +1195,7 @@ loop:
 		goto loop;
 	}
 	
-	case 0x78: // SEI
+	OP( 78 ): // SEI
 		if ( flags & i04 )
 			goto loop;
 		flags |= i04;
@@ -1142,7 +1213,7 @@ loop:
 	
 // Special
 	
-	case 0x53:{// TAM
+	OP( 53 ):{// TAM
 		int bits = data; // avoid using data across function call
 		pc++;
 		for ( int i = 0; i < 8; i++ )
@@ -1151,7 +1222,7 @@ loop:
 		goto loop;
 	}
 	
-	case 0x43:{// TMA
+	OP( 43 ):{// TMA
 		pc++;
 		byte const* in = CPU.mmr;
 		do
@@ -1164,9 +1235,9 @@ loop:
 		goto loop;
 	}
 	
-	case 0x03: // ST0
-	case 0x13: // ST1
-	case 0x23:{// ST2
+	OP( 03 ): // ST0
+	OP( 13 ): // ST1
+	OP( 23 ):{// ST2
 		int addr = opcode >> 4;
 		if ( addr )
 			addr++;
@@ -1177,18 +1248,18 @@ loop:
 		goto loop;
 	}
 	
-	case 0xEA: // NOP
+	OP( EA ): // NOP
 		goto loop;
 
-	case 0x54: // CSL
+	OP( 54 ): // CSL
 		dprintf( "CSL not supported\n" );
 		illegal_encountered = true;
 		goto loop;
 	
-	case 0xD4: // CSH
+	OP( D4 ): // CSH
 		goto loop;
 	
-	case 0xF4: { // SET
+	OP( F4 ): { // SET
 		//int operand = GET_MSB();
 		dprintf( "SET not handled\n" );
 		//switch ( data )
@@ -1206,11 +1277,11 @@ loop:
 		int out_alt;
 		int out_inc;
 		
-	case 0xE3: // TIA
+	OP( E3 ): // TIA
 		in_alt  = 0;
 		goto bxfer_alt;
 	
-	case 0xF3: // TAI
+	OP( F3 ): // TAI
 		in_alt  = 1;
 	bxfer_alt:
 		in_inc  = in_alt ^ 1;
@@ -1218,17 +1289,17 @@ loop:
 		out_inc = in_alt;
 		goto bxfer;
 	
-	case 0xD3: // TIN
+	OP( D3 ): // TIN
 		in_inc  = 1;
 		out_inc = 0;
 		goto bxfer_no_alt;
 	
-	case 0xC3: // TDD
+	OP( C3 ): // TDD
 		in_inc  = -1;
 		out_inc = -1;
 		goto bxfer_no_alt;
 	
-	case 0x73: // TII
+	OP( 73 ): // TII
 		in_inc  = 1;
 		out_inc = 1;
 	bxfer_no_alt:
@@ -1266,6 +1337,9 @@ loop:
 // Illegal
 
 	default:
+	#if GME_COMPUTED_GOTO
+	op_default:
+	#endif
 		check( (unsigned) opcode <= 0xFF );
 		dprintf( "Illegal opcode $%02X at $%04X\n", (int) opcode, (int) pc - 1 );
 		illegal_encountered = true;
@@ -1281,6 +1355,7 @@ handle_brk:
 interrupt:
 	{
 		s_time += 7;
+		spin_key = -1;
 		
 		// Save PC and read vector
 		WRITE_STACK( SP( -1 ), pc >> 8 );
@@ -1308,6 +1383,53 @@ interrupt:
 		goto loop;
 	}
 	
+jumped_back:
+	// Every few passes of a short loop, checks whether it's only waiting for the
+	// next interrupt or end of emulation, and if so skips its whole periods
+	if ( (unsigned) (spin_end - pc) <= Spin_Detector::max_size )
+	{
+		int key = (spin_end - pc) << 16 | pc;
+		if ( spin_key != key )
+		{
+			spin_key   = key;
+			spin_count = Spin_Detector::check_interval - 1;
+			CPU.spin.forget();
+		}
+		
+		if ( --spin_count < 0 )
+		{
+			spin_count = Spin_Detector::check_interval - 1;
+			int const regs [] = { a, x, y, sp, flags, c, nz };
+			if ( CPU.spin.repeated( regs, sizeof regs / sizeof *regs, TIME() ) )
+			{
+				// Instructions must have no side effects, and branches within
+				// loop must go to one of them
+				int addr = pc;
+				unsigned starts  = 0;
+				unsigned targets = 0;
+				while ( addr < spin_end )
+				{
+					Spin_Detector::instr_t in = Spin_Detector::decode_6502( addr, &READ_CODE( addr ) );
+					if ( !in.size )
+						break;
+					if ( in.read == Spin_Detector::mem_read &&
+							!CAN_SKIP_READS( in.addr, in.addr + in.span - 1 ) )
+						break;
+					starts |= 1u << (addr - pc);
+					if ( (unsigned) (in.target - pc) < (unsigned) (spin_end - pc) )
+						targets |= 1u << (in.target - pc);
+					addr += in.size;
+				}
+				
+				if ( addr == spin_end && !(targets & ~starts) )
+					s_time += CPU.spin.skip( -s_time );
+				else
+					spin_count = INT_MAX; // don't check again
+			}
+		}
+	}
+	goto loop;
+	
 idle_done:
 	s_time = 0;
 	
@@ -136,7 +136,11 @@ gme_type_t_ const gme_hes_type [1] = {{ "PC Engine", 256, &new_hes_emu, &new_hes
 
 blargg_err_t Hes_Emu::load_( Data_Reader& in )
 {
-	RETURN_ERR( core.load( in ) );
+	// Core can use file data in place too if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( core.load_mem( file_begin(), file_size() ) );
+	else
+		RETURN_ERR( core.load( in ) );
 	
 	static const char* const names [Hes_Apu::osc_count + Hes_Apu_Adpcm::osc_count] = {
 		"Wave 1", "Wave 2", "Wave 3", "Wave 4", "Multi 1", "Multi 2", "ADPCM"
@@ -185,6 +189,24 @@ blargg_err_t Hes_Emu::run_clocks( blip_time_t& duration_, int )
 	return core.end_frame( duration_ );
 }
 
+bool Hes_Emu::copy_core_state( State_Copier& copier )
+{
+	core.copy_state( copier );
+	return true;
+}
+
+bool Hes_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core.set_loop_detector( d );
+	return true;
+}
+
+void Hes_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core.spin_detector().hits();
+	*clocks_skipped = core.spin_detector().clocks_skipped();
+}
+
 blargg_err_t Hes_Emu::hash_( Hash_Function& out ) const
 {
 	hash_hes_file( header(), core.data(), core.data_size(), out );
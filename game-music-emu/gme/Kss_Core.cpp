@@ -20,6 +20,7 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 Kss_Core::Kss_Core() : rom( Kss_Cpu::page_size )
 {
 	memset( unmapped_read, 0xFF, sizeof unmapped_read );
+	loop_detector = NULL;
 }
 
 Kss_Core::~Kss_Core() { }
@@ -40,7 +41,11 @@ blargg_err_t Kss_Core::load_( Data_Reader& in )
 {
 	memset( &header_, 0, sizeof header_ );
 	assert( offsetof (header_t,msx_audio_vol) == header_t::size - 1 );
-	RETURN_ERR( rom.load( in, header_t::base_size, &header_, 0 ) );
+	// Use file data in place if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( rom.borrow( file_begin(), file_size(), header_t::base_size, &header_, 0 ) );
+	else
+		RETURN_ERR( rom.load( in, header_t::base_size, &header_, 0 ) );
 	
 	RETURN_ERR( check_kss_header( header_.tag ) );
 	
@@ -212,3 +217,12 @@ blargg_err_t Kss_Core::end_frame( time_t end )
 	
 	return blargg_ok;
 }
+
+void Kss_Core::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	copier( ram );
+	copier( gain_updated );
+	copier( play_period );
+	copier( next_play );
+}
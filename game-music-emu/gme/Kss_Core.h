@@ -7,6 +7,7 @@
 #include "Gme_Loader.h"
 #include "Rom_Data.h"
 #include "Z80_Cpu.h"
+class Loop_Detector;
 
 class Kss_Core : public Gme_Loader {
 public:
@@ -50,10 +51,21 @@ public:
 	blargg_err_t start_track( int );
 	
 	blargg_err_t end_frame( time_t );
+	
+	// Saves/restores CPU and memory state between time frames
+	// (see State_Copier.h)
+	void copy_state( State_Copier& );
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
 
 protected:
 	typedef Z80_Cpu Kss_Cpu;
 	Kss_Cpu cpu;
+	Loop_Detector* loop_detector;
 	
 	void set_bank( int logical, int physical );
 	
@@ -2,6 +2,7 @@
 
 #include "Kss_Emu.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 
 /* Copyright (C) 2006-2009 Shay Green. This module is free software; you
@@ -59,6 +60,40 @@ void Kss_Emu::unload()
 	Classic_Emu::unload();
 }
 
+bool Kss_Emu::Core::copy_state( State_Copier& copier )
+{
+	if ( sms.fm || msx.music || msx.audio )
+		return false; // FM sound chip state can't be saved
+	
+	Kss_Core::copy_state( copier );
+	IF_PTR( sms.psg )->copy_state( copier );
+	IF_PTR( msx.psg )->copy_state( copier );
+	IF_PTR( msx.scc )->copy_state( copier );
+	copier( scc_accessed );
+	copier( scc_enabled );
+	copier( ay_latch );
+	if ( copier.loading() )
+		update_gain_();
+	return true;
+}
+
+bool Kss_Emu::copy_core_state( State_Copier& copier )
+{
+	return core.copy_state( copier );
+}
+
+bool Kss_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core.set_loop_detector( d );
+	return true;
+}
+
+void Kss_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core.spin_detector().hits();
+	*clocks_skipped = core.spin_detector().clocks_skipped();
+}
+
 // Track info
 
 static void copy_kss_fields( Kss_Core::header_t const& h, track_info_t* out )
@@ -187,7 +222,11 @@ static blargg_err_t new_opl_apu( Opl_Apu::type_t type, Opl_Apu** out )
 
 blargg_err_t Kss_Emu::load_( Data_Reader& in )
 {
-	RETURN_ERR( core.load( in ) );
+	// Core can use file data in place too if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( core.load_mem( file_begin(), file_size() ) );
+	else
+		RETURN_ERR( core.load( in ) );
 	set_warning( core.warning() );
 
 	set_track_count( get_le16( header().last_track ) + 1 );
@@ -375,7 +414,11 @@ void Kss_Emu::Core::cpu_write_( addr_t addr, int data )
 		//if ( (unsigned) (scc_addr - 0x90) < 0x10 )
 		//  scc_addr -= 0x10; // 0x90-0x9F mirrors to 0x80-0x8F
 		if ( scc_addr < Scc_Apu::reg_count )
+		{
+			if ( loop_detector )
+				loop_detector->write( cpu.time(), addr, data );
 			msx.scc->write( cpu.time(), addr, data );
+		}
 		return;
 	}
 
@@ -392,6 +435,9 @@ void Kss_Emu::Core::cpu_write( addr_t addr, int data )
 void Kss_Emu::Core::cpu_out( time_t time, addr_t addr, int data )
 {
 	data &= 0xFF;
+	if ( loop_detector )
+		loop_detector->write( time, 0x10000 | (addr & 0xFF), data );
+	
 	switch ( addr & 0xFF )
 	{
 	case 0xA0:
@@ -37,6 +37,9 @@ protected:
 	virtual void set_voice( int, Blip_Buffer*, Blip_Buffer*, Blip_Buffer* );
 	virtual void update_eq( blip_eq_t const& );
 	virtual void unload();
+	virtual bool copy_core_state( State_Copier& );
+	virtual bool set_loop_detector( Loop_Detector* );
+	virtual void spin_stats_( long*, double* ) const;
 	
 private:
 	struct Core;
@@ -73,6 +76,7 @@ private:
 		void cpu_write_( addr_t addr, int data );
 		void update_gain_();
 		void unload();
+		bool copy_state( State_Copier& );
 	} core;
 };
 
@@ -1,6 +1,7 @@
 // Game_Music_Emu $vers. http://www.slack.net/~ant/
 
 #include "Kss_Scc_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -122,3 +123,10 @@ void Scc_Apu::run_until( blip_time_t end_time )
 	}
 	last_time = end_time;
 }
+
+void Scc_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( last_time );
+	copier( regs );
+}
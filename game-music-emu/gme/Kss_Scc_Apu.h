@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 class Scc_Apu {
 public:
@@ -26,6 +27,9 @@ public:
 
 	// Resets sound chip
 	void reset();
+	
+	// Saves/restores emulation state (see State_Copier.h)
+	void copy_state( State_Copier& );
 
 	// Same as set_output(), but for a particular channel
 	enum { osc_count = 5 };
@@ -0,0 +1,152 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Loop_Detector.h"
+
+#include <string.h>
+
+#include "blargg_source.h"
+
+// Multiplier of rolling window hash
+unsigned const hash_mult = 0x01000193;
+
+Loop_Detector::Loop_Detector()
+{
+	reset( 1000 );
+}
+
+void Loop_Detector::reset( int clock_rate )
+{
+	count          = 0;
+	window         = 0;
+	frame_start    = 0;
+	set_clock_rate( clock_rate );
+	cand_repeat    = 0;
+	cand_length    = 0;
+	loop_start_    = -1;
+	loop_length_   = -1;
+	error_         = blargg_ok;
+
+	window_factor = 1;
+	for ( int i = window_size; i--; )
+		window_factor *= hash_mult;
+
+	int* w = windows.begin();
+	for ( int i = (int) windows.size(); i--; )
+		w [i] = 0;
+}
+
+int Loop_Detector::time() const
+{
+	return (int) frame_start;
+}
+
+void Loop_Detector::end_frame( int time )
+{
+	frame_start += time * msec_per_clock;
+}
+
+blargg_err_t Loop_Detector::grow()
+{
+	int n = (int) entries.size() * 2;
+	if ( n < 4096 )
+		n = 4096;
+	RETURN_ERR( entries.resize( n ) );
+	RETURN_ERR( windows.resize( n * 2 ) );
+
+	// Re-insert in original order, so earliest of identical windows is kept
+	memset( windows.begin(), 0, windows.size() * sizeof windows [0] );
+	for ( int i = window_size - 1; i < count; i++ )
+		find_window( entries [i].window, i );
+	return blargg_ok;
+}
+
+// Finds earlier window identical to the one ending at entry 'end', or adds it to
+// table and returns -1 if there isn't one
+int Loop_Detector::find_window( unsigned hash, int end )
+{
+	int const mask = (int) windows.size() - 1;
+	for ( int i = (hash * 0x9E3779B1) >> 8; ; i++ )
+	{
+		int& slot = windows [i & mask];
+		if ( !slot )
+		{
+			slot = end + 1;
+			return -1;
+		}
+
+		int other = slot - 1;
+		if ( entries [other].window == hash )
+		{
+			int n = window_size;
+			while ( n && entries [other - n + 1].write == entries [end - n + 1].write )
+				n--;
+			if ( !n )
+				return other;
+		}
+	}
+}
+
+void Loop_Detector::confirm_loop()
+{
+	// Back up to earliest point writes repeat from
+	int first  = cand_repeat - cand_length;
+	int repeat = cand_repeat;
+	while ( first > 0 && entries [first - 1].write == entries [repeat - 1].write )
+	{
+		first--;
+		repeat--;
+	}
+
+	loop_start_  = entries [first].time;
+	loop_length_ = entries [repeat].time - loop_start_;
+	if ( loop_length_ <= 0 )
+		loop_length_ = 1;
+}
+
+void Loop_Detector::write( int time, int addr, int data )
+{
+	if ( loop_found() || error_ )
+		return;
+
+	if ( count >= (int) entries.size() )
+	{
+		error_ = grow();
+		if ( error_ )
+			return;
+	}
+
+	unsigned w = (unsigned) addr << 8 | (data & 0xFF);
+	window = window * hash_mult + w;
+	if ( count >= window_size )
+		window -= entries [count - window_size].write * window_factor;
+
+	int n = count++;
+	entry_t& e = entries [n];
+	e.write  = w;
+	e.window = window;
+	e.time   = (int) (frame_start + time * msec_per_clock);
+
+	if ( cand_length )
+	{
+		if ( w != entries [n - cand_length].write )
+		{
+			cand_length = 0;
+		}
+		else if ( n - cand_repeat >= cand_length &&
+				e.time - entries [cand_repeat].time >= confirm_time )
+		{
+			confirm_loop();
+			return;
+		}
+	}
+
+	if ( n >= window_size - 1 )
+	{
+		int prev = find_window( window, n );
+		if ( prev >= 0 && !cand_length )
+		{
+			cand_length = n - prev;
+			cand_repeat = n - (window_size - 1);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+// Finds where a track loops by looking for a repeating run of sound chip writes
+
+// Game_Music_Emu $vers
+#ifndef LOOP_DETECTOR_H
+#define LOOP_DETECTOR_H
+
+#include "blargg_common.h"
+
+/* Emulators log every sound chip register write during a dry run. Once the
+writes from some point on have repeated exactly, for at least one full pass and
+for at least confirm_time, that point is taken as the loop start. Timing of the
+writes isn't compared, only their order, register and data. */
+class Loop_Detector {
+public:
+	// Minimum time writes must keep repeating before a loop is accepted, so that
+	// a repeated phrase isn't mistaken for the whole song looping
+	enum { confirm_time = 20000 }; // msec
+
+	// Clears history and sets clock rate of times passed to write() and end_frame()
+	void reset( int clock_rate );
+	
+	// Changes clock rate for following times
+	void set_clock_rate( int rate )         { msec_per_clock = 1000.0 / rate; }
+
+	// Logs write of data to register addr at time within current frame. Each sound
+	// chip must use a distinct range of addresses, at most 0xFFFFFF.
+	void write( int time, int addr, int data );
+
+	// Ends time frame at time, which becomes time 0 of the next frame
+	void end_frame( int time );
+
+	// Milliseconds emulated since reset()
+	int time() const;
+
+	// Time of most recent write, or -1 if none
+	int last_write() const                  { return count ? entries [count - 1].time : -1; }
+
+	// True if a loop has been found
+	bool loop_found() const                 { return loop_length_ > 0; }
+
+	// Start and length of loop, in milliseconds
+	int loop_start() const                  { return loop_start_; }
+	int loop_length() const                 { return loop_length_; }
+
+	// Error if history couldn't be allocated, otherwise NULL
+	blargg_err_t error() const              { return error_; }
+
+public:
+	Loop_Detector();
+
+private:
+	enum { window_size = 32 }; // writes hashed together when looking for a repeat
+
+	struct entry_t
+	{
+		unsigned write;     // address and data
+		unsigned window;    // hash of window_size writes ending with this one
+		int time;           // msec
+	};
+	blargg_vector<entry_t> entries;
+	int count;
+	blargg_vector<int> windows; // index of first entry ending each window hash, +1
+	unsigned window;
+	unsigned window_factor;
+
+	double frame_start;     // msec
+	double msec_per_clock;
+
+	// Current guess, from entry 'repeat' onwards matching from 'repeat - length'
+	int cand_repeat;
+	int cand_length;
+
+	int loop_start_;
+	int loop_length_;
+	blargg_err_t error_;
+
+	blargg_err_t grow();
+	int find_window( unsigned hash, int end );
+	void confirm_loop();
+};
+
+#endif
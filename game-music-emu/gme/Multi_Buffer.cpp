@@ -2,6 +2,8 @@
 
 #include "Multi_Buffer.h"
 
+#include "State_Copier.h"
+
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -59,6 +61,12 @@ blargg_err_t Mono_Buffer::set_sample_rate( int rate, int msec )
 	return Multi_Buffer::set_sample_rate( buf.sample_rate(), buf.length() );
 }
 
+bool Mono_Buffer::copy_state( State_Copier& copier )
+{
+	buf.copy_state( copier );
+	return true;
+}
+
 
 // Tracked_Blip_Buffer
 
@@ -75,6 +83,12 @@ void Tracked_Blip_Buffer::clear()
 	Blip_Buffer::clear();
 }
 
+void Tracked_Blip_Buffer::copy_state( State_Copier& copier )
+{
+	Blip_Buffer::copy_state( copier );
+	copier( last_non_silence );
+}
+
 void Tracked_Blip_Buffer::end_frame( blip_time_t t )
 {
 	Blip_Buffer::end_frame( t );
@@ -165,6 +179,14 @@ void Stereo_Buffer::clear()
 		bufs [i].clear();
 }
 
+bool Stereo_Buffer::copy_state( State_Copier& copier )
+{
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].copy_state( copier );
+	copier( mixer.samples_read );
+	return true;
+}
+
 void Stereo_Buffer::end_frame( blip_time_t time )
 {
 	for ( int i = bufs_size; --i >= 0; )
@@ -216,6 +238,89 @@ void Stereo_Mixer::read_pairs( blip_sample_t out [], int count )
 		mix_mono( out, count );
 }
 
+#if BLIP_SIMD
+
+// Integrators are run over a block of samples first, then the block is clamped
+// and interleaved all at once, which can use vector instructions
+int const mix_block = 256;
+
+void Stereo_Mixer::mix_mono( blip_sample_t out [], int count )
+{
+	int const bass = bufs [2]->highpass_shift();
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT center = bufs [2]->read_pos() + samples_read - count;
+	int center_sum = bufs [2]->integrator();
+	
+	int temp [mix_block];
+	while ( count > 0 )
+	{
+		int const n = min( count, mix_block );
+		for ( int i = 0; i < n; i++ )
+		{
+			temp [i] = center_sum >> Blip_Buffer::delta_bits;
+			
+			center_sum -= center_sum >> bass;
+			center_sum += center [i];
+		}
+		
+		blip_clamp_samples_( temp, out,     n, stereo );
+		blip_clamp_samples_( temp, out + 1, n, stereo );
+		
+		center += n;
+		out    += n * stereo;
+		count  -= n;
+	}
+	
+	bufs [2]->set_integrator( center_sum );
+}
+
+void Stereo_Mixer::mix_stereo( blip_sample_t out [], int count )
+{
+	int const bass = bufs [2]->highpass_shift();
+	int const start = samples_read - count;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT left   = bufs [0]->read_pos() + start;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT right  = bufs [1]->read_pos() + start;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT center = bufs [2]->read_pos() + start;
+	
+	int left_sum   = bufs [0]->integrator();
+	int right_sum  = bufs [1]->integrator();
+	int center_sum = bufs [2]->integrator();
+	
+	int temp_l [mix_block];
+	int temp_r [mix_block];
+	while ( count > 0 )
+	{
+		int const n = min( count, mix_block );
+		for ( int i = 0; i < n; i++ )
+		{
+			temp_l [i] = (center_sum + left_sum ) >> Blip_Buffer::delta_bits;
+			temp_r [i] = (center_sum + right_sum) >> Blip_Buffer::delta_bits;
+			
+			left_sum   -= left_sum   >> bass;
+			right_sum  -= right_sum  >> bass;
+			center_sum -= center_sum >> bass;
+			
+			left_sum   += left   [i];
+			right_sum  += right  [i];
+			center_sum += center [i];
+		}
+		
+		blip_clamp_samples_( temp_l, out,     n, stereo );
+		blip_clamp_samples_( temp_r, out + 1, n, stereo );
+		
+		left   += n;
+		right  += n;
+		center += n;
+		out    += n * stereo;
+		count  -= n;
+	}
+	
+	bufs [0]->set_integrator( left_sum   );
+	bufs [1]->set_integrator( right_sum  );
+	bufs [2]->set_integrator( center_sum );
+}
+
+#else
+
 void Stereo_Mixer::mix_mono( blip_sample_t out_ [], int count )
 {
 	int const bass = bufs [2]->highpass_shift();
@@ -288,3 +393,5 @@ void Stereo_Mixer::mix_stereo( blip_sample_t out_ [], int count )
 		break;
 	}
 }
+
+#endif
@@ -48,6 +48,10 @@ public:
 	virtual void end_frame( blip_time_t )               BLARGG_PURE( ; )
 	virtual int read_samples( blip_sample_t [], int )   BLARGG_PURE( ; )
 	virtual int samples_avail() const                   BLARGG_PURE( ; )
+	
+	// Saves/restores buffered samples and mixing state (see State_Copier.h).
+	// Returns false if this buffer type doesn't support it.
+	virtual bool copy_state( State_Copier& )            BLARGG_PURE( ; )
 
 private:
 	// noncopyable
@@ -93,6 +97,7 @@ public:
 	virtual int read_samples( blip_sample_t p [], int s )   { return buf.read_samples( p, s ); }
 	virtual channel_t channel( int )                        { return chan; }
 	virtual void end_frame( blip_time_t t )                 { buf.end_frame( t ); }
+	virtual bool copy_state( State_Copier& );
 
 private:
 	Blip_Buffer buf;
@@ -117,6 +122,7 @@ private:
 		Tracked_Blip_Buffer();
 		void clear();
 		void end_frame( blip_time_t );
+		void copy_state( State_Copier& );
 	
 	private:
 		int last_non_silence;
@@ -160,6 +166,7 @@ public:
 	virtual void end_frame( blip_time_t );
 	virtual int samples_avail() const           { return (bufs [0].samples_avail() - mixer.samples_read) * 2; }
 	virtual int read_samples( blip_sample_t [], int );
+	virtual bool copy_state( State_Copier& );
 	
 private:
 	enum { bufs_size = 3 };
@@ -184,6 +191,7 @@ public:
 	virtual void end_frame( blip_time_t )           { }
 	virtual int samples_avail() const               { return 0; }
 	virtual int read_samples( blip_sample_t [], int ) { return 0; }
+	virtual bool copy_state( State_Copier& )        { return true; }
 };
 
 
@@ -203,6 +211,7 @@ inline void Multi_Buffer::clear()                               { }
 inline void Multi_Buffer::end_frame( blip_time_t )              { }
 inline int  Multi_Buffer::read_samples( blip_sample_t [], int ) { return 0; }
 inline int  Multi_Buffer::samples_avail() const                 { return 0; }
+inline bool Multi_Buffer::copy_state( State_Copier& )           { return false; }
 
 inline blargg_err_t Multi_Buffer::set_channel_count( int n, int const types [] )
 {
@@ -2,6 +2,10 @@
 
 #include "Music_Emu.h"
 
+#include "Loop_Detector.h"
+#include "State_Copier.h"
+#include "Track_Lookahead.h"
+
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -28,21 +32,40 @@ void Music_Emu::clear_track_vars()
 
 void Music_Emu::unload()
 {
-	voice_count_ = 0;
+	if ( lookahead_ )
+		lookahead_->stop(); // uses file data
+	enable_outputs( false );
+	voice_count_  = 0;
+	output_count_ = 0;
+	output_names_ = NULL;
 	clear_track_vars();
+	clear_checkpoints();
 	Gme_File::unload();
 }
 
 Music_Emu::gme_t()
 {
 	effects_buffer_ = NULL;
+	lookahead_      = NULL;
 	sample_rate_    = 0;
 	mute_mask_      = 0;
+	outputs_enabled = false;
+	outputs_        = NULL;
+	outputs_pos_    = 0;
+	outputs_wrap_   = 0;
+	ahead_kept      = false;
 	tempo_          = 1.0;
 	gain_           = 1.0;
+	ym2612_core_    = -1;
+	qsound_rate_    = -1;
+	resampler_quality_ = -1;
     
     fade_set        = false;
 	
+	checkpoint_msec     = 0;
+	checkpoint_limit    = 0;
+	checkpoint_interval = 0;
+	
 	// defaults
 	tfilter = track_filter.setup();
 	set_max_initial_silence( 15 );
@@ -63,6 +86,7 @@ Music_Emu::gme_t()
 Music_Emu::~gme_t()
 {
 	assert( !effects_buffer_ );
+	delete lookahead_;
 }
 
 blargg_err_t Music_Emu::set_sample_rate( int rate )
@@ -72,6 +96,7 @@ blargg_err_t Music_Emu::set_sample_rate( int rate )
 	RETURN_ERR( track_filter.init( this ) );
 	sample_rate_ = rate;
 	tfilter.max_silence = 6 * stereo * sample_rate();
+	set_seek_checkpoints( checkpoint_msec, checkpoint_limit );
 	return blargg_ok;
 }
 
@@ -116,6 +141,14 @@ const char* Music_Emu::voice_name( int i ) const
 	return "";
 }
 
+const char* Music_Emu::output_name( int i ) const
+{
+	if ( (unsigned) i < (unsigned) output_count_ )
+		return output_names_ ? output_names_ [i] : voice_name( i );
+	
+	return "";
+}
+
 void Music_Emu::set_tempo( double t )
 {
 	require( sample_rate() ); // sample rate must be set first
@@ -123,9 +156,84 @@ void Music_Emu::set_tempo( double t )
 	double const max = 4.00;
 	if ( t < min ) t = min;
 	if ( t > max ) t = max;
+	if ( t != tempo_ )
+		clear_checkpoints();
 	tempo_ = t;
 	set_tempo_( t );
 	track_filter.set_tempo( t );
+	if ( current_track_ >= 0 )
+		start_lookahead( current_track_ );
+}
+
+blargg_err_t Music_Emu::set_ym2612_core( int core )
+{
+	if ( core < gme_ym2612_nuked || core > gme_ym2612_benchmark )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid YM2612 core" );
+	
+	RETURN_ERR( set_ym2612_core_( core ) );
+	ym2612_core_ = core;
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::set_chip_threads( int count )
+{
+	if ( count < 0 )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid thread count" );
+	
+	return set_chip_threads_( count );
+}
+
+blargg_err_t Music_Emu::enable_profile( bool enabled )
+{
+	return enable_profile_( enabled );
+}
+
+int Music_Emu::get_profile( gme_chip_profile_t out [], int max )
+{
+	if ( max < 0 )
+		max = 0;
+	return get_profile_( out, max );
+}
+
+blargg_err_t Music_Emu::set_sample_cache( long max_bytes )
+{
+	if ( max_bytes < 0 )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid sample cache size" );
+	
+	return set_sample_cache_( max_bytes );
+}
+
+blargg_err_t Music_Emu::set_qsound_rate( int rate )
+{
+	if ( rate < 0 )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid QSound rate" );
+	
+	RETURN_ERR( set_qsound_rate_( rate ) );
+	qsound_rate_ = rate;
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::enable_fast_dsp( bool enabled )
+{
+	return enable_fast_dsp_( enabled );
+}
+
+blargg_err_t Music_Emu::set_resampler_quality( int quality )
+{
+	static int const widths [] = { 0, 8, 16, 32 };
+	if ( (unsigned) quality >= sizeof widths / sizeof *widths )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid resampler quality" );
+	
+	RETURN_ERR( set_resampler_width_( widths [quality] ) );
+	resampler_quality_ = quality;
+	return blargg_ok;
+}
+
+void Music_Emu::spin_stats( long* hits, double* clocks_skipped ) const
+{
+	*hits           = 0;
+	*clocks_skipped = 0;
+	spin_stats_( hits, clocks_skipped );
 }
 
 blargg_err_t Music_Emu::post_load()
@@ -151,6 +259,21 @@ int Music_Emu::tell() const
 	return sec * 1000 + (track_filter.sample_count() - sec * rate) * 1000 / rate;
 }
 
+bool Music_Emu::ended_on_silence( int* silence_msec ) const
+{
+	if ( !track_filter.ended_on_silence() )
+		return false;
+	
+	if ( silence_msec )
+	{
+		int rate = sample_rate() * stereo;
+		int time = track_filter.silence_start();
+		int sec  = time / rate;
+		*silence_msec = sec * 1000 + (time - sec * rate) * 1000 / rate;
+	}
+	return true;
+}
+
 int Music_Emu::tell_scaled() const
 {
 	return int(track_filter.sample_count_scaled() / (sample_rate() / 1000.0));
@@ -159,7 +282,8 @@ int Music_Emu::tell_scaled() const
 blargg_err_t Music_Emu::seek( int msec )
 {
 	int time = msec_to_samples( msec );
-	if ( time < track_filter.sample_count() )
+	if ( !load_checkpoint( time, false ) && !load_seek_index( time ) &&
+			time < track_filter.sample_count() )
     {
 		RETURN_ERR( start_track( current_track_ ) );
         if ( fade_set )
@@ -172,7 +296,8 @@ blargg_err_t Music_Emu::seek_scaled( int msec )
 {
 	require( tempo_ > 0 );
 	float frames = (msec / 1000.0f) * sample_rate();
-	if (frames < track_filter.sample_count_scaled())
+	if (!load_checkpoint( int(frames), true ) && !load_seek_index( int(frames * stereo / tempo_) ) &&
+			frames < track_filter.sample_count_scaled())
 		RETURN_ERR(start_track( current_track_ ));
 	int samples_to_skip = int((frames - track_filter.sample_count_scaled()) * stereo / tempo_);
 	samples_to_skip += samples_to_skip % stereo;
@@ -182,7 +307,22 @@ blargg_err_t Music_Emu::seek_scaled( int msec )
 blargg_err_t Music_Emu::skip( int count )
 {
 	require( current_track() >= 0 ); // start_track() must have been called already
-	return track_filter.skip( count );
+	
+	// stop at each checkpoint along the way, so a long seek fills them in
+	for ( ;; )
+	{
+		save_checkpoint();
+		int n = next_checkpoint - track_filter.emu_sample_count();
+		if ( !checkpoint_interval || n <= 0 || n >= count )
+			break;
+		n += n & 1;
+		count -= n;
+		RETURN_ERR( track_filter.skip( n ) );
+	}
+	
+	RETURN_ERR( track_filter.skip( count ) );
+	save_checkpoint();
+	return blargg_ok;
 }
 
 blargg_err_t Music_Emu::skip_( int count )
@@ -214,6 +354,8 @@ blargg_err_t Music_Emu::start_track( int track )
 	int remapped = track;
 	RETURN_ERR( remap_track_( &remapped ) );
 	current_track_ = track;
+	if ( track != checkpoint_track )
+		clear_checkpoints();
 	blargg_err_t err = start_track_( remapped );
 	if ( err )
 	{
@@ -229,7 +371,27 @@ blargg_err_t Music_Emu::start_track( int track )
 	#endif
 	track_filter.setup( s );
 	
-	return track_filter.start_track();
+	// Emulator generates buf_size samples at a time while skipping initial
+	// silence, so keep the outputs of the last ones for play_outputs()
+	ahead_kept = false;
+	if ( outputs_enabled )
+	{
+		int const size = Track_Filter::buf_size;
+		RETURN_ERR( ahead_outputs.resize( output_count_ * size ) );
+		RETURN_ERR( ahead_output_ptrs.resize( output_count_ ) );
+		for ( int i = output_count_; --i >= 0; )
+			ahead_output_ptrs [i] = &ahead_outputs [i * size];
+		outputs_      = ahead_output_ptrs.begin();
+		outputs_pos_  = 0;
+		outputs_wrap_ = size;
+	}
+	err = track_filter.start_track();
+	outputs_      = NULL;
+	outputs_wrap_ = 0;
+	RETURN_ERR( err );
+	ahead_kept = outputs_enabled;
+	start_lookahead( track );
+	return blargg_ok;
 }
 
 void Music_Emu::set_fade( int start_msec, int length_msec )
@@ -241,12 +403,416 @@ void Music_Emu::set_fade( int start_msec, int length_msec )
 			length_msec * sample_rate() / (1000 / stereo) );
 }
 
+// Switches emulator to or from generating outputs separately
+blargg_err_t Music_Emu::enable_outputs( bool enabled )
+{
+	if ( outputs_enabled != enabled )
+	{
+		ahead_kept = false;
+		RETURN_ERR( set_outputs_( enabled ) );
+		outputs_enabled = enabled;
+	}
+	return blargg_ok;
+}
+
 blargg_err_t Music_Emu::play( int out_count, sample_t out [] )
 {
 	require( current_track() >= 0 );
 	require( out_count % stereo == 0 );
 	
-	return track_filter.play( out_count, out );
+	RETURN_ERR( enable_outputs( false ) );
+	update_lookahead();
+	RETURN_ERR( track_filter.play( out_count, out ) );
+	save_checkpoint();
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::play_float( int count, float left [], float right [] )
+{
+	require( current_track() >= 0 );
+	
+	RETURN_ERR( enable_outputs( false ) );
+	update_lookahead();
+	RETURN_ERR( track_filter.play_float( count, left, right ) );
+	save_checkpoint();
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::play_outputs( int count, sample_t mix [], sample_t* const outs [] )
+{
+	require( current_track() >= 0 );
+	require( count % stereo == 0 );
+	
+	if ( !output_count_ )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "separate outputs not supported" );
+	
+	if ( !outputs_enabled && !track_filter.sample_count() && track_filter.samples_ahead() )
+	{
+		// Start track over so that outputs are kept for samples it generates ahead
+		RETURN_ERR( enable_outputs( true ) );
+		RETURN_ERR( start_track( current_track_ ) );
+		if ( fade_set )
+			set_fade( length_msec, fade_msec );
+	}
+	RETURN_ERR( enable_outputs( true ) );
+	
+	// Emulator writes outputs of samples it generates from now on. Ones for
+	// samples it generated ahead were kept by start_track(), otherwise they're
+	// silent, such as when switching from play().
+	int const ahead = min( count, track_filter.samples_ahead() );
+	int const kept_pos = Track_Filter::buf_size - track_filter.samples_ahead();
+	for ( int i = output_count_; --i >= 0; )
+	{
+		if ( !outs [i] )
+			continue;
+		
+		if ( ahead_kept )
+			memcpy( outs [i], ahead_outputs.begin() + i * Track_Filter::buf_size + kept_pos,
+					ahead * sizeof *outs [i] );
+		else
+			memset( outs [i], 0, ahead * sizeof *outs [i] );
+	}
+	
+	update_lookahead();
+	outputs_     = outs;
+	outputs_pos_ = ahead;
+	blargg_err_t err = track_filter.play_direct( count, mix, outs, output_count_ );
+	outputs_     = NULL;
+	RETURN_ERR( err );
+	save_checkpoint();
+	return blargg_ok;
+}
+
+// Length estimation
+
+blargg_err_t Music_Emu::estimate_length( int track, int max_msec, length_estimate_t* out )
+{
+	out->length      = -1;
+	out->loop_start  = -1;
+	out->loop_length = -1;
+	out->method      = gme_length_limit;
+	
+	track_info_t info;
+	RETURN_ERR( track_info( &info, track ) );
+	if ( info.length > 0 || info.loop_length > 0 )
+	{
+		out->length = info.length;
+		if ( info.loop_length > 0 )
+		{
+			out->loop_start  = max( info.intro_length, 0 );
+			out->loop_length = info.loop_length;
+			if ( out->length <= 0 )
+				out->length = out->loop_start + out->loop_length;
+		}
+		out->method = gme_length_tagged;
+		return blargg_ok;
+	}
+	
+	bool supported;
+	RETURN_ERR( dry_run_estimate( track, max_msec, out, &supported ) );
+	if ( !supported )
+		return play_length( track, max_msec, out );
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::dry_run_estimate( int track, int max_msec, length_estimate_t* out,
+		bool* supported )
+{
+	*supported = false;
+	clear_track_vars();
+	int remapped = track;
+	RETURN_ERR( remap_track_( &remapped ) );
+	RETURN_ERR( start_track_( remapped ) );
+	
+	Loop_Detector detector;
+	if ( !set_dry_run_( &detector ) )
+		return blargg_ok;
+	*supported = true;
+	
+	// track_filter is only used to catch emulator ending track
+	track_filter.resume( 0, 0 );
+	blargg_err_t err = dry_run_length( detector, max_msec, out );
+	set_dry_run_( NULL );
+	
+	// leave any warning from emulation
+	track_filter.stop();
+	current_track_ = -1;
+	return err;
+}
+
+blargg_err_t Music_Emu::dry_run_length( Loop_Detector& detector, int max_msec, length_estimate_t* out )
+{
+	int const block = 50; // msec
+	
+	// Emulated times are shorter than at normal tempo by tempo factor
+	double const scale = tempo_;
+	max_msec = (int) (max_msec / scale);
+	
+	while ( detector.time() < max_msec )
+	{
+		// emulation error ends track, as when playing
+		blargg_err_t err = dry_run_( block );
+		if ( err )
+		{
+			set_warning( err );
+			track_filter.set_track_ended();
+		}
+		RETURN_ERR( detector.error() );
+		
+		// A very short loop means sound has stopped changing
+		int const min_loop = 250; // msec
+		if ( detector.loop_found() && detector.loop_length() < min_loop )
+		{
+			out->length = (int) (detector.loop_start() * scale);
+			out->method = gme_length_ended;
+			return blargg_ok;
+		}
+		
+		if ( detector.loop_found() )
+		{
+			out->loop_start  = (int) (detector.loop_start()  * scale);
+			out->loop_length = (int) (detector.loop_length() * scale);
+			out->length      = out->loop_start + out->loop_length;
+			out->method      = gme_length_looped;
+			return blargg_ok;
+		}
+		
+		if ( track_filter.emu_track_ended() )
+		{
+			out->length = (int) (detector.time() * scale);
+			out->method = gme_length_ended;
+			return blargg_ok;
+		}
+		
+		// No writes for as long as a loop must repeat means sound won't change
+		int last = max( detector.last_write(), 0 );
+		if ( detector.time() - last >= Loop_Detector::confirm_time )
+		{
+			out->length = (int) (last * scale);
+			out->method = gme_length_ended;
+			return blargg_ok;
+		}
+	}
+	
+	out->length = (int) (max_msec * scale);
+	return blargg_ok;
+}
+
+blargg_err_t Music_Emu::play_length( int track, int max_msec, length_estimate_t* out )
+{
+	RETURN_ERR( start_track( track ) );
+	
+	sample_t buf [1024];
+	while ( !track_ended() && tell() < max_msec )
+		RETURN_ERR( play( (int) (sizeof buf / sizeof *buf), buf ) );
+	
+	int silence;
+	if ( ended_on_silence( &silence ) )
+	{
+		out->length = silence;
+		out->method = gme_length_silence;
+	}
+	else if ( track_ended() )
+	{
+		out->length = tell();
+		out->method = gme_length_ended;
+	}
+	else
+	{
+		out->length = max_msec;
+	}
+	track_filter.stop();
+	current_track_ = -1;
+	return blargg_ok;
+}
+
+// Background lookahead
+
+blargg_err_t Music_Emu::set_background_lookahead( bool enable )
+{
+	keep_file_data( enable );
+	if ( !enable )
+	{
+		delete lookahead_;
+		lookahead_ = NULL;
+		track_filter.set_end_time( -1 );
+		return blargg_ok;
+	}
+	
+	if ( !Track_Lookahead::supported() )
+		return BLARGG_ERR( BLARGG_ERR_LIMITATION, "background threads not supported" );
+	
+	if ( !lookahead_ )
+		CHECK_ALLOC( lookahead_ = BLARGG_NEW Track_Lookahead );
+	
+	if ( current_track_ >= 0 )
+		start_lookahead( current_track_ );
+	return blargg_ok;
+}
+
+void Music_Emu::start_lookahead( int track )
+{
+	if ( !lookahead_ )
+		return;
+	
+	Track_Lookahead::setup_t s;
+	s.type        = type();
+	s.data        = file_begin();
+	s.size        = file_size();
+	s.sample_rate = sample_rate();
+	s.gain        = gain();
+	s.tempo       = tempo_;
+	s.track       = track;
+	s.mute_mask   = mute_mask_;
+	s.equalizer   = equalizer_;
+	s.ym2612_core = ym2612_core_;
+	s.qsound_rate = qsound_rate_;
+	s.resampler_quality = resampler_quality_;
+	s.filter      = tfilter;
+	static Simple_Effects_Buffer::config_t const no_effects = { false, 0, 0, false };
+	s.effects_buffer = (effects_buffer_ != NULL);
+	s.effects = no_effects;
+	if ( effects_buffer_ )
+		s.effects = STATIC_CAST(Simple_Effects_Buffer*,effects_buffer_)->config();
+	if ( remap_track_( &s.track ) )
+		return;
+	
+	// keep result of earlier search of same track, as when seeking backwards
+	if ( !lookahead_->matches( s ) )
+	{
+		lookahead_->stop();
+		if ( file_begin() && !track_filter.silence_ignored() )
+			lookahead_->start( s );
+	}
+	update_lookahead();
+}
+
+void Music_Emu::update_lookahead()
+{
+	if ( !lookahead_ )
+		return;
+	
+	// falls back to normal lookahead if search failed or wasn't started
+	track_filter.set_end_time( lookahead_->end_time() );
+	
+	// keep search a minute ahead of playback, and stop it at end of fade
+	int const lead_secs = 60;
+	double limit = track_filter.sample_count_scaled() + (double) lead_secs * sample_rate();
+	if ( fade_set && length_msec >= 0 )
+		limit = min( limit, (length_msec + fade_msec) * (sample_rate() / 1000.0) * tempo_ );
+	lookahead_->set_limit( (int) min( limit, (double) Track_Filter::indefinite_count ) );
+}
+
+// Seek checkpoints
+
+void Music_Emu::set_seek_checkpoints( int msec, int max_bytes )
+{
+	checkpoint_msec  = max( msec, 0 );
+	checkpoint_limit = max_bytes;
+	clear_checkpoints();
+}
+
+void Music_Emu::clear_checkpoints()
+{
+	checkpoint_count    = 0;
+	checkpoint_size     = -1;
+	checkpoint_track    = current_track_;
+	checkpoint_interval = 0;
+	if ( sample_rate() && checkpoint_msec )
+		checkpoint_interval = msec_to_samples( checkpoint_msec );
+	next_checkpoint     = checkpoint_interval;
+}
+
+void Music_Emu::save_checkpoint()
+{
+	if ( !checkpoint_interval || track_filter.track_ended() )
+		return;
+	
+	int time = track_filter.emu_sample_count();
+	if ( time < next_checkpoint )
+		return;
+	
+	// size changes if emulator switches buffers, making existing states unusable
+	State_Copier measure;
+	int size = copy_state_( measure ) ? measure.size() : 0;
+	if ( size != checkpoint_size )
+	{
+		checkpoint_count = 0;
+		checkpoint_size  = size;
+		int capacity = size ? checkpoint_limit / size : 0;
+		if ( capacity < 2 || checkpoints.resize( capacity ) ||
+				checkpoint_data.resize( (size_t) capacity * size ) )
+		{
+			checkpoints.clear();
+			checkpoint_data.clear();
+			checkpoint_interval = 0; // not supported, or not enough memory
+			return;
+		}
+	}
+	
+	if ( checkpoint_count >= (int) checkpoints.size() )
+	{
+		// keep every other checkpoint and double spacing
+		int n = 0;
+		for ( int i = 1; i < checkpoint_count; i += 2, n++ )
+		{
+			checkpoints [n] = checkpoints [i];
+			memcpy( &checkpoint_data [(size_t) n * checkpoint_size],
+					&checkpoint_data [(size_t) i * checkpoint_size], checkpoint_size );
+		}
+		checkpoint_count = n;
+		if ( checkpoint_interval < INT_MAX / 4 )
+			checkpoint_interval *= 2;
+	}
+	
+	checkpoint_t& cp = checkpoints [checkpoint_count];
+	cp.time        = time;
+	cp.time_scaled = track_filter.sample_count_scaled() +
+			int((time - track_filter.sample_count()) * tempo_ / stereo);
+	State_Copier copier( State_Copier::save, &checkpoint_data [(size_t) checkpoint_count * checkpoint_size] );
+	copy_state_( copier );
+	assert( copier.size() == checkpoint_size );
+	checkpoint_count++;
+	next_checkpoint = time + checkpoint_interval;
+}
+
+bool Music_Emu::load_checkpoint( int time, bool scaled )
+{
+	// latest checkpoint at or before time
+	int i = checkpoint_count;
+	while ( i > 0 && (scaled ? checkpoints [i - 1].time_scaled : checkpoints [i - 1].time) > time )
+		i--;
+	if ( !i )
+		return false;
+	
+	// don't go back if just playing forward from current position is quicker
+	checkpoint_t const& cp = checkpoints [i - 1];
+	int pos = (scaled ? track_filter.sample_count_scaled() : track_filter.sample_count());
+	if ( time >= pos && (scaled ? cp.time_scaled : cp.time) <= pos )
+		return false;
+	
+	State_Copier copier( State_Copier::load, &checkpoint_data [(size_t) (i - 1) * checkpoint_size] );
+	if ( !copy_state_( copier ) )
+	{
+		// saved with a different setup, so none of them are usable
+		clear_checkpoints();
+		return false;
+	}
+	track_filter.resume( cp.time, cp.time_scaled );
+	return true;
+}
+
+// Restarts track at point emulator can quickly get to, if that's closer to time
+// than current position
+bool Music_Emu::load_seek_index( int time )
+{
+	int pos = track_filter.sample_count();
+	int n = seek_index_( time, (time >= pos ? pos : 0) );
+	if ( n < 0 )
+		return false;
+	
+	track_filter.resume( n, int(n * tempo_ / stereo) );
+	return true;
 }
 
 // Gme_Info_
@@ -8,6 +8,9 @@
 #include "Track_Filter.h"
 #include "blargg_errors.h"
 class Multi_Buffer;
+class State_Copier;
+class Track_Lookahead;
+class Loop_Detector;
 
 struct gme_t : public Gme_File, private Track_Filter::callbacks_t {
 public:
@@ -31,6 +34,13 @@ public:
 	typedef short sample_t;
 	blargg_err_t play( int count, sample_t* buf );
 	
+	// Generates 'count' samples for each channel as floats from -1.0 to 1.0, into
+	// separate 'left' and 'right' buffers. Otherwise same as play().
+	blargg_err_t play_float( int count, float left [], float right [] );
+	
+	// Scales play_float() output, so that 1.0 gives -1.0 to 1.0 (the default)
+	void set_float_scale( double );
+	
 // Track information
 	
 	// See Gme_File.h
@@ -63,9 +73,21 @@ public:
 	// Skips n samples
 	blargg_err_t skip( int n );
 	
+	// Saves emulator state every interval_msec while playing or skipping, so that
+	// later seeks resume from the nearest saved point instead of emulating from the
+	// beginning of the track. Saved states use at most max_bytes of memory; once
+	// full, every other one is discarded and the interval doubled. An interval of
+	// 0 disables (the default). Has no effect on emulators that can't save state.
+	// Output after a restored seek is the same as after a normal seek.
+	void set_seek_checkpoints( int interval_msec, int max_bytes );
+	
 	// True if a track has reached its end
 	bool track_ended() const;
 	
+	// True if track was ended by excessive silence rather than by the emulator or
+	// a fade. If so, also sets *silence_msec to time the silence began.
+	bool ended_on_silence( int* silence_msec = NULL ) const;
+	
 	// Sets start time and length of track fade out. Once fade ends track_ended() returns
 	// true. Fade time must be set after track has been started, and can be changed
 	// at any time.
@@ -73,12 +95,26 @@ public:
 	
 	// Disables automatic end-of-track detection and skipping of silence at beginning
 	void ignore_silence( bool disable = true );
+	
+	// Detects end of track by playing a copy of the emulator on a background thread,
+	// rather than by running ahead at high speed within play() during silence.
+	// Should be enabled before loading file, so a copy of its data is kept. Returns
+	// error if threads aren't supported, in which case end is detected as normal.
+	blargg_err_t set_background_lookahead( bool enable = true );
 
 	// Info for currently playing track
 	using Gme_File::track_info;
 	blargg_err_t track_info( track_info_t* out ) const;
 	blargg_err_t set_track_info( const track_info_t* in );
 	blargg_err_t set_track_info( const track_info_t* in, int track_number );
+	
+	// Finds length of track by emulating it without generating sound, for at most
+	// max_msec, and looking for a repeating pattern of sound chip writes. Emulators
+	// that don't support this play the track and use silence detection instead.
+	// Stops current track, so start_track() must be called before playing again.
+	// See gme.h for details.
+	typedef gme_length_estimate_t length_estimate_t;
+	blargg_err_t estimate_length( int track, int max_msec, length_estimate_t* out );
 
 // Voices
 
@@ -95,6 +131,26 @@ public:
 	// 0 unmutes them all, 0x01 mutes just the first voice, etc.
 	void mute_voices( int mask );
 
+// Separate outputs
+
+	// Number of outputs play_outputs() generates separately, or 0 if it isn't
+	// supported. These are the voices, except for VGM files using FM or PCM chips,
+	// which have one output per kind of PSG chip used, then one per group of FM
+	// and PCM chips running at the same rate, named by its first chip.
+	int output_count() const;
+	
+	// Name of output i, from 0 to output_count()-1
+	const char* output_name( int i ) const;
+	
+	// Generates count samples into mix as play() does, and the part of them that
+	// came from output i into outs [i], for each output whose pointer isn't NULL.
+	// Outputs are in stereo like mix, and faded along with it. Silence isn't
+	// looked ahead for while using this, so tracks don't end on silence. Sound
+	// generated before switching from play() in the middle of a track is silent
+	// in outputs, and switching may shift mix by a fraction of a sample for
+	// emulators using voices.
+	blargg_err_t play_outputs( int count, sample_t mix [], sample_t* const outs [] );
+
 // Sound customization
 	
 	// Adjusts song tempo, where 1.0 = normal, 0.5 = half speed, 2.0 = double speed.
@@ -109,6 +165,50 @@ public:
 	// on others this has no effect. Should be called only once *before* set_sample_rate().
 	virtual void set_buffer( class Multi_Buffer* ) { }
 	
+	// Selects YM2612 emulator used by VGM and GYM files, one of the gme_ym2612_*
+	// values in gme.h. Has no effect on other emulators.
+	blargg_err_t set_ym2612_core( int core );
+	
+	// Renders sound chips on count threads, including caller's, or one per
+	// processor if 0. Output is the same as with one thread, the default. Only
+	// supported by VGM files using several FM or PCM chips; has no effect on others.
+	blargg_err_t set_chip_threads( int count );
+	
+	// Starts collecting time and work of each sound chip, or stops if false,
+	// clearing profile collected so far. Only supported by VGM files; has no
+	// effect on others.
+	blargg_err_t enable_profile( bool enabled = true );
+	
+	// Copies profile of up to max chips to out, and returns number of chips
+	// profiled, or 0 if profiling isn't enabled
+	int get_profile( gme_chip_profile_t out [], int max );
+	
+	// Keeps ADPCM samples decoded the first time they're played, using up to
+	// max_bytes per chip, or decodes them every time if 0, the default. Only
+	// supported by VGM files; has no effect on others.
+	blargg_err_t set_sample_cache( long max_bytes );
+	
+	// Mixes QSound chips at rate rather than output rate, which takes less time
+	// but loses treble, or at output rate if 0, the default. Only supported by
+	// VGM files; has no effect on others.
+	blargg_err_t set_qsound_rate( int rate );
+	
+	// Runs SNES DSP a voice at a time for whole samples rather than a clock at a
+	// time, which is faster and gives the same output. Only supported by SPC
+	// files; has no effect on others.
+	blargg_err_t enable_fast_dsp( bool enabled = true );
+	
+	// Sets quality of resampling from chip rates to output rate: 0 for each
+	// type's default, or 1 to 3 for FIR of 8, 16 or 32 points. Higher quality
+	// passes less aliasing but takes longer. Only supported by VGM and GYM
+	// files; has no effect on others.
+	blargg_err_t set_resampler_quality( int quality );
+	
+	// Number of times CPU was found in a busy-wait loop that nothing could end
+	// before its next interrupt or end of frame, and skipped ahead, and number of
+	// CPU clocks skipped, since track started. Zero for music types without a CPU.
+	void spin_stats( long* hits, double* clocks_skipped ) const;
+	
 // Sound equalization (treble/bass)
 
 	// Frequency equalizer parameters (see gme.txt)
@@ -141,6 +241,19 @@ protected:
 	// Sets names of voices
 	void set_voice_names( const char* const names [] );
 	
+	// Sets number of separate outputs, if play_outputs() is supported, and their
+	// names, or NULL if they're the voices
+	void set_output_count( int n )              { output_count_ = n; }
+	void set_output_names( const char* const names [] ) { output_names_ = names; }
+	
+	// While play_outputs() is running, buffers play_() should write each output's
+	// part of samples to, starting at outputs_pos(), skipping NULL ones. NULL while
+	// play() is running. play_() should call outputs_played() with every count of
+	// samples it generates, whether or not it wrote outputs for them.
+	sample_t* const* outputs() const            { return outputs_; }
+	int outputs_pos() const                     { return outputs_pos_; }
+	void outputs_played( int n )                { if ( (outputs_pos_ += n) == outputs_wrap_ ) outputs_pos_ = 0; }
+	
 	// Current gain
 	double gain() const                         { return gain_; }
 	
@@ -173,6 +286,53 @@ protected:
 	
 	// Skip count samples. Count will always be even.
 	virtual blargg_err_t skip_( int count );
+	
+	// Save or restore all emulation state with copier, including buffered output,
+	// or return false if not supported. Restoring must return false without
+	// changing anything if the state can't be used anymore.
+	virtual bool copy_state_( State_Copier& )                   { return false; }
+	
+	// Quickly restart track at a point at or before time, without emulating up
+	// to it, and return the point's time. If not supported, or the point wouldn't
+	// be after min_time, return -1 and leave track as it is.
+	virtual int seek_index_( int /* time */, int /* min_time */ ) { return -1; }
+	
+	// Start dry run, where sound chip register writes are logged to detector
+	// and no sound is generated, or stop it if detector is NULL. Return false
+	// if not supported.
+	virtual bool set_dry_run_( Loop_Detector* )                 { return false; }
+	
+	// Run emulation for msec during dry run
+	virtual blargg_err_t dry_run_( int msec )                   BLARGG_PURE( ; )
+	
+	// Select YM2612 core, already checked to be valid
+	virtual blargg_err_t set_ym2612_core_( int )                { return blargg_ok; }
+	
+	// Set number of threads to render chips on, already checked to be valid
+	virtual blargg_err_t set_chip_threads_( int )               { return blargg_ok; }
+	
+	// Enable or disable chip profiling, and get profile
+	virtual blargg_err_t enable_profile_( bool )                { return blargg_ok; }
+	virtual int get_profile_( gme_chip_profile_t [], int )      { return 0; }
+	
+	// Set size of sample caches, already checked to be valid
+	virtual blargg_err_t set_sample_cache_( long )              { return blargg_ok; }
+	
+	// Set QSound mixing rate, already checked to be valid
+	virtual blargg_err_t set_qsound_rate_( int )                { return blargg_ok; }
+	
+	// Enable or disable fast DSP
+	virtual blargg_err_t enable_fast_dsp_( bool )               { return blargg_ok; }
+	
+	// Set number of points in resampler FIR, or 0 for default
+	virtual blargg_err_t set_resampler_width_( int )            { return blargg_ok; }
+	
+	// Get busy-wait loop statistics, already set to zero
+	virtual void spin_stats_( long*, double* ) const            { }
+	
+	// Start generating outputs separately as well as mixed, or stop. Takes
+	// effect by next call to play_() that generates new samples.
+	virtual blargg_err_t set_outputs_( bool )                   { return blargg_ok; }
 
     // Save current state of file to specified writer.
     virtual blargg_err_t save_( gme_writer_t, void* ) const { return "Not supported by this format"; }
@@ -198,18 +358,66 @@ private:
 	const char* const* voice_names_;
 	int voice_count_;
 	int mute_mask_;
+	
+	// Separate outputs
+	const char* const* output_names_;
+	int output_count_;
+	bool outputs_enabled;
+	sample_t* const* outputs_;
+	int outputs_pos_;
+	int outputs_wrap_;  // outputs_pos_ goes back to 0 when it reaches this
+	blargg_vector<sample_t> ahead_outputs; // outputs of samples start_track() generated ahead
+	blargg_vector<sample_t*> ahead_output_ptrs;
+	bool ahead_kept;    // ahead_outputs are for track_filter.samples_ahead()
+	blargg_err_t enable_outputs( bool );
 	double tempo_;
 	double gain_;
 	int sample_rate_;
+	int ym2612_core_;       // settings copied to background lookahead, -1 if unset
+	int qsound_rate_;
+	int resampler_quality_;
 	int current_track_;
 
     bool fade_set;
     int length_msec;
     int fade_msec;
 	
+	// Seek checkpoints
+	struct checkpoint_t
+	{
+		int time;       // emulator sample count when saved
+		int time_scaled;
+	};
+	blargg_vector<checkpoint_t> checkpoints;
+	blargg_vector<byte> checkpoint_data;
+	int checkpoint_count;
+	int checkpoint_size;    // size of each state, 0 if unsupported, -1 if not yet known
+	int checkpoint_msec;
+	int checkpoint_limit;   // max bytes for checkpoint_data
+	int checkpoint_interval;// samples between checkpoints, 0 if disabled
+	int checkpoint_track;
+	int next_checkpoint;
+	void clear_checkpoints();
+	void save_checkpoint();
+	bool load_checkpoint( int time, bool scaled );
+	bool load_seek_index( int time );
+	
+	// Background lookahead
+	Track_Lookahead* lookahead_;
+	void start_lookahead( int track );
+	void update_lookahead();
+	
 	void clear_track_vars();
 	int msec_to_samples( int msec ) const;
+	blargg_err_t dry_run_length( Loop_Detector&, int max_msec, length_estimate_t* );
 	
+	// Estimates length by dry run only, setting *supported to false and doing
+	// nothing more if emulator doesn't support dry runs
+	blargg_err_t dry_run_estimate( int track, int max_msec, length_estimate_t*, bool* supported );
+	blargg_err_t play_length( int track, int max_msec, length_estimate_t* );
+	
+	friend class Track_Lookahead;
+	friend class Gme_Batch;
 	friend Music_Emu* gme_new_emu( gme_type_t, int );
 	friend void gme_effects( Music_Emu const*, gme_effects_t* );
 	friend void gme_set_effects( Music_Emu*, gme_effects_t const* );
@@ -255,11 +463,13 @@ inline blargg_err_t Music_Emu::set_track_info(const track_info_t *in, int track)
 
 inline int Music_Emu::sample_rate() const           { return sample_rate_; }
 inline int Music_Emu::voice_count() const           { return voice_count_; }
+inline int Music_Emu::output_count() const          { return output_count_; }
 inline int Music_Emu::current_track() const         { return current_track_; }
 inline bool Music_Emu::track_ended() const          { return track_filter.track_ended(); }
 inline const Music_Emu::equalizer_t& Music_Emu::equalizer() const { return equalizer_; }
 
 inline void Music_Emu::ignore_silence( bool b )     { track_filter.ignore_silence( b ); }
+inline void Music_Emu::set_float_scale( double s )  { track_filter.set_float_scale( (float) s ); }
 inline void Music_Emu::set_tempo_( double t )       { tempo_ = t; }
 inline void Music_Emu::remute_voices()              { mute_voices( mute_mask_ ); }
 
@@ -279,6 +489,8 @@ inline blargg_err_t Music_Emu::set_sample_rate_( int ) { return blargg_ok; }
 
 inline blargg_err_t Music_Emu::play_( int, sample_t [] ) { return blargg_ok; }
 
+inline blargg_err_t Music_Emu::dry_run_( int ) { return blargg_ok; }
+
 inline blargg_err_t Music_Emu::hash_( Hash_Function& ) const { return BLARGG_ERR( BLARGG_ERR_CALLER, "no hashing function defined" ); }
 
 inline void Music_Emu::Hash_Function::hash_( byte const*, size_t ) { }
@@ -1,6 +1,7 @@
 // Nes_Snd_Emu $vers. http://www.slack.net/~ant/
 
 #include "Nes_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -392,3 +393,22 @@ int Nes_Apu::read_status( blip_time_t time )
 	
 	return result;
 }
+
+void Nes_Apu::copy_state( State_Copier& copier )
+{
+	copier( square1 );
+	copier( square2 );
+	copier( noise );
+	copier( triangle );
+	copier( dmc );
+	copier( last_time );
+	copier( last_dmc_time );
+	copier( earliest_irq_ );
+	copier( next_irq );
+	copier( frame_period );
+	copier( frame_delay );
+	copier( frame );
+	copier( osc_enables );
+	copier( frame_mode );
+	copier( irq_flag );
+}
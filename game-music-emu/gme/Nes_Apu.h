@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Nes_Oscs.h"
+#include "State_Copier.h"
 
 struct apu_state_t;
 class Nes_Buffer;
@@ -63,6 +64,9 @@ public:
 	void save_state( apu_state_t* out ) const;
 	void load_state( apu_state_t const& );
 	
+	// Saves/restores emulation state to/from same object (see State_Copier.h)
+	void copy_state( State_Copier& );
+	
 	// Sets overall volume (default is 1.0)
 	void volume( double );
 	
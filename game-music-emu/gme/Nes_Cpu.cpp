@@ -54,6 +54,7 @@ void Nes_Cpu::reset( void const* unmapped_page )
 	irq_time_ = future_time;
 	end_time_ = future_time;
 	error_count_ = 0;
+	spin.reset();
 	
 	set_code_page( page_count, unmapped_page );
 	map_code( 0, 0x10000, unmapped_page, page_size );
@@ -5,6 +5,8 @@
 #define NES_CPU_H
 
 #include "blargg_common.h"
+#include "State_Copier.h"
+#include "Spin_Detector.h"
 
 class Nes_Cpu {
 public:
@@ -54,11 +56,18 @@ public:
 	time_t end_time() const         { return end_time_; }
 	void set_end_time( time_t );
 	
+	// Finds busy-wait loops so their time can be skipped. Cleared by reset().
+	Spin_Detector spin;
+	
 	// Number of unimplemented instructions encountered and skipped
 	void clear_error_count()        { error_count_ = 0; }
 	unsigned error_count() const    { return error_count_; }
 	void count_error()              { error_count_++; }
 	
+	// Saves/restores registers, memory mapping and timing. Must not be called
+	// during emulation.
+	void copy_state( State_Copier& );
+	
 	// Unmapped page should be filled with this
 	enum { halt_opcode = 0x22 };
 	
@@ -128,4 +137,14 @@ inline void Nes_Cpu::set_end_time( time_t t )
 	update_end_time( t, irq_time_ );
 }   
 
+inline void Nes_Cpu::copy_state( State_Copier& copier )
+{
+	assert( cpu_state == &cpu_state_ );
+	copier( r );
+	copier( cpu_state_ );
+	copier( irq_time_ );
+	copier( end_time_ );
+	copier( error_count_ );
+}
+
 #endif
@@ -33,6 +33,11 @@ CACHE_TIME() allow the time changing functions to work.
 	// Optional; defaults to READ_MEM.
 	void READ_PPU(  addr_t, int& out );
 	// 0 <= out <= 0xFF
+	
+	// True if reading any address from first to last has no side effects and gives
+	// the same value until CPU writes there, so busy-wait loops reading them can be
+	// skipped. Optional; defaults to false.
+	bool CAN_SKIP_READS( addr_t first, addr_t last );
 
 // The following can be used within macros:
 	
@@ -90,6 +95,10 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 	#define READ_FAST( addr, out )
 #endif
 
+#ifndef CAN_SKIP_READS
+	#define CAN_SKIP_READS( first, last ) 0
+#endif
+
 #ifndef READ_PPU
 	#define READ_PPU( addr, out )\
 	{\
@@ -196,6 +205,12 @@ int const c01 = 0x01; // c
 		SET_FLAGS( temp );
 	}
 	
+	// Busy-wait loop detection. Any jump other than a short one backwards clears
+	// spin_key, so while it's unchanged, CPU has only run forward through loop.
+	int spin_end   = 0;  // end of last instruction that jumped back
+	int spin_key   = -1; // identifies loop CPU is in
+	int spin_count = 0;  // passes until its registers are checked
+	
 loop:
 	
 	// Check all values
@@ -256,11 +271,56 @@ loop:
 	int data;
 	data = *instr;
 	
+	#if GME_COMPUTED_GOTO
+		// Jump straight to instruction's case below
+		static void* const instrs [256] = {
+			&&op_00, &&op_01, &&op_02, &&op_default, &&op_04, &&op_05, &&op_06, &&op_default,
+			&&op_08, &&op_09, &&op_0A, &&op_default, &&op_0C, &&op_0D, &&op_0E, &&op_default,
+			&&op_10, &&op_11, &&op_12, &&op_default, &&op_14, &&op_15, &&op_16, &&op_default,
+			&&op_18, &&op_19, &&op_1A, &&op_default, &&op_1C, &&op_1D, &&op_1E, &&op_default,
+			&&op_20, &&op_21, &&op_22, &&op_default, &&op_24, &&op_25, &&op_26, &&op_default,
+			&&op_28, &&op_29, &&op_2A, &&op_default, &&op_2C, &&op_2D, &&op_2E, &&op_default,
+			&&op_30, &&op_31, &&op_32, &&op_default, &&op_34, &&op_35, &&op_36, &&op_default,
+			&&op_38, &&op_39, &&op_3A, &&op_default, &&op_3C, &&op_3D, &&op_3E, &&op_default,
+			&&op_40, &&op_41, &&op_42, &&op_default, &&op_44, &&op_45, &&op_46, &&op_default,
+			&&op_48, &&op_49, &&op_4A, &&op_default, &&op_4C, &&op_4D, &&op_4E, &&op_default,
+			&&op_50, &&op_51, &&op_52, &&op_default, &&op_54, &&op_55, &&op_56, &&op_default,
+			&&op_58, &&op_59, &&op_5A, &&op_default, &&op_5C, &&op_5D, &&op_5E, &&op_default,
+			&&op_60, &&op_61, &&op_62, &&op_default, &&op_64, &&op_65, &&op_66, &&op_default,
+			&&op_68, &&op_69, &&op_6A, &&op_default, &&op_6C, &&op_6D, &&op_6E, &&op_default,
+			&&op_70, &&op_71, &&op_72, &&op_default, &&op_74, &&op_75, &&op_76, &&op_default,
+			&&op_78, &&op_79, &&op_7A, &&op_default, &&op_7C, &&op_7D, &&op_7E, &&op_default,
+			&&op_80, &&op_81, &&op_82, &&op_default, &&op_84, &&op_85, &&op_86, &&op_default,
+			&&op_88, &&op_89, &&op_8A, &&op_default, &&op_8C, &&op_8D, &&op_8E, &&op_default,
+			&&op_90, &&op_91, &&op_92, &&op_default, &&op_94, &&op_95, &&op_96, &&op_default,
+			&&op_98, &&op_99, &&op_9A, &&op_default, &&op_default, &&op_9D, &&op_default, &&op_default,
+			&&op_A0, &&op_A1, &&op_A2, &&op_default, &&op_A4, &&op_A5, &&op_A6, &&op_default,
+			&&op_A8, &&op_A9, &&op_AA, &&op_default, &&op_AC, &&op_AD, &&op_AE, &&op_default,
+			&&op_B0, &&op_B1, &&op_B2, &&op_default, &&op_B4, &&op_B5, &&op_B6, &&op_default,
+			&&op_B8, &&op_B9, &&op_BA, &&op_default, &&op_BC, &&op_BD, &&op_BE, &&op_default,
+			&&op_C0, &&op_C1, &&op_C2, &&op_default, &&op_C4, &&op_C5, &&op_C6, &&op_default,
+			&&op_C8, &&op_C9, &&op_CA, &&op_default, &&op_CC, &&op_CD, &&op_CE, &&op_default,
+			&&op_D0, &&op_D1, &&op_D2, &&op_default, &&op_D4, &&op_D5, &&op_D6, &&op_default,
+			&&op_D8, &&op_D9, &&op_DA, &&op_default, &&op_DC, &&op_DD, &&op_DE, &&op_default,
+			&&op_E0, &&op_E1, &&op_E2, &&op_default, &&op_E4, &&op_E5, &&op_E6, &&op_default,
+			&&op_E8, &&op_E9, &&op_EA, &&op_EB, &&op_EC, &&op_ED, &&op_EE, &&op_default,
+			&&op_F0, &&op_F1, &&op_F2, &&op_default, &&op_F4, &&op_F5, &&op_F6, &&op_default,
+			&&op_F8, &&op_F9, &&op_FA, &&op_default, &&op_FC, &&op_FD, &&op_FE, &&op_FF
+		};
+		goto *instrs [opcode];
+	#endif
+	
 	switch ( opcode )
 	{
 
 // Macros
 
+#if GME_COMPUTED_GOTO
+	#define OP( n ) case 0x##n: op_##n
+#else
+	#define OP( n ) case 0x##n
+#endif
+
 #define GET_MSB()       (instr [1])
 #define ADD_PAGE( out ) (pc++, out = data + 0x100 * GET_MSB())
 #define GET_ADDR()      GET_LE16( instr )
@@ -280,33 +340,33 @@ loop:
 		out = 0x100 * READ_LOW( BYTE( temp + 1 ) ) + READ_LOW( BYTE( temp ) );\
 	}
 	
-#define ARITH_ADDR_MODES( op )\
-case op - 0x04: /* (ind,x) */\
+#define ARITH_ADDR_MODES( hi, next )\
+OP( hi##1 ): /* (ind,x) */\
 	IND_X( data )\
-	goto ptr##op;\
-case op + 0x0C: /* (ind),y */\
+	goto ptr##hi;\
+OP( next##1 ): /* (ind),y */\
 	IND_Y( PAGE_PENALTY, data )\
-	goto ptr##op;\
-case op + 0x10: /* zp,X */\
+	goto ptr##hi;\
+OP( next##5 ): /* zp,X */\
 	data = BYTE( data + x );\
-case op + 0x00: /* zp */\
+OP( hi##5 ): /* zp */\
 	data = READ_LOW( data );\
-	goto imm##op;\
-case op + 0x14: /* abs,Y */\
+	goto imm##hi;\
+OP( next##9 ): /* abs,Y */\
 	data += y;\
-	goto ind##op;\
-case op + 0x18: /* abs,X */\
+	goto ind##hi;\
+OP( next##D ): /* abs,X */\
 	data += x;\
-ind##op:\
+ind##hi:\
 	PAGE_PENALTY( data );\
-case op + 0x08: /* abs */\
+OP( hi##D ): /* abs */\
 	ADD_PAGE( data );\
-ptr##op:\
+ptr##hi:\
 	FLUSH_TIME();\
 	data = READ_MEM( data );\
 	CACHE_TIME();\
-case op + 0x04: /* imm */\
-imm##op:
+OP( hi##9 ): /* imm */\
+imm##hi:
 
 // TODO: more efficient way to handle negative branch that wraps PC around
 #define BRANCH( cond )\
@@ -316,94 +376,102 @@ imm##op:
 	s_time++;\
 	int offset = SBYTE( data );\
 	s_time += (BYTE(pc) + offset) >> 8 & 1;\
+	spin_end = pc;\
 	pc = WORD( pc + offset );\
+	if ( offset < 0 )\
+		goto jumped_back;\
 	goto loop;\
 }
 
 // Often-Used
 
-	case 0xB5: // LDA zp,x
+	OP( B5 ): // LDA zp,x
 		a = nz = READ_LOW( BYTE( data + x ) );
 		pc++;
 		goto loop;
 	
-	case 0xA5: // LDA zp
+	OP( A5 ): // LDA zp
 		a = nz = READ_LOW( data );
 		pc++;
 		goto loop;
 	
-	case 0xD0: // BNE
+	OP( D0 ): // BNE
 		BRANCH( BYTE( nz ) );
 	
-	case 0x20: { // JSR
+	OP( 20 ): { // JSR
 		int temp = pc + 1;
 		pc = GET_ADDR();
+		spin_key = -1;
 		WRITE_STACK( SP( -1 ), temp >> 8 );
 		sp = SP( -2 );
 		WRITE_STACK( sp, temp );
 		goto loop;
 	}
 	
-	case 0x4C: // JMP abs
+	OP( 4C ): // JMP abs
+		spin_end = pc + 2;
 		pc = GET_ADDR();
+		if ( pc < spin_end )
+			goto jumped_back;
 		goto loop;
 	
-	case 0xE8: // INX
+	OP( E8 ): // INX
 		INC_DEC( x, 1 )
 	
-	case 0x10: // BPL
+	OP( 10 ): // BPL
 		BRANCH( !IS_NEG )
 	
-	ARITH_ADDR_MODES( 0xC5 ) // CMP
+	ARITH_ADDR_MODES( C, D ) // CMP
 		nz = a - data;
 		pc++;
 		c = ~nz;
 		nz &= 0xFF;
 		goto loop;
 	
-	case 0x30: // BMI
+	OP( 30 ): // BMI
 		BRANCH( IS_NEG )
 	
-	case 0xF0: // BEQ
+	OP( F0 ): // BEQ
 		BRANCH( !BYTE( nz ) );
 	
-	case 0x95: // STA zp,x
+	OP( 95 ): // STA zp,x
 		data = BYTE( data + x );
-	case 0x85: // STA zp
+	OP( 85 ): // STA zp
 		pc++;
 		WRITE_LOW( data, a );
 		goto loop;
 	
-	case 0xC8: // INY
+	OP( C8 ): // INY
 		INC_DEC( y, 1 )
 
-	case 0xA8: // TAY
+	OP( A8 ): // TAY
 		y  = a;
 		nz = a;
 		goto loop;
 	
-	case 0x98: // TYA
+	OP( 98 ): // TYA
 		a  = y;
 		nz = y;
 		goto loop;
 	
-	case 0xAD:{// LDA abs
+	OP( AD ):{// LDA abs
 		int addr = GET_ADDR();
 		pc += 2;
 		READ_PPU( addr, a = nz );
 		goto loop;
 	}
 	
-	case 0x60: // RTS
+	OP( 60 ): // RTS
 		pc = 1 + READ_STACK( sp );
 		pc += 0x100 * READ_STACK( SP( 1 ) );
 		sp = SP( 2 );
+		spin_key = -1;
 		goto loop;
 	
 	{
 		int addr;
 		
-	case 0x8D: // STA abs
+	OP( 8D ): // STA abs
 		addr = GET_ADDR();
 		pc += 2;
 		if ( CAN_WRITE_FAST( addr ) )
@@ -417,7 +485,7 @@ imm##op:
 		CACHE_TIME();
 		goto loop;
 	
-	case 0x99: // STA abs,Y
+	OP( 99 ): // STA abs,Y
 		addr = y + GET_ADDR();
 		pc += 2;
 		if ( CAN_WRITE_FAST( addr ) )
@@ -427,7 +495,7 @@ imm##op:
 		}
 		goto sta_abs_x;
 	
-	case 0x9D: // STA abs,X (slightly more common than STA abs)
+	OP( 9D ): // STA abs,X (slightly more common than STA abs)
 		addr = x + GET_ADDR();
 		pc += 2;
 		if ( CAN_WRITE_FAST( addr ) )
@@ -442,21 +510,21 @@ imm##op:
 		CACHE_TIME();
 		goto loop;
 	
-	case 0x91: // STA (ind),Y
+	OP( 91 ): // STA (ind),Y
 		#define NO_PAGE_PENALTY( lsb )
 		IND_Y( NO_PAGE_PENALTY, addr )
 		pc++;
 		DUMMY_READ( addr, y );
 		goto sta_ptr;
 	
-	case 0x81: // STA (ind,X)
+	OP( 81 ): // STA (ind,X)
 		IND_X( addr )
 		pc++;
 		goto sta_ptr;
 	
 	}
 	
-	case 0xA9: // LDA #imm
+	OP( A9 ): // LDA #imm
 		pc++;
 		a  = data;
 		nz = data;
@@ -466,12 +534,12 @@ imm##op:
 	{
 		int addr;
 		
-	case 0xA1: // LDA (ind,X)
+	OP( A1 ): // LDA (ind,X)
 		IND_X( addr )
 		pc++;
 		goto a_nz_read_addr;
 	
-	case 0xB1:// LDA (ind),Y
+	OP( B1 ):// LDA (ind),Y
 		addr = READ_LOW( data ) + y;
 		PAGE_PENALTY( addr );
 		addr += 0x100 * READ_LOW( BYTE( data + 1 ) );
@@ -482,7 +550,7 @@ imm##op:
 		DUMMY_READ( addr, y );
 		goto a_nz_read_addr;
 	
-	case 0xB9: // LDA abs,Y
+	OP( B9 ): // LDA abs,Y
 		PAGE_PENALTY( data + y );
 		addr = GET_ADDR() + y;
 		pc += 2;
@@ -491,7 +559,7 @@ imm##op:
 			goto loop;
 		goto a_nz_read_addr;
 	
-	case 0xBD: // LDA abs,X
+	OP( BD ): // LDA abs,X
 		PAGE_PENALTY( data + x );
 		addr = GET_ADDR() + x;
 		pc += 2;
@@ -509,58 +577,58 @@ imm##op:
 
 // Branch
 
-	case 0x50: // BVC
+	OP( 50 ): // BVC
 		BRANCH( !(flags & v40) )
 	
-	case 0x70: // BVS
+	OP( 70 ): // BVS
 		BRANCH( flags & v40 )
 	
-	case 0xB0: // BCS
+	OP( B0 ): // BCS
 		BRANCH( c & 0x100 )
 	
-	case 0x90: // BCC
+	OP( 90 ): // BCC
 		BRANCH( !(c & 0x100) )
 	
 // Load/store
 	
-	case 0x94: // STY zp,x
+	OP( 94 ): // STY zp,x
 		data = BYTE( data + x );
-	case 0x84: // STY zp
+	OP( 84 ): // STY zp
 		pc++;
 		WRITE_LOW( data, y );
 		goto loop;
 	
-	case 0x96: // STX zp,y
+	OP( 96 ): // STX zp,y
 		data = BYTE( data + y );
-	case 0x86: // STX zp
+	OP( 86 ): // STX zp
 		pc++;
 		WRITE_LOW( data, x );
 		goto loop;
 	
-	case 0xB6: // LDX zp,y
+	OP( B6 ): // LDX zp,y
 		data = BYTE( data + y );
-	case 0xA6: // LDX zp
+	OP( A6 ): // LDX zp
 		data = READ_LOW( data );
-	case 0xA2: // LDX #imm
+	OP( A2 ): // LDX #imm
 		pc++;
 		x = data;
 		nz = data;
 		goto loop;
 	
-	case 0xB4: // LDY zp,x
+	OP( B4 ): // LDY zp,x
 		data = BYTE( data + x );
-	case 0xA4: // LDY zp
+	OP( A4 ): // LDY zp
 		data = READ_LOW( data );
-	case 0xA0: // LDY #imm
+	OP( A0 ): // LDY #imm
 		pc++;
 		y = data;
 		nz = data;
 		goto loop;
 	
-	case 0xBC: // LDY abs,X
+	OP( BC ): // LDY abs,X
 		data += x;
 		PAGE_PENALTY( data );
-	case 0xAC:{// LDY abs
+	OP( AC ):{// LDY abs
 		int addr = data + 0x100 * GET_MSB();
 		pc += 2;
 		FLUSH_TIME();
@@ -569,10 +637,10 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0xBE: // LDX abs,y
+	OP( BE ): // LDX abs,y
 		data += y;
 		PAGE_PENALTY( data );
-	case 0xAE:{// LDX abs
+	OP( AE ):{// LDX abs
 		int addr = data + 0x100 * GET_MSB();
 		pc += 2;
 		FLUSH_TIME();
@@ -583,11 +651,11 @@ imm##op:
 	
 	{
 		int temp;
-	case 0x8C: // STY abs
+	OP( 8C ): // STY abs
 		temp = y;
 		goto store_abs;
 	
-	case 0x8E: // STX abs
+	OP( 8E ): // STX abs
 		temp = x;
 	store_abs:
 		int addr = GET_ADDR();
@@ -605,7 +673,7 @@ imm##op:
 
 // Compare
 
-	case 0xEC:{// CPX abs
+	OP( EC ):{// CPX abs
 		int addr = GET_ADDR();
 		pc++;
 		FLUSH_TIME();
@@ -614,9 +682,9 @@ imm##op:
 		goto cpx_data;
 	}
 	
-	case 0xE4: // CPX zp
+	OP( E4 ): // CPX zp
 		data = READ_LOW( data );
-	case 0xE0: // CPX #imm
+	OP( E0 ): // CPX #imm
 	cpx_data:
 		nz = x - data;
 		pc++;
@@ -624,7 +692,7 @@ imm##op:
 		nz &= 0xFF;
 		goto loop;
 	
-	case 0xCC:{// CPY abs
+	OP( CC ):{// CPY abs
 		int addr = GET_ADDR();
 		pc++;
 		FLUSH_TIME();
@@ -633,9 +701,9 @@ imm##op:
 		goto cpy_data;
 	}
 	
-	case 0xC4: // CPY zp
+	OP( C4 ): // CPY zp
 		data = READ_LOW( data );
-	case 0xC0: // CPY #imm
+	OP( C0 ): // CPY #imm
 	cpy_data:
 		nz = y - data;
 		pc++;
@@ -645,22 +713,22 @@ imm##op:
 	
 // Logical
 
-	ARITH_ADDR_MODES( 0x25 ) // AND
+	ARITH_ADDR_MODES( 2, 3 ) // AND
 		nz = (a &= data);
 		pc++;
 		goto loop;
 	
-	ARITH_ADDR_MODES( 0x45 ) // EOR
+	ARITH_ADDR_MODES( 4, 5 ) // EOR
 		nz = (a ^= data);
 		pc++;
 		goto loop;
 	
-	ARITH_ADDR_MODES( 0x05 ) // ORA
+	ARITH_ADDR_MODES( 0, 1 ) // ORA
 		nz = (a |= data);
 		pc++;
 		goto loop;
 	
-	case 0x2C:{// BIT abs
+	OP( 2C ):{// BIT abs
 		int addr = GET_ADDR();
 		pc += 2;
 		READ_PPU( addr, nz );
@@ -671,7 +739,7 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0x24: // BIT zp
+	OP( 24 ): // BIT zp
 		nz = READ_LOW( data );
 		pc++;
 		flags = (flags & ~v40) + (nz & v40);
@@ -682,12 +750,12 @@ imm##op:
 		
 // Add/subtract
 
-	ARITH_ADDR_MODES( 0xE5 ) // SBC
-	case 0xEB: // unofficial equivalent
+	ARITH_ADDR_MODES( E, F ) // SBC
+	OP( EB ): // unofficial equivalent
 		data ^= 0xFF;
 		goto adc_imm;
 	
-	ARITH_ADDR_MODES( 0x65 ) // ADC
+	ARITH_ADDR_MODES( 6, 7 ) // ADC
 	adc_imm: {
 		int carry = c >> 8 & 1;
 		int ov = (a ^ 0x80) + carry + SBYTE( data );
@@ -700,22 +768,22 @@ imm##op:
 	
 // Shift/rotate
 
-	case 0x4A: // LSR A
+	OP( 4A ): // LSR A
 		c = 0;
-	case 0x6A: // ROR A
+	OP( 6A ): // ROR A
 		nz = c >> 1 & 0x80;
 		c = a << 8;
 		nz += a >> 1;
 		a = nz;
 		goto loop;
 
-	case 0x0A: // ASL A
+	OP( 0A ): // ASL A
 		nz = a << 1;
 		c = nz;
 		a = BYTE( nz );
 		goto loop;
 
-	case 0x2A: { // ROL A
+	OP( 2A ): { // ROL A
 		nz = a << 1;
 		int temp = c >> 8 & 1;
 		c = nz;
@@ -724,11 +792,11 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0x5E: // LSR abs,X
+	OP( 5E ): // LSR abs,X
 		data += x;
-	case 0x4E: // LSR abs
+	OP( 4E ): // LSR abs
 		c = 0;
-	case 0x6E: // ROR abs
+	OP( 6E ): // ROR abs
 	ror_abs: {
 		ADD_PAGE( data );
 		FLUSH_TIME();
@@ -738,15 +806,15 @@ imm##op:
 		goto rotate_common;
 	}
 	
-	case 0x3E: // ROL abs,X
+	OP( 3E ): // ROL abs,X
 		data += x;
 		goto rol_abs;
 	
-	case 0x1E: // ASL abs,X
+	OP( 1E ): // ASL abs,X
 		data += x;
-	case 0x0E: // ASL abs
+	OP( 0E ): // ASL abs
 		c = 0;
-	case 0x2E: // ROL abs
+	OP( 2E ): // ROL abs
 	rol_abs:
 		ADD_PAGE( data );
 		nz = c >> 8 & 1;
@@ -758,19 +826,19 @@ imm##op:
 		CACHE_TIME();
 		goto loop;
 	
-	case 0x7E: // ROR abs,X
+	OP( 7E ): // ROR abs,X
 		data += x;
 		goto ror_abs;
 	
-	case 0x76: // ROR zp,x
+	OP( 76 ): // ROR zp,x
 		data = BYTE( data + x );
 		goto ror_zp;
 	
-	case 0x56: // LSR zp,x
+	OP( 56 ): // LSR zp,x
 		data = BYTE( data + x );
-	case 0x46: // LSR zp
+	OP( 46 ): // LSR zp
 		c = 0;
-	case 0x66: // ROR zp
+	OP( 66 ): // ROR zp
 	ror_zp: {
 		int temp = READ_LOW( data );
 		nz = (c >> 1 & 0x80) + (temp >> 1);
@@ -778,15 +846,15 @@ imm##op:
 		goto write_nz_zp;
 	}
 	
-	case 0x36: // ROL zp,x
+	OP( 36 ): // ROL zp,x
 		data = BYTE( data + x );
 		goto rol_zp;
 	
-	case 0x16: // ASL zp,x
+	OP( 16 ): // ASL zp,x
 		data = BYTE( data + x );
-	case 0x06: // ASL zp
+	OP( 06 ): // ASL zp
 		c = 0;
-	case 0x26: // ROL zp
+	OP( 26 ): // ROL zp
 	rol_zp:
 		nz = c >> 8 & 1;
 		nz += (c = READ_LOW( data ) << 1);
@@ -794,21 +862,21 @@ imm##op:
 	
 // Increment/decrement
 
-	case 0xCA: // DEX
+	OP( CA ): // DEX
 		INC_DEC( x, -1 )
 	
-	case 0x88: // DEY
+	OP( 88 ): // DEY
 		INC_DEC( y, -1 )
 	
-	case 0xF6: // INC zp,x
+	OP( F6 ): // INC zp,x
 		data = BYTE( data + x );
-	case 0xE6: // INC zp
+	OP( E6 ): // INC zp
 		nz = 1;
 		goto add_nz_zp;
 	
-	case 0xD6: // DEC zp,x
+	OP( D6 ): // DEC zp,x
 		data = BYTE( data + x );
-	case 0xC6: // DEC zp
+	OP( C6 ): // DEC zp
 		nz = -1;
 	add_nz_zp:
 		nz += READ_LOW( data );
@@ -817,21 +885,21 @@ imm##op:
 		WRITE_LOW( data, nz );
 		goto loop;
 	
-	case 0xFE: // INC abs,x
+	OP( FE ): // INC abs,x
 		data = x + GET_ADDR();
 		goto inc_ptr;
 	
-	case 0xEE: // INC abs
+	OP( EE ): // INC abs
 		data = GET_ADDR();
 	inc_ptr:
 		nz = 1;
 		goto inc_common;
 	
-	case 0xDE: // DEC abs,x
+	OP( DE ): // DEC abs,x
 		data = x + GET_ADDR();
 		goto dec_ptr;
 	
-	case 0xCE: // DEC abs
+	OP( CE ): // DEC abs
 		data = GET_ADDR();
 	dec_ptr:
 		nz = -1;
@@ -845,39 +913,40 @@ imm##op:
 		
 // Transfer
 
-	case 0xAA: // TAX
+	OP( AA ): // TAX
 		x = nz = a;
 		goto loop;
 		
-	case 0x8A: // TXA
+	OP( 8A ): // TXA
 		a = nz = x;
 		goto loop;
 
-	case 0x9A: // TXS
+	OP( 9A ): // TXS
 		SET_SP( x ); // verified (no flag change)
 		goto loop;
 	
-	case 0xBA: // TSX
+	OP( BA ): // TSX
 		x = nz = GET_SP();
 		goto loop;
 	
 // Stack
 	
-	case 0x48: // PHA
+	OP( 48 ): // PHA
 		sp = SP( -1 );
 		WRITE_STACK( sp, a );
 		goto loop;
 		
-	case 0x68: // PLA
+	OP( 68 ): // PLA
 		a = nz = READ_STACK( sp );
 		sp = SP( 1 );
 		goto loop;
 		
-	case 0x40:{// RTI
+	OP( 40 ):{// RTI
 		pc  = READ_STACK( SP( 1 ) );
 		pc += READ_STACK( SP( 2 ) ) * 0x100;
 		int temp = READ_STACK( sp );
 		sp = SP( 3 );
+		spin_key = -1;
 		data = flags;
 		SET_FLAGS( temp );
 		CPU.r.flags = flags; // update externally-visible I flag
@@ -889,7 +958,7 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0x28:{// PLP
+	OP( 28 ):{// PLP
 		int temp = READ_STACK( sp );
 		sp = SP( 1 );
 		int changed = flags ^ temp;
@@ -901,7 +970,7 @@ imm##op:
 		goto handle_cli;
 	}
 	
-	case 0x08:{// PHP
+	OP( 08 ):{// PHP
 		int temp;
 		GET_FLAGS( temp );
 		sp = SP( -1 );
@@ -909,41 +978,42 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0x6C:{// JMP (ind)
+	OP( 6C ):{// JMP (ind)
 		data = GET_ADDR();
 		byte const* page = CODE_PAGE( data );
 		pc = page [CODE_OFFSET( data )];
 		data = (data & 0xFF00) + ((data + 1) & 0xFF);
 		pc += page [CODE_OFFSET( data )] * 0x100;
+		spin_key = -1;
 		goto loop;
 	}
 	
-	case 0x00: // BRK
+	OP( 00 ): // BRK
 		goto handle_brk;
 	
 // Flags
 
-	case 0x38: // SEC
+	OP( 38 ): // SEC
 		c = 0x100;
 		goto loop;
 	
-	case 0x18: // CLC
+	OP( 18 ): // CLC
 		c = 0;
 		goto loop;
 		
-	case 0xB8: // CLV
+	OP( B8 ): // CLV
 		flags &= ~v40;
 		goto loop;
 	
-	case 0xD8: // CLD
+	OP( D8 ): // CLD
 		flags &= ~d08;
 		goto loop;
 	
-	case 0xF8: // SED
+	OP( F8 ): // SED
 		flags |= d08;
 		goto loop;
 	
-	case 0x58: // CLI
+	OP( 58 ): // CLI
 		if ( !(flags & i04) )
 			goto loop;
 		flags &= ~i04;
@@ -976,7 +1046,7 @@ imm##op:
 		goto loop;
 	}
 	
-	case 0x78: // SEI
+	OP( 78 ): // SEI
 		if ( flags & i04 )
 			goto loop;
 		flags |= i04;
@@ -995,36 +1065,39 @@ imm##op:
 // Unofficial
 	
 	// SKW - skip word
-	case 0x1C: case 0x3C: case 0x5C: case 0x7C: case 0xDC: case 0xFC:
+	OP( 1C ): OP( 3C ): OP( 5C ): OP( 7C ): OP( DC ): OP( FC ):
 		PAGE_PENALTY( data + x );
-	case 0x0C:
+	OP( 0C ):
 		pc++;
 	// SKB - skip byte
-	case 0x74: case 0x04: case 0x14: case 0x34: case 0x44: case 0x54: case 0x64:
-	case 0x80: case 0x82: case 0x89: case 0xC2: case 0xD4: case 0xE2: case 0xF4:
+	OP( 74 ): OP( 04 ): OP( 14 ): OP( 34 ): OP( 44 ): OP( 54 ): OP( 64 ):
+	OP( 80 ): OP( 82 ): OP( 89 ): OP( C2 ): OP( D4 ): OP( E2 ): OP( F4 ):
 		pc++;
 		goto loop;
 	
 	// NOP
-	case 0xEA: case 0x1A: case 0x3A: case 0x5A: case 0x7A: case 0xDA: case 0xFA:
+	OP( EA ): OP( 1A ): OP( 3A ): OP( 5A ): OP( 7A ): OP( DA ): OP( FA ):
 		goto loop;
 	
-	case Nes_Cpu::halt_opcode: // HLT - halt processor
+	OP( 22 ): // HLT - halt processor
 		if ( pc-- > 0x10000 )
 		{
 			// handle wrap-around (assumes caller has put page of HLT at 0x10000)
 			pc = WORD( pc );
 			goto loop;
 		}
-	case 0x02: case 0x12:            case 0x32: case 0x42: case 0x52:
-	case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:
+	OP( 02 ): OP( 12 ):            OP( 32 ): OP( 42 ): OP( 52 ):
+	OP( 62 ): OP( 72 ): OP( 92 ): OP( B2 ): OP( D2 ): OP( F2 ):
 		goto stop;
 	
 // Unimplemented
 	
-	case 0xFF:  // force 256-entry jump table for optimization purposes
+	OP( FF ):  // force 256-entry jump table for optimization purposes
 		c |= 1; // compiler doesn't know that this won't affect anything
 	default:
+	#if GME_COMPUTED_GOTO
+	op_default:
+	#endif
 		check( (unsigned) opcode < 0x100 );
 		
 		#ifdef UNIMPL_INSTR
@@ -1064,6 +1137,7 @@ interrupt:
 #endif
 	{
 		s_time += 7;
+		spin_key = -1;
 		
 		// Save PC and read vector
 		WRITE_STACK( SP( -1 ), pc >> 8 );
@@ -1089,6 +1163,53 @@ interrupt:
 		goto loop;
 	}
 	
+jumped_back:
+	// Every few passes of a short loop, checks whether it's only waiting for the
+	// next interrupt or end of emulation, and if so skips its whole periods
+	if ( (unsigned) (spin_end - pc) <= Spin_Detector::max_size )
+	{
+		int key = (spin_end - pc) << 16 | pc;
+		if ( spin_key != key )
+		{
+			spin_key   = key;
+			spin_count = Spin_Detector::check_interval - 1;
+			CPU.spin.forget();
+		}
+		
+		if ( --spin_count < 0 )
+		{
+			spin_count = Spin_Detector::check_interval - 1;
+			int const regs [] = { a, x, y, sp, flags, c, nz };
+			if ( CPU.spin.repeated( regs, sizeof regs / sizeof *regs, TIME() ) )
+			{
+				// Instructions must have no side effects, and branches within
+				// loop must go to one of them
+				int addr = pc;
+				unsigned starts  = 0;
+				unsigned targets = 0;
+				while ( addr < spin_end )
+				{
+					Spin_Detector::instr_t in = Spin_Detector::decode_6502( addr, &READ_CODE( addr ) );
+					if ( !in.size )
+						break;
+					if ( in.read == Spin_Detector::mem_read &&
+							!CAN_SKIP_READS( in.addr, in.addr + in.span - 1 ) )
+						break;
+					starts |= 1u << (addr - pc);
+					if ( (unsigned) (in.target - pc) < (unsigned) (spin_end - pc) )
+						targets |= 1u << (in.target - pc);
+					addr += in.size;
+				}
+				
+				if ( addr == spin_end && !(targets & ~starts) )
+					s_time += CPU.spin.skip( -s_time );
+				else
+					spin_count = INT_MAX; // don't check again
+			}
+		}
+	}
+	goto loop;
+	
 out_of_time:
 	pc--;
 	
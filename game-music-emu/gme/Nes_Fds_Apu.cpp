@@ -1,6 +1,7 @@
 // Game_Music_Emu $vers. http://www.slack.net/~ant/
 
 #include "Nes_Fds_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -278,3 +279,22 @@ void Nes_Fds_Apu::run_until( blip_time_t final_end_time )
 	}
 	last_time = final_end_time;
 }
+
+void Nes_Fds_Apu::copy_state( State_Copier& copier )
+{
+	copier( regs_ );
+	copier( env_delay );
+	copier( env_speed );
+	copier( env_gain );
+	copier( sweep_delay );
+	copier( sweep_speed );
+	copier( sweep_gain );
+	copier( wave_pos );
+	copier( last_amp );
+	copier( wave_fract );
+	copier( mod_fract );
+	copier( mod_pos );
+	copier( mod_write_pos );
+	copier( mod_wave );
+	copier( last_time );
+}
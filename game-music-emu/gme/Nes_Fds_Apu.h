@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 class Nes_Fds_Apu {
 public:
@@ -23,6 +24,7 @@ public:
 	void write( blip_time_t time, unsigned addr, int data );
 	int read( blip_time_t time, unsigned addr );
 	void end_frame( blip_time_t );
+	void copy_state( State_Copier& );
 	
 public:
 	Nes_Fds_Apu();
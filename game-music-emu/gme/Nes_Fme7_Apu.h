@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 struct fme7_apu_state_t
 {
@@ -28,6 +29,7 @@ public:
 	void end_frame( blip_time_t );
 	void save_state( fme7_apu_state_t* ) const;
 	void load_state( fme7_apu_state_t const& );
+	void copy_state( State_Copier& );
 	
 	// Mask and addresses of registers
 	enum { addr_mask = 0xE000 };
@@ -121,6 +123,14 @@ inline void Nes_Fme7_Apu::save_state( fme7_apu_state_t* out ) const
 	*out = *this;
 }
 
+inline void Nes_Fme7_Apu::copy_state( State_Copier& copier )
+{
+	fme7_apu_state_t* state = this;
+	copier( *state );
+	copier( oscs );
+	copier( last_time );
+}
+
 inline void Nes_Fme7_Apu::load_state( fme7_apu_state_t const& in )
 {
 	reset();
@@ -20,6 +20,8 @@ public:
 	enum { exram_size = 1024 };
 	unsigned char exram [exram_size];
 	
+	void copy_state( State_Copier& );
+	
 	BLARGG_DEPRECATED_TEXT( enum { start_addr = 0x5000 }; )
 	BLARGG_DEPRECATED_TEXT( enum { end_addr   = 0x5015 }; )
 };
@@ -33,6 +35,12 @@ inline void Nes_Mmc5_Apu::set_output( int i, Blip_Buffer* b )
 	Nes_Apu::set_output( i, b );
 }
 
+inline void Nes_Mmc5_Apu::copy_state( State_Copier& copier )
+{
+	Nes_Apu::copy_state( copier );
+	copier( exram );
+}
+
 inline void Nes_Mmc5_Apu::set_output( Blip_Buffer* b )
 {
 	set_output( 0, b );
@@ -1,6 +1,7 @@
 // Nes_Snd_Emu $vers. http://www.slack.net/~ant/
 
 #include "Nes_Namco_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2003-2006 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -150,3 +151,10 @@ void Nes_Namco_Apu::run_until( blip_time_t nes_end_time )
 	last_time = nes_end_time;
 }
 
+void Nes_Namco_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( last_time );
+	copier( addr_reg );
+	copier( reg );
+}
@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 struct namco_state_t;
 
@@ -32,6 +33,7 @@ public:
 	// to do: implement save/restore
 	void save_state( namco_state_t* out ) const;
 	void load_state( namco_state_t const& );
+	void copy_state( State_Copier& );
 	
 public:
 	Nes_Namco_Apu();
@@ -1,6 +1,7 @@
 // Nes_Snd_Emu $vers. http://www.slack.net/~ant/
 
 #include "Nes_Vrc6_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2003-2006 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -214,3 +215,8 @@ void Nes_Vrc6_Apu::run_saw( blip_time_t end_time )
 	osc.last_amp = last_amp;
 }
 
+void Nes_Vrc6_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( last_time );
+}
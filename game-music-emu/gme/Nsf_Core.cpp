@@ -244,6 +244,23 @@ void Nsf_Core::cpu_write( addr_t addr, int data )
 	return Nsf_Impl::cpu_write( addr, data );
 }
 
+bool Nsf_Core::copy_state( State_Copier& copier )
+{
+	#if !NSF_EMU_APU_ONLY
+		if ( vrc7 )
+			return false; // FM synthesis state isn't accessible
+		
+		if ( fds   ) fds  ->copy_state( copier );
+		if ( fme7  ) fme7 ->copy_state( copier );
+		if ( mmc5  ) mmc5 ->copy_state( copier );
+		if ( namco ) namco->copy_state( copier );
+		if ( vrc6  ) vrc6 ->copy_state( copier );
+	#endif
+	
+	copier( mmc5_mul );
+	return Nsf_Impl::copy_state( copier );
+}
+
 void Nsf_Core::unmapped_write( addr_t addr, int data )
 {
 	switch ( addr )
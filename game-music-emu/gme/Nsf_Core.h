@@ -48,6 +48,7 @@ public:
 	virtual void unload();
 	virtual blargg_err_t start_track( int );
 	virtual void end_frame( time_t );
+	virtual bool copy_state( State_Copier& );
 
 protected:
 	virtual blargg_err_t post_load();
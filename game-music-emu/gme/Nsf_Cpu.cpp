@@ -4,6 +4,8 @@
 
 #include "Nsf_Impl.h"
 
+#include "Loop_Detector.h"
+
 #include "blargg_endian.h"
 
 #ifdef BLARGG_DEBUG_H
@@ -72,6 +74,8 @@ void Nsf_Impl::write_mem( addr_t addr, int data )
 			}
 			else if ( (unsigned) (addr - apu.io_addr) < apu.io_size )
 			{
+				if ( loop_detector )
+					loop_detector->write( time(), addr, data );
 				apu.write_register( time(), addr, data );
 			}
 			else
@@ -83,7 +87,12 @@ void Nsf_Impl::write_mem( addr_t addr, int data )
 					fdsram() [i] = data;
 				else
 			#endif
-				cpu_write( addr, data );
+				{
+					// expansion sound chips
+					if ( loop_detector )
+						loop_detector->write( time(), addr, data );
+					cpu_write( addr, data );
+				}
 			}
 		}
 	}
@@ -99,6 +108,9 @@ void Nsf_Impl::write_mem( addr_t addr, int data )
 #define CAN_READ_FAST( addr )   ((addr ^ 0x8000) < 0xA000)
 #define READ_FAST( addr, out  ) (LOG_MEM( addr, ">", out = READ_CODE( addr ) ))
 
+// low RAM, SRAM, and ROM
+#define CAN_SKIP_READS( first, last ) ((unsigned) (last) < 0x2000 || (first) >= sram_addr)
+
 #define READ_MEM(  addr       ) read_mem(  addr )
 #define WRITE_MEM( addr, data ) write_mem( addr, data )
 
@@ -271,7 +271,11 @@ blargg_err_t Nsf_Emu::init_sound()
 
 blargg_err_t Nsf_Emu::load_( Data_Reader& in )
 {
-	RETURN_ERR( core_.load( in ) );
+	// Core can use file data in place too if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( core_.load_mem( file_begin(), file_size() ) );
+	else
+		RETURN_ERR( core_.load( in ) );
 	set_track_count( header().track_count );
 	RETURN_ERR( check_nsf_header( header() ) );
 	set_warning( core_.warning() );
@@ -339,6 +343,23 @@ blargg_err_t Nsf_Emu::run_clocks( blip_time_t& duration, int )
 	return blargg_ok;
 }
 
+bool Nsf_Emu::copy_core_state( State_Copier& copier )
+{
+	return core_.copy_state( copier );
+}
+
+bool Nsf_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core_.set_loop_detector( d );
+	return true;
+}
+
+void Nsf_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core_.spin_detector().hits();
+	*clocks_skipped = core_.spin_detector().clocks_skipped();
+}
+
 blargg_err_t Nsf_Emu::hash_( Hash_Function& out ) const
 {
 	hash_nsf_file( header(), core_.rom_().begin(), core_.rom_().file_size(), out );
@@ -40,6 +40,9 @@ protected:
 	virtual void set_tempo_( double );
 	virtual void set_voice( int, Blip_Buffer*, Blip_Buffer*, Blip_Buffer* );
 	virtual void update_eq( blip_eq_t const& );
+	virtual bool copy_core_state( State_Copier& );
+	virtual bool set_loop_detector( Loop_Detector* );
+	virtual void spin_stats_( long*, double* ) const;
 	
 private:
 	enum { max_voices = 32 };
@@ -3,6 +3,7 @@
 #include "Nsf_Impl.h"
 
 #include "blargg_endian.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -35,6 +36,7 @@ int Nsf_Impl::pcm_read( void* self, int addr )
 Nsf_Impl::Nsf_Impl() : rom( bank_size ), enable_w4011( true )
 {
 	apu.dmc_reader( pcm_read, this );
+	loop_detector = NULL;
 	assert( offsetof (header_t,unused [4]) == header_t::size );
 }
 
@@ -96,7 +98,11 @@ Nsf_Impl::addr_t Nsf_Impl::get_addr( byte const in [] )
 blargg_err_t Nsf_Impl::load_( Data_Reader& in )
 {
 	// pad ROM data with 0
-	RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
+	// Use file data in place if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( rom.borrow( file_begin(), file_size(), header_.size, &header_, 0 ) );
+	else
+		RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
 	
 	if ( !header_.valid_tag() )
 		return blargg_err_file_type;
@@ -326,3 +332,17 @@ void Nsf_Impl::end_frame( time_t end )
 	
 	apu.end_frame( end );
 }
+
+bool Nsf_Impl::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	apu.copy_state( copier );
+	copier.copy( high_ram.begin(), (int) high_ram.size() );
+	copier( low_ram );
+	copier( next_play );
+	copier( play_period );
+	copier( play_extra );
+	copier( play_delay );
+	copier( saved_state );
+	return true;
+}
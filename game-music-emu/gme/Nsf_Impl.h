@@ -8,6 +8,7 @@
 #include "Nes_Cpu.h"
 #include "Rom_Data.h"
 #include "Nes_Apu.h"
+class Loop_Detector;
 
 // NSF file header
 struct nsf_header_t
@@ -90,8 +91,18 @@ public:
 	
 	// Time emulated to
 	time_t time() const             { return cpu.time(); }
+	
+	// Saves/restores CPU, memory and sound chip state between frames, or returns
+	// false if not supported by current file (see State_Copier.h)
+	virtual bool copy_state( State_Copier& );
 
 	void enable_w4011_(bool enable = true) { enable_w4011 = enable; }
+	
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
 
 	Rom_Data const& rom_() const { return rom; }
 	
@@ -169,6 +180,7 @@ private:
 	int play_extra;
 	int play_delay;
 	bool enable_w4011;
+	Loop_Detector* loop_detector;
 	Nes_Cpu::registers_t saved_state; // of interrupted init routine
 	
 	// Large objects after others
@@ -3,7 +3,11 @@
 #include "Okim6295_Emu.h"
 #include "okim6295.h"
 
-Okim6295_Emu::Okim6295_Emu() { chip = 0; }
+Okim6295_Emu::Okim6295_Emu()
+{
+	chip = 0;
+	cache_budget = 0;
+}
 
 Okim6295_Emu::~Okim6295_Emu()
 {
@@ -22,6 +26,8 @@ int Okim6295_Emu::set_rate( int clock_rate )
 	if ( !chip )
 		return 0;
 	
+	if ( cache_budget )
+		okim6295_set_cache( chip, cache_budget );
 	reset();
 	return (clock_rate & 0x7FFFFFFF) / ((clock_rate & 0x80000000) ? 132 : 165);
 }
@@ -42,6 +48,23 @@ void Okim6295_Emu::write_rom( int size, int start, int length, void * data )
 	okim6295_write_rom( chip, size, start, length, (const UINT8 *) data );
 }
 
+void Okim6295_Emu::set_cache( int budget )
+{
+	cache_budget = budget;
+	if ( chip )
+		okim6295_set_cache( chip, budget );
+}
+
+void Okim6295_Emu::cache_stats( long* bytes, long* hits, long* misses ) const
+{
+	UINT32 b = 0, h = 0, m = 0;
+	if ( chip )
+		okim6295_get_cache_stats( chip, &b, &h, &m );
+	*bytes  = b;
+	*hits   = h;
+	*misses = m;
+}
+
 void Okim6295_Emu::mute_voices( int mask )
 {
 	okim6295_set_mute_mask( chip, mask );
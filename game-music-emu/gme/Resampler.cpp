@@ -2,6 +2,8 @@
 
 #include "Resampler.h"
 
+#include "State_Copier.h"
+
 /* Copyright (C) 2004-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -17,6 +19,7 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
 Resampler::Resampler()
 {
+	read_pos  = 0;
 	write_pos = 0;
 	rate_     = 0;
 }
@@ -25,10 +28,20 @@ Resampler::~Resampler() { }
 
 void Resampler::clear()
 {
+	read_pos  = 0;
 	write_pos = 0;
 	clear_();
 }
 
+void Resampler::copy_state( State_Copier& copier )
+{
+	copier( read_pos );
+	copier( write_pos );
+	if ( buf.size() )
+		copier.copy( buf.begin(), buf.size() * sizeof buf [0] );
+	copy_state_( copier );
+}
+
 inline int Resampler::resample_wrapper( sample_t out [], int* out_size,
 		sample_t const in [], int in_size )
 {
@@ -54,26 +67,34 @@ int Resampler::resample( sample_t out [], int out_size, sample_t const in [], in
 
 blargg_err_t Resampler::resize_buffer( int new_size )
 {
-	RETURN_ERR( buf.resize( new_size ) );
+	RETURN_ERR( buf.resize( new_size * 2 ) );
 	clear();
 	return blargg_ok;
 }
 
 int Resampler::skip_input( int count )
 {
-	write_pos -= count;
-	if ( write_pos < 0 ) // occurs when downsampling
+	int remain = written() - count;
+	if ( remain < 0 ) // occurs when downsampling
+	{
+		count += remain;
+		remain = 0;
+	}
+	read_pos += count;
+	
+	// buffer_free() assumes read_pos is within first half
+	if ( !remain || read_pos > (int) (buf.size() >> 1) )
 	{
-		count += write_pos;
-		write_pos = 0;
+		memmove( buf.begin(), &buf [read_pos], remain * sizeof buf [0] );
+		read_pos  = 0;
+		write_pos = remain;
 	}
-	memmove( buf.begin(), &buf [count], write_pos * sizeof buf [0] );
 	return count;
 }
 
 int Resampler::read( sample_t out [], int out_size )
 {
 	if ( out_size )
-		skip_input( resample_wrapper( out, &out_size, buf.begin(), write_pos ) );
+		skip_input( resample_wrapper( out, &out_size, &buf [read_pos], written() ) );
 	return out_size;
 }
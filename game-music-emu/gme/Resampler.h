@@ -6,6 +6,8 @@
 
 #include "blargg_common.h"
 
+class State_Copier;
+
 class Resampler {
 public:
 	
@@ -42,7 +44,7 @@ public:
 	int write( sample_t const in [], int n );
 	
 	// Number of input samples in buffer
-	int written() const             { return write_pos; }
+	int written() const             { return write_pos - read_pos; }
 	
 	// Removes first n input samples from buffer, fewer if there aren't that many.
 	// Returns number of samples actually removed.
@@ -59,18 +61,27 @@ public:
 	sample_t* buffer()              { return &buf [write_pos]; }
 	
 	// Number of samples that can be written to buffer()
-	int buffer_free() const         { return buf.size() - write_pos; }
+	int buffer_free() const         { return (buf.size() >> 1) - written(); }
 	
 	// Notifies resampler that n input samples have been written to buffer().
 	// N must not be greater than buffer_free().
 	void write( int n );
 
+// State save/load
+
+	// Saves/restores input buffer and position between input samples. Rate
+	// must be the same when restoring (see State_Copier.h).
+	void copy_state( State_Copier& );
+
 // Derived interface
 protected:
 	virtual blargg_err_t set_rate_( double rate ) BLARGG_PURE( ; )
 	
 	virtual void clear_() { }
 	
+	// Save/restore position between input samples
+	virtual void copy_state_( State_Copier& ) { }
+	
 	// Resample as many available in samples as will fit within out_size and
 	// return pointer past last input sample read and set *out just past
 	// the last output sample.
@@ -82,7 +93,10 @@ public:
 	Resampler();
 
 private:
+	// Twice the requested size, so that removed input only needs to be moved
+	// down once the read position passes the middle
 	blargg_vector<sample_t> buf;
+	int read_pos;
 	int write_pos;
 	double rate_;
 	
@@ -20,7 +20,11 @@ void Rom_Data::clear()
 	file_size_ = 0;
 	rom_addr   = 0;
 	mask       = 0;
+	rom_size   = 0;
+	fill_      = 0;
+	borrowed   = NULL;
 	rom.clear();
+	tail.clear();
 }
 
 Rom_Data::Rom_Data( int page_size ) :
@@ -64,10 +68,53 @@ blargg_err_t Rom_Data::load( Data_Reader& in, int header_size,
 	
 	memset( rom.begin()         , fill, pad_size );
 	memset( rom.end() - pad_size, fill, pad_size );
+	rom_size = rom.size();
 	
 	return blargg_ok;
 }
 
+blargg_err_t Rom_Data::borrow( void const* data, int size, int header_size,
+		void* header_out, int fill )
+{
+	// Small files aren't worth the trouble, and ends must not overlap
+	if ( size - header_size < pad_size * 4 )
+	{
+		Mem_File_Reader in( data, size );
+		return load( in, header_size, header_out, fill );
+	}
+	
+	clear();
+	byte const* in = STATIC_CAST(byte const*,data);
+	memcpy( header_out, in, header_size );
+	borrowed   = in + header_size;
+	file_size_ = size - header_size;
+	fill_      = fill;
+	rom_size   = pad_size + file_size_ + pad_size;
+	
+	// Unmapped page, then first page of file
+	blargg_err_t err = rom.resize( pad_size * 2 );
+	if ( !err )
+		err = fill_tail();
+	if ( err )
+	{
+		clear();
+		return err;
+	}
+	memset( rom.begin(), fill, pad_size );
+	memcpy( &rom [pad_size], borrowed, pad_size );
+	
+	return blargg_ok;
+}
+
+// Copies end of borrowed file data to tail, followed by fill up to rom_size
+blargg_err_t Rom_Data::fill_tail()
+{
+	RETURN_ERR( tail.resize( rom_size - file_size_ ) );
+	memcpy( tail.begin(), borrowed + file_size_ - pad_size, pad_size );
+	memset( &tail [pad_size], fill_, tail.size() - pad_size );
+	return blargg_ok;
+}
+
 void Rom_Data::set_addr( int addr )
 {
 	int const page_size = pad_size - pad_extra;
@@ -84,16 +131,35 @@ void Rom_Data::set_addr( int addr )
 	
 	// Address of first byte of ROM (possibly negative)
 	rom_addr = addr - page_size - pad_extra;
-
+	
+	if ( borrowed )
+	{
+		rom_size = size - rom_addr + pad_extra;
+		if ( fill_tail() ) // OK if shrink fails
+			rom_size = min( rom_size, file_size_ + (int) tail.size() );
+		return;
+	}
+	
 	if ( rom.resize( size - rom_addr + pad_extra ) ) { } // OK if shrink fails
+	rom_size = rom.size();
 }
 
 byte* Rom_Data::at_addr( int addr )
 {
 	int offset = mask_addr( addr ) - rom_addr;
 	
-	if ( (unsigned) offset > (unsigned) (rom.size() - pad_size) )
+	if ( (unsigned) offset > (unsigned) (rom_size - pad_size) )
 		offset = 0; // unmapped
 	
+	if ( borrowed && offset >= pad_size )
+	{
+		// Last page and padding after it are in tail
+		if ( offset >= file_size_ )
+			return &tail [offset - file_size_];
+		
+		// Page is entirely within file data. CPUs only read from ROM pages.
+		return CONST_CAST(byte*,borrowed) + (offset - pad_size);
+	}
+	
 	return &rom [offset];
 }
@@ -16,6 +16,9 @@ caller, as is the starting address of the ROM data following it. File loading is
 performed with a single read, rather than two or more that might otherwise be
 required.
 
+* ROM data already in memory can be used in place instead. Only the pages at each
+end, which are partly fill, are copied.
+
 * Once ROM data is loaded and its address specified, a pointer to any "page" can
 be obtained. ROM data is mirrored using smallest power of 2 that contains it.
 Addresses not aligned to pages can also be used, but this might cause unexpected
@@ -48,14 +51,18 @@ public:
 	// if in.remain() <= header_size.
 	blargg_err_t load( Data_Reader& in, int header_size, void* header_out, int fill );
 	
+	// Same as load(), but uses file data in memory in place rather than copying it,
+	// except for a page or so at each end. Data MUST NOT be changed or freed until
+	// clear() is called or a different file is loaded.
+	blargg_err_t borrow( void const* data, int size, int header_size, void* header_out, int fill );
+	
 	// Below, "file data" refers to data AFTER the header
 	
 	// Size of file data
 	int file_size() const               { return file_size_; }
 	
 	// Pointer to beginning of file data
-	byte      * begin()                 { return rom.begin() + pad_size; }
-	byte const* begin() const           { return rom.begin() + pad_size; }
+	byte const* begin() const           { return borrowed ? borrowed : rom.begin() + pad_size; }
 	
 	// Pointer to unmapped page cleared with fill value
 	byte* unmapped()                    { return rom.begin(); }
@@ -65,7 +72,7 @@ public:
 	void set_addr( int addr );
 	
 	// Address of first empty page (file size + addr rounded up to multiple of page_size)
-	int size() const                    { return rom.size() - pad_extra + rom_addr; }
+	int size() const                    { return rom_size - pad_extra + rom_addr; }
 	
 	// Masks address to nearest power of two greater than size()
 	int mask_addr( int addr ) const     { return addr & mask; }
@@ -82,13 +89,18 @@ public:
 	~Rom_Data();
 
 protected:
-	blargg_vector<byte> rom;
+	blargg_vector<byte> rom;    // padded file data, or just first page of it if borrowed
+	blargg_vector<byte> tail;   // last page of borrowed file data, and padding after
+	byte const* borrowed;       // file data in caller's memory, or NULL if copied
+	int rom_size;               // size rom would be if it held all of file data
 	int mask;
 	int rom_addr;
 	int const pad_size;
 	int file_size_;
+	int fill_;
 	
 	blargg_err_t load_( Data_Reader& in, int header_size, int file_offset );
+	blargg_err_t fill_tail();
 };
 
 #endif
@@ -1,6 +1,7 @@
 // Game_Music_Emu $vers. http://www.slack.net/~ant/
 
 #include "Sap_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2006-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -337,3 +338,13 @@ void Sap_Apu::end_frame( blip_time_t end_time )
 	last_time -= end_time;
 	assert( last_time >= 0 );
 }
+
+void Sap_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( last_time );
+	copier( poly5_pos );
+	copier( poly4_pos );
+	copier( polym_pos );
+	copier( control );
+}
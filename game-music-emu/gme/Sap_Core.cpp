@@ -20,6 +20,7 @@ int const idle_addr = 0xD2D2;
 Sap_Core::Sap_Core()
 {
 	set_tempo( 1 );
+	loop_detector = NULL;
 }
 
 void Sap_Core::push( int b )
@@ -190,3 +191,16 @@ blargg_err_t Sap_Core::end_frame( time_t end )
 	
 	return blargg_ok;
 }
+
+void Sap_Core::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	apu_ .copy_state( copier );
+	apu2_.copy_state( copier );
+	copier( mem.ram );
+	copier( scanline_period );
+	copier( next_play );
+	copier( time_mask );
+	copier( frame_start );
+	copier( saved_state );
+}
@@ -6,6 +6,7 @@
 
 #include "Sap_Apu.h"
 #include "Nes_Cpu.h"
+class Loop_Detector;
 
 class Sap_Core {
 public:
@@ -40,6 +41,16 @@ public:
 	typedef Nes_Cpu::time_t time_t; // Clock count
 	blargg_err_t end_frame( time_t t );
 	
+	// Saves/restores CPU, memory and sound chip state between time frames
+	// (see State_Copier.h)
+	void copy_state( State_Copier& );
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
+	
 
 // Implementation
 public:
@@ -54,6 +65,7 @@ private:
 	time_t next_play;
 	time_t time_mask;
 	time_t frame_start;
+	Loop_Detector* loop_detector;
 	Nes_Cpu cpu;
 	Nes_Cpu::registers_t saved_state;
 	info_t info;
@@ -2,6 +2,7 @@
 
 #include "Sap_Core.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 
 //#define CPU_LOG_MAX 100000
@@ -35,12 +36,16 @@ void Sap_Core::write_D2xx( int d2xx, int data )
 	
 	if ( d2xx < apu_.io_size )
 	{
+		if ( loop_detector )
+			loop_detector->write( time(), d2xx + base, data );
 		apu_.write_data( time(), d2xx + base, data );
 		return;
 	}
 	
 	if ( (unsigned) (d2xx - 0x10) < apu2_.io_size && info.stereo )
 	{
+		if ( loop_detector )
+			loop_detector->write( time(), d2xx + base, data );
 		apu2_.write_data( time(), d2xx + (base - 0x10), data );
 		return;
 	}
@@ -422,6 +422,24 @@ blargg_err_t Sap_Emu::run_clocks( blip_time_t& duration, int )
 	return core.end_frame( duration );
 }
 
+bool Sap_Emu::copy_core_state( State_Copier& copier )
+{
+	core.copy_state( copier );
+	return true;
+}
+
+bool Sap_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core.set_loop_detector( d );
+	return true;
+}
+
+void Sap_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core.spin_detector().hits();
+	*clocks_skipped = core.spin_detector().clocks_skipped();
+}
+
 blargg_err_t Sap_Emu::hash_( Hash_Function& out ) const
 {
 	hash_sap_file( info(), info().rom_data, file_end - info().rom_data, out );
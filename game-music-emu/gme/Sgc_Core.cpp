@@ -2,6 +2,8 @@
 
 #include "Sgc_Core.h"
 
+#include "Loop_Detector.h"
+
 /* Copyright (C) 2009 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -63,7 +65,9 @@ blargg_err_t Sgc_Core::end_frame( time_t t )
 }
 	
 Sgc_Core::Sgc_Core()
-{ }
+{
+	loop_detector = NULL;
+}
 
 Sgc_Core::~Sgc_Core()
 { }
@@ -71,6 +75,8 @@ Sgc_Core::~Sgc_Core()
 void Sgc_Core::cpu_out( time_t time, addr_t addr, int data )
 {
 	int port = addr & 0xFF;
+	if ( loop_detector )
+		loop_detector->write( time, port, data );
 	
 	if ( sega_mapping() )
 	{
@@ -106,3 +112,21 @@ void Sgc_Core::cpu_out( time_t time, addr_t addr, int data )
 	
 	Sgc_Impl::cpu_out( time, addr, data );
 }
+
+bool Sgc_Core::copy_state( State_Copier& copier )
+{
+	// FM chip state can't be saved, so only states from before it was first
+	// accessed are supported, and restoring one puts FM chip back to reset state
+	if ( fm_accessed && !copier.loading() )
+		return false;
+	
+	Sgc_Impl::copy_state( copier );
+	apu_.copy_state( copier );
+	
+	if ( fm_accessed )
+	{
+		fm_apu_.reset();
+		fm_accessed = false;
+	}
+	return true;
+}
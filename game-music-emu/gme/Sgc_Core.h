@@ -7,6 +7,7 @@
 #include "Sgc_Impl.h"
 #include "Sms_Fm_Apu.h"
 #include "Sms_Apu.h"
+class Loop_Detector;
 
 class Sgc_Core : public Sgc_Impl {
 public:
@@ -21,9 +22,17 @@ public:
 	// Ends time frame at time t
 	blargg_err_t end_frame( time_t t );
 	
+	// Saves/restores CPU, memory and sound chip state between time frames, or
+	// returns false if FM sound chip has been used since track was started
+	// (see State_Copier.h)
+	bool copy_state( State_Copier& );
+	
 	// SN76489 sound chip
 	Sms_Apu& apu()                  { return apu_; }
 	Sms_Fm_Apu& fm_apu()            { return fm_apu_; }
+
+	// Logs sound chip register writes to d, or stops if NULL
+	void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
 	
 protected:
 	// Overrides
@@ -37,6 +46,7 @@ public:
 
 private:
 	bool fm_accessed;
+	Loop_Detector* loop_detector;
 	Sms_Apu apu_;
 	Sms_Fm_Apu fm_apu_;
 };
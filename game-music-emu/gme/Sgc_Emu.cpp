@@ -107,7 +107,11 @@ gme_type_t_ const gme_sgc_type [1] = {{ "Z80 PSG", 0, &new_sgc_emu, &new_sgc_fil
 
 blargg_err_t Sgc_Emu::load_( Data_Reader& in )
 {
-	RETURN_ERR( core_.load( in ) );
+	// Core can use file data in place too if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( core_.load_mem( file_begin(), file_size() ) );
+	else
+		RETURN_ERR( core_.load( in ) );
 	set_warning( core_.warning() );
 	set_track_count( header().song_count );
 	set_voice_count( core_.sega_mapping() ? osc_count : core_.apu().osc_count );
@@ -160,6 +164,23 @@ blargg_err_t Sgc_Emu::run_clocks( blip_time_t& duration, int )
 	return blargg_ok;
 }
 
+bool Sgc_Emu::copy_core_state( State_Copier& copier )
+{
+	return core_.copy_state( copier );
+}
+
+bool Sgc_Emu::set_loop_detector( Loop_Detector* d )
+{
+	core_.set_loop_detector( d );
+	return true;
+}
+
+void Sgc_Emu::spin_stats_( long* hits, double* clocks_skipped ) const
+{
+	*hits           = core_.spin_detector().hits();
+	*clocks_skipped = core_.spin_detector().clocks_skipped();
+}
+
 blargg_err_t Sgc_Emu::hash_( Hash_Function& out ) const
 {
 	hash_sgc_file( header(), core_.rom_().begin(), core_.rom_().file_size(), out );
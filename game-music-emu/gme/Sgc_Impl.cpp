@@ -33,7 +33,11 @@ bool Sgc_Impl::header_t::valid_tag() const
 
 blargg_err_t Sgc_Impl::load_( Data_Reader& in )
 {
-	RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
+	// Use file data in place if it was passed to load_mem()
+	if ( file_begin() )
+		RETURN_ERR( rom.borrow( file_begin(), file_size(), header_.size, &header_, 0 ) );
+	else
+		RETURN_ERR( rom.load( in, header_.size, &header_, 0 ) );
 	
 	if ( !header_.valid_tag() )
 		return blargg_err_file_type;
@@ -223,3 +227,14 @@ blargg_err_t Sgc_Impl::end_frame( time_t end )
 	
 	return blargg_ok;
 }
+
+void Sgc_Impl::copy_state( State_Copier& copier )
+{
+	cpu.copy_state( copier );
+	copier.copy( vectors.begin(), (int) vectors.size() );
+	copier.copy( ram    .begin(), (int) ram    .size() );
+	copier.copy( ram2   .begin(), (int) ram2   .size() );
+	copier( bank2 );
+	copier( play_period );
+	copier( next_play );
+}
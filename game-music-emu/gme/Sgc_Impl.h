@@ -63,6 +63,12 @@ public:
 	// Runs for t clocks
 	blargg_err_t end_frame( time_t t );
 	
+	// Saves/restores CPU and memory state between time frames (see State_Copier.h)
+	void copy_state( State_Copier& );
+
+	// Busy-wait loops skipped by CPU
+	Spin_Detector const& spin_detector() const { return cpu.spin; }
+	
 	// True if Master System or Game Gear
 	bool sega_mapping() const;
 	
@@ -1,6 +1,7 @@
 // Sms_Snd_Emu $vers. http://www.slack.net/~ant/
 
 #include "Sms_Apu.h"
+#include "State_Copier.h"
 
 /* Copyright (C) 2003-2008 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
@@ -369,3 +370,13 @@ blargg_err_t Sms_Apu::load_state( sms_apu_state_t const& in )
 	write_ggstereo( 0, ggstereo );
 	return blargg_ok;
 }
+
+void Sms_Apu::copy_state( State_Copier& copier )
+{
+	copier( oscs );
+	copier( ggstereo );
+	copier( latch );
+	copier( last_time );
+	copier( noise_feedback );
+	copier( looped_feedback );
+}
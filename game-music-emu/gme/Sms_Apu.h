@@ -6,6 +6,7 @@
 
 #include "blargg_common.h"
 #include "Blip_Buffer.h"
+#include "State_Copier.h"
 
 struct sms_apu_state_t;
 
@@ -50,6 +51,10 @@ public:
 	
 	// Loads state. You should call reset() BEFORE this.
 	blargg_err_t load_state( sms_apu_state_t const& in );
+	
+	// Saves/restores exact emulation state to/from same object, without any
+	// conversion (see State_Copier.h)
+	void copy_state( State_Copier& );
 
 private:
 	// noncopyable
@@ -31,6 +31,7 @@ blargg_err_t Snes_Spc::init()
 {
   memset( &m, 0, sizeof m );
   dsp.init( RAM );
+  loop_detector = NULL;
 
   set_sfm_queue( 0, 0 );
 
@@ -253,6 +254,21 @@ void Snes_Spc::clear_echo(bool force)
   }
 }
 
+void Snes_Spc::copy_state( State_Copier& copier )
+{
+  dsp.copy_state( copier );
+
+  // Keep tempo and SFM queue, which aren't part of emulation state
+  int const tempo = m.tempo;
+  uint8_t const* const sfm_queue     = m.sfm_queue;
+  uint8_t const* const sfm_queue_end = m.sfm_queue_end;
+  copier( m );
+  if ( copier.loading() && m.tempo != tempo )
+    set_tempo( tempo );
+  m.sfm_queue     = sfm_queue;
+  m.sfm_queue_end = sfm_queue_end;
+}
+
 
 //// Sample output
 
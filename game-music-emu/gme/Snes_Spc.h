@@ -8,6 +8,7 @@
 #include "blargg_endian.h"
 
 class Sfm_Emu;
+class Loop_Detector;
 
 struct Snes_Spc {
   friend class Sfm_Emu;
@@ -69,6 +70,9 @@ struct Snes_Spc {
   // If true, enables cubic interpolation
   void interpolation_level( int level = 0 );
 
+  // If true, runs DSP a voice at a time, which is faster and sounds the same
+  void fast_dsp( bool enable = true );
+
   // Sets tempo, where tempo_unit = normal, tempo_unit / 2 = half speed, etc.
   enum { tempo_unit = 0x100 };
   void set_tempo( int );
@@ -97,6 +101,12 @@ struct Snes_Spc {
   // SFM Queue
   void set_sfm_queue(const uint8_t* queue, const uint8_t* queue_end);
 
+  // Saves/restores emulation state to/from same object (see State_Copier.h)
+  void copy_state( State_Copier& );
+
+  // Logs DSP register writes and time frames to d, or stops if NULL
+  void set_loop_detector( Loop_Detector* d ) { loop_detector = d; }
+
   // State save/load (only available with accurate DSP)
 
 #if !SPC_NO_COPY_STATE_FUNCS
@@ -211,6 +221,7 @@ struct Snes_Spc {
     } ram;
   };
   state_t m;
+  Loop_Detector* loop_detector;
 
   enum { rom_addr = 0xFFC0 };
 
@@ -299,6 +310,8 @@ inline void Snes_Spc::disable_surround( bool disable ) { dsp.disable_surround( d
 
 inline void Snes_Spc::interpolation_level( int level ) { dsp.interpolation_level( level ); }
 
+inline void Snes_Spc::fast_dsp( bool enable ) { dsp.fast_mode( enable ); }
+
 inline Spc_Dsp const* Snes_Spc::get_dsp() const { return &dsp; }
 inline Spc_Dsp * Snes_Spc::get_dsp() { return &dsp; }
 
@@ -4,6 +4,8 @@
 
 #include "Snes_Spc.h"
 
+#include "Loop_Detector.h"
+
 /* Copyright (C) 2004-2007 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -165,6 +167,9 @@ inline void Snes_Spc::dsp_write( int data, rel_time_t time )
   SPC_DSP_WRITE_HOOK( m.spc_time + time, REGS [r_dspaddr], (uint8_t) data );
 #endif
 
+  if ( loop_detector )
+    loop_detector->write( m.spc_time + time, REGS [r_dspaddr], data );
+
   if ( REGS [r_dspaddr] <= 0x7F )
   {
     if ( REGS [r_dspaddr] != Spc_Dsp::r_flg )
@@ -550,6 +555,9 @@ void Snes_Spc::end_frame( time_t end_time )
   m.spc_time     -= end_time;
   m.extra_clocks += end_time;
 
+  if ( loop_detector )
+    loop_detector->end_frame( end_time );
+
   // Greatest number of clocks early that emulation can stop early due to
   // not being able to execute current instruction without going over
   // allowed time.
@@ -507,6 +507,28 @@ inline int Spc_Dsp::interpolate_nearest( voice_t const* v )
   return v->buf [(v->interp_pos >> 12) + v->buf_pos] & ~1;
 }
 
+inline int Spc_Dsp::interpolate_voice( voice_t const* v )
+{
+  switch ( m.interpolation_level )
+  {
+    case 0:
+    default:
+      return interpolate( v );
+
+    case 1:
+      return interpolate_cubic( v );
+
+    case 2:
+      return interpolate_sinc( v );
+
+    case -1:
+      return interpolate_linear( v );
+
+    case -2:
+      return interpolate_nearest( v );
+  }
+}
+
 //// Counters
 
 int const simple_counter_range = 2048 * 5 * 3; // 30720
@@ -806,31 +828,7 @@ VOICE_CLOCK( V3c )
 
   // Gaussian interpolation
   {
-    int output;
-
-    switch ( m.interpolation_level )
-    {
-      case 0:
-      default:
-        output = interpolate( v );
-        break;
-
-      case 1:
-        output = interpolate_cubic( v );
-        break;
-
-      case 2:
-        output = interpolate_sinc( v );
-        break;
-
-      case -1:
-        output = interpolate_linear( v );
-        break;
-
-      case -2:
-        output = interpolate_nearest( v );
-        break;
-    }
+    int output = interpolate_voice( v );
 
     // Noise
     if ( m.t_non & v->vbit )
@@ -1181,12 +1179,238 @@ PHASE(29) misc_29();                                                 echo_29();\
 PHASE(30) misc_30();V(V3c,0)                                         echo_30();\
 PHASE(31)  V(V4,0)       V(V1,2)\
 
+
+
+//// Fast mode
+
+/* Runs a whole sample at a time, from clock 0 to clock 0 of the next sample,
+and each voice from start to finish rather than a step at a time alongside the
+others. Registers are only written between samples, so each step still sees
+what it would have at its own clock, as long as steps that depend on each other
+stay in order: V1 reads the source number of the voice it runs ahead of, voice
+0 is set up before echo and mixed after, and echo reads come before echo
+writes, which come before the next BRR decode. Since nothing else differs,
+output and state between samples are the same as when running by clocks. */
+
+// V3c and V4, skipping interpolation and mixing when voice is silent
+inline void Spc_Dsp::voice_fast_V3c_V4( voice_t* const v )
+{
+  // Pitch modulation using previous voice's output
+  if ( m.t_pmon & v->vbit )
+    m.t_pitch += ((m.t_output >> 5) * m.t_pitch) >> 10;
+
+  if ( v->kon_delay )
+  {
+    // Get ready to start BRR decoding on next sample
+    if ( v->kon_delay == 5 )
+    {
+      v->brr_addr    = m.t_brr_next_addr;
+      v->brr_offset  = 1;
+      v->buf_pos     = 0;
+      m.t_brr_header = 0; // header is ignored on this sample
+      m.kon_check    = true;
+    }
+
+    // Envelope is never run during KON
+    v->env        = 0;
+    v->hidden_env = 0;
+
+    // Disable BRR decoding until last three samples
+    v->interp_pos = 0;
+    if ( --v->kon_delay & 3 )
+      v->interp_pos = 0x4000;
+
+    // Pitch is never added during KON
+    m.t_pitch = 0;
+  }
+
+  // Interpolation, noise and envelope
+  m.t_output = 0;
+  if ( v->env )
+  {
+    int output = interpolate_voice( v );
+    if ( m.t_non & v->vbit )
+      output = (int16_t) (m.noise * 2);
+    m.t_output = (output * v->env) >> 11 & ~1;
+  }
+  v->t_envx_out = (uint8_t) (v->env >> 4);
+
+  // Immediate silence due to end of sample or soft reset
+  if ( REG(flg) & 0x80 || (m.t_brr_header & 3) == 1 )
+  {
+    v->env_mode = env_release;
+    v->env      = 0;
+  }
+
+  if ( m.every_other_sample )
+  {
+    // KOFF
+    if ( m.t_koff & v->vbit )
+      v->env_mode = env_release;
+
+    // KON
+    if ( m.kon & v->vbit )
+    {
+      v->kon_delay = 5;
+      v->env_mode  = env_attack;
+    }
+  }
+
+  // Run envelope for next sample
+  if ( !v->kon_delay )
+    run_envelope( v );
+
+  // Decode BRR
+  m.t_looped = 0;
+  if ( v->interp_pos >= 0x4000 )
+  {
+    decode_brr( v );
+
+    if ( (v->brr_offset += 2) >= brr_block_size )
+    {
+      // Start decoding next BRR block
+      assert( v->brr_offset == brr_block_size );
+      v->brr_addr = (v->brr_addr + brr_block_size) & 0xFFFF;
+      if ( m.t_brr_header & 1 )
+      {
+        v->brr_addr = m.t_brr_next_addr;
+        m.t_looped = v->vbit;
+      }
+      v->brr_offset = 1;
+    }
+  }
+
+  // Apply pitch
+  v->interp_pos = (v->interp_pos & 0x3FFF) + m.t_pitch;
+
+  // Keep from getting too far ahead (when using pitch modulation)
+  if ( v->interp_pos > 0x7FFF )
+    v->interp_pos = 0x7FFF;
+
+  // Output left
+  if ( m.t_output )
+    voice_output( v, 0 );
+}
+
+// V5 to V9
+inline void Spc_Dsp::voice_fast_V5_V9( voice_t* const v )
+{
+  // Output right
+  if ( m.t_output )
+    voice_output( v, 1 );
+
+  // Update ENDX, clearing bit if KON just began
+  int endx = REG(endx) | m.t_looped;
+  if ( v->kon_delay == 5 )
+    endx &= ~v->vbit;
+  m.endx_buf = (uint8_t) endx;
+  REG(endx)  = m.endx_buf;
+
+  // Update OUTX and ENVX
+  m.outx_buf = (uint8_t) (m.t_output >> 8);
+  VREG(v->regs,outx) = m.outx_buf;
+  m.envx_buf = v->t_envx_out;
+  VREG(v->regs,envx) = m.envx_buf;
+}
+
+// Echo clocks 22 to 25, only keeping history when echo input is scaled to nothing
+inline void Spc_Dsp::echo_fast_read()
+{
+  if ( REG(evoll) | REG(evolr) | REG(efb) )
+  {
+    echo_22();
+    echo_23();
+    echo_24();
+    echo_25();
+    return;
+  }
+
+  if ( ++m.echo_hist_pos >= &m.echo_hist [echo_hist_size] )
+    m.echo_hist_pos = m.echo_hist;
+
+  m.t_echo_ptr = (m.t_esa * 0x100 + m.echo_offset) & 0xFFFF;
+  echo_read( 0 );
+  echo_read( 1 );
+
+  m.t_echo_in [0] = 0;
+  m.t_echo_in [1] = 0;
+}
+
+void Spc_Dsp::run_fast( int samples )
+{
+  assert( m.phase == 0 );
+
+  voice_t* const v0 = m.voices;
+  voice_t* const end = &m.voices [voice_count];
+  do
+  {
+    // Finish voice 0 of previous sample
+    voice_fast_V5_V9( v0 );
+
+    // Voices 1 to 7. V1 of voice 2 was run at end of previous sample.
+    for ( voice_t* v = v0 + 1; v < end; v++ )
+    {
+      if ( v != v0 + 1 )
+        voice_V1( v + 1 < end ? v + 1 : v0 );
+      voice_V2( v );
+      voice_V3a( v );
+      voice_V3b( v );
+      voice_fast_V3c_V4( v );
+      voice_fast_V5_V9( v );
+    }
+
+    // Read voice 0's registers and BRR data before echo is written
+    voice_V1( v0 + 1 );
+    voice_V2( v0 );
+    voice_V3a( v0 );
+    voice_V3b( v0 );
+
+    echo_fast_read();
+    echo_26();
+    misc_27();
+    echo_27();
+    misc_28();
+    echo_28();
+    misc_29();
+    echo_29();
+    misc_30();
+    echo_30();
+
+    // Voice 0 goes into next sample
+    voice_fast_V3c_V4( v0 );
+    voice_V1( v0 + 2 );
+  }
+  while ( --samples );
+}
+
+
 #if !SPC_DSP_CUSTOM_RUN
 
 void Spc_Dsp::run( int clocks_remain )
 {
   require( clocks_remain > 0 );
 
+  if ( m.fast_mode )
+  {
+    // Clocks up to start of next sample are run one at a time
+    int const partial = -m.phase & 31;
+    int const samples = (clocks_remain - partial) >> 5;
+    if ( samples > 0 )
+    {
+      if ( partial )
+        run_clocks( partial );
+      run_fast( samples );
+      clocks_remain -= partial + samples * 32;
+      if ( !clocks_remain )
+        return;
+    }
+  }
+
+  run_clocks( clocks_remain );
+}
+
+void Spc_Dsp::run_clocks( int clocks_remain )
+{
   int const phase = m.phase;
   m.phase = (phase + clocks_remain) & 31;
   switch ( phase )
@@ -1213,6 +1437,7 @@ void Spc_Dsp::init( void* ram_64k )
   mute_voices( 0 );
   disable_surround( true );  // disable Dolby Pro Logic type surround
   interpolation_level( -1 ); // TODO(montag): expose interpolation quality
+  fast_mode( false );
   set_output( 0, 0 );
   reset();
 
@@ -1317,6 +1542,21 @@ void SPC_State_Copier::extra()
 	skip( n );
 }
 
+void Spc_Dsp::copy_state( State_Copier& copier )
+{
+	// Keep settings and output pointers
+	state_t const settings = m;
+	copier( m );
+	m.ram                 = settings.ram;
+	m.mute_mask           = settings.mute_mask;
+	m.surround_threshold  = settings.surround_threshold;
+	m.interpolation_level = settings.interpolation_level;
+	m.fast_mode           = settings.fast_mode;
+	m.out                 = settings.out;
+	m.out_end             = settings.out_end;
+	m.out_begin           = settings.out_begin;
+}
+
 void Spc_Dsp::copy_state( unsigned char** io, copy_func_t copy )
 {
 	SPC_State_Copier copier( io, copy );
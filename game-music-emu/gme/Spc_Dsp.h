@@ -5,6 +5,7 @@
 #define SPC_DSP_H
 
 #include "blargg_common.h"
+#include "State_Copier.h"
 
 extern "C" { typedef void (*dsp_copy_func_t)( unsigned char** io, void* state, size_t ); }
 
@@ -48,6 +49,11 @@ public:
   // a pair of samples is be generated.
   void run( int clock_count );
 
+  // Runs whole samples a voice at a time rather than a clock at a time for all
+  // voices, which is faster, especially with silent voices or echo. Output and
+  // state are the same either way, so this can be changed at any time.
+  void fast_mode( bool enable = true ) { m.fast_mode = enable; }
+
   // Sound control
 
   // Mutes voices corresponding to non-zero bits in mask (issues repeated KOFF events).
@@ -66,6 +72,9 @@ public:
   typedef dsp_copy_func_t copy_func_t;
   void copy_state( unsigned char** io, copy_func_t );
 
+  // Saves/restores emulation state to/from same object (see State_Copier.h)
+  void copy_state( State_Copier& );
+
   // Returns non-zero if new key-on events occurred since last call
   bool check_kon();
 
@@ -191,6 +200,7 @@ private:
     int mute_mask;
     int surround_threshold;
     int interpolation_level;
+    bool fast_mode;
     sample_t* out;
     sample_t* out_end;
     sample_t* out_begin;
@@ -209,6 +219,7 @@ private:
   int  interpolate_sinc( voice_t const* v );
   int  interpolate_linear( voice_t const* v );
   int  interpolate_nearest( voice_t const* v );
+  int  interpolate_voice( voice_t const* v );
   void run_envelope( voice_t* const v );
   void decode_brr( voice_t* v );
 
@@ -247,6 +258,12 @@ private:
   void echo_29();
   void echo_30();
 
+  void voice_fast_V3c_V4( voice_t* const );
+  void voice_fast_V5_V9( voice_t* const );
+  void echo_fast_read();
+  void run_fast( int samples );
+  void run_clocks( int clock_count );
+
   void soft_reset_common();
 };
 
@@ -2,6 +2,7 @@
 
 #include "Spc_Emu.h"
 
+#include "Loop_Detector.h"
 #include "blargg_endian.h"
 
 /* Copyright (C) 2004-2009 Shay Green. This module is free software; you
@@ -328,6 +329,12 @@ blargg_err_t Spc_Emu::set_sample_rate_( int sample_rate )
   return blargg_ok;
 }
 
+blargg_err_t Spc_Emu::enable_fast_dsp_( bool enabled )
+{
+  apu.fast_dsp( enabled );
+  return blargg_ok;
+}
+
 void Spc_Emu::mute_voices_( int m )
 {
   Music_Emu::mute_voices_( m );
@@ -396,6 +403,14 @@ blargg_err_t Spc_Emu::skip_( int count )
   return play_( resampler_latency, buf );
 }
 
+bool Spc_Emu::copy_state_( State_Copier& copier )
+{
+  apu.copy_state( copier );
+  resampler.copy_state( copier );
+  filter.copy_state( copier );
+  return true;
+}
+
 blargg_err_t Spc_Emu::play_( int count, sample_t out [] )
 {
   if ( sample_rate() == native_sample_rate )
@@ -416,6 +431,29 @@ blargg_err_t Spc_Emu::play_( int count, sample_t out [] )
   return blargg_ok;
 }
 
+bool Spc_Emu::set_dry_run_( Loop_Detector* d )
+{
+  apu.set_loop_detector( d );
+  if ( d )
+  {
+    d->reset( Snes_Spc::clock_rate );
+  }
+  else
+  {
+    // resampler and filter restart from silence, as after skip_()
+    resampler.clear();
+    filter.clear();
+  }
+  return true;
+}
+
+blargg_err_t Spc_Emu::dry_run_( int msec )
+{
+  // DSP still runs since SPC program can read its state, but output is
+  // discarded without resampling or filtering
+  return apu.play( msec * (Snes_Spc::sample_rate / 1000) * 2, NULL );
+}
+
 blargg_err_t Spc_Emu::hash_( Hash_Function& out ) const
 {
   hash_spc_file( header(), file_begin() + header_t::size, blargg_min( (size_t) ( 0x10200 - header_t::size ), (size_t) ( file_end() - file_begin() - header_t::size ) ), out );
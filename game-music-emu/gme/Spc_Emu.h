@@ -80,6 +80,10 @@ protected:
   virtual blargg_err_t skip_( int );
   virtual void mute_voices_( int );
   virtual void set_tempo_( double );
+  virtual bool copy_state_( State_Copier& );
+  virtual bool set_dry_run_( Loop_Detector* );
+  virtual blargg_err_t dry_run_( int msec );
+  virtual blargg_err_t enable_fast_dsp_( bool );
 
 private:
   Spc_Emu_Resampler resampler;
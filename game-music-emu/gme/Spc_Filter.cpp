@@ -2,6 +2,8 @@
 
 #include "Spc_Filter.h"
 
+#include "State_Copier.h"
+
 /* Copyright (C) 2007 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -48,6 +50,12 @@ inline short Spc_Filter::limit_sample(int sample)
 
 void Spc_Filter::clear() { limiting = false; memset( ch, 0, sizeof ch ); }
 
+void Spc_Filter::copy_state( State_Copier& copier )
+{
+	copier( limiting );
+	copier( ch );
+}
+
 Spc_Filter::Spc_Filter()
 {
 	enabled = true;
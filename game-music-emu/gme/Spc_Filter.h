@@ -6,6 +6,8 @@
 
 #include "blargg_common.h"
 
+class State_Copier;
+
 struct Spc_Filter {
 public:
 	
@@ -18,6 +20,9 @@ public:
 	// Clears filter to silence
 	void clear();
 	
+	// Saves/restores filter history (see State_Copier.h)
+	void copy_state( State_Copier& );
+	
 	// Sets gain (volume), where gain_unit is normal. Gains greater than gain_unit
 	// are fine, since output is clamped to 16-bit sample range.
 	enum { gain_unit = 0x100 };
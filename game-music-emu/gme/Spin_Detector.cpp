@@ -0,0 +1,231 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Spin_Detector.h"
+
+#include "blargg_source.h"
+
+typedef BOOST::uint8_t byte;
+
+void Spin_Detector::reset()
+{
+	saved    = false;
+	time_    = 0;
+	period   = 0;
+	hits_    = 0;
+	skipped  = 0;
+}
+
+int Spin_Detector::skip( int clocks_left )
+{
+	if ( period <= 0 || clocks_left < period )
+		return 0;
+	
+	int clocks = clocks_left / period * period;
+	time_   += clocks;
+	skipped += clocks;
+	hits_++;
+	return clocks;
+}
+
+static Spin_Detector::instr_t side_effects()
+{
+	Spin_Detector::instr_t r;
+	r.size   = 0;
+	r.read   = Spin_Detector::no_read;
+	r.addr   = 0;
+	r.span   = 0;
+	r.target = -1;
+	return r;
+}
+
+static Spin_Detector::instr_t no_effects( int size )
+{
+	Spin_Detector::instr_t r = side_effects();
+	r.size = size;
+	return r;
+}
+
+static Spin_Detector::instr_t reads( int size, int addr, int span )
+{
+	Spin_Detector::instr_t r = no_effects( size );
+	r.read = Spin_Detector::mem_read;
+	r.addr = addr;
+	r.span = span;
+	if ( addr + span > 0x10000 )
+		r.size = 0; // wraps around; not worth handling
+	return r;
+}
+
+static Spin_Detector::instr_t branches( int size, int target )
+{
+	Spin_Detector::instr_t r = no_effects( size );
+	r.target = target & 0xFFFF;
+	return r;
+}
+
+Spin_Detector::instr_t Spin_Detector::decode_6502( int pc, byte const in [] )
+{
+	int const addr = in [2] * 0x100 + in [1];
+	
+	switch ( in [0] )
+	{
+	case 0xAA: case 0x8A: case 0xA8: case 0x98: case 0xBA: case 0x9A: // TAX TXA TAY TYA TSX TXS
+	case 0xE8: case 0xC8: case 0xCA: case 0x88: // INX INY DEX DEY
+	case 0x18: case 0x38: case 0xB8: case 0xD8: case 0xF8: // CLC SEC CLV CLD SED
+	case 0x0A: case 0x4A: case 0x2A: case 0x6A: // ASL LSR ROL ROR A
+	case 0xEA: // NOP
+		return no_effects( 1 );
+	
+	case 0xA9: case 0xA2: case 0xA0: // LDA LDX LDY #imm
+	case 0xC9: case 0xE0: case 0xC0: // CMP CPX CPY #imm
+	case 0x29: case 0x09: case 0x49: case 0x69: case 0xE9: // AND ORA EOR ADC SBC #imm
+		return no_effects( 2 );
+	
+	case 0xA5: case 0xA6: case 0xA4: case 0xC5: case 0xE4: case 0xC4: case 0x24: // zp
+	case 0x25: case 0x05: case 0x45: case 0x65: case 0xE5:
+	case 0xB5: case 0xB6: case 0xB4: case 0xD5: // zp,X and zp,Y
+	case 0x35: case 0x15: case 0x55: case 0x75: case 0xF5: {
+		instr_t r = no_effects( 2 );
+		r.read = ram_read;
+		return r;
+	}
+	
+	case 0xAD: case 0xAE: case 0xAC: case 0xCD: case 0xEC: case 0xCC: case 0x2C: // abs
+	case 0x2D: case 0x0D: case 0x4D: case 0x6D: case 0xED:
+		return reads( 3, addr, 1 );
+	
+	case 0xBD: case 0xBC: case 0xDD: case 0x3D: case 0x1D: case 0x5D: case 0x7D: case 0xFD: // abs,X
+	case 0xB9: case 0xBE: case 0xD9: case 0x39: case 0x19: case 0x59: case 0x79: case 0xF9: // abs,Y
+		return reads( 3, addr, 0x100 );
+	
+	case 0x10: case 0x30: case 0x50: case 0x70: // BPL BMI BVC BVS
+	case 0x90: case 0xB0: case 0xD0: case 0xF0: // BCC BCS BNE BEQ
+		return branches( 2, pc + 2 + (BOOST::int8_t) in [1] );
+	
+	case 0x4C: // JMP abs
+		return branches( 3, addr );
+	}
+	
+	return side_effects();
+}
+
+// Instructions Z80 and LR35902 share with 8080
+static Spin_Detector::instr_t decode_8080( int pc, byte const in [] )
+{
+	int op = in [0];
+	switch ( op )
+	{
+	case 0x00: // NOP
+	case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x3C: // INC r
+	case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x25: case 0x2D: case 0x3D: // DEC r
+	case 0x03: case 0x13: case 0x23: case 0x33: // INC rr
+	case 0x0B: case 0x1B: case 0x2B: case 0x3B: // DEC rr
+	case 0x09: case 0x19: case 0x29: case 0x39: // ADD HL,rr
+	case 0x07: case 0x0F: case 0x17: case 0x1F: // RLCA RRCA RLA RRA
+	case 0x27: case 0x2F: case 0x37: case 0x3F: // DAA CPL SCF CCF
+	case 0xF9: // LD SP,HL
+		return no_effects( 1 );
+	
+	case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E: // LD r,imm
+	case 0xC6: case 0xCE: case 0xD6: case 0xDE: // ADD ADC SUB SBC imm
+	case 0xE6: case 0xEE: case 0xF6: case 0xFE: // AND XOR OR CP imm
+		return no_effects( 2 );
+	
+	case 0x01: case 0x11: case 0x21: case 0x31: // LD rr,imm
+		return no_effects( 3 );
+	
+	case 0x0A: case 0x1A: // LD A,(BC) LD A,(DE)
+		return reads( 1, 0, 0x10000 );
+	
+	case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+		return branches( 2, pc + 2 + (BOOST::int8_t) in [1] );
+	
+	case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: // JP
+		return branches( 3, in [2] * 0x100 + in [1] );
+	
+	case 0xCB:
+		op = in [1];
+		if ( (op & 7) != 6 )
+			return no_effects( 2 ); // shifts and bit operations on registers
+		
+		if ( (op & 0xC0) == 0x40 )
+			return reads( 2, 0, 0x10000 ); // BIT n,(HL)
+		
+		return side_effects();
+	}
+	
+	if ( (unsigned) (op - 0x40) < 0x80 && (op & 0xF8) != 0x70 )
+	{
+		// LD r,r and arithmetic on A, but not LD (HL),r or HALT
+		if ( (op & 7) == 6 )
+			return reads( 1, 0, 0x10000 ); // (HL)
+		return no_effects( 1 );
+	}
+	
+	return side_effects();
+}
+
+Spin_Detector::instr_t Spin_Detector::decode_z80( int pc, byte const in [] )
+{
+	switch ( in [0] )
+	{
+	case 0x10: // DJNZ
+		return branches( 2, pc + 2 + (BOOST::int8_t) in [1] );
+	
+	case 0x3A: // LD A,(addr)
+		return reads( 3, in [2] * 0x100 + in [1], 1 );
+	
+	case 0x2A: // LD HL,(addr)
+		return reads( 3, in [2] * 0x100 + in [1], 2 );
+	
+	case 0xE2: case 0xEA: case 0xF2: case 0xFA: // JP PO PE P M
+		return branches( 3, in [2] * 0x100 + in [1] );
+	
+	case 0xDD: // IX
+	case 0xFD: // IY
+		switch ( in [1] )
+		{
+		case 0x46: case 0x4E: case 0x56: case 0x5E: case 0x66: case 0x6E: case 0x7E: // LD r,(IX+d)
+		case 0x86: case 0x8E: case 0x96: case 0x9E: // ADD ADC SUB SBC (IX+d)
+		case 0xA6: case 0xAE: case 0xB6: case 0xBE: // AND XOR OR CP (IX+d)
+			return reads( 3, 0, 0x10000 );
+		
+		case 0x23: case 0x2B: // INC DEC IX
+			return no_effects( 2 );
+		
+		case 0x21: // LD IX,imm
+			return no_effects( 4 );
+		
+		case 0x2A: // LD IX,(addr)
+			return reads( 4, in [3] * 0x100 + in [2], 2 );
+		
+		case 0xCB:
+			if ( (in [3] & 0xC0) == 0x40 )
+				return reads( 4, 0, 0x10000 ); // BIT n,(IX+d)
+			break;
+		}
+		return side_effects();
+	}
+	
+	return decode_8080( pc, in );
+}
+
+Spin_Detector::instr_t Spin_Detector::decode_lr35902( int pc, byte const in [] )
+{
+	switch ( in [0] )
+	{
+	case 0xF0: // LD A,($FF00+imm)
+		return reads( 2, 0xFF00 + in [1], 1 );
+	
+	case 0xF2: // LD A,($FF00+C)
+		return reads( 1, 0xFF00, 0x100 );
+	
+	case 0xFA: // LD A,(addr)
+		return reads( 3, in [2] * 0x100 + in [1], 1 );
+	
+	case 0xF8: // LD HL,SP+imm
+		return no_effects( 2 );
+	}
+	
+	return decode_8080( pc, in );
+}
@@ -0,0 +1,90 @@
+// Finds CPU busy-wait loops whose time can be skipped without changing anything
+
+// Game_Music_Emu $vers
+#ifndef SPIN_DETECTOR_H
+#define SPIN_DETECTOR_H
+
+#include "blargg_common.h"
+#include <string.h>
+
+// A CPU core tells detector about a loop every few passes, as long as it keeps
+// jumping back to the same place without any other kind of jump in between. If
+// registers come back the same and loop's instructions don't write anything or
+// read anything that can change by itself, CPU will keep doing exactly the same
+// thing until the next interrupt or other event, so core can add the time of all
+// whole periods before then and run only the final partial one.
+class Spin_Detector {
+public:
+	Spin_Detector()                 { reset(); }
+	
+	// Forgets loop and clears statistics
+	void reset();
+	
+	// Loops longer than this many bytes aren't checked
+	enum { max_size = 32 };
+	
+	// Registers are compared once every this many passes of loop
+	enum { check_interval = 8 };
+	
+	// Forgets registers saved for previous loop
+	void forget()                   { saved = false; }
+	
+	// Saves count values describing CPU's registers at time. True if they're the
+	// same as the ones saved last time, in which case caller should check loop's
+	// instructions, then call skip() if they have no side effects.
+	enum { max_regs = 8 };
+	bool repeated( int const regs [], int count, int time );
+	
+	// Number of clocks to add to time to skip all whole periods of loop that
+	// finish within clocks_left
+	int skip( int clocks_left );
+	
+	// Number of times loops were skipped, and total clocks skipped
+	long hits() const               { return hits_; }
+	double clocks_skipped() const   { return skipped; }
+	
+// Instruction decoders for checking loops
+	
+	// Kinds of memory read
+	enum {
+		no_read,    // doesn't read memory
+		mem_read,   // might read any of addr to addr + span - 1; caller checks them
+		ram_read    // reads RAM directly, which only changes when CPU writes to it
+	};
+	
+	struct instr_t {
+		int size;   // in bytes, or 0 if instruction might have side effects
+		int read;   // kind of memory read
+		int addr;
+		int span;
+		int target; // address instruction might jump to, or -1 if none
+	};
+	
+	// Decode instruction at instr, whose address is pc. Only common instructions
+	// without side effects are handled; everything else gives size 0.
+	static instr_t decode_6502(     int pc, BOOST::uint8_t const instr [] ); // also HuC6280
+	static instr_t decode_z80(      int pc, BOOST::uint8_t const instr [] );
+	static instr_t decode_lr35902(  int pc, BOOST::uint8_t const instr [] );
+	
+private:
+	bool saved;
+	int regs_ [max_regs];
+	int time_;
+	int period;
+	long hits_;
+	double skipped;
+};
+
+inline bool Spin_Detector::repeated( int const regs [], int count, int time )
+{
+	assert( count <= max_regs );
+	bool same = saved && !memcmp( regs, regs_, count * sizeof *regs );
+	period = time - time_;
+	time_  = time;
+	saved  = true;
+	if ( !same )
+		memcpy( regs_, regs, count * sizeof *regs );
+	return same;
+}
+
+#endif
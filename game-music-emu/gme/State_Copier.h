@@ -0,0 +1,58 @@
+// Saves/restores emulator state to/from a block of memory
+
+// Game_Music_Emu $vers
+#ifndef STATE_COPIER_H
+#define STATE_COPIER_H
+
+#include "blargg_common.h"
+#include <string.h>
+
+/* An emulator's copy_state( State_Copier& ) passes each piece of its state
+to the copier, which either measures the total size, saves it into a block,
+or restores it from a block saved earlier by the same sequence of calls.
+
+Objects are copied as raw bytes, so a state can only be restored into the
+same object it was saved from, during the same run of the program. Pointers
+into the object's own memory remain valid; pointers to Blip_Buffers are
+restored as they were, so the caller must re-apply voice outputs/muting. */
+class State_Copier {
+public:
+	enum mode_t { measure, save, load };
+
+	// Measures size of state without copying anything
+	State_Copier()                          { init( measure, NULL ); }
+
+	// Saves state to, or loads state from, block at p
+	State_Copier( mode_t m, void* p )       { init( m, p ); }
+
+	// Copies size bytes at p to/from block
+	void copy( void* p, int size );
+
+	// Copies plain object/array/struct t
+	template<class T>
+	void operator () ( T& t )               { copy( &t, sizeof t ); }
+
+	// True if state is being restored
+	bool loading() const                    { return mode_ == load; }
+
+	// Number of bytes copied/measured so far
+	int size() const                        { return size_; }
+
+private:
+	mode_t mode_;
+	unsigned char* pos;
+	int size_;
+
+	void init( mode_t m, void* p )          { mode_ = m; pos = (unsigned char*) p; size_ = 0; }
+};
+
+inline void State_Copier::copy( void* p, int size )
+{
+	if ( mode_ == save )
+		memcpy( pos + size_, p, size );
+	else if ( mode_ == load )
+		memcpy( p, pos + size_, size );
+	size_ += size;
+}
+
+#endif
@@ -13,6 +13,14 @@ details. You should have received a copy of the GNU Lesser General Public
 License along with this module; if not, write to the Free Software Foundation,
 Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define TRACK_FILTER_SSE2 1
+#elif (defined (__ARM_NEON) || defined (__ARM_NEON__)) && !defined (__ARM_BIG_ENDIAN)
+	#include <arm_neon.h>
+	#define TRACK_FILTER_NEON 1
+#endif
+
 #include "blargg_source.h"
 
 int const fade_block_size = 512;
@@ -39,6 +47,7 @@ void Track_Filter::stop()
 {
 	emu_track_ended_ = true;
 	track_ended_     = true;
+	silence_ended_   = false;
 	fade_start       = indefinite_count;
 	fade_step        = 1;
 	buf_remain       = 0;
@@ -51,6 +60,8 @@ Track_Filter::Track_Filter() : setup_()
 	callbacks          = NULL;
 	setup_.max_silence = indefinite_count;
 	silence_ignored_   = false;
+	end_time_          = -1;
+	float_scale_       = 1.0f;
 	stop();
 }
 
@@ -79,6 +90,20 @@ blargg_err_t Track_Filter::start_track()
 	return emu_error;
 }
 
+void Track_Filter::resume( int n, int scaled_n )
+{
+	emu_error        = NULL;
+	emu_track_ended_ = false;
+	track_ended_     = false;
+	silence_ended_   = false;
+	buf_remain       = 0;
+	emu_time         = n;
+	out_time         = n;
+	out_time_scaled_ = scaled_n;
+	silence_time     = n;
+	silence_count    = 0;
+}
+
 void Track_Filter::end_track_if_error( blargg_err_t err )
 {
 	if ( err )
@@ -115,6 +140,7 @@ blargg_err_t Track_Filter::skip( int count )
 	if ( !(silence_count | buf_remain) ) // caught up to emulator, so update track ended
 		track_ended_ |= emu_track_ended_;
 	
+	check_end_time( 0 );
 	return emu_error;
 }
 
@@ -154,26 +180,85 @@ static int int_log( int x, int step, int unit )
 	return ((unit - fraction) + (fraction >> 1)) >> shift;
 }
 
+// gain at time, where 1 << fade_gain_shift is unity; ends track at end of fade
+int const fade_gain_shift = 14;
+
+int Track_Filter::fade_gain( int time )
+{
+	int const unit = 1 << fade_gain_shift;
+	int gain = int_log( (time - fade_start) / fade_block_size, fade_step, unit );
+	if ( gain < (unit >> fade_shift) )
+		track_ended_ = emu_track_ended_ = true;
+	return gain;
+}
+
 void Track_Filter::handle_fade( sample_t out [], int out_count )
 {
 	for ( int i = 0; i < out_count; i += fade_block_size )
 	{
-		int const shift = 14;
-		int const unit = 1 << shift;
-		int gain = int_log( (out_time + i - fade_start) / fade_block_size,
-				fade_step, unit );
-		if ( gain < (unit >> fade_shift) )
-			track_ended_ = emu_track_ended_ = true;
+		int gain = fade_gain( out_time + i );
 		
 		sample_t* io = &out [i];
 		for ( int count = min( fade_block_size, out_count - i ); count; --count )
 		{
-			*io = sample_t ((*io * gain) >> shift);
+			*io = sample_t ((*io * gain) >> fade_gain_shift);
 			++io;
 		}
 	}
 }
 
+// Converts count stereo sample pairs to planar floats, scaled by scale
+static void to_float( Track_Filter::sample_t const in [], int count, float scale,
+		float left [], float right [] )
+{
+	int i = 0;
+	
+	#if TRACK_FILTER_SSE2
+		__m128 const vscale = _mm_set1_ps( scale );
+		for ( ; i <= count - 4; i += 4 )
+		{
+			// L0 R0 L1 R1 L2 R2 L3 R3 -> sign-extended L0-L3 and R0-R3
+			__m128i lr = _mm_loadu_si128( (__m128i const*) &in [i * stereo] );
+			__m128i l  = _mm_srai_epi32( _mm_slli_epi32( lr, 16 ), 16 );
+			__m128i r  = _mm_srai_epi32( lr, 16 );
+			_mm_storeu_ps( &left  [i], _mm_mul_ps( _mm_cvtepi32_ps( l ), vscale ) );
+			_mm_storeu_ps( &right [i], _mm_mul_ps( _mm_cvtepi32_ps( r ), vscale ) );
+		}
+	#elif TRACK_FILTER_NEON
+		for ( ; i <= count - 4; i += 4 )
+		{
+			// L0 R0 L1 R1 L2 R2 L3 R3 -> L0-L3 and R0-R3
+			int16x4x2_t lr = vld2_s16( &in [i * stereo] );
+			vst1q_f32( &left  [i], vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( lr.val [0] ) ), scale ) );
+			vst1q_f32( &right [i], vmulq_n_f32( vcvtq_f32_s32( vmovl_s16( lr.val [1] ) ), scale ) );
+		}
+	#endif
+	
+	for ( ; i < count; i++ )
+	{
+		left  [i] = in [i * stereo    ] * scale;
+		right [i] = in [i * stereo + 1] * scale;
+	}
+}
+
+void Track_Filter::handle_fade_float( sample_t const in [], int in_count,
+		float left [], float right [] )
+{
+	float const unit = float_scale_ / 0x8000;
+	if ( !is_fading() )
+	{
+		to_float( in, in_count / stereo, unit, left, right );
+		return;
+	}
+	
+	for ( int i = 0; i < in_count; i += fade_block_size )
+	{
+		float scale = fade_gain( out_time + i ) * (unit / (1 << fade_gain_shift));
+		to_float( &in [i], min( fade_block_size, in_count - i ) / stereo, scale,
+				&left [i / stereo], &right [i / stereo] );
+	}
+}
+
 // Silence detection
 
 void Track_Filter::emu_play( sample_t out [], int count )
@@ -214,9 +299,8 @@ void Track_Filter::fill_buf()
 	silence_count += buf_size;
 }
 
-blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
+void Track_Filter::play_unfaded( int out_count, sample_t out [], bool direct )
 {
-	emu_error = NULL;
 	if ( track_ended_ )
 	{
 		memset( out, 0, out_count * sizeof *out );
@@ -232,7 +316,7 @@ blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
 		int pos = 0;
 		if ( silence_count )
 		{
-			if ( !silence_ignored_ )
+			if ( looking_ahead() && !direct )
 			{
 				// during a run of silence, run emulator at >=2x speed so it gets ahead
 				int ahead_time = setup_.lookahead * (out_time + out_count - silence_time) +
@@ -244,6 +328,7 @@ blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
 				if ( emu_time - silence_time > setup_.max_silence )
 				{
 					track_ended_  = emu_track_ended_ = true;
+					silence_ended_ = true;
 					silence_count = out_count;
 					buf_remain    = 0;
 				}
@@ -271,7 +356,7 @@ blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
 			emu_play( out + pos, remain );
 			track_ended_ |= emu_track_ended_;
 			
-			if ( silence_ignored_ && !is_fading() )
+			if ( direct || (silence_ignored_ && !is_fading()) )
 			{
 				// if left unupdated, ahead_time could become too large
 				silence_time = emu_time;
@@ -288,10 +373,67 @@ blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
 			}
 		}
 		
-		if ( is_fading() )
-			handle_fade( out, out_count );
+		if ( !direct )
+			check_end_time( out_count );
+	}
+}
+
+// Ends track if end_time_ falls within the count samples just generated. These
+// are left as is, since they're either silence or the emulator ended within them.
+void Track_Filter::check_end_time( int count )
+{
+	if ( silence_ignored_ || end_time_ < 0 || end_time_ == indefinite_count )
+		return;
+	
+	if ( (end_time_ - out_time_scaled_) * (stereo / tempo_) <= count )
+		track_ended_ = emu_track_ended_ = true;
+}
+
+blargg_err_t Track_Filter::play( int out_count, sample_t out [] )
+{
+	emu_error = NULL;
+	play_unfaded( out_count, out );
+	if ( is_fading() )
+		handle_fade( out, out_count );
+	out_time += out_count;
+	out_time_scaled_ += int(out_count * tempo_ / stereo);
+	return emu_error;
+}
+
+blargg_err_t Track_Filter::play_direct( int out_count, sample_t out [],
+		sample_t* const extra [], int extra_count )
+{
+	emu_error = NULL;
+	play_unfaded( out_count, out, true );
+	if ( is_fading() )
+	{
+		handle_fade( out, out_count );
+		for ( int i = 0; i < extra_count; i++ )
+			if ( extra [i] )
+				handle_fade( extra [i], out_count );
 	}
 	out_time += out_count;
 	out_time_scaled_ += int(out_count * tempo_ / stereo);
 	return emu_error;
 }
+
+blargg_err_t Track_Filter::play_float( int count, float left [], float right [] )
+{
+	emu_error = NULL;
+	
+	// generate in blocks small enough to stay in cache, then fade and convert
+	// in one pass
+	sample_t temp [buf_size];
+	while ( count > 0 )
+	{
+		int n = min( count, (int) buf_size / stereo );
+		play_unfaded( n * stereo, temp );
+		handle_fade_float( temp, n * stereo, left, right );
+		out_time += n * stereo;
+		out_time_scaled_ += int(n * tempo_);
+		left  += n;
+		right += n;
+		count -= n;
+	}
+	return emu_error;
+}
@@ -36,6 +36,13 @@ public:
 	
 	// Disables automatic end-of-track detection and skipping of silence at beginning
 	void ignore_silence( bool disable = true )  { silence_ignored_ = disable; }
+	bool silence_ignored() const                { return silence_ignored_; }
+	
+	// Stops looking ahead for silence, and instead ends track once sample_count_scaled()
+	// reaches end, as found by someone else. An end of indefinite_count means not
+	// known yet, so looking ahead continues until it is, and -1 restores normal
+	// looking ahead (the default).
+	void set_end_time( int end )                { end_time_ = end; }
 	
 	// Clears state and skips initial silence in track
 	blargg_err_t start_track();
@@ -44,10 +51,30 @@ public:
 	void set_fade( sample_count_t start, sample_count_t length );
 
 	void set_tempo( double t )                  { tempo_ = t; }
+	
+	// Sets amplitude of play_float() output, where 1.0 gives -1.0 to 1.0
+	void set_float_scale( float s )             { float_scale_ = s; }
 
 	// Generates n samples into buf
 	blargg_err_t play( int n, sample_t buf [] );
 
+	// Generates n stereo sample pairs as floats from -1.0 to 1.0, with left and
+	// right channels written to separate buffers
+	blargg_err_t play_float( int n, float left [], float right [] );
+
+	// Generates n samples into buf like play(), but only runs emulator for samples
+	// it writes into buf itself, after any it already generated ahead, so that
+	// emulator can write other buffers in step with buf. Doesn't look ahead for
+	// silence or end track at end time. Any fade is also applied to n samples of
+	// each of the extra_count buffers in extra that aren't NULL.
+	blargg_err_t play_direct( int n, sample_t buf [], sample_t* const extra [], int extra_count );
+	
+	// Number of samples emulator has already generated that play() and
+	// play_direct() will use before running it again. Right after start_track(),
+	// these are the last of the buf_size samples it had emulator generate last.
+	int samples_ahead() const                   { return silence_count + buf_remain; }
+	enum { buf_size = 2048 };
+
 	// Skips n samples
 	blargg_err_t skip( int n );
 
@@ -58,10 +85,27 @@ public:
 	// This should approximate the absolute position in the song.
 	int sample_count_scaled() const             { return out_time_scaled_; }
 
+	// Number of samples emulator has generated since start_track(). Can be ahead
+	// of sample_count() while looking ahead for silence.
+	int emu_sample_count() const                { return emu_time; }
+
+	// Continues track from point where emulator had generated n samples (scaled_n
+	// for sample_count_scaled()), after caller restored emulator to that point.
+	void resume( int n, int scaled_n );
+
 	// True if track ended. Causes are end of source samples, end of fade,
 	// or excessive silence.
 	bool track_ended() const                    { return track_ended_; }
 
+	// True if emulator has reached end of track, even if output hasn't yet
+	bool emu_track_ended() const                { return emu_track_ended_ != 0; }
+
+	// True if track was ended by excessive silence
+	bool ended_on_silence() const               { return silence_ended_; }
+
+	// Sample count at which most recent run of silence began
+	int silence_start() const                   { return silence_time; }
+
 	// Clears state
 	void stop();
 
@@ -83,14 +127,17 @@ private:
 	setup_t setup_;
 	const char* emu_error;
 	bool silence_ignored_;
+	int end_time_;
 	
 	// Timing
 	int out_time;  // number of samples played since start of track
 	int out_time_scaled_;
 	double tempo_;
+	float float_scale_;
 	int emu_time;  // number of samples emulator has generated since start of track
 	int emu_track_ended_; // emulator has reached end of track
 	volatile int track_ended_;
+	bool silence_ended_;  // track was ended by silence detection
 	void clear_time_vars();
 	void end_track_if_error( blargg_err_t );
 	
@@ -98,16 +145,25 @@ private:
 	int fade_start;
 	int fade_step;
 	bool is_fading() const;
+	int fade_gain( int time );
 	void handle_fade( sample_t out [], int count );
+	void handle_fade_float( sample_t const in [], int count, float left [], float right [] );
 	
 	// Silence detection
 	int silence_time;   // absolute number of samples where most recent silence began
 	int silence_count;  // number of samples of silence to play before using buf
 	int buf_remain;     // number of samples left in silence buffer
-	enum { buf_size = 2048 };
 	blargg_vector<sample_t> buf;
 	void fill_buf();
 	void emu_play( sample_t out [], int count );
+	void play_unfaded( int count, sample_t out [], bool direct = false );
+	bool looking_ahead() const;
+	void check_end_time( int count );
 };
 
+inline bool Track_Filter::looking_ahead() const
+{
+	return !silence_ignored_ && (end_time_ < 0 || end_time_ == indefinite_count);
+}
+
 #endif
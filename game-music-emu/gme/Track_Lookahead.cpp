@@ -0,0 +1,208 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Track_Lookahead.h"
+
+#include "Music_Emu.h"
+
+#include "blargg_source.h"
+
+// Number of samples generated per play() call by copy. Smaller values find
+// the end more precisely, since copy's track only ends at a call boundary.
+int const block_size = 1024;
+
+Track_Lookahead::Track_Lookahead()
+{
+	started = false;
+#if !GME_DISABLE_THREADS
+	end_time_ = -1;
+	stop_requested = false;
+	limit = 0;
+#endif
+}
+
+Track_Lookahead::~Track_Lookahead()
+{
+	stop();
+}
+
+bool Track_Lookahead::supported()
+{
+	#if GME_DISABLE_THREADS
+		return false;
+	#else
+		return true;
+	#endif
+}
+
+bool Track_Lookahead::matches( setup_t const& s ) const
+{
+	return started &&
+			s.type        == setup_.type &&
+			s.data        == setup_.data &&
+			s.size        == setup_.size &&
+			s.sample_rate == setup_.sample_rate &&
+			s.gain        == setup_.gain &&
+			s.tempo       == setup_.tempo &&
+			s.track       == setup_.track &&
+			s.mute_mask   == setup_.mute_mask &&
+			s.equalizer.treble  == setup_.equalizer.treble &&
+			s.equalizer.bass    == setup_.equalizer.bass &&
+			s.ym2612_core       == setup_.ym2612_core &&
+			s.qsound_rate       == setup_.qsound_rate &&
+			s.resampler_quality == setup_.resampler_quality &&
+			s.filter.max_initial == setup_.filter.max_initial &&
+			s.filter.max_silence == setup_.filter.max_silence &&
+			s.filter.lookahead   == setup_.filter.lookahead &&
+			s.effects_buffer     == setup_.effects_buffer &&
+			s.effects.enabled    == setup_.effects.enabled &&
+			s.effects.echo       == setup_.effects.echo &&
+			s.effects.stereo     == setup_.effects.stereo &&
+			s.effects.surround   == setup_.effects.surround;
+}
+
+#if GME_DISABLE_THREADS
+
+blargg_err_t Track_Lookahead::start( setup_t const& )
+{
+	return BLARGG_ERR( BLARGG_ERR_LIMITATION, "threads not supported" );
+}
+
+void Track_Lookahead::stop() { }
+
+void Track_Lookahead::set_limit( int ) { }
+
+int Track_Lookahead::end_time() const { return -1; }
+
+#else
+
+blargg_err_t Track_Lookahead::start( setup_t const& s )
+{
+	stop();
+
+	setup_         = s;
+	end_time_      = Track_Filter::indefinite_count;
+	stop_requested = false;
+	limit          = 0;
+
+	#if __cpp_exceptions || __EXCEPTIONS || _CPPUNWIND
+		try {
+			thread = std::thread( &Track_Lookahead::run, this );
+		}
+		catch ( ... ) {
+			end_time_ = -1;
+			return BLARGG_ERR( BLARGG_ERR_GENERIC, "couldn't start thread" );
+		}
+	#else
+		thread = std::thread( &Track_Lookahead::run, this );
+	#endif
+
+	started = true;
+	return blargg_ok;
+}
+
+void Track_Lookahead::stop()
+{
+	if ( started )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			stop_requested = true;
+		}
+		limit_changed.notify_one();
+		thread.join();
+		started = false;
+	}
+	end_time_ = -1;
+}
+
+int Track_Lookahead::end_time() const
+{
+	return end_time_;
+}
+
+void Track_Lookahead::set_limit( int time )
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( time <= limit )
+			return;
+		limit = time;
+	}
+	limit_changed.notify_one();
+}
+
+// Waits until search may play past time. False if stop was requested.
+bool Track_Lookahead::wait_for_limit( int time )
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	while ( time >= limit && !stop_requested )
+		limit_changed.wait( lock );
+	return !stop_requested;
+}
+
+void Track_Lookahead::run()
+{
+	int end = -1;
+
+	Music_Emu* emu = setup_.type->new_emu();
+#if !GME_DISABLE_EFFECTS
+	if ( emu && setup_.effects_buffer )
+	{
+		// echo delays silence, so copy needs effects as gme_new_emu() gives them
+		emu->effects_buffer_ = BLARGG_NEW Simple_Effects_Buffer;
+		if ( emu->effects_buffer_ )
+		{
+			emu->set_buffer( emu->effects_buffer_ );
+		}
+		else
+		{
+			delete emu;
+			emu = NULL;
+		}
+	}
+#endif
+	if ( emu )
+	{
+		// copy must generate same sound, so silence is found at same time
+		emu->set_gain( setup_.gain );
+		blargg_err_t err = emu->set_sample_rate( setup_.sample_rate );
+		emu->tfilter = setup_.filter;
+		if ( !err && setup_.ym2612_core >= 0 )
+			err = emu->set_ym2612_core( setup_.ym2612_core );
+		if ( !err && setup_.qsound_rate >= 0 )
+			err = emu->set_qsound_rate( setup_.qsound_rate );
+		if ( !err && setup_.resampler_quality >= 0 )
+			err = emu->set_resampler_quality( setup_.resampler_quality );
+		if ( !err )
+			err = emu->load_mem( setup_.data, setup_.size );
+		if ( !err )
+		{
+			if ( setup_.effects_buffer )
+			{
+				Simple_Effects_Buffer* b = STATIC_CAST(Simple_Effects_Buffer*,emu->effects_buffer_);
+				b->config() = setup_.effects;
+				b->apply_config();
+			}
+			emu->set_equalizer( setup_.equalizer );
+			emu->mute_voices( setup_.mute_mask );
+			emu->set_tempo( setup_.tempo );
+			err = emu->start_track( setup_.track );
+		}
+
+		if ( !err )
+		{
+			Music_Emu::sample_t buf [block_size];
+			while ( !emu->track_ended() &&
+					wait_for_limit( emu->track_filter.sample_count_scaled() ) )
+				emu->play( block_size, buf ); // errors end track
+
+			if ( !stop_requested )
+				end = emu->track_filter.sample_count_scaled();
+		}
+		delete emu;
+	}
+
+	end_time_ = end;
+}
+
+#endif
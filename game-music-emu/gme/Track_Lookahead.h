@@ -0,0 +1,91 @@
+// Finds end of track in background, by playing a copy of the emulator in
+// another thread
+
+// Game_Music_Emu $vers
+#ifndef TRACK_LOOKAHEAD_H
+#define TRACK_LOOKAHEAD_H
+
+#include "blargg_common.h"
+#include "Effects_Buffer.h"
+#include "Track_Filter.h"
+
+#include "gme.h"
+
+#if !GME_DISABLE_THREADS
+	#include <atomic>
+	#include <condition_variable>
+	#include <mutex>
+	#include <thread>
+#endif
+
+class Track_Lookahead {
+public:
+	struct setup_t {
+		gme_type_t_ const* type;
+		void const* data;   // file data; must remain valid until stop()
+		long size;
+		int sample_rate;
+		double gain;
+		double tempo;
+		int track;          // track index after any playlist remapping
+		
+		// Settings of emulator being played, or -1 for ones never set
+		int mute_mask;
+		gme_equalizer_t equalizer;
+		int ym2612_core;
+		int qsound_rate;
+		int resampler_quality;
+		
+		// Silence detection and effects, which decide when track ends
+		Track_Filter::setup_t filter;
+		bool effects_buffer;    // true if emulator uses an effects buffer
+		Simple_Effects_Buffer::config_t effects;
+	};
+
+	// Stops any current search, then loads file into a new emulator and plays
+	// track in the background until it ends
+	blargg_err_t start( setup_t const& );
+
+	// Stops search and waits for background thread to finish
+	void stop();
+	
+	// Lets search play until Track_Filter::sample_count_scaled() reaches time,
+	// then waits for a later limit. Starts at 0, so search waits until this is
+	// called.
+	void set_limit( int time );
+
+	// Track_Filter::sample_count_scaled() at which track ended, indefinite_count
+	// if not known yet, or -1 if search failed or isn't running
+	int end_time() const;
+
+	// True if a search was started with the same setup
+	bool matches( setup_t const& ) const;
+
+	// True if background threads are available
+	static bool supported();
+
+public:
+	Track_Lookahead();
+	~Track_Lookahead();
+	BLARGG_DISABLE_NOTHROW
+
+private:
+	setup_t setup_;
+	bool started;
+#if !GME_DISABLE_THREADS
+	std::thread thread;
+	std::atomic<int> end_time_;
+	std::atomic<bool> stop_requested;
+	std::mutex mutex;
+	std::condition_variable limit_changed;
+	int limit;
+	void run();
+	bool wait_for_limit( int time );
+#endif
+
+	// noncopyable
+	Track_Lookahead( const Track_Lookahead& );
+	Track_Lookahead& operator = ( const Track_Lookahead& );
+};
+
+#endif
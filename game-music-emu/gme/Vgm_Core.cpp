@@ -263,10 +263,22 @@ Vgm_Core::Vgm_Core()
 	blip_buf[0] = stereo_buf[0].center();
 	blip_buf[1] = blip_buf[0];
 	has_looped = false;
+	stream = NULL;
+	event_count  = 0;
+	loop_event   = -1;
+	events_begin = NULL;
+	next_event   = -1;
+	seek_point_count = -1;
+	lane_count     = 0;
+	chip_write_seq = 0;
+	lane_end_time  = 0;
 	DacCtrlUsed = 0;
 	dac_control = NULL;
 	memset( PCMBank, 0, sizeof( PCMBank ) );
 	memset( &PCMTbl, 0, sizeof( PCMTbl ) );
+	profiling_ = false;
+	qsound_rate_ = 0;
+	resampler_width_ = 0;
 	memset( DacCtrl, 0, sizeof( DacCtrl ) );
 	memset( DacCtrlTime, 0, sizeof( DacCtrlTime ) );
 }
@@ -275,12 +287,18 @@ Vgm_Core::~Vgm_Core()
 {
 	for (unsigned i = 0; i < DacCtrlUsed; i++) device_stop_daccontrol( dac_control [i] );
 	if ( dac_control ) free( dac_control );
-	for (unsigned i = 0; i < PCM_BANK_COUNT; i++)
+	free_pcm_banks();
+	if ( PCMTbl.Entries ) free( PCMTbl.Entries );
+}
+
+void Vgm_Core::free_pcm_banks()
+{
+	for ( unsigned i = 0; i < PCM_BANK_COUNT; i++ )
 	{
 		if ( PCMBank [i].Bank ) free( PCMBank [i].Bank );
-		if ( PCMBank [i].Data ) free( PCMBank [i].Data );
+		if ( PCMBank [i].Buffer ) free( PCMBank [i].Buffer );
 	}
-	if ( PCMTbl.Entries ) free( PCMTbl.Entries );
+	memset( PCMBank, 0, sizeof( PCMBank ) );
 }
 
 typedef unsigned int FUINT8;
@@ -304,7 +322,7 @@ void Vgm_Core::ReadPCMTable(unsigned DataSize, const byte* Data)
 	memcpy(PCMTbl.Entries, Data + 0x06, TblSize);
 }
 
-bool Vgm_Core::DecompressDataBlk(VGM_PCM_DATA* Bank, unsigned DataSize, const byte* Data)
+bool Vgm_Core::DecompressDataBlk(VGM_PCM_DATA* Bank, byte* Out, unsigned DataSize, const byte* Data)
 {
 	UINT8 ComprType;
 	UINT8 BitDec;
@@ -365,9 +383,9 @@ bool Vgm_Core::DecompressDataBlk(VGM_PCM_DATA* Bank, unsigned DataSize, const by
 		InDataEnd = Data + DataSize;
 		InShift = 0;
 		OutShift = BitDec - BitCmp;
-		OutDataEnd = Bank->Data + Bank->DataSize;
+		OutDataEnd = Out + Bank->DataSize;
 
-		for (OutPos = Bank->Data; OutPos < OutDataEnd && InPos < InDataEnd; OutPos += ValSize)
+		for (OutPos = Out; OutPos < OutDataEnd && InPos < InDataEnd; OutPos += ValSize)
 		{
 			//InVal = ReadBits(Data, InPos, &InShift, BitCmp);
 			// inlined - is 30% faster
@@ -446,10 +464,10 @@ bool Vgm_Core::DecompressDataBlk(VGM_PCM_DATA* Bank, unsigned DataSize, const by
 		InDataEnd = Data + DataSize;
 		InShift = 0;
 		OutShift = BitDec - BitCmp;
-		OutDataEnd = Bank->Data + Bank->DataSize;
+		OutDataEnd = Out + Bank->DataSize;
 		AddVal = 0x0000;
 
-		for (OutPos = Bank->Data; OutPos < OutDataEnd && InPos < InDataEnd; OutPos += ValSize)
+		for (OutPos = Out; OutPos < OutDataEnd && InPos < InDataEnd; OutPos += ValSize)
 		{
 			//InVal = ReadBits(Data, InPos, &InShift, BitCmp);
 			// inlined - is 30% faster
@@ -500,6 +518,46 @@ bool Vgm_Core::DecompressDataBlk(VGM_PCM_DATA* Bank, unsigned DataSize, const by
 	return true;
 }
 
+// Makes room in bank's own buffer for size bytes of data, doubling its size
+// as it grows so blocks aren't copied many times. If bank moves, updates
+// pointers into it.
+bool Vgm_Core::grow_pcm_bank( unsigned bank, unsigned size )
+{
+	VGM_PCM_BANK& b = PCMBank [bank];
+	if ( b.Data == b.Buffer && size <= b.BufferSize )
+		return true;
+	
+	unsigned new_size = size;
+	if ( b.BufferSize <= 0x7FFFFFFF / 2 && new_size < b.BufferSize * 2 )
+		new_size = b.BufferSize * 2;
+	byte* buf = (byte*) realloc( b.Buffer, new_size );
+	if ( !buf )
+		return false;
+	
+	// first block is still in place in file
+	if ( b.Data != b.Buffer && b.DataSize )
+		memcpy( buf, b.Data, b.DataSize );
+	
+	byte const* old = b.Data;
+	b.Buffer     = buf;
+	b.BufferSize = new_size;
+	b.Data       = buf;
+	for ( unsigned i = 0; i < b.BankCount; i++ )
+		if ( b.Bank [i].Data )
+			b.Bank [i].Data = buf + b.Bank [i].DataStart;
+	
+	// rebase PCM seek pointer and DAC streams playing from bank
+	if ( bank == 0 && old && pcm_pos >= old && pcm_pos <= old + b.DataSize )
+		pcm_pos = buf + (pcm_pos - old);
+	for ( unsigned i = 0; i < DacCtrlUsed; i++ )
+	{
+		unsigned chip = DacCtrlUsg [i];
+		if ( DacCtrl [chip].Enable && DacCtrl [chip].Bank == bank )
+			daccontrol_refresh_data( dac_control [i], b.Data, b.DataSize );
+	}
+	return true;
+}
+
 void Vgm_Core::AddPCMData(byte Type, unsigned DataSize, const byte* Data)
 {
 	unsigned CurBnk;
@@ -519,11 +577,11 @@ void Vgm_Core::AddPCMData(byte Type, unsigned DataSize, const byte* Data)
 	}
 
 	TempPCM = &PCMBank[Type & 0x3F];
-	CurBnk = TempPCM->BankCount;
-	TempPCM->BankCount ++;
 	TempPCM->BnkPos ++;
-	if (TempPCM->BnkPos < TempPCM->BankCount)
+	if (TempPCM->BnkPos <= TempPCM->BankCount)
 		return;	// Speed hack (for restarting playback)
+	CurBnk = TempPCM->BankCount;
+	TempPCM->BankCount ++;
 	TempPCM->Bank = (VGM_PCM_DATA*)realloc(TempPCM->Bank,
 		sizeof(VGM_PCM_DATA) * TempPCM->BankCount);
 
@@ -531,26 +589,45 @@ void Vgm_Core::AddPCMData(byte Type, unsigned DataSize, const byte* Data)
 		BankSize = DataSize;
 	else
 		BankSize = get_le32( Data + 1 );
-	TempPCM->Data = ( byte * ) realloc(TempPCM->Data, TempPCM->DataSize + BankSize);
 	TempBnk = &TempPCM->Bank[CurBnk];
 	TempBnk->DataStart = TempPCM->DataSize;
+	TempBnk->Data = NULL;
+	TempBnk->DataSize = 0x00;
+
+	// A bank that's a single uncompressed block is used in place in file
+	if (! (Type & 0x40) && ! CurBnk)
+	{
+		TempBnk->DataSize = DataSize;
+		TempBnk->Data = Data;
+		TempPCM->Data = Data;
+		TempPCM->DataSize = DataSize;
+		return;
+	}
+
+	// Others are copied into bank's own buffer, grown as blocks are added
+	if (BankSize > 0x7FFFFFFF - TempPCM->DataSize ||
+			! grow_pcm_bank(Type & 0x3F, TempPCM->DataSize + BankSize))
+	{
+		set_warning( "PCM data too large" );
+		return;
+	}
+	byte* Out = TempPCM->Buffer + TempBnk->DataStart;
+
 	if (! (Type & 0x40))
 	{
 		TempBnk->DataSize = DataSize;
-		TempBnk->Data = TempPCM->Data + TempBnk->DataStart;
-		memcpy(TempBnk->Data, Data, DataSize);
+		memcpy(Out, Data, DataSize);
 	}
 	else
 	{
-		TempBnk->Data = TempPCM->Data + TempBnk->DataStart;
-		RetVal = DecompressDataBlk(TempBnk, DataSize, Data);
+		RetVal = DecompressDataBlk(TempBnk, Out, DataSize, Data);
 		if (! RetVal)
 		{
-			TempBnk->Data = NULL;
 			TempBnk->DataSize = 0x00;
 			return;
 		}
 	}
+	TempBnk->Data = Out;
 	TempPCM->DataSize += BankSize;
 }
 
@@ -589,6 +666,45 @@ extern "C" void chip_reg_write_c(void * context, UINT32 Sample, UINT8 ChipType,
 	core->chip_reg_write(Sample, ChipType, ChipID, Port, Offset, Data);
 }
 
+extern "C" void chip_stream_write_c(void * context, UINT8 ChipType, UINT8 ChipID, UINT16 Command,
+		const UINT32* Samples, const UINT8* Data, UINT8 DataStep, UINT32 Count)
+{
+	Vgm_Core * core = (Vgm_Core *) context;
+	core->chip_stream_write(ChipType, ChipID, Command, Samples, Data, DataStep, Count);
+}
+
+// Writes run of DAC stream commands. Only called from run_dac_control(), so
+// doesn't need to run streams first like chip_reg_write() does. Every sample
+// still counts as one profiled write, as if written by chip_reg_write().
+void Vgm_Core::chip_stream_write( int type, int id, int command, unsigned const times [],
+		byte const* data, int step, int count )
+{
+	id = !!id;
+	switch ( type )
+	{
+	case 0x02:
+		if ( command == ym2612_dac_port ) // port 0
+		{
+			write_pcm_run( id, times, data, step, count );
+			return;
+		}
+		break;
+	
+	case 0x11:
+		for ( int i = 0; i < count; i++, data += step )
+			write_chip( to_fm_time( times [i] ), type, id, command & 0x0F, data [1] & 0x0F, data [0] );
+		return;
+	
+	case 0x17:
+		for ( int i = 0; i < count; i++, data += step )
+			write_chip( to_fm_time( times [i] ), type, id, 0, command & 0xFF, data [0] );
+		return;
+	}
+	
+	for ( int i = 0; i < count; i++, data += step )
+		chip_reg_write( times [i], type, id, command >> 8, command & 0xFF, data [0] );
+}
+
 void Vgm_Core::chip_reg_write(unsigned Sample, byte ChipType, byte ChipID, byte Port, byte Offset, byte Data)
 {
 	run_dac_control( Sample ); /* Let's get recursive! */
@@ -596,160 +712,356 @@ void Vgm_Core::chip_reg_write(unsigned Sample, byte ChipType, byte ChipID, byte
 	switch (ChipType)
 	{
 	case 0x02:
-		switch (Port)
+		if ( Port == 0 && Offset == ym2612_dac_port )
+		{
+			write_pcm( Sample, ChipID, Data );
+			return;
+		}
+		if ( Port > 1 || !ym2612[ChipID].enabled() )
+			return;
+		
+		if ( Port == 0 )
 		{
-		case 0:
-			if ( Offset == ym2612_dac_port )
+			if ( Offset == 0x2B )
 			{
-				write_pcm( Sample, ChipID, Data );
+				dac_disabled[ChipID] = (Data >> 7 & 1) - 1;
+				dac_amp[ChipID] |= dac_disabled[ChipID];
 			}
-			else if ( run_ym2612( ChipID, to_fm_time( Sample ) ) )
+		}
+		else if ( Offset == ym2612_dac_pan_port )
+		{
+			Blip_Buffer * blip_buf = NULL;
+			switch ( Data >> 6 )
 			{
-				if ( Offset == 0x2B )
-				{
-					dac_disabled[ChipID] = (Data >> 7 & 1) - 1;
-					dac_amp[ChipID] |= dac_disabled[ChipID];
-				}
-				ym2612[ChipID].write0( Offset, Data );
+			case 0: blip_buf = NULL; break;
+			case 1: blip_buf = stereo_buf[0].right(); break;
+			case 2: blip_buf = stereo_buf[0].left(); break;
+			case 3: blip_buf = stereo_buf[0].center(); break;
 			}
-			break;
-		
-		case 1:
-			if ( run_ym2612( ChipID, to_fm_time( Sample ) ) )
+			/*if ( this->blip_buf != blip_buf )
 			{
-				if ( Offset == ym2612_dac_pan_port )
-				{
-					Blip_Buffer * blip_buf = NULL;
-					switch ( Data >> 6 )
-					{
-					case 0: blip_buf = NULL; break;
-					case 1: blip_buf = stereo_buf[0].right(); break;
-					case 2: blip_buf = stereo_buf[0].left(); break;
-					case 3: blip_buf = stereo_buf[0].center(); break;
-					}
-					/*if ( this->blip_buf != blip_buf )
-					{
-						blip_time_t blip_time = to_psg_time( vgm_time );
-						if ( this->blip_buf ) pcm.offset_inline( blip_time, -dac_amp, this->blip_buf );
-						if ( blip_buf )       pcm.offset_inline( blip_time,  dac_amp, blip_buf );
-					}*/
-					this->blip_buf[ChipID] = blip_buf;
-				}
-				ym2612[ChipID].write1( Offset, Data );
-			}
-			break;
+				blip_time_t blip_time = to_psg_time( vgm_time );
+				if ( this->blip_buf ) pcm.offset_inline( blip_time, -dac_amp, this->blip_buf );
+				if ( blip_buf )       pcm.offset_inline( blip_time,  dac_amp, blip_buf );
+			}*/
+			this->blip_buf[ChipID] = blip_buf;
 		}
 		break;
 
+	case 0x00: {
+		double start = profile_start();
+		psg[ChipID].write_data( to_psg_time( Sample ), Data );
+		profile_write( apu_profile[0][ChipID], start );
+		return;
+	}
+
+	case 0x12: {
+		double start = profile_start();
+		ay[ChipID].write_addr( Offset );
+		ay[ChipID].write_data( to_ay_time( Sample ), Data );
+		profile_write( apu_profile[1][ChipID], start );
+		return;
+	}
+
+	case 0x13: {
+		double start = profile_start();
+		gbdmg[ChipID].write_register( to_gbdmg_time( Sample ), 0xFF10 + Offset, Data );
+		profile_write( apu_profile[3][ChipID], start );
+		return;
+	}
+
+    case 0x1B: {
+        double start = profile_start();
+        huc6280[ChipID].write_data( to_huc6280_time( Sample ), 0x800 + Offset, Data );
+        profile_write( apu_profile[2][ChipID], start );
+        return;
+    }
+
+	case 0x01:
+	case 0x03:
+	case 0x06:
+	case 0x07:
+	case 0x08:
+	case 0x09:
+	case 0x0C:
+	case 0x0F:
 	case 0x11:
-		if ( run_pwm( to_fm_time( Sample ) ) )
-			pwm.write( Port, ( ( Offset ) << 8 ) + Data );
+	case 0x17:
+	case 0x18:
+	case 0x19:
+	case 0x1A:
+	case 0x1D:
 		break;
 
-	case 0x00:
-		psg[ChipID].write_data( to_psg_time( Sample ), Data );
+	case 0x1F: // QSound is run to VGM time rather than FM time
+		write_chip( Sample, ChipType, ChipID, Port, Offset, Data );
+		return;
+
+	default:
+		return;
+	}
+	write_chip( to_fm_time( Sample ), ChipType, ChipID, Port, Offset, Data );
+}
+
+// Chips that write_chip() handles, in the order they're run to the end of frame.
+// Besides chip_reg_write() types, 0x04 is SegaPCM, 0x05 RF5C68, 0x10 RF5C164,
+// and 0x1C C140. Port 1 of RF5Cxx writes to memory.
+static byte const lane_chips [] = {
+	0x0C, 0x09, 0x02, 0x08, 0x07, 0x01, 0x06, 0x03, 0x1C, 0x04,
+	0x05, 0x10, 0x11, 0x17, 0x18, 0x19, 0x1D, 0x1A, 0x0F, 0x1F
+};
+
+template<class Emu>
+static Chip_Resampler* enabled_resampler( Chip_Resampler_Emu<Emu>& chip )
+{
+	return chip.enabled() ? &chip.resampler() : NULL;
+}
+
+// Resampler of chip, or NULL if it isn't enabled
+Chip_Resampler* Vgm_Core::chip_resampler( int type, int id )
+{
+	switch ( type )
+	{
+	case 0x0C: return enabled_resampler( ymf262 [id] );
+	case 0x09: return enabled_resampler( ym3812 [id] );
+	case 0x02: return enabled_resampler( ym2612 [id] );
+	case 0x08: return enabled_resampler( ym2610 [id] );
+	case 0x07: return enabled_resampler( ym2608 [id] );
+	case 0x01: return enabled_resampler( ym2413 [id] );
+	case 0x06: return enabled_resampler( ym2203 [id] );
+	case 0x03: return enabled_resampler( ym2151 [id] );
+	case 0x1C: return id ? NULL : enabled_resampler( c140 );
+	case 0x04: return id ? NULL : enabled_resampler( segapcm );
+	case 0x05: return id ? NULL : enabled_resampler( rf5c68 );
+	case 0x10: return id ? NULL : enabled_resampler( rf5c164 );
+	case 0x11: return id ? NULL : enabled_resampler( pwm );
+	case 0x17: return enabled_resampler( okim6258 [id] );
+	case 0x18: return enabled_resampler( okim6295 [id] );
+	case 0x19: return id ? NULL : enabled_resampler( k051649 );
+	case 0x1D: return id ? NULL : enabled_resampler( k053260 );
+	case 0x1A: return id ? NULL : enabled_resampler( k054539 );
+	case 0x0F: return id ? NULL : enabled_resampler( ymz280b );
+	case 0x1F: return enabled_resampler( qsound [id] );
+	}
+	return NULL;
+}
+
+// Has enabled chips running at the same rate sum their output and resample it
+// once, rather than each resampling its own
+void Vgm_Core::group_chips()
+{
+	Chip_Resampler* groups [max_lanes];
+	int group_count = 0;
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+	{
+		// OKIM6258 changes rate with its clock, and QSound runs to VGM time
+		int type = lane_chips [i];
+		if ( type == 0x17 || type == 0x1F )
+			continue;
+		
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( type, id );
+			if ( !r )
+				break;
+			
+			int n = 0;
+			while ( n < group_count && !groups [n]->merge( *r ) )
+				n++;
+			if ( n >= group_count )
+				groups [group_count++] = r;
+		}
+	}
+}
+
+int Vgm_Core::run_chip( int type, int id, int time )
+{
+	switch ( type )
+	{
+	case 0x0C: return run_ymf262( id, time );
+	case 0x09: return run_ym3812( id, time );
+	case 0x02: return run_ym2612( id, time );
+	case 0x08: return run_ym2610( id, time );
+	case 0x07: return run_ym2608( id, time );
+	case 0x01: return run_ym2413( id, time );
+	case 0x06: return run_ym2203( id, time );
+	case 0x03: return run_ym2151( id, time );
+	case 0x1C: return run_c140( time );
+	case 0x04: return run_segapcm( time );
+	case 0x05: return run_rf5c68( time );
+	case 0x10: return run_rf5c164( time );
+	case 0x11: return run_pwm( time );
+	case 0x17: return run_okim6258( id, time );
+	case 0x18: return run_okim6295( id, time );
+	case 0x19: return run_k051649( time );
+	case 0x1D: return run_k053260( time );
+	case 0x1A: return run_k054539( time );
+	case 0x0F: return run_ymz280b( time );
+	case 0x1F: return run_qsound( id, time );
+	}
+	return false;
+}
+
+void Vgm_Core::run_chip_write( chip_write_t const& w )
+{
+	int const id = w.id;
+	int const offset = w.offset;
+	int const data = w.data;
+	if ( !run_chip( w.type, id, w.time ) )
+		return;
+	
+	if ( profiling() )
+		chip_resampler( w.type, id )->profile().writes++;
+	
+	switch ( w.type )
+	{
+	case 0x02:
+		if ( w.port ) ym2612[id].write1( offset, data );
+		else          ym2612[id].write0( offset, data );
+		break;
+
+	case 0x11:
+		pwm.write( w.port, ( offset << 8 ) + data );
 		break;
 
 	case 0x01:
-		if ( run_ym2413( ChipID, to_fm_time( Sample ) ) )
-			ym2413[ChipID].write( Offset, Data );
+		ym2413[id].write( offset, data );
 		break;
 
 	case 0x03:
-		if ( run_ym2151( ChipID, to_fm_time( Sample ) ) )
-			ym2151[ChipID].write( Offset, Data );
+		ym2151[id].write( offset, data );
 		break;
 
 	case 0x06:
-		if ( run_ym2203( ChipID, to_fm_time( Sample ) ) )
-			ym2203[ChipID].write( Offset, Data );
+		ym2203[id].write( offset, data );
 		break;
 
 	case 0x07:
-		if ( run_ym2608( ChipID, to_fm_time( Sample ) ) )
+		switch ( w.port )
 		{
-			switch (Port)
-			{
-			case 0: ym2608[ChipID].write0( Offset, Data ); break;
-			case 1: ym2608[ChipID].write1( Offset, Data ); break;
-			}
+		case 0: ym2608[id].write0( offset, data ); break;
+		case 1: ym2608[id].write1( offset, data ); break;
 		}
 		break;
 
 	case 0x08:
-		if ( run_ym2610( ChipID, to_fm_time( Sample ) ) )
+		switch ( w.port )
 		{
-			switch (Port)
-			{
-			case 0: ym2610[ChipID].write0( Offset, Data ); break;
-			case 1: ym2610[ChipID].write1( Offset, Data ); break;
-			}
+		case 0: ym2610[id].write0( offset, data ); break;
+		case 1: ym2610[id].write1( offset, data ); break;
 		}
 		break;
 
 	case 0x09:
-		if ( run_ym3812( ChipID, to_fm_time( Sample ) ) )
-			ym3812[ChipID].write( Offset, Data );
+		ym3812[id].write( offset, data );
 		break;
 
 	case 0x0C:
-		if ( run_ymf262( ChipID, to_fm_time( Sample ) ) )
+		switch ( w.port )
 		{
-			switch (Port)
-			{
-			case 0: ymf262[ChipID].write0( Offset, Data ); break;
-			case 1: ymf262[ChipID].write1( Offset, Data ); break;
-			}
+		case 0: ymf262[id].write0( offset, data ); break;
+		case 1: ymf262[id].write1( offset, data ); break;
 		}
 		break;
 
 	case 0x0F:
-		if ( run_ymz280b( to_fm_time( Sample ) ) )
-			ymz280b.write( Offset, Data );
-		break;
-
-	case 0x12:
-		ay[ChipID].write_addr( Offset );
-		ay[ChipID].write_data( to_ay_time( Sample ), Data );
-		break;
-
-	case 0x13:
-		gbdmg[ChipID].write_register( to_gbdmg_time( Sample ), 0xFF10 + Offset, Data );
+		ymz280b.write( offset, data );
 		break;
 
 	case 0x17:
-		if ( run_okim6258( ChipID, to_fm_time( Sample ) ) )
-			okim6258[ChipID].write( Offset, Data );
+		okim6258[id].write( offset, data );
 		break;
 
 	case 0x18:
-		if ( run_okim6295( ChipID, to_fm_time( Sample ) ) )
-			okim6295[ChipID].write( Offset, Data );
+		okim6295[id].write( offset, data );
 		break;
 
 	case 0x19:
-		if ( run_k051649( to_fm_time( Sample ) ) )
-			k051649.write( Port, Offset, Data );
+		k051649.write( w.port, offset, data );
 		break;
 
 	case 0x1A:
-		if ( run_k054539( to_fm_time( Sample ) ) )
-			k054539.write( ( Port << 8 ) | Offset, Data );
+		k054539.write( ( w.port << 8 ) | offset, data );
 		break;
 
-    case 0x1B:
-        huc6280[ChipID].write_data( to_huc6280_time( Sample ), 0x800 + Offset, Data );
-        break;
-
 	case 0x1D:
-		if ( run_k053260( to_fm_time( Sample ) ) )
-			k053260.write( Offset, Data );
+		k053260.write( offset, data );
 		break;
 
     case 0x1F:
-        if ( run_qsound( ChipID, Sample ) )
-            qsound[ ChipID ].write( Data, ( Port << 8 ) + Offset );
+        qsound[id].write( data, ( w.port << 8 ) + offset );
         break;
+
+	case 0x04:
+		segapcm.write( offset, data );
+		break;
+
+	case 0x05:
+		if ( w.port ) rf5c68.write_mem( offset, data );
+		else          rf5c68.write( offset, data );
+		break;
+
+	case 0x10:
+		if ( w.port ) rf5c164.write_mem( offset, data );
+		else          rf5c164.write( offset, data );
+		break;
+
+	case 0x1C:
+		c140.write( offset, data );
+		break;
+	}
+}
+
+// Runs FM or PCM chip to time then writes to it, or queues that if chips are
+// being run on several threads
+void Vgm_Core::write_chip( int time, int type, int id, int port, int offset, int data )
+{
+	chip_write_t w;
+	w.time   = time;
+	w.seq    = chip_write_seq++;
+	w.offset = offset;
+	w.type   = type;
+	w.id     = id;
+	w.port   = port;
+	w.data   = data;
+	if ( !lane_count )
+	{
+		run_chip_write( w );
+		return;
+	}
+	
+	int n = lane_of [type] [id];
+	if ( n >= lane_count )
+		return; // chip isn't enabled, so run_chip_write() would do nothing
+	
+	chip_lane_t& lane = lanes [n];
+	if ( lane.write_count >= (int) lane.writes.size() )
+	{
+		if ( lane.writes.resize( lane.writes.size() * 2 + 64 ) )
+		{
+			// Out of memory, so run write now
+			sync_chips();
+			lane.log.set_seq( w.seq );
+			run_chip_write( w );
+			return;
+		}
+	}
+	lane.writes [lane.write_count++] = w;
+}
+
+// Runs queued writes of all lanes, for when something else needs chips to be
+// up to date
+void Vgm_Core::sync_chips()
+{
+	for ( int n = 0; n < lane_count; n++ )
+	{
+		chip_lane_t& lane = lanes [n];
+		for ( int i = 0; i < lane.write_count; i++ )
+		{
+			lane.log.set_seq( lane.writes [i].seq );
+			run_chip_write( lane.writes [i] );
+		}
+		lane.write_count = 0;
 	}
 }
 
@@ -846,6 +1158,9 @@ blargg_err_t Vgm_Core::load_mem_( byte const data [], int size )
 	
 	if ( size <= header_t::size_min )
 		return blargg_err_file_type;
+	
+	if ( stream )
+		RETURN_ERR( stream->fill( header_t::size_max ) );
 
 	memcpy( &_header, data, header_t::size_min );
 	
@@ -868,6 +1183,17 @@ blargg_err_t Vgm_Core::load_mem_( byte const data [], int size )
 
 	_header.cleanup();
 
+	// PCM data, events decoded and seek index from previous file
+	free_pcm_banks();
+	events_begin = NULL;
+	event_count  = 0;
+	loop_event   = -1;
+	next_event   = -1;
+	seek_point_count = -1;
+	seek_points.clear();
+	seek_changes.clear();
+	seek_shadow.clear();
+	
 	// Get loop
 	loop_begin = file_end();
 	if ( get_le32( h.loop_offset ) )
@@ -936,15 +1262,19 @@ blargg_err_t Vgm_Core::load_mem_( byte const data [], int size )
 }
 
 // Update pre-1.10 header FM rates by scanning commands
-void Vgm_Core::update_fm_rates( int* ym2151_rate, int* ym2413_rate, int* ym2612_rate ) const
+void Vgm_Core::update_fm_rates( int* ym2151_rate, int* ym2413_rate, int* ym2612_rate )
 {
 	byte const* p = file_begin() + header().size();
 	int data_offset = get_le32( header().data_offset );
 	check( data_offset );
 	if ( data_offset )
 		p += data_offset + offsetof( header_t, data_offset ) - header().size();
+	byte const* limit = fill_stream( p );
 	while ( p < file_end() )
 	{
+		if ( p >= limit )
+			limit = fill_stream( p );
+		
 		switch ( *p )
 		{
 		case cmd_end:
@@ -1279,6 +1609,7 @@ blargg_err_t Vgm_Core::init_chips( double* rate, bool reinit )
 	if ( okim6295_rate )
 	{
 		// moo
+		fill_file(); // GD3 tag is at end
 		Mem_File_Reader rdr( file_begin(), file_size() );
 		Music_Emu * vgm = gme_vgm_type->new_info();
 		track_info_t info;
@@ -1370,11 +1701,14 @@ blargg_err_t Vgm_Core::init_chips( double* rate, bool reinit )
 			int result = qsound[0].set_rate( qsound_rate );
 			CHECK_ALLOC( result );
 		}
-		qsound[0].set_sample_rate( vgm_rate );
-        RETURN_ERR( qsound[0].setup( 1.0, 0.85, 1.0 ) );
+        RETURN_ERR( setup_qsound() );
         qsound[0].enable();
     }
 
+	group_chips();
+	set_chip_profiling();
+	RETURN_ERR( set_chip_widths() );
+	
 	fm_rate = *rate;
 	
 	return blargg_ok;
@@ -1396,15 +1730,14 @@ void Vgm_Core::start_track()
 
 	dac_disabled[0] = -1;
 	dac_disabled[1] = -1;
-	pos             = file_begin() + header().size();
 	dac_amp[0]      = -1;
 	dac_amp[1]      = -1;
 	vgm_time        = 0;
-	int data_offset = get_le32( header().data_offset );
-	check( data_offset );
-	if ( data_offset )
-		pos += data_offset + offsetof (header_t,data_offset) - header().size();
-	pcm_pos      = pos;
+	byte const* data = data_begin();
+	pcm_pos      = data;
+	if ( events_begin != data )
+		restart_decode( data );
+	next_event   = 0;
 	
 	if ( uses_fm() )
 	{
@@ -1555,9 +1888,30 @@ inline blip_time_t Vgm_Core::to_gbdmg_time( vgm_time_t t ) const
 	return (t * blip_gbdmg_time_factor) >> blip_time_bits;
 }
 
+// Longest command, other than data blocks
+int const max_cmd_size = 16;
+
+// Inflates file up to end if it's being streamed, and returns position before
+// which commands can be read without inflating more
+byte const* Vgm_Core::fill_stream( byte const* end )
+{
+	if ( !stream || stream->avail() >= stream->size() )
+		return file_end();
+	
+	blargg_err_t err = stream->fill( end - file_begin() + max_cmd_size );
+	if ( err )
+		set_warning( err );
+	
+	if ( stream->avail() >= stream->size() )
+		return file_end();
+	return file_begin() + stream->avail() - max_cmd_size;
+}
+
 void Vgm_Core::write_pcm( vgm_time_t vgm_time, int chip, int amp )
 {
 	chip = !!chip;
+	if ( profiling() )
+		ym2612[chip].resampler().profile().writes++;
 	if ( blip_buf[chip] )
 	{
 		check( amp >= 0 );
@@ -1573,503 +1927,428 @@ void Vgm_Core::write_pcm( vgm_time_t vgm_time, int chip, int amp )
 	}
 }
 
-blip_time_t Vgm_Core::run( vgm_time_t end_time )
+// Same as write_pcm() for each of count samples, with sample i written at times [i].
+// Counts each sample as a write when profiling, so profile doesn't depend on
+// whether PCM came from DAC streams or from individual commands.
+void Vgm_Core::write_pcm_run( int chip, unsigned const times [], byte const* data, int step, int count )
 {
-	vgm_time_t vgm_time = this->vgm_time; 
-	vgm_time_t vgm_loop_time = ~0;
-	int ChipID;
-	byte const* pos = this->pos;
-	if ( pos > file_end() )
-		set_warning( "Stream lacked end event" );
+	if ( profiling() )
+		ym2612[chip].resampler().profile().writes += count;
+	
+	Blip_Buffer* const buf = blip_buf[chip];
+	if ( !buf )
+		return;
+	
+	buf->set_modified();
+	int amp = dac_amp[chip];
+	for ( int i = 0; i < count; i++, data += step )
+	{
+		int old = amp;
+		amp = *data;
+		if ( old >= 0 )
+			pcm.offset_inline( to_psg_time( times [i] ), amp - old, buf );
+		else
+			amp |= dac_disabled[chip];
+	}
+	dac_amp[chip] = amp;
+}
+
+// Kinds of event_t
+enum {
+	event_delay,
+	event_end,
+	event_write,        // chip_reg_write()
+	event_psg,
+	event_gg_stereo,
+	event_pcm,          // YM2612 DAC write from PCM data
+	event_pcm_seek,
+	event_segapcm,
+	event_rf5c68,
+	event_rf5c68_mem,
+	event_rf5c164,
+	event_rf5c164_mem,
+	event_c140,
+	event_command       // run from file data by run_command()
+};
+
+// Number of events decoded at a time
+int const decode_batch = 1024;
+
+inline unsigned write_arg( int id, int port, int reg, int data )
+{
+	return id << 24 | port << 16 | reg << 8 | data;
+}
+
+void Vgm_Core::restart_decode( byte const* begin )
+{
+	events_begin = begin;
+	pos          = begin;
+	event_count  = 0;
+	loop_event   = -1;
+	decode_ended = false;
+}
+
+void Vgm_Core::add_event( int kind, int chip, unsigned arg )
+{
+	event_t& e = events [event_count++];
+	e.arg   = arg;
+	e.kind  = kind;
+	e.chip  = chip;
+	e.delay = 0;
+	decode_merge = true;
+}
+
+void Vgm_Core::add_delay( int delay )
+{
+	if ( !delay )
+		return;
+	
+	if ( decode_merge )
+	{
+		event_t& prev = events [event_count - 1];
+		if ( prev.delay + delay <= 0xFFFF )
+		{
+			prev.delay += delay;
+			return;
+		}
+	}
+	add_event( event_delay );
+	events [event_count - 1].delay = delay;
+}
+
+// Decodes next batch of commands and returns index of first new event, or -1
+// if there are no more
+int Vgm_Core::decode_events()
+{
+	if ( decode_ended )
+		return -1;
+	
+	// Long logs are decoded through a window rather than all kept
+	if ( event_count >= max_events )
+		restart_decode( pos );
+	
+	int const end = event_count + decode_batch;
+	if ( end > (int) events.size() )
+	{
+		int n = max( (int) events.size() * 2, end );
+		if ( n > max_events + decode_batch )
+			n = max_events + decode_batch;
+		if ( events.resize( n ) )
+		{
+			if ( (int) events.size() < decode_batch )
+			{
+				set_warning( blargg_err_memory );
+				decode_ended = true;
+				return -1;
+			}
+			restart_decode( pos );
+		}
+	}
 	
-	while ( vgm_time < end_time && pos < file_end() )
+	int const first = event_count;
+	decode_merge = false; // previous event might have already been run
+	byte const* pos = this->pos;
+	byte const* limit = fill_stream( pos );
+	while ( event_count < first + decode_batch && !decode_ended )
 	{
-		// TODO: be sure there are enough bytes left in stream for particular command
-		// so we don't read past end
+		if ( pos >= file_end() )
+		{
+			decode_ended = true;
+			break;
+		}
+		
+		if ( pos >= limit )
+			limit = fill_stream( pos );
+		
+		if ( pos == loop_begin )
+		{
+			loop_event = event_count;
+			decode_merge = false;
+		}
+		
+		unsigned const offset = pos - file_begin();
 		switch ( *pos++ )
 		{
 		case cmd_end:
-			if ( vgm_loop_time == ~0 ) vgm_loop_time = vgm_time;
-			else if ( vgm_loop_time == vgm_time ) loop_begin = file_end(); // XXX some files may loop forever on a region without any delay commands
-			pos = loop_begin; // if not looped, loop_begin == file_end()
-			if ( pos != file_end() ) has_looped = true;
+			add_event( event_end );
+			decode_ended = true;
 			break;
 		
 		case cmd_delay_735:
-			vgm_time += 735;
+			add_delay( 735 );
 			break;
 		
 		case cmd_delay_882:
-			vgm_time += 882;
+			add_delay( 882 );
 			break;
 		
 		case cmd_gg_stereo:
-			psg[0].write_ggstereo( to_psg_time( vgm_time ), *pos++ );
+			add_event( event_gg_stereo, 0, *pos++ );
 			break;
 
 		case cmd_gg_stereo_2:
-			psg[1].write_ggstereo( to_psg_time( vgm_time ), *pos++ );
+			add_event( event_gg_stereo, 1, *pos++ );
 			break;
 		
 		case cmd_psg:
-			psg[0].write_data( to_psg_time( vgm_time ), *pos++ );
+			add_event( event_psg, 0, *pos++ );
 			break;
 
 		case cmd_psg_2:
-			psg[1].write_data( to_psg_time( vgm_time ), *pos++ );
+			add_event( event_psg, 1, *pos++ );
 			break;
 
 		case cmd_ay8910:
-			ChipID = !!(pos [0] & 0x80);
-			chip_reg_write( vgm_time, 0x12, ChipID, 0x00, pos [0] & 0x7F, pos [1] );
+			add_event( event_write, 0x12, write_arg( !!(pos [0] & 0x80), 0x00, pos [0] & 0x7F, pos [1] ) );
 			pos += 2;
 			break;
 		
 		case cmd_delay:
-			vgm_time += pos [1] * 0x100 + pos [0];
+			add_delay( pos [1] * 0x100 + pos [0] );
 			pos += 2;
 			break;
 		
 		case cmd_byte_delay:
-			vgm_time += *pos++;
+			add_delay( *pos++ );
 			break;
 
 		case cmd_segapcm_write:
 			if ( get_le32( header().segapcm_rate ) > 0 )
-				if ( run_segapcm( to_fm_time( vgm_time ) ) )
-					segapcm.write( get_le16( pos ), pos [2] );
+				add_event( event_segapcm, 0, get_le16( pos ) << 8 | pos [2] );
 			pos += 3;
 			break;
 
 		case cmd_rf5c68:
-			if ( run_rf5c68( to_fm_time( vgm_time ) ) )
-				rf5c68.write( pos [0], pos [1] );
+			add_event( event_rf5c68, 0, pos [0] << 8 | pos [1] );
 			pos += 2;
 			break;
 
 		case cmd_rf5c68_mem:
-			if ( run_rf5c68( to_fm_time( vgm_time ) ) )
-				rf5c68.write_mem( get_le16( pos ), pos [2] );
+			add_event( event_rf5c68_mem, 0, get_le16( pos ) << 8 | pos [2] );
 			pos += 3;
 			break;
 
 		case cmd_rf5c164:
-			if ( run_rf5c164( to_fm_time( vgm_time ) ) )
-				rf5c164.write( pos [0], pos [1] );
+			add_event( event_rf5c164, 0, pos [0] << 8 | pos [1] );
 			pos += 2;
 			break;
 
 		case cmd_rf5c164_mem:
-			if ( run_rf5c164( to_fm_time( vgm_time ) ) )
-				rf5c164.write_mem( get_le16( pos ), pos [2] );
+			add_event( event_rf5c164_mem, 0, get_le16( pos ) << 8 | pos [2] );
 			pos += 3;
 			break;
 
 		case cmd_pwm:
-			chip_reg_write( vgm_time, 0x11, 0x00, pos [0] >> 4, pos [0] & 0x0F, pos [1] );
+			add_event( event_write, 0x11, write_arg( 0x00, pos [0] >> 4, pos [0] & 0x0F, pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_c140:
 			if ( get_le32( header().c140_rate ) > 0 )
-				if ( run_c140( to_fm_time( vgm_time ) ) )
-					c140.write( get_be16( pos ), pos [2] );
+				add_event( event_c140, 0, get_be16( pos ) << 8 | pos [2] );
 			pos += 3;
 			break;
 
 		case cmd_ym2151:
-			chip_reg_write( vgm_time, 0x03, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x03, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2151_2:
-			chip_reg_write( vgm_time, 0x03, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x03, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2203:
-			chip_reg_write( vgm_time, 0x06, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x06, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2203_2:
-			chip_reg_write( vgm_time, 0x06, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x06, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 		
 		case cmd_ym2413:
-			chip_reg_write( vgm_time, 0x01, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x01, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2413_2:
-			chip_reg_write( vgm_time, 0x01, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x01, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym3812:
-			chip_reg_write( vgm_time, 0x09, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x09, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym3812_2:
-			chip_reg_write( vgm_time, 0x09, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x09, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ymf262_port0:
-			chip_reg_write( vgm_time, 0x0C, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x0C, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ymf262_2_port0:
-			chip_reg_write( vgm_time, 0x0C, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x0C, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ymf262_port1:
-			chip_reg_write( vgm_time, 0x0C, 0x00, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x0C, write_arg( 0x00, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ymf262_2_port1:
-			chip_reg_write( vgm_time, 0x0C, 0x01, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x0C, write_arg( 0x01, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ymz280b:
-			chip_reg_write( vgm_time, 0x0F, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x0F, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 		
 		case cmd_ym2612_port0:
-			chip_reg_write( vgm_time, 0x02, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x02, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2612_2_port0:
-			chip_reg_write( vgm_time, 0x02, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x02, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 		
 		case cmd_ym2612_port1:
-			chip_reg_write( vgm_time, 0x02, 0x00, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x02, write_arg( 0x00, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2612_2_port1:
-			chip_reg_write( vgm_time, 0x02, 0x01, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x02, write_arg( 0x01, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2610_port0:
-			chip_reg_write( vgm_time, 0x08, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x08, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2610_2_port0:
-			chip_reg_write( vgm_time, 0x08, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x08, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2610_port1:
-			chip_reg_write( vgm_time, 0x08, 0x00, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x08, write_arg( 0x00, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2610_2_port1:
-			chip_reg_write( vgm_time, 0x08, 0x01, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x08, write_arg( 0x01, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2608_port0:
-			chip_reg_write( vgm_time, 0x07, 0x00, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x07, write_arg( 0x00, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2608_2_port0:
-			chip_reg_write( vgm_time, 0x07, 0x01, 0x00, pos [0], pos [1] );
+			add_event( event_write, 0x07, write_arg( 0x01, 0x00, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2608_port1:
-			chip_reg_write( vgm_time, 0x07, 0x00, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x07, write_arg( 0x00, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_ym2608_2_port1:
-			chip_reg_write( vgm_time, 0x07, 0x01, 0x01, pos [0], pos [1] );
+			add_event( event_write, 0x07, write_arg( 0x01, 0x01, pos [0], pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_okim6258_write:
-			chip_reg_write( vgm_time, 0x17, ChipID, 0x00, pos [0] & 0x7F, pos [1] );
+			add_event( event_write, 0x17, write_arg( !!(pos [0] & 0x80), 0x00, pos [0] & 0x7F, pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_okim6295_write:
-			ChipID = (pos [0] & 0x80) ? 1 : 0;
-			chip_reg_write( vgm_time, 0x18, ChipID, 0x00, pos [0] & 0x7F, pos [1] );
+			add_event( event_write, 0x18, write_arg( !!(pos [0] & 0x80), 0x00, pos [0] & 0x7F, pos [1] ) );
 			pos += 2;
 			break;
 
-        case cmd_huc6280_write:
-            ChipID = (pos [0] & 0x80) ? 1 : 0;
-            chip_reg_write( vgm_time, 0x1B, ChipID, 0x00, pos [0] & 0x7F, pos [1] );
-            pos += 2;
-            break;
+		case cmd_huc6280_write:
+			add_event( event_write, 0x1B, write_arg( !!(pos [0] & 0x80), 0x00, pos [0] & 0x7F, pos [1] ) );
+			pos += 2;
+			break;
 
 		case cmd_gbdmg_write:
-			ChipID = (pos [0] & 0x80) ? 1 : 0;
-			chip_reg_write( vgm_time, 0x13, ChipID, 0x00, pos [0] & 0x7F, pos [1] );
+			add_event( event_write, 0x13, write_arg( !!(pos [0] & 0x80), 0x00, pos [0] & 0x7F, pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_k051649_write:
-			chip_reg_write( vgm_time, 0x19, 0x00, pos [0] & 0x7F, pos [1], pos [2] );
+			add_event( event_write, 0x19, write_arg( 0x00, pos [0] & 0x7F, pos [1], pos [2] ) );
 			pos += 3;
 			break;
 
 		case cmd_k053260_write:
-			chip_reg_write( vgm_time, 0x1D, 0x00, 0x00, pos [0] & 0x7F, pos [1] );
+			add_event( event_write, 0x1D, write_arg( 0x00, 0x00, pos [0] & 0x7F, pos [1] ) );
 			pos += 2;
 			break;
 
 		case cmd_k054539_write:
-			chip_reg_write( vgm_time, 0x1A, 0x00, pos [0] & 0x7F, pos [1], pos [2] );
+			add_event( event_write, 0x1A, write_arg( 0x00, pos [0] & 0x7F, pos [1], pos [2] ) );
 			pos += 3;
 			break;
 
-        case cmd_qsound_write:
-            chip_reg_write( vgm_time, 0x1F, 0x00, pos [0], pos [1], pos [2] );
-            pos += 3;
-            break;
-			
-		case cmd_dacctl_setup:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF )
-				{
-					if ( ! DacCtrl [chip].Enable )
-					{
-						dac_control_grow( chip );
-						DacCtrl [chip].Enable = true;
-					}
-					daccontrol_setup_chip( dac_control [DacCtrlMap [chip]], pos [1] & 0x7F, ( pos [1] & 0x80 ) >> 7, get_be16( pos + 2 ) );
-				}
-			}
-			pos += 4;
+		case cmd_qsound_write:
+			add_event( event_write, 0x1F, write_arg( 0x00, pos [0], pos [1], pos [2] ) );
+			pos += 3;
 			break;
-
+		
+		case cmd_dacctl_setup:
 		case cmd_dacctl_data:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF && DacCtrl [chip].Enable )
-				{
-					DacCtrl [chip].Bank = pos [1];
-					if ( DacCtrl [chip].Bank >= 0x40 )
-						DacCtrl [chip].Bank = 0x00;
-
-					VGM_PCM_BANK * TempPCM = &PCMBank [DacCtrl [chip].Bank];
-					daccontrol_set_data( dac_control [DacCtrlMap [chip]], TempPCM->Data, TempPCM->DataSize, pos [2], pos [3] );
-				}
-			}
+		case cmd_dacctl_playblock:
+			add_event( event_command, 0, offset );
 			pos += 4;
 			break;
+		
 		case cmd_dacctl_freq:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF && DacCtrl [chip].Enable )
-				{
-					daccontrol_set_frequency( dac_control [DacCtrlMap [chip]], get_le32( pos + 1 ) );
-				}
-			}
+			add_event( event_command, 0, offset );
 			pos += 5;
 			break;
+		
 		case cmd_dacctl_play:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF && DacCtrl [chip].Enable && PCMBank [DacCtrl [chip].Bank].BankCount )
-				{
-					daccontrol_start( dac_control [DacCtrlMap [chip]], get_le32( pos + 1 ), pos [5], get_le32( pos + 6 ) );
-				}
-			}
+			add_event( event_command, 0, offset );
 			pos += 10;
 			break;
+		
 		case cmd_dacctl_stop:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF && DacCtrl [chip].Enable )
-				{
-					daccontrol_stop( dac_control [DacCtrlMap [chip]] );
-				}
-				else if ( chip == 0xFF )
-				{
-					for ( unsigned i = 0; i < DacCtrlUsed; i++ )
-					{
-						daccontrol_stop( dac_control [i] );
-					}
-				}
-			}
+			add_event( event_command, 0, offset );
 			pos++;
 			break;
-		case cmd_dacctl_playblock:
-			if ( run_dac_control( vgm_time ) )
-			{
-				unsigned chip = pos [0];
-				if ( chip < 0xFF && DacCtrl [chip].Enable && PCMBank [DacCtrl [chip].Bank].BankCount )
-				{
-					VGM_PCM_BANK * TempPCM = &PCMBank [DacCtrl [chip].Bank];
-					unsigned block_number = get_le16( pos + 1 );
-					if ( block_number >= TempPCM->BankCount )
-						block_number = 0;
-					VGM_PCM_DATA * TempBnk = &TempPCM->Bank [block_number];
-					unsigned flags = DCTRL_LMODE_BYTES | ((pos [4] & 1) << 7);
-					daccontrol_start( dac_control [DacCtrlMap [chip]], TempBnk->DataStart, flags, TempBnk->DataSize );
-				}
-			}
-			pos += 4;
-			break;
-
-		case cmd_data_block: {
-			check( *pos == cmd_end );
-			int type = pos [1];
-			int size = get_le32( pos + 2 );
-			int chipid = 0;
-			if ( size & 0x80000000 )
-			{
-				size &= 0x7FFFFFFF;
-				chipid = 1;
-			}
-			pos += 6;
-			switch ( type & 0xC0 )
-			{
-			case pcm_block_type:
-			case pcm_aux_block_type:
-				AddPCMData( type, size, pos );
-				break;
-
-			case rom_block_type:
-				if ( size >= 8 )
-				{
-					int rom_size = get_le32( pos );
-					int data_start = get_le32( pos + 4 );
-					int data_size = size - 8;
-					void * rom_data = ( void * ) ( pos + 8 );
-
-					switch ( type )
-					{
-					case rom_segapcm:
-						if ( segapcm.enabled() )
-							segapcm.write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-					case rom_ym2608_deltat:
-						if ( ym2608[chipid].enabled() )
-						{
-							ym2608[chipid].write_rom( 0x02, rom_size, data_start, data_size, rom_data );
-						}
-						break;
-
-					case rom_ym2610_adpcm:
-					case rom_ym2610_deltat:
-						if ( ym2610[chipid].enabled() )
-						{
-							int rom_id = 0x01 + ( type - rom_ym2610_adpcm );
-							ym2610[chipid].write_rom( rom_id, rom_size, data_start, data_size, rom_data );
-						}
-						break;
-
-					case rom_ymz280b:
-						if ( ymz280b.enabled() )
-							ymz280b.write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-					case rom_okim6295:
-						if ( okim6295[chipid].enabled() )
-							okim6295[chipid].write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-					case rom_k054539:
-						if ( k054539.enabled() )
-							k054539.write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-					case rom_c140:
-						if ( c140.enabled() )
-							c140.write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-					case rom_k053260:
-						if ( k053260.enabled() )
-							k053260.write_rom( rom_size, data_start, data_size, rom_data );
-						break;
-
-                    case rom_qsound:
-                        if ( qsound[chipid].enabled() )
-                            qsound[chipid].write_rom( rom_size, data_start, data_size, rom_data );
-                        break;
-					}
-				}
-				break;
 
-			case ram_block_type:
-				if ( size >= 2 )
-				{
-					int data_start = get_le16( pos );
-					int data_size = size - 2;
-					void * ram_data = ( void * ) ( pos + 2 );
-
-					switch ( type )
-					{
-					case ram_rf5c68:
-						if ( rf5c68.enabled() )
-							rf5c68.write_ram( data_start, data_size, ram_data );
-						break;
-
-					case ram_rf5c164:
-						if ( rf5c164.enabled() )
-							rf5c164.write_ram( data_start, data_size, ram_data );
-						break;
-					}
-				}
-				break;
-			}
-			pos += size;
+		case cmd_data_block:
+			add_event( event_command, 0, offset );
+			pos += 6 + (get_le32( pos + 2 ) & 0x7FFFFFFF);
+			limit = fill_stream( pos );
 			break;
-		}
-
-		case cmd_ram_block: {
-			check( *pos == cmd_end );
-			int type = pos[ 1 ];
-			int data_start = get_le24( pos + 2 );
-			int data_addr = get_le24( pos + 5 );
-			int data_size = get_le24( pos + 8 );
-			if ( !data_size ) data_size += 0x01000000;
-			void * data_ptr = (void *) GetPointerFromPCMBank( type, data_start );
-			switch ( type )
-			{
-			case rf5c68_ram_block:
-				if ( rf5c68.enabled() )
-					rf5c68.write_ram( data_addr, data_size, data_ptr );
-				break;
-
-			case rf5c164_ram_block:
-				if ( rf5c164.enabled() )
-					rf5c164.write_ram( data_addr, data_size, data_ptr );
-				break;
-			}
+		
+		case cmd_ram_block:
+			add_event( event_command, 0, offset );
 			pos += 11;
 			break;
-		}
 		
 		case cmd_pcm_seek:
-			pcm_pos = GetPointerFromPCMBank( 0, get_le32( pos ) );
+			add_event( event_pcm_seek, 0, get_le32( pos ) );
 			pos += 4;
 			break;
 		
@@ -2078,12 +2357,12 @@ blip_time_t Vgm_Core::run( vgm_time_t end_time )
 			switch ( cmd & 0xF0 )
 			{
 				case cmd_pcm_delay:
-					chip_reg_write( vgm_time, 0x02, 0x00, 0x00, ym2612_dac_port, *pcm_pos++ );
-					vgm_time += cmd & 0x0F;
+					add_event( event_pcm );
+					add_delay( cmd & 0x0F );
 					break;
 				
 				case cmd_short_delay:
-					vgm_time += (cmd & 0x0F) + 1;
+					add_delay( (cmd & 0x0F) + 1 );
 					break;
 				
 				case 0x50:
@@ -2096,207 +2375,1240 @@ blip_time_t Vgm_Core::run( vgm_time_t end_time )
 			}
 		}
 	}
-	vgm_time -= end_time;
 	this->pos = pos;
-	this->vgm_time = vgm_time;
+	if ( pos > file_end() )
+		set_warning( "Stream lacked end event" );
 	
-	return to_psg_time( end_time );
+	if ( event_count == first )
+		return -1;
+	return first;
 }
 
-blip_time_t Vgm_Core::run_psg( int msec )
+// Returns event to continue from after end command, or -1 if track doesn't loop
+int Vgm_Core::loop_to_event()
 {
-	blip_time_t t = run( msec * vgm_rate / 1000 );
-	psg[0].end_frame( t );
-	psg[1].end_frame( t );
-	return t;
+	if ( loop_begin == file_end() )
+		return -1;
+	
+	has_looped = true;
+	if ( loop_begin > file_end() )
+		return -1;
+	
+	if ( loop_event < 0 )
+	{
+		// Loop point was forgotten, or wasn't on a command
+		restart_decode( loop_begin );
+		return 0;
+	}
+	return loop_event;
 }
 
-int Vgm_Core::play_frame( blip_time_t blip_time, int sample_count, blip_sample_t out [] )
+blip_time_t Vgm_Core::run( vgm_time_t end_time )
 {
-	// to do: timing is working mostly by luck
-	int min_pairs = (unsigned) sample_count / 2;
-	int vgm_time = (min_pairs << fm_time_bits) / fm_time_factor - 1;
-	assert( to_fm_time( vgm_time ) <= min_pairs );
-	int pairs;
-	while ( (pairs = to_fm_time( vgm_time )) < min_pairs )
-		vgm_time++;
-	//dprintf( "pairs: %d, min_pairs: %d\n", pairs, min_pairs );
-	
-    memset( out, 0, pairs * stereo * sizeof *out );
-
-	if ( ymf262[0].enabled() )
+	vgm_time_t vgm_time = this->vgm_time; 
+	vgm_time_t vgm_loop_time = ~0;
+	int i = next_event;
+	while ( vgm_time < end_time && i >= 0 )
 	{
-		ymf262[0].begin_frame( out );
-		if ( ymf262[1].enabled() )
+		if ( i >= event_count )
 		{
-			ymf262[1].begin_frame( out );
+			i = decode_events();
+			if ( i < 0 )
+				break;
 		}
-	}
-	if ( ym3812[0].enabled() )
-	{
-		ym3812[0].begin_frame( out );
-		if ( ym3812[1].enabled() )
+		
+		event_t const& e = events [i++];
+		unsigned const arg = e.arg;
+		switch ( e.kind )
 		{
-			ym3812[1].begin_frame( out );
+		case event_end:
+			if ( vgm_loop_time == ~0 ) vgm_loop_time = vgm_time;
+			else if ( vgm_loop_time == vgm_time ) loop_begin = file_end(); // XXX some files may loop forever on a region without any delay commands
+			i = loop_to_event();
+			continue;
+		
+		case event_write:
+			chip_reg_write( vgm_time, e.chip, arg >> 24, arg >> 16 & 0xFF, arg >> 8 & 0xFF, arg & 0xFF );
+			break;
+		
+		case event_psg: {
+			double start = profile_start();
+			psg [e.chip].write_data( to_psg_time( vgm_time ), arg );
+			profile_write( apu_profile [0] [e.chip], start );
+			break;
+		}
+		
+		case event_gg_stereo: {
+			double start = profile_start();
+			psg [e.chip].write_ggstereo( to_psg_time( vgm_time ), arg );
+			profile_write( apu_profile [0] [e.chip], start );
+			break;
+		}
+		
+		case event_pcm:
+			chip_reg_write( vgm_time, 0x02, 0x00, 0x00, ym2612_dac_port, *pcm_pos++ );
+			break;
+		
+		case event_pcm_seek:
+			pcm_pos = GetPointerFromPCMBank( 0, arg );
+			break;
+
+		case event_segapcm:
+			write_chip( to_fm_time( vgm_time ), 0x04, 0, 0, arg >> 8, arg & 0xFF );
+			break;
+
+		case event_rf5c68:
+			write_chip( to_fm_time( vgm_time ), 0x05, 0, 0, arg >> 8, arg & 0xFF );
+			break;
+
+		case event_rf5c68_mem:
+			write_chip( to_fm_time( vgm_time ), 0x05, 0, 1, arg >> 8, arg & 0xFF );
+			break;
+
+		case event_rf5c164:
+			write_chip( to_fm_time( vgm_time ), 0x10, 0, 0, arg >> 8, arg & 0xFF );
+			break;
+
+		case event_rf5c164_mem:
+			write_chip( to_fm_time( vgm_time ), 0x10, 0, 1, arg >> 8, arg & 0xFF );
+			break;
+
+		case event_c140:
+			write_chip( to_fm_time( vgm_time ), 0x1C, 0, 0, arg >> 8, arg & 0xFF );
+			break;
+		
+		case event_command:
+			run_command( file_begin() + arg, vgm_time );
+			break;
 		}
+		vgm_time += e.delay;
 	}
-	if ( ym2612[0].enabled() )
+	next_event = i;
+	vgm_time -= end_time;
+	this->vgm_time = vgm_time;
+	
+	return to_psg_time( end_time );
+}
+
+// Runs less common commands directly from file data
+void Vgm_Core::run_command( byte const* pos, vgm_time_t vgm_time )
+{
+	switch ( *pos++ )
 	{
-		ym2612[0].begin_frame( out );
-		if ( ym2612[1].enabled() )
+	case cmd_dacctl_setup:
+		if ( run_dac_control( vgm_time ) )
 		{
-			ym2612[1].begin_frame( out );
+			unsigned chip = pos [0];
+			if ( chip < 0xFF )
+			{
+				if ( ! DacCtrl [chip].Enable )
+				{
+					dac_control_grow( chip );
+					DacCtrl [chip].Enable = true;
+				}
+				daccontrol_setup_chip( dac_control [DacCtrlMap [chip]], pos [1] & 0x7F, ( pos [1] & 0x80 ) >> 7, get_be16( pos + 2 ) );
+			}
 		}
-	}
-	if ( ym2610[0].enabled() )
-	{
-		ym2610[0].begin_frame( out );
-		if ( ym2610[1].enabled() )
+		break;
+
+	case cmd_dacctl_data:
+		if ( run_dac_control( vgm_time ) )
+		{
+			unsigned chip = pos [0];
+			if ( chip < 0xFF && DacCtrl [chip].Enable )
+			{
+				DacCtrl [chip].Bank = pos [1];
+				if ( DacCtrl [chip].Bank >= 0x40 )
+					DacCtrl [chip].Bank = 0x00;
+
+				VGM_PCM_BANK * TempPCM = &PCMBank [DacCtrl [chip].Bank];
+				daccontrol_set_data( dac_control [DacCtrlMap [chip]], TempPCM->Data, TempPCM->DataSize, pos [2], pos [3] );
+			}
+		}
+		break;
+	case cmd_dacctl_freq:
+		if ( run_dac_control( vgm_time ) )
 		{
-			ym2610[1].begin_frame( out );
+			unsigned chip = pos [0];
+			if ( chip < 0xFF && DacCtrl [chip].Enable )
+			{
+				daccontrol_set_frequency( dac_control [DacCtrlMap [chip]], get_le32( pos + 1 ) );
+			}
 		}
-	}
-	if ( ym2608[0].enabled() )
-	{
-		ym2608[0].begin_frame( out );
-		if ( ym2608[1].enabled() )
+		break;
+	case cmd_dacctl_play:
+		if ( run_dac_control( vgm_time ) )
 		{
-			ym2608[1].begin_frame( out );
+			unsigned chip = pos [0];
+			if ( chip < 0xFF && DacCtrl [chip].Enable && PCMBank [DacCtrl [chip].Bank].BankCount )
+			{
+				daccontrol_start( dac_control [DacCtrlMap [chip]], get_le32( pos + 1 ), pos [5], get_le32( pos + 6 ) );
+			}
 		}
-	}
-	if ( ym2413[0].enabled() )
-	{
-		ym2413[0].begin_frame( out );
-		if ( ym2413[1].enabled() )
+		break;
+	case cmd_dacctl_stop:
+		if ( run_dac_control( vgm_time ) )
 		{
-			ym2413[1].begin_frame( out );
+			unsigned chip = pos [0];
+			if ( chip < 0xFF && DacCtrl [chip].Enable )
+			{
+				daccontrol_stop( dac_control [DacCtrlMap [chip]] );
+			}
+			else if ( chip == 0xFF )
+			{
+				for ( unsigned i = 0; i < DacCtrlUsed; i++ )
+				{
+					daccontrol_stop( dac_control [i] );
+				}
+			}
 		}
-	}
-	if ( ym2203[0].enabled() )
-	{
-		ym2203[0].begin_frame( out );
-		if ( ym2203[1].enabled() )
+		break;
+	case cmd_dacctl_playblock:
+		if ( run_dac_control( vgm_time ) )
+		{
+			unsigned chip = pos [0];
+			if ( chip < 0xFF && DacCtrl [chip].Enable && PCMBank [DacCtrl [chip].Bank].BankCount )
+			{
+				VGM_PCM_BANK * TempPCM = &PCMBank [DacCtrl [chip].Bank];
+				unsigned block_number = get_le16( pos + 1 );
+				if ( block_number >= TempPCM->BankCount )
+					block_number = 0;
+				VGM_PCM_DATA * TempBnk = &TempPCM->Bank [block_number];
+				unsigned flags = DCTRL_LMODE_BYTES | ((pos [4] & 1) << 7);
+				daccontrol_start( dac_control [DacCtrlMap [chip]], TempBnk->DataStart, flags, TempBnk->DataSize );
+			}
+		}
+		break;
+
+	case cmd_data_block: {
+		check( *pos == cmd_end );
+		int type = pos [1];
+		int size = get_le32( pos + 2 );
+		int chipid = 0;
+		if ( size & 0x80000000 )
+		{
+			size &= 0x7FFFFFFF;
+			chipid = 1;
+		}
+		pos += 6;
+		fill_stream( pos + size );
+		switch ( type & 0xC0 )
 		{
-			ym2203[1].begin_frame( out );
+		case pcm_block_type:
+		case pcm_aux_block_type:
+			AddPCMData( type, size, pos );
+			break;
+
+		case rom_block_type:
+			sync_chips();
+			if ( size >= 8 )
+			{
+				int rom_size = get_le32( pos );
+				int data_start = get_le32( pos + 4 );
+				int data_size = size - 8;
+				void * rom_data = ( void * ) ( pos + 8 );
+
+				switch ( type )
+				{
+				case rom_segapcm:
+					if ( segapcm.enabled() )
+						segapcm.write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+				case rom_ym2608_deltat:
+					if ( ym2608[chipid].enabled() )
+					{
+						ym2608[chipid].write_rom( 0x02, rom_size, data_start, data_size, rom_data );
+					}
+					break;
+
+				case rom_ym2610_adpcm:
+				case rom_ym2610_deltat:
+					if ( ym2610[chipid].enabled() )
+					{
+						int rom_id = 0x01 + ( type - rom_ym2610_adpcm );
+						ym2610[chipid].write_rom( rom_id, rom_size, data_start, data_size, rom_data );
+					}
+					break;
+
+				case rom_ymz280b:
+					if ( ymz280b.enabled() )
+						ymz280b.write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+				case rom_okim6295:
+					if ( okim6295[chipid].enabled() )
+						okim6295[chipid].write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+				case rom_k054539:
+					if ( k054539.enabled() )
+						k054539.write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+				case rom_c140:
+					if ( c140.enabled() )
+						c140.write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+				case rom_k053260:
+					if ( k053260.enabled() )
+						k053260.write_rom( rom_size, data_start, data_size, rom_data );
+					break;
+
+                    case rom_qsound:
+                        if ( qsound[chipid].enabled() )
+                            qsound[chipid].write_rom( rom_size, data_start, data_size, rom_data );
+                        break;
+				}
+			}
+			break;
+
+		case ram_block_type:
+			sync_chips();
+			if ( size >= 2 )
+			{
+				int data_start = get_le16( pos );
+				int data_size = size - 2;
+				void * ram_data = ( void * ) ( pos + 2 );
+
+				switch ( type )
+				{
+				case ram_rf5c68:
+					if ( rf5c68.enabled() )
+						rf5c68.write_ram( data_start, data_size, ram_data );
+					break;
+
+				case ram_rf5c164:
+					if ( rf5c164.enabled() )
+						rf5c164.write_ram( data_start, data_size, ram_data );
+					break;
+				}
+			}
+			break;
 		}
+		break;
 	}
-	if ( ym2151[0].enabled() )
-	{
-		ym2151[0].begin_frame( out );
-		if ( ym2151[1].enabled() )
+
+	case cmd_ram_block: {
+		check( *pos == cmd_end );
+		int type = pos[ 1 ];
+		int data_start = get_le24( pos + 2 );
+		int data_addr = get_le24( pos + 5 );
+		int data_size = get_le24( pos + 8 );
+		if ( !data_size ) data_size += 0x01000000;
+		void * data_ptr = (void *) GetPointerFromPCMBank( type, data_start );
+		sync_chips();
+		switch ( type )
 		{
-			ym2151[1].begin_frame( out );
+		case rf5c68_ram_block:
+			if ( rf5c68.enabled() )
+				rf5c68.write_ram( data_addr, data_size, data_ptr );
+			break;
+
+		case rf5c164_ram_block:
+			if ( rf5c164.enabled() )
+				rf5c164.write_ram( data_addr, data_size, data_ptr );
+			break;
 		}
+		break;
+	}
 	}
+}
+
+// Seek index
 
-	if ( c140.enabled() )
+// Time between seek points
+int const seek_interval = 44100;
+
+byte const* Vgm_Core::data_begin() const
+{
+	byte const* data = file_begin() + header().size();
+	int data_offset = get_le32( header().data_offset );
+	check( data_offset );
+	if ( data_offset )
+		data += data_offset + offsetof (header_t,data_offset) - header().size();
+	return data;
+}
+
+// Chips whose state can be restored by writing their registers
+static bool restorable_chip( int chip )
+{
+	switch ( chip )
 	{
-		c140.begin_frame( out );
+	case 0x00: // SN76489
+	case 0x01: // YM2413
+	case 0x02: // YM2612
+	case 0x03: // YM2151
+	case 0x06: // YM2203
+	case 0x07: // YM2608
+	case 0x08: // YM2610
+	case 0x09: // YM3812
+	case 0x0C: // YMF262
+	case 0x12: // AY8910
+	case 0x13: // GB DMG
+		return true;
 	}
-	if ( segapcm.enabled() )
+	return false;
+}
+
+static bool is_opn( int chip )
+{
+	return chip == 0x02 || chip == 0x06 || chip == 0x07 || chip == 0x08;
+}
+
+// Shadow has 4 ports of 256 registers for each chip. Ports 0 and 1 are the
+// chip's own, and port 2 holds state that needs more than one register, like
+// key on for each channel.
+inline int shadow_key( int chip, int id, int port, int reg )
+{
+	return ((chip * 2 + id) * 4 + port) * 0x100 + reg;
+}
+
+int const shadow_size = 0x20 * 2 * 4 * 0x100;
+
+// Key for register write in shadow, or -1 if write shouldn't be restored
+static int shadow_write_key( int chip, int id, int port, int reg, int data )
+{
+	if ( is_opn( chip ) && port == 0 && reg == 0x28 )
+		return shadow_key( chip, id, 2, data & 0x07 );
+	
+	switch ( chip )
 	{
-		segapcm.begin_frame( out );
+	case 0x02:
+		if ( port == 0 && reg == 0x2A ) // DAC data
+			return -1;
+		break;
+	
+	case 0x03:
+		if ( reg == 0x08 )
+			return shadow_key( chip, id, 2, data & 0x07 );
+		if ( reg == 0x19 && (data & 0x80) ) // PMD shares address with AMD
+			return shadow_key( chip, id, 2, reg );
+		break;
+	
+	case 0x07: // rhythm and ADPCM triggers, ADPCM memory
+		if ( (port == 0 && reg == 0x10) || (port == 1 && (reg == 0x00 || reg == 0x08)) )
+			return -1;
+		break;
+	
+	case 0x08: // ADPCM triggers
+		if ( (port == 0 && reg == 0x10) || (port == 1 && reg == 0x00) )
+			return -1;
+		break;
 	}
-	if ( rf5c68.enabled() )
+	return shadow_key( chip, id, port, reg );
+}
+
+// Indexes file by running through its events and keeping a shadow of sound chip
+// registers, without emulating chips
+bool Vgm_Core::build_seek_index()
+{
+	if ( seek_point_count >= 0 )
+		return seek_point_count > 0;
+	seek_point_count = 0;
+	
+	byte const* const begin = data_begin();
+	if ( events_begin != begin || seek_shadow.resize( shadow_size ) )
+		return false;
+	memset( seek_shadow.begin(), 0xFF, shadow_size * sizeof seek_shadow [0] );
+	
+	// Registers changed since last point
+	blargg_vector<byte> changed;
+	blargg_vector<int> changed_keys;
+	if ( changed.resize( shadow_size ) || changed_keys.resize( shadow_size ) )
+		return false;
+	memset( changed.begin(), 0, shadow_size );
+	int changed_count = 0;
+	
+	int psg_latch [2] = { 0, 0 };
+	int pcm_seek   = -1;
+	int pcm_played = 0;
+	int changes    = 0;
+	int points     = 0;
+	int time       = 0;
+	int next_time  = 0;
+	seek_loop_time = -1;
+	
+	for ( int i = 0; ; i++ )
 	{
-		rf5c68.begin_frame( out );
+		if ( i >= event_count )
+		{
+			// Stop rather than slide window, since that would lose events
+			// being played
+			if ( event_count >= max_events )
+				return false;
+			
+			if ( decode_events() < 0 )
+				break;
+			
+			if ( events_begin != begin )
+				return false;
+		}
+		
+		if ( i == loop_event )
+			seek_loop_time = time;
+		
+		if ( time >= next_time )
+		{
+			if ( points >= (int) seek_points.size() &&
+					seek_points.resize( max( points * 2, 64 ) ) )
+				return false;
+			
+			if ( changes + changed_count > (int) seek_changes.size() &&
+					seek_changes.resize( max( (int) seek_changes.size() * 2, changes + changed_count ) ) )
+				return false;
+			
+			for ( int n = 0; n < changed_count; n++ )
+			{
+				int key = changed_keys [n];
+				changed [key] = false;
+				event_t& e = seek_changes [changes++];
+				e.kind  = event_write;
+				e.chip  = key >> 11;
+				e.arg   = write_arg( key >> 10 & 1, key >> 8 & 3, key & 0xFF, seek_shadow [key] );
+				e.delay = 0;
+			}
+			changed_count = 0;
+			
+			seek_point_t& p = seek_points [points++];
+			p.time        = time;
+			p.event       = i;
+			p.pcm_seek    = pcm_seek;
+			p.pcm_played  = pcm_played;
+			p.changes_end = changes;
+			next_time = time + seek_interval;
+		}
+		
+		event_t const& e = events [i];
+		int key  = -1;
+		int data = e.arg & 0xFF;
+		switch ( e.kind )
+		{
+		case event_delay:
+		case event_end:
+			break;
+		
+		case event_write: {
+			int chip = e.chip;
+			if ( !restorable_chip( chip ) )
+				return false;
+			key = shadow_write_key( chip, e.arg >> 24, e.arg >> 16 & 0xFF, e.arg >> 8 & 0xFF, data );
+			break;
+		}
+		
+		case event_psg: {
+			// Registers 0-3 are volume, 4-7 low bits of period, 8-11 high bits,
+			// and 12 the latch
+			int& latch = psg_latch [e.chip];
+			if ( data & 0x80 )
+			{
+				latch = data;
+				int k = shadow_key( 0x00, e.chip, 0, 12 );
+				if ( seek_shadow [k] != data && !changed [k] )
+				{
+					changed [k] = true;
+					changed_keys [changed_count++] = k;
+				}
+				seek_shadow [k] = data;
+			}
+			int osc = latch >> 5 & 3;
+			if ( latch & 0x10 )
+			{
+				key  = osc;
+				data &= 0x0F;
+			}
+			else if ( osc == 3 || (data & 0x80) )
+			{
+				key  = 4 + osc;
+				data &= 0x0F;
+			}
+			else
+			{
+				key  = 8 + osc;
+				data &= 0x3F;
+			}
+			key = shadow_key( 0x00, e.chip, 0, key );
+			break;
+		}
+		
+		case event_gg_stereo:
+			key = shadow_key( 0x00, e.chip, 2, 0 );
+			break;
+		
+		case event_pcm:
+			pcm_played++;
+			break;
+		
+		case event_pcm_seek:
+			pcm_seek   = e.arg;
+			pcm_played = 0;
+			break;
+		
+		case event_command:
+			switch ( file_begin() [e.arg] )
+			{
+			case cmd_dacctl_play:
+			case cmd_dacctl_stop:
+			case cmd_dacctl_playblock:
+				// Streams already playing at seek point are left silent
+				break;
+			
+			case cmd_data_block:
+			case cmd_dacctl_setup:
+			case cmd_dacctl_data:
+			case cmd_dacctl_freq:
+				// Rerun all of these when restoring
+				if ( changes >= (int) seek_changes.size() &&
+						seek_changes.resize( max( changes * 2, 256 ) ) )
+					return false;
+				seek_changes [changes++] = e;
+				break;
+			
+			default:
+				return false;
+			}
+			break;
+		
+		default:
+			return false;
+		}
+		
+		if ( key >= 0 )
+		{
+			if ( seek_shadow [key] != data && !changed [key] )
+			{
+				changed [key] = true;
+				changed_keys [changed_count++] = key;
+			}
+			seek_shadow [key] = data;
+		}
+		
+		if ( e.kind == event_end )
+			break;
+		
+		time += e.delay;
 	}
-	if ( rf5c164.enabled() )
+	seek_end_time = time;
+	if ( seek_loop_time < 0 && loop_begin != file_end() )
+		return false; // loop point wasn't on a command
+	
+	seek_point_count = points;
+	return true;
+}
+
+// Index of latest seek point at or before time. Sets *loop_offset to time
+// added by looping.
+int Vgm_Core::find_seek_point( int time, int* loop_offset ) const
+{
+	*loop_offset = 0;
+	if ( time > seek_end_time )
 	{
-		rf5c164.begin_frame( out );
+		int length = seek_end_time - seek_loop_time;
+		if ( seek_loop_time >= 0 && length > 0 )
+		{
+			int t = seek_loop_time + (time - seek_loop_time) % length;
+			*loop_offset = time - t;
+			time = t;
+		}
+		else
+		{
+			time = seek_end_time;
+		}
 	}
-	if ( pwm.enabled() )
+	
+	int lo = 0;
+	int hi = seek_point_count;
+	while ( hi - lo > 1 )
 	{
-		pwm.begin_frame( out );
+		int mid = (lo + hi) / 2;
+		if ( seek_points [mid].time <= time )
+			lo = mid;
+		else
+			hi = mid;
 	}
-	if ( okim6258[0].enabled() )
+	return lo;
+}
+
+int Vgm_Core::seek_point( int time )
+{
+	if ( time < 0 || !build_seek_index() )
+		return -1;
+	
+	int offset;
+	int i = find_seek_point( time, &offset );
+	return seek_points [i].time + offset;
+}
+
+// Writes registers saved in shadow to chip, in an order that gets it to same state
+void Vgm_Core::restore_registers( int chip, int id )
+{
+	BOOST::int16_t const* regs = &seek_shadow [shadow_key( chip, id, 0, 0 )];
+	
+	if ( chip == 0x00 )
 	{
-		okim6258[0].begin_frame( out );
-        if ( okim6258[1].enabled() )
-        {
-            okim6258[1].begin_frame( out );
-        }
+		for ( int osc = 0; osc < 4; osc++ )
+		{
+			int lo = regs [4 + osc];
+			int hi = regs [8 + osc];
+			if ( lo >= 0 || hi >= 0 )
+			{
+				chip_reg_write( 0, chip, id, 0, 0, 0x80 | osc << 5 | max( lo, 0 ) );
+				if ( osc < 3 )
+					chip_reg_write( 0, chip, id, 0, 0, max( hi, 0 ) );
+			}
+			if ( regs [osc] >= 0 )
+				chip_reg_write( 0, chip, id, 0, 0, 0x90 | osc << 5 | regs [osc] );
+		}
+		
+		// Restore latch for data bytes that follow, then undo its change
+		int latch = regs [12];
+		if ( latch >= 0 )
+		{
+			int osc = latch >> 5 & 3;
+			chip_reg_write( 0, chip, id, 0, 0, latch );
+			if ( latch & 0x10 )
+				chip_reg_write( 0, chip, id, 0, 0, max( (int) regs [osc], 0 ) );
+			else if ( osc == 3 )
+				chip_reg_write( 0, chip, id, 0, 0, max( (int) regs [4 + osc], 0 ) );
+		}
+		
+		if ( regs [0x200] >= 0 )
+			psg [id].write_ggstereo( 0, regs [0x200] );
+		return;
+	}
+	
+	// Registers that affect how others are written
+	if ( chip == 0x0C && regs [0x105] >= 0 )
+		chip_reg_write( 0, chip, id, 1, 0x05, regs [0x105] );
+	if ( chip == 0x13 && regs [0x16] >= 0 )
+		chip_reg_write( 0, chip, id, 0, 0x16, regs [0x16] );
+	
+	for ( int i = 0; i < 0x200; i++ )
+	{
+		int r = i;
+		if ( is_opn( chip ) && (r & 0xF0) == 0xA0 )
+			r ^= 0x04; // frequency high bits are latched by write of low bits
+		if ( regs [r] >= 0 )
+			chip_reg_write( 0, chip, id, r >> 8, r & 0xFF, regs [r] );
 	}
-	if ( okim6295[0].enabled() )
+	
+	// Key on last, so notes restart with registers already set
+	for ( int r = 0; r < 0x100; r++ )
 	{
-		okim6295[0].begin_frame( out );
-		if ( okim6295[1].enabled() )
+		int data = regs [0x200 + r];
+		if ( data < 0 )
+			continue;
+		
+		if ( is_opn( chip ) )
+			chip_reg_write( 0, chip, id, 0, 0x28, data );
+		else if ( chip == 0x03 )
+			chip_reg_write( 0, chip, id, 0, (r == 0x19 ? 0x19 : 0x08), data );
+	}
+}
+
+blargg_err_t Vgm_Core::set_chip_threads( int count )
+{
+	if ( count == 1 )
+	{
+		chip_pool.stop();
+		return blargg_ok;
+	}
+	return chip_pool.start( count );
+}
+
+blargg_err_t Vgm_Core::enable_profile( bool enabled )
+{
+	#if GME_DISABLE_PROFILE
+		if ( enabled )
+			return BLARGG_ERR( BLARGG_ERR_LIMITATION, "profiling not supported" );
+	#endif
+	profiling_ = enabled;
+	set_chip_profiling();
+	return blargg_ok;
+}
+
+// Clears profiles of all chips, and has resamplers of FM and PCM chips count
+// theirs if profiling
+void Vgm_Core::set_chip_profiling()
+{
+	for ( int apu = 0; apu < 4; apu++ )
+	{
+		apu_profile [apu] [0].clear();
+		apu_profile [apu] [1].clear();
+	}
+	
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+	{
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( lane_chips [i], id );
+			if ( !r )
+				break;
+			r->profile().clear();
+			r->set_profiling( profiling() );
+		}
+	}
+}
+
+static const char* chip_name( int type )
+{
+	switch ( type )
+	{
+	case 0x00: return "SN76489";
+	case 0x01: return "YM2413";
+	case 0x02: return "YM2612";
+	case 0x03: return "YM2151";
+	case 0x04: return "SegaPCM";
+	case 0x05: return "RF5C68";
+	case 0x06: return "YM2203";
+	case 0x07: return "YM2608";
+	case 0x08: return "YM2610";
+	case 0x09: return "YM3812";
+	case 0x0C: return "YMF262";
+	case 0x0F: return "YMZ280B";
+	case 0x10: return "RF5C164";
+	case 0x11: return "PWM";
+	case 0x12: return "AY8910";
+	case 0x13: return "GB DMG";
+	case 0x17: return "OKIM6258";
+	case 0x18: return "OKIM6295";
+	case 0x19: return "K051649";
+	case 0x1A: return "K054539";
+	case 0x1B: return "HuC6280";
+	case 0x1C: return "C140";
+	case 0x1D: return "K053260";
+	case 0x1F: return "QSound";
+	}
+	return "?";
+}
+
+// Copies profile to out [count] if there's room, and counts it either way
+static void add_profile( gme_chip_profile_t out [], int max, int* count,
+		int type, int id, Chip_Profile const& p )
+{
+	if ( *count < max )
+	{
+		gme_chip_profile_t& o = out [*count];
+		o.name        = chip_name( type );
+		o.index       = id;
+		o.nanoseconds = p.nanoseconds;
+		o.samples     = p.samples;
+		o.writes      = p.writes;
+		o.cache_bytes = 0;
+		o.cache_hits  = 0;
+		o.cache_misses = 0;
+	}
+	++*count;
+}
+
+int Vgm_Core::get_profile( gme_chip_profile_t out [], int max )
+{
+	if ( !profiling() )
+		return 0;
+	
+	int count = 0;
+	
+	// PSG chips, in stereo_buf order
+	static byte const apu_types [4] = { 0x00, 0x12, 0x1B, 0x13 };
+	int const apu_rates [4] = {
+		(int) get_le32( header().psg_rate ),
+		(int) get_le32( header().ay8910_rate ),
+		(int) get_le32( header().huc6280_rate ),
+		(int) get_le32( header().gbdmg_rate )
+	};
+	for ( int apu = 0; apu < 4; apu++ )
+	{
+		for ( int id = 0; id < 2; id++ )
 		{
-			okim6295[1].begin_frame( out );
+			int rate = apu_rates [apu];
+			if ( !(rate & 0x3FFFFFFF) || (id && !(rate & 0x40000000)) )
+				break;
+			add_profile( out, max, &count, apu_types [apu], id, apu_profile [apu] [id] );
 		}
 	}
-	if ( k051649.enabled() )
+	
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
 	{
-		k051649.begin_frame( out );
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( lane_chips [i], id );
+			if ( !r )
+				break;
+			add_profile( out, max, &count, lane_chips [i], id, r->profile() );
+			if ( count <= max )
+			{
+				gme_chip_profile_t& o = out [count - 1];
+				if ( lane_chips [i] == 0x18 )
+					okim6295 [id].cache_stats( &o.cache_bytes, &o.cache_hits, &o.cache_misses );
+				else if ( lane_chips [i] == 0x0F )
+					ymz280b.cache_stats( &o.cache_bytes, &o.cache_hits, &o.cache_misses );
+			}
+		}
 	}
-	if ( k053260.enabled() )
+	return count;
+}
+
+int Vgm_Core::chip_group_count()
+{
+	int count = 0;
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+	{
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( lane_chips [i], id );
+			if ( !r )
+				break;
+			if ( &r->group() == r )
+				count++;
+		}
+	}
+	return min( count, (int) max_chip_groups );
+}
+
+const char* Vgm_Core::chip_group_name( int n )
+{
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+	{
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( lane_chips [i], id );
+			if ( !r )
+				break;
+			if ( &r->group() == r && !n-- )
+				return chip_name( lane_chips [i] );
+		}
+	}
+	return "";
+}
+
+const char* Vgm_Core::buf_name( int i ) const
+{
+	static const char* const names [4] = { "SN76489", "AY8910", "HuC6280", "GB DMG" };
+	int const rates [4] = {
+		(int) get_le32( header().psg_rate ),
+		(int) get_le32( header().ay8910_rate ),
+		(int) get_le32( header().huc6280_rate ),
+		(int) get_le32( header().gbdmg_rate )
+	};
+	
+	// YM2612 DAC is also written to PSG's buffer
+	bool const used = (rates [i] & 0x3FFFFFFF) != 0;
+	if ( !i && ym2612 [0].enabled() )
+		return used ? "SN76489 + YM2612 DAC" : "YM2612 DAC";
+	
+	return used ? names [i] : NULL;
+}
+
+void Vgm_Core::set_sample_cache( long max_bytes )
+{
+	int budget = (int) min( max_bytes, 0x7FFFFFFFL );
+	okim6295 [0].set_cache( budget );
+	okim6295 [1].set_cache( budget );
+	ymz280b.set_cache( budget );
+}
+
+blargg_err_t Vgm_Core::set_qsound_rate( int hz )
+{
+	qsound_rate_ = hz;
+	if ( qsound[0].enabled() )
+		return setup_qsound();
+	return blargg_ok;
+}
+
+blargg_err_t Vgm_Core::set_resampler_width( int points )
+{
+	resampler_width_ = points;
+	return set_chip_widths();
+}
+
+// Resamplers keep their width when their rate is set again, so this only needs
+// to be done when chips are enabled
+blargg_err_t Vgm_Core::set_chip_widths()
+{
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
 	{
-		k053260.begin_frame( out );
+		for ( int id = 0; id < 2; id++ )
+		{
+			Chip_Resampler* r = chip_resampler( lane_chips [i], id );
+			if ( !r )
+				break;
+			RETURN_ERR( r->set_width( resampler_width_ ) );
+		}
 	}
-	if ( k054539.enabled() )
+	return blargg_ok;
+}
+
+// QSound isn't grouped with other chips, so its rate can change during play
+blargg_err_t Vgm_Core::setup_qsound()
+{
+	int rate = vgm_rate;
+	if ( qsound_rate_ && qsound_rate_ < rate )
+		rate = qsound_rate_;
+	qsound[0].set_sample_rate( rate );
+	RETURN_ERR( qsound[0].setup( (double) rate / vgm_rate, 0.85, 1.0 ) );
+	qsound[0].resampler().set_profiling( profiling() );
+	return blargg_ok;
+}
+
+double Vgm_Core::samples_per_time()
+{
+	// Rounded time factors make this differ slightly from nominal rate / 44100
+	if ( uses_fm() )
+		return (double) fm_time_factor / (1 << fm_time_bits);
+	
+	Blip_Buffer const* buf = stereo_buf[0].center();
+	return (double) buf->resampled_duration( blip_time_factor ) /
+			(1 << blip_time_bits) / (1 << BLIP_BUFFER_ACCURACY);
+}
+
+void Vgm_Core::restore_seek_point( int time )
+{
+	int offset;
+	seek_point_t const& p = seek_points [find_seek_point( time, &offset )];
+	
+	memset( seek_shadow.begin(), 0xFF, shadow_size * sizeof seek_shadow [0] );
+	for ( int i = 0; i < p.changes_end; i++ )
 	{
-		k054539.begin_frame( out );
+		event_t const& e = seek_changes [i];
+		if ( e.kind == event_command )
+		{
+			run_command( file_begin() + e.arg, 0 );
+		}
+		else
+		{
+			int key = shadow_key( e.chip, e.arg >> 24, e.arg >> 16 & 0xFF, e.arg >> 8 & 0xFF );
+			seek_shadow [key] = e.arg & 0xFF;
+		}
 	}
-	if ( ymz280b.enabled() )
+	
+	for ( int chip = 0; chip < 0x20; chip++ )
 	{
-		ymz280b.begin_frame( out );
+		if ( restorable_chip( chip ) )
+		{
+			restore_registers( chip, 0 );
+			restore_registers( chip, 1 );
+		}
 	}
-    if ( qsound[0].enabled() )
-    {
-        qsound[0].begin_frame( out );
-        if ( qsound[1].enabled() )
-        {
-            qsound[1].begin_frame( out );
-        }
-    }
+	
+	byte const* pcm = data_begin();
+	if ( p.pcm_seek >= 0 )
+		pcm = GetPointerFromPCMBank( 0, p.pcm_seek );
+	if ( pcm )
+		pcm += p.pcm_played;
+	pcm_pos = pcm;
+	
+	next_event = p.event;
+	if ( offset )
+		has_looped = true;
+}
+
+// Ends frame of PSG chip, and counts its time and samples if profile isn't NULL
+template<class Apu>
+static void end_apu_frame( Apu& apu, blip_time_t end, Chip_Profile* profile, Blip_Buffer const* buf )
+{
+	if ( !profile )
+	{
+		apu.end_frame( end );
+		return;
+	}
+	
+	double start = Chip_Profile::now();
+	apu.end_frame( end );
+	profile->add_time( start );
+	profile->samples += buf->count_samples( end );
+}
+
+// Profile to count end of frame of PSG chip into, or NULL if not profiling
+Chip_Profile* Vgm_Core::profile_frame( int apu, int id )
+{
+	return profiling() ? &apu_profile [apu] [id] : NULL;
+}
+
+blip_time_t Vgm_Core::run_psg( int msec )
+{
+	blip_time_t t = run( msec * vgm_rate / 1000 );
+	end_apu_frame( psg[0], t, profile_frame( 0, 0 ), stereo_buf[0].center() );
+	end_apu_frame( psg[1], t, profile_frame( 0, 1 ), stereo_buf[0].center() );
+	return t;
+}
+
+// Begins frame for FM and PCM chips, and sets up their lanes if they're to be
+// run on several threads
+void Vgm_Core::begin_chips( short* out, int pairs, short* const group_out [] )
+{
+	lane_count = 0;
+	chip_write_seq = 0;
+	bool threaded = chip_pool.size() > 1;
+	if ( threaded )
+		memset( lane_of, max_lanes, sizeof lane_of );
+	
+	int group_index = 0;
+	for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+	{
+		int type = lane_chips [i];
+		for ( int id = 0; id < 2; id++ )
+		{
+			// Second chip is only run if first is
+			Chip_Resampler* r = chip_resampler( type, id );
+			if ( !r )
+				break;
+			
+			Chip_Resampler* group = &r->group();
+			group->begin_frame( out );
+			if ( group == r )
+			{
+				short* separate = NULL;
+				if ( group_out && group_index < max_chip_groups )
+				{
+					separate = group_out [group_index];
+					memset( separate, 0, pairs * stereo * sizeof *separate );
+				}
+				r->set_separate( separate );
+				group_index++;
+			}
+			if ( !threaded )
+				continue;
+			
+			// Chips sharing a resampler share its lane
+			int n = 0;
+			while ( n < lane_count && lanes [n].group != group )
+				n++;
+			if ( n < lane_count )
+			{
+				lane_of [type] [id] = n;
+				continue;
+			}
+			
+			chip_lane_t& lane = lanes [lane_count];
+			if ( !lane.log.resize( pairs ) )
+			{
+				lane.type        = type;
+				lane.id          = id;
+				lane.group       = group;
+				lane.write_count = 0;
+				lane_of [type] [id] = lane_count++;
+			}
+			else
+			{
+				threaded = false;
+			}
+		}
+	}
+	
+	// Not worth it unless at least two lanes can run at once
+	if ( !threaded || lane_count < 2 )
+	{
+		lane_count = 0;
+		return;
+	}
+	
+	for ( int n = 0; n < lane_count; n++ )
+		lanes [n].group->begin_frame( out, &lanes [n].log );
+}
+
+void Vgm_Core::run_lane( void* self, int n )
+{
+	Vgm_Core& core = *STATIC_CAST(Vgm_Core*,self);
+	chip_lane_t& lane = core.lanes [n];
+	for ( int i = 0; i < lane.write_count; i++ )
+	{
+		lane.log.set_seq( lane.writes [i].seq );
+		core.run_chip_write( lane.writes [i] );
+	}
+	lane.write_count = 0;
+	
+	// Lanes are in the order chips are run to end of frame
+	lane.log.set_seq( core.chip_write_seq + n );
+	core.run_chip( lane.type, lane.id, core.lane_end_time );
+}
+
+// Runs FM and PCM chips to end of frame, then mixes their logged output into out
+// if they were run on several threads
+void Vgm_Core::end_chips( short* out, int pairs )
+{
+	if ( !lane_count )
+	{
+		for ( unsigned i = 0; i < sizeof lane_chips; i++ )
+		{
+			run_chip( lane_chips [i], 0, pairs );
+			run_chip( lane_chips [i], 1, pairs );
+		}
+		return;
+	}
+	
+	lane_end_time = pairs;
+	chip_pool.run( run_lane, this, lane_count );
+	
+	// Merge logs by sequence number
+	int next [max_lanes] = { 0 };
+	for ( ;; )
+	{
+		int first = -1;
+		int first_seq = 0;
+		for ( int n = 0; n < lane_count; n++ )
+		{
+			Chip_Output_Log const& log = lanes [n].log;
+			if ( next [n] < log.count() && (first < 0 || log [next [n]].seq < first_seq) )
+			{
+				first = n;
+				first_seq = log [next [n]].seq;
+			}
+		}
+		if ( first < 0 )
+			break;
+		
+		Chip_Output_Log const& log = lanes [first].log;
+		log.apply( log [next [first]++], out );
+	}
+	lane_count = 0;
+}
+
+int Vgm_Core::play_frame( blip_time_t blip_time, int sample_count, blip_sample_t out [],
+		blip_sample_t* const group_out [] )
+{
+	// to do: timing is working mostly by luck
+	int min_pairs = (unsigned) sample_count / 2;
+	int vgm_time = (min_pairs << fm_time_bits) / fm_time_factor - 1;
+	assert( to_fm_time( vgm_time ) <= min_pairs );
+	int pairs;
+	while ( (pairs = to_fm_time( vgm_time )) < min_pairs )
+		vgm_time++;
+	//dprintf( "pairs: %d, min_pairs: %d\n", pairs, min_pairs );
+	
+    memset( out, 0, pairs * stereo * sizeof *out );
+	
+	// QSound is run to VGM time, which can exceed pairs
+	begin_chips( out, max( pairs, vgm_time ), group_out );
 
 	run( vgm_time );
 
 	run_dac_control( vgm_time );
 
-	run_ymf262( 0, pairs ); run_ymf262( 1, pairs );
-	run_ym3812( 0, pairs ); run_ym3812( 1, pairs );
-	run_ym2612( 0, pairs ); run_ym2612( 1, pairs );
-	run_ym2610( 0, pairs ); run_ym2610( 1, pairs );
-	run_ym2608( 0, pairs ); run_ym2608( 1, pairs );
-	run_ym2413( 0, pairs ); run_ym2413( 1, pairs );
-	run_ym2203( 0, pairs ); run_ym2203( 1, pairs );
-	run_ym2151( 0, pairs ); run_ym2151( 1, pairs );
-	run_c140( pairs );
-	run_segapcm( pairs );
-	run_rf5c68( pairs );
-	run_rf5c164( pairs );
-	run_pwm( pairs );
-	run_okim6258( 0, pairs ); run_okim6258( 1, pairs );
-	run_okim6295( 0, pairs ); run_okim6295( 1, pairs );
-	run_k051649( pairs );
-	run_k053260( pairs );
-	run_k054539( pairs );
-	run_ymz280b( pairs );
-    run_qsound( 0, pairs ); run_qsound( 1, pairs );
+	end_chips( out, pairs );
 	
 	fm_time_offset = (vgm_time * fm_time_factor + fm_time_offset) - (pairs << fm_time_bits);
 	
-	psg[0].end_frame( blip_time );
-	psg[1].end_frame( blip_time );
+	end_apu_frame( psg[0], blip_time, profile_frame( 0, 0 ), stereo_buf[0].center() );
+	end_apu_frame( psg[1], blip_time, profile_frame( 0, 1 ), stereo_buf[0].center() );
 
 	ay_time_offset = (vgm_time * blip_ay_time_factor + ay_time_offset) - (pairs << blip_time_bits);
 
 	blip_time_t ay_end_time = to_ay_time( vgm_time );
-	ay[0].end_frame( ay_end_time );
-	ay[1].end_frame( ay_end_time );
+	end_apu_frame( ay[0], ay_end_time, profile_frame( 1, 0 ), stereo_buf[1].center() );
+	end_apu_frame( ay[1], ay_end_time, profile_frame( 1, 1 ), stereo_buf[1].center() );
 
     huc6280_time_offset = (vgm_time * blip_huc6280_time_factor + huc6280_time_offset) - (pairs << blip_time_bits);
 
     blip_time_t huc6280_end_time = to_huc6280_time( vgm_time );
-    huc6280[0].end_frame( huc6280_end_time );
-    huc6280[1].end_frame( huc6280_end_time );
+    end_apu_frame( huc6280[0], huc6280_end_time, profile_frame( 2, 0 ), stereo_buf[2].center() );
+    end_apu_frame( huc6280[1], huc6280_end_time, profile_frame( 2, 1 ), stereo_buf[2].center() );
 
 	gbdmg_time_offset = (vgm_time * blip_gbdmg_time_factor + gbdmg_time_offset) - (pairs << blip_time_bits);
 
 	blip_time_t gbdmg_end_time = to_gbdmg_time( vgm_time );
-	gbdmg[0].end_frame( gbdmg_end_time );
-	gbdmg[1].end_frame( gbdmg_end_time );
+	end_apu_frame( gbdmg[0], gbdmg_end_time, profile_frame( 3, 0 ), stereo_buf[3].center() );
+	end_apu_frame( gbdmg[1], gbdmg_end_time, profile_frame( 3, 1 ), stereo_buf[3].center() );
 
 	memset( DacCtrlTime, 0, sizeof(DacCtrlTime) );
 	
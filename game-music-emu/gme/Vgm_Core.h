@@ -4,6 +4,7 @@
 #ifndef VGM_CORE_H
 #define VGM_CORE_H
 
+#include "gme.h"
 #include "Gme_Loader.h"
 #include "Ymz280b_Emu.h"
 #include "Ymf262_Emu.h"
@@ -31,6 +32,7 @@
 #include "Sms_Apu.h"
 #include "Multi_Buffer.h"
 #include "Chip_Resampler.h"
+#include "Worker_Pool.h"
 
 	template<class Emu>
 	class Chip_Emu : public Emu {
@@ -142,6 +144,13 @@ public:
 	byte const* file_begin() const      { return Gme_Loader::file_begin(); }
 	byte const* file_end  () const      { return Gme_Loader::file_end(); }
 	
+	// Inflater to use when reading beyond what it has made available so far, or
+	// NULL if whole file is in memory. Must be set before load_mem().
+	void set_stream( Gzip_Stream* s )   { stream = s; }
+	
+	// Inflates rest of file if it's being streamed
+	void fill_file() const              { if ( stream ) stream->fill_all(); }
+	
 	// If file uses FM, initializes FM sound emulator using *sample_rate. If
 	// *sample_rate is zero, sets *sample_rate to the proper accurate rate and
 	// uses that. The output of the FM sound emulator is resampled to the
@@ -175,11 +184,62 @@ public:
 	blip_time_t run_psg( int msec );
 	
 	// Plays FM for at most count samples into *out, and returns number of
-	// samples actually generated (always even). Also runs PSG for blip_time.
-	int play_frame( blip_time_t blip_time, int count, blip_sample_t out [] );
+	// samples actually generated (always even). Also runs PSG for blip_time. If
+	// group_out isn't NULL, also writes each group of FM and PCM chips' part of
+	// out to group_out [i].
+	int play_frame( blip_time_t blip_time, int count, blip_sample_t out [],
+			blip_sample_t* const group_out [] = NULL );
+	
+	// FM and PCM chips running at the same rate are grouped and resampled
+	// together. Groups are in the order chips are run, and named by their first
+	// chip. Fixed once file is loaded.
+	enum { max_chip_groups = 32 };
+	int chip_group_count();
+	const char* chip_group_name( int i );
+	
+	// Name of chips that write to stereo_buf [i], or NULL if file doesn't use any
+	const char* buf_name( int i ) const;
 	
 	// True if all of file data has been played
-	bool track_ended() const            { return pos >= file_end(); }
+	bool track_ended() const            { return next_event < 0; }
+	
+	// Latest point at or before time that track can be restarted from by writing
+	// saved sound chip registers, or -1 if file uses chips that can't be restored
+	// that way. Times are in 1/44100 seconds since start of track, and continue
+	// counting through loops. Indexes whole file the first time it's called.
+	int seek_point( int time );
+	
+	// Restarts track at point returned by seek_point(). Track must have just
+	// been started.
+	void restore_seek_point( int time );
+	
+	// Samples per channel played for each unit of time in log, at FM rate if
+	// uses_fm(), otherwise at output rate
+	double samples_per_time();
+	
+	// Renders FM and PCM chips on count threads, including caller's, or one per
+	// processor if 0. Output is the same as when using one thread, the default.
+	blargg_err_t set_chip_threads( int count );
+	
+	// Starts collecting time and work of each chip, or stops if false. Either
+	// way clears profile collected so far, as does loading a file.
+	blargg_err_t enable_profile( bool );
+	
+	// Copies profile of up to max chips to out, and returns number of chips
+	// profiled, or 0 if profiling isn't enabled
+	int get_profile( gme_chip_profile_t out [], int max );
+	
+	// Has ADPCM chips keep samples decoded the first time they're played, using
+	// up to max_bytes each, or decode them every time if 0
+	void set_sample_cache( long max_bytes );
+	
+	// Mixes QSound at hz, or at output rate if 0 or higher. Lower rates take
+	// less time but lose treble.
+	blargg_err_t set_qsound_rate( int hz );
+	
+	// Sets number of points in FIR of FM and PCM chip resamplers, or 0 for
+	// default. More take longer but pass less aliasing.
+	blargg_err_t set_resampler_width( int points );
 	
     // 0 for PSG and YM2612 DAC, 1 for AY, 2 for HuC6280, 3 for GB DMG
     Stereo_Buffer stereo_buf[4];
@@ -218,7 +278,7 @@ public:
 	Chip_Resampler_Emu<K053260_Emu> k053260;
 	Chip_Resampler_Emu<K054539_Emu> k054539;
 	Chip_Resampler_Emu<Ymz280b_Emu> ymz280b; int ymz280b_hz;
-    Chip_Resampler_Emu<Qsound_Apu> qsound[2];
+    Chip_Resampler_Emu<Qsound_Apu> qsound[2]; int qsound_rate_;
 
 	// DAC control
 	typedef struct daccontrol_data
@@ -242,6 +302,8 @@ public:
 
 public:
 	void chip_reg_write(unsigned Sample, byte ChipType, byte ChipID, byte Port, byte Offset, byte Data);
+	void chip_stream_write( int type, int id, int command, unsigned const times [],
+			byte const* data, int step, int count );
 
 // Implementation
 public:
@@ -283,9 +345,55 @@ private:
 	int gbdmg_time_offset;
 	blip_time_t to_gbdmg_time( vgm_time_t ) const;
 	
+	// Commands are decoded into events ahead of time, and kept so that loops
+	// and restarts don't have to decode them again
+	struct event_t
+	{
+		BOOST::uint32_t arg;    // usually id << 24 | port << 16 | reg << 8 | data
+		byte kind;
+		byte chip;
+		BOOST::uint16_t delay;  // time to wait after event
+	};
+	enum { max_events = 1 << 21 }; // above this, window slides rather than grows
+	blargg_vector<event_t> events;
+	int event_count;
+	int loop_event;             // -1 if loop point hasn't been decoded
+	byte const* events_begin;   // command first event was decoded from
+	bool decode_ended;
+	bool decode_merge;
+	void restart_decode( byte const* );
+	int decode_events();
+	void add_event( int kind, int chip = 0, unsigned arg = 0 );
+	void add_delay( int );
+	int loop_to_event();
+	void run_command( byte const*, vgm_time_t );
+
+	// Seek index, with sound chip registers changed since previous point
+	struct seek_point_t
+	{
+		int time;
+		int event;
+		int pcm_seek;       // last PCM seek offset, or -1 if none
+		int pcm_played;     // PCM bytes played since then
+		int changes_end;    // end of changes since previous point, in seek_changes
+	};
+	blargg_vector<seek_point_t> seek_points;
+	blargg_vector<event_t> seek_changes;
+	blargg_vector<BOOST::int16_t> seek_shadow;
+	int seek_point_count;       // -1 if not yet indexed, 0 if file can't be indexed
+	int seek_loop_time;         // -1 if track doesn't loop
+	int seek_end_time;
+	bool build_seek_index();
+	int find_seek_point( int time, int* loop_offset ) const;
+	void restore_registers( int chip, int id );
+	byte const* data_begin() const;
+
 	// Current time and position in log
 	vgm_time_t vgm_time;
-	byte const* pos;
+	int next_event;             // -1 if track has ended
+	byte const* pos;            // next command to decode
+	Gzip_Stream* stream;
+	byte const* fill_stream( byte const* end );
 	byte const* loop_begin;
 	bool has_looped;
 	
@@ -294,7 +402,7 @@ private:
 	typedef struct _vgm_pcm_bank_data
 	{
 		unsigned DataSize;
-		byte* Data;
+		byte const* Data;
 		unsigned DataStart;
 	} VGM_PCM_DATA;
 	typedef struct _vgm_pcm_bank
@@ -302,9 +410,11 @@ private:
 		unsigned BankCount;
 		VGM_PCM_DATA* Bank;
 		unsigned DataSize;
-		byte* Data;
+		byte const* Data;       // in file if bank is one uncompressed block, otherwise Buffer
 		unsigned DataPos;
 		unsigned BnkPos;
+		byte* Buffer;           // copy of blocks, grown as they're added
+		unsigned BufferSize;
 	} VGM_PCM_BANK;
 
 	typedef struct pcmbank_table
@@ -320,15 +430,19 @@ private:
 	VGM_PCM_BANK PCMBank[PCM_BANK_COUNT];
 	PCMBANK_TBL PCMTbl;
 
+	bool grow_pcm_bank( unsigned bank, unsigned size );
+	void free_pcm_banks();
+
 	void ReadPCMTable(unsigned DataSize, const byte* Data);
 	void AddPCMData(byte Type, unsigned DataSize, const byte* Data);
-	bool DecompressDataBlk(VGM_PCM_DATA* Bank, unsigned DataSize, const byte* Data);
+	bool DecompressDataBlk(VGM_PCM_DATA* Bank, byte* Out, unsigned DataSize, const byte* Data);
 	const byte* GetPointerFromPCMBank(byte Type, unsigned DataPos);
 
 	byte const* pcm_pos;    // current position in PCM data
 	int dac_amp[2];
 	int dac_disabled[2];       // -1 if disabled
 	void write_pcm( vgm_time_t, int chip, int amp );
+	void write_pcm_run( int chip, unsigned const times [], byte const* data, int step, int count );
 	
 	blip_time_t run( vgm_time_t );
 	int run_ym2151( int chip, int time );
@@ -351,7 +465,87 @@ private:
 	int run_k053260( int time );
 	int run_k054539( int time );
     int run_qsound( int chip, int time );
-	void update_fm_rates( int* ym2151_rate, int* ym2413_rate, int* ym2612_rate ) const;
+	
+	// FM and PCM chips are run through these, so that they can be run on several
+	// threads. Chips running at the same rate share a resampler, and so a lane.
+	// During a frame, each chip's writes are queued in its lane. Lanes are then
+	// run on separate threads, each logging its chips' output, and the logs are
+	// applied in the order a single thread would have written them.
+	struct chip_write_t
+	{
+		int time;       // chip time to run to before write
+		int seq;        // order of write among all chips
+		int offset;
+		byte type;      // as for chip_reg_write()
+		byte id;
+		byte port;
+		byte data;
+	};
+	struct chip_lane_t
+	{
+		byte type;      // first chip of group
+		byte id;
+		Chip_Resampler* group;
+		int write_count;
+		blargg_vector<chip_write_t> writes;
+		Chip_Output_Log log;
+	};
+	enum { max_lanes = max_chip_groups };
+	chip_lane_t lanes [max_lanes];
+	int lane_count;             // 0 if chips are being run directly
+	byte lane_of [0x20] [2];    // lane of chip, or max_lanes if none
+	int chip_write_seq;
+	int lane_end_time;
+	Worker_Pool chip_pool;
+	Chip_Resampler* chip_resampler( int type, int id );
+	void group_chips();
+	blargg_err_t setup_qsound();
+	int run_chip( int type, int id, int time );
+	void run_chip_write( chip_write_t const& );
+	void write_chip( int time, int type, int id, int port, int offset, int data );
+	void sync_chips();
+	void begin_chips( short* out, int pairs, short* const group_out [] );
+	void end_chips( short* out, int pairs );
+	static void run_lane( void*, int );
+	
+	void update_fm_rates( int* ym2151_rate, int* ym2413_rate, int* ym2612_rate );
+	
+	int resampler_width_;
+	blargg_err_t set_chip_widths();
+	
+	// Profiling. Time and samples of FM and PCM chips are counted by their
+	// resamplers, and of PSG chips around their writes and end of frame.
+	bool profiling_;
+	Chip_Profile apu_profile [4] [2]; // indexed like stereo_buf
+	bool profiling() const;
+	void set_chip_profiling();
+	double profile_start() const;
+	void profile_write( Chip_Profile&, double start );
+	Chip_Profile* profile_frame( int apu, int id );
 };
 
+inline bool Vgm_Core::profiling() const
+{
+	#if GME_DISABLE_PROFILE
+		return false;
+	#else
+		return profiling_;
+	#endif
+}
+
+// Time to pass to profile_write() after a PSG write
+inline double Vgm_Core::profile_start() const
+{
+	return profiling() ? Chip_Profile::now() : 0;
+}
+
+inline void Vgm_Core::profile_write( Chip_Profile& p, double start )
+{
+	if ( profiling() )
+	{
+		p.add_time( start );
+		p.writes++;
+	}
+}
+
 #endif
@@ -31,7 +31,8 @@ Vgm_Emu::Vgm_Emu()
 	set_type( gme_vgm_type );
 	set_max_initial_silence( 1 );
 	set_silence_lookahead( 1 ); // tracks should already be trimmed
-
+	stream_gzip(); // arcade logs with PCM data can be tens of MB inflated
+	
 	static equalizer_t const eq = { -14.0, 80 , 0,0,0,0,0,0,0,0 };
 	set_equalizer( eq );
 }
@@ -131,6 +132,7 @@ blargg_err_t Vgm_Emu::track_info_( track_info_t* out, int ) const
 	if ( gd3_offset <= 0 )
 		return blargg_ok;
 	
+	core.fill_file();
 	byte const* gd3 = core.file_begin() + gd3_offset + offsetof( header_t, gd3_offset );
 	int gd3_size = check_gd3_header( gd3, core.file_end() - gd3 );
 	if ( gd3_size )
@@ -146,11 +148,12 @@ blargg_err_t Vgm_Emu::gd3_data( const unsigned char ** data, int * size )
 {
 	*data = 0;
 	*size = 0;
-
+	
 	int gd3_offset = get_le32( header().gd3_offset );
 	if ( gd3_offset <= 0 )
 		return blargg_ok;
-
+	
+	core.fill_file();
 	byte const* gd3 = core.file_begin() + gd3_offset + offsetof( header_t, gd3_offset );
 	int gd3_size = check_gd3_header( gd3, core.file_end() - gd3 );
 	if ( gd3_size )
@@ -158,7 +161,7 @@ blargg_err_t Vgm_Emu::gd3_data( const unsigned char ** data, int * size )
 		*data = gd3;
 		*size = gd3_size + gd3_header_size;
 	}
-
+	
 	return blargg_ok;
 }
 
@@ -238,30 +241,30 @@ struct Vgm_File : Gme_Info_
 		RETURN_ERR( in.read( &h, h.size_min ) );
 		if ( !h.valid_tag() )
 			return blargg_err_file_type;
-
+		
 		if ( h.size() > h.size_min )
 			RETURN_ERR( in.read( &h.rf5c68_rate, h.size() - h.size_min ) );
-
+		
 		h.cleanup();
-
+		
 		int data_offset = get_le32( h.data_offset ) + offsetof( Vgm_Core::header_t, data_offset );
 		int data_size = file_size - offsetof( Vgm_Core::header_t, data_offset ) - data_offset;
 		int gd3_offset = get_le32( h.gd3_offset );
 		if ( gd3_offset > 0 )
 			gd3_offset += offsetof( Vgm_Core::header_t, gd3_offset );
-
+		
 		int amount_to_skip = gd3_offset - h.size();
-
+		
 		if ( gd3_offset > 0 && gd3_offset > data_offset )
 		{
 			data_size = gd3_offset - data_offset;
 			amount_to_skip = 0;
-
+			
 			RETURN_ERR( data.resize( data_size ) );
 			RETURN_ERR( in.skip( data_offset - h.size() ) );
 			RETURN_ERR( in.read( data.begin(), data_size ) );
 		}
-
+		
 		int remain = file_size - gd3_offset;
 		byte gd3_h [gd3_header_size];
 		if ( gd3_offset > 0 && remain >= gd3_header_size )
@@ -274,7 +277,7 @@ struct Vgm_File : Gme_Info_
 				RETURN_ERR( gd3.resize( gd3_size ) );
 				RETURN_ERR( in.read( gd3.begin(), gd3.size() ) );
 			}
-
+			
 			if ( data_offset > gd3_offset )
 			{
 				RETURN_ERR( data.resize( data_size ) );
@@ -282,7 +285,7 @@ struct Vgm_File : Gme_Info_
 				RETURN_ERR( in.read( data.begin(), data.end() - data.begin() ) );
 			}
 		}
-
+		
 		return blargg_ok;
 	}
 	
@@ -293,7 +296,7 @@ struct Vgm_File : Gme_Info_
 			parse_gd3( gd3.begin(), gd3.end(), out );
 		return blargg_ok;
 	}
-
+	
 	blargg_err_t hash_( Hash_Function& out ) const
 	{
 		hash_vgm_file( h, data.begin(), data.end() - data.begin(), out );
@@ -349,7 +352,7 @@ void Vgm_Emu::set_voice( int i, Blip_Buffer* c, Blip_Buffer* l, Blip_Buffer* r )
 void Vgm_Emu::mute_voices_( int mask )
 {
 	muted_voices = mask;
-
+	
 	Classic_Emu::mute_voices_( mask );
 	
 	// TODO: what was this for?
@@ -403,7 +406,7 @@ void Vgm_Emu::mute_voices_( int mask )
 				core.ym2203[1].mute_voices(mask);
 			}
 		}
-
+		
 		if ( core.ym2413[0].enabled() )
 		{
 			int m = mask & 0x3F;
@@ -415,14 +418,14 @@ void Vgm_Emu::mute_voices_( int mask )
 			if ( core.ym2413[1].enabled() )
 				core.ym2413[1].mute_voices( m );
 		}
-
+		
 		if ( core.ym2151[0].enabled() )
 		{
 			core.ym2151[0].mute_voices( mask );
 			if ( core.ym2151[1].enabled() )
 				core.ym2151[1].mute_voices( mask );
 		}
-
+		
 		if ( core.c140.enabled() )
 		{
 			int m = 0;
@@ -433,12 +436,12 @@ void Vgm_Emu::mute_voices_( int mask )
 			}
 			core.c140.mute_voices( m );
 		}
-
+		
 		if ( core.rf5c68.enabled() )
 		{
 			core.rf5c68.mute_voices( mask );
 		}
-
+		
 		if ( core.rf5c164.enabled() )
 		{
 			core.rf5c164.mute_voices( mask );
@@ -446,17 +449,56 @@ void Vgm_Emu::mute_voices_( int mask )
 	}
 }
 
+blargg_err_t Vgm_Emu::set_ym2612_core_( int c )
+{
+	RETURN_ERR( core.ym2612[0].set_core( (Ym2612_Emu::core_t) c ) );
+	return core.ym2612[1].set_core( (Ym2612_Emu::core_t) c );
+}
+
+blargg_err_t Vgm_Emu::set_chip_threads_( int count )
+{
+	return core.set_chip_threads( count );
+}
+
+blargg_err_t Vgm_Emu::enable_profile_( bool enabled )
+{
+	return core.enable_profile( enabled );
+}
+
+int Vgm_Emu::get_profile_( gme_chip_profile_t out [], int max )
+{
+	return core.get_profile( out, max );
+}
+
+blargg_err_t Vgm_Emu::set_sample_cache_( long max_bytes )
+{
+	core.set_sample_cache( max_bytes );
+	return blargg_ok;
+}
+
+blargg_err_t Vgm_Emu::set_qsound_rate_( int rate )
+{
+	return core.set_qsound_rate( rate );
+}
+
+blargg_err_t Vgm_Emu::set_resampler_width_( int points )
+{
+	RETURN_ERR( resampler.set_width( points ) );
+	return core.set_resampler_width( points );
+}
+
 blargg_err_t Vgm_Emu::load_mem_( byte const data [], int size )
 {
+	core.set_stream( file_stream() );
 	RETURN_ERR( core.load_mem( data, size ) );
-
+	
 	set_voice_count( core.psg[0].osc_count );
 	
 	double fm_rate = 0.0;
 	if ( !disable_oversampling_ )
 		fm_rate = sample_rate() * oversample_factor;
 	RETURN_ERR( core.init_chips( &fm_rate ) );
-
+	
 	double psg_gain = ( ( core.header().psg_rate[3] & 0xC0 ) == 0x40 ) ? 0.5 : 1.0;
 	
 	if ( core.uses_fm() )
@@ -493,7 +535,49 @@ blargg_err_t Vgm_Emu::load_mem_( byte const data [], int size )
 	};
 	set_voice_types( types );
 	
-	return Classic_Emu::setup_buffer( core.stereo_buf[0].center()->clock_rate() );
+	RETURN_ERR( Classic_Emu::setup_buffer( core.stereo_buf[0].center()->clock_rate() ) );
+	
+	if ( core.uses_fm() )
+		setup_fm_outputs();
+	
+	return blargg_ok;
+}
+
+// FM chips mix their voices internally, so outputs are by chip rather than voice
+void Vgm_Emu::setup_fm_outputs()
+{
+	int count = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		buf_output [i] = -1;
+		const char* name = core.buf_name( i );
+		if ( name )
+		{
+			buf_output [i] = count;
+			fm_output_names [count++] = name;
+		}
+	}
+	
+	int group_count = core.chip_group_count();
+	for ( int i = 0; i < group_count; i++ )
+		fm_output_names [count++] = core.chip_group_name( i );
+	
+	set_output_count( count );
+	set_output_names( fm_output_names );
+}
+
+blargg_err_t Vgm_Emu::set_outputs_( bool enabled )
+{
+	if ( !enabled )
+	{
+		RETURN_ERR( resampler.set_outputs( 0, 0 ) );
+		return Classic_Emu::set_outputs_( false );
+	}
+	
+	if ( !core.uses_fm() )
+		return Classic_Emu::set_outputs_( true );
+	
+	return resampler.set_outputs( 4, core.chip_group_count() );
 }
 
 // Emulation
@@ -503,7 +587,7 @@ blargg_err_t Vgm_Emu::start_track_( int track )
 	RETURN_ERR( Classic_Emu::start_track_( track ) );
 	
 	core.start_track();
-
+	
 	mute_voices_(muted_voices);
 	
 	if ( core.uses_fm() )
@@ -512,6 +596,27 @@ blargg_err_t Vgm_Emu::start_track_( int track )
 	return blargg_ok;
 }
 
+// Time given to restored chips to settle before reaching seek target
+int const seek_warm_up = 44100;
+
+int Vgm_Emu::seek_index_( int time, int min_time )
+{
+	double samples_per_time = core.samples_per_time() * 2; // stereo
+	if ( core.uses_fm() )
+		samples_per_time /= resampler.rate();
+	int t = core.seek_point( int (time / samples_per_time) - seek_warm_up );
+	if ( t < 0 )
+		return -1;
+	
+	int n = int (t * samples_per_time);
+	n -= n & 1;
+	if ( n <= min_time || Vgm_Emu::start_track_( current_track() ) )
+		return -1;
+	
+	core.restore_seek_point( t );
+	return n;
+}
+
 inline void Vgm_Emu::check_end()
 {
 	if ( core.track_ended() )
@@ -536,7 +641,13 @@ blargg_err_t Vgm_Emu::run_clocks( blip_time_t& time_io, int msec )
 inline int Vgm_Emu::play_frame( blip_time_t blip_time, int sample_count, sample_t buf [] )
 {
 	check_end();
-	int result = core.play_frame( blip_time, sample_count, buf );
+	
+	sample_t* group_out [Vgm_Core::max_chip_groups];
+	int group_count = resampler.stream_count();
+	for ( int i = 0; i < group_count; i++ )
+		group_out [i] = resampler.stream_buffer( i );
+	
+	int result = core.play_frame( blip_time, sample_count, buf, group_count ? group_out : NULL );
 	check_warning();
 	return result;
 }
@@ -552,12 +663,29 @@ blargg_err_t Vgm_Emu::play_( int count, sample_t out [] )
 		return Classic_Emu::play_( count, out );
 
     Stereo_Buffer * secondaries[] = { &core.stereo_buf[1], &core.stereo_buf[2], &core.stereo_buf[3] };
-    resampler.dual_play( count, out, core.stereo_buf[0], secondaries, 3 );
+	
+	// Outputs in the order resampler takes them: buffers, then chip groups
+	sample_t* outs [4 + Vgm_Core::max_chip_groups];
+	sample_t* const* const o = outputs();
+	if ( o )
+	{
+		int group_count = resampler.stream_count();
+		int first_group = output_count() - group_count;
+		for ( int i = 0; i < 4 + group_count; i++ )
+		{
+			int n = (i < 4 ? buf_output [i] : first_group + i - 4);
+			outs [i] = (n >= 0 && o [n] ? o [n] + outputs_pos() : NULL);
+		}
+	}
+	
+    resampler.dual_play( count, out, core.stereo_buf[0], secondaries, 3, o ? outs : NULL );
+	outputs_played( count );
 	return blargg_ok;
 }
 
 blargg_err_t Vgm_Emu::hash_( Hash_Function& out ) const
 {
+	core.fill_file();
 	byte const* p = file_begin() + header().size();
 	byte const* e = file_end();
 	int data_offset = get_le32( header().data_offset );
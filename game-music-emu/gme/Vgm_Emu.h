@@ -47,12 +47,21 @@ protected:
 	blargg_err_t set_sample_rate_( int sample_rate );
 	blargg_err_t start_track_( int );
 	blargg_err_t play_( int count, sample_t  []);
+	virtual int seek_index_( int time, int min_time );
 	blargg_err_t run_clocks( blip_time_t&, int );
 	virtual void set_tempo_( double );
 	virtual void mute_voices_( int mask );
+	virtual blargg_err_t set_ym2612_core_( int );
+	virtual blargg_err_t set_chip_threads_( int );
+	virtual blargg_err_t enable_profile_( bool );
+	virtual int get_profile_( gme_chip_profile_t [], int );
+	virtual blargg_err_t set_sample_cache_( long );
+	virtual blargg_err_t set_qsound_rate_( int );
+	virtual blargg_err_t set_resampler_width_( int );
 	virtual void set_voice( int, Blip_Buffer*, Blip_Buffer*, Blip_Buffer* );
 	virtual void update_eq( blip_eq_t const& );
 	virtual void unload();
+	virtual blargg_err_t set_outputs_( bool );
 	
 private:
 	bool disable_oversampling_;
@@ -60,6 +69,12 @@ private:
 	Dual_Resampler resampler;
 	Vgm_Core core;
 	
+	// Separate outputs when FM is used: each kind of PSG chip used, then each
+	// group of FM and PCM chips
+	const char* fm_output_names [4 + Vgm_Core::max_chip_groups];
+	int buf_output [4]; // output of core.stereo_buf [i], or -1 if unused
+	void setup_fm_outputs();
+	
 	void check_end();
 	void check_warning();
 	int play_frame( blip_time_t blip_time, int sample_count, sample_t buf [] );
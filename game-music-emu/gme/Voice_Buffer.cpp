@@ -0,0 +1,328 @@
+// Blip_Buffer $vers. http://www.slack.net/~ant/
+
+#include "Voice_Buffer.h"
+
+#include "State_Copier.h"
+
+#include "blargg_source.h"
+
+int const stereo = 2;
+
+// Integrators are run over a block of samples at a time, so that channels can
+// be summed in a small array
+int const mix_block = 256;
+
+Voice_Buffer::Voice_Buffer() : Multi_Buffer( stereo )
+{
+	bufs         = NULL;
+	bufs_size    = 0;
+	clock_rate_  = 0;
+	bass_freq_   = 90;
+	samples_read = 0;
+}
+
+Voice_Buffer::~Voice_Buffer()
+{
+	delete_bufs();
+}
+
+// avoid using new []
+blargg_err_t Voice_Buffer::new_bufs( int size )
+{
+	bufs = (buf_t*) malloc( size * sizeof *bufs );
+	CHECK_ALLOC( bufs );
+	for ( int i = 0; i < size; i++ )
+		new (bufs + i) buf_t;
+	bufs_size = size;
+	return blargg_ok;
+}
+
+void Voice_Buffer::delete_bufs()
+{
+	if ( bufs )
+	{
+		for ( int i = bufs_size; --i >= 0; )
+			bufs [i].~buf_t();
+		free( bufs );
+		bufs = NULL;
+	}
+	bufs_size = 0;
+}
+
+blargg_err_t Voice_Buffer::set_sample_rate( int rate, int msec )
+{
+	samples_read = 0;
+	for ( int i = bufs_size; --i >= 0; )
+		RETURN_ERR( bufs [i].set_sample_rate( rate, msec ) );
+	return Multi_Buffer::set_sample_rate( rate, msec );
+}
+
+blargg_err_t Voice_Buffer::set_channel_count( int count, int const types [] )
+{
+	RETURN_ERR( Multi_Buffer::set_channel_count( count, types ) );
+
+	delete_bufs();
+	samples_read = 0;
+	RETURN_ERR( new_bufs( count * 3 ) );
+
+	for ( int i = bufs_size; --i >= 0; )
+		RETURN_ERR( bufs [i].set_sample_rate( sample_rate(), length() ) );
+
+	clock_rate( clock_rate_ );
+	bass_freq( bass_freq_ );
+	channels_changed();
+	return blargg_ok;
+}
+
+void Voice_Buffer::clock_rate( int rate )
+{
+	clock_rate_ = rate;
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].clock_rate( clock_rate_ );
+}
+
+void Voice_Buffer::bass_freq( int freq )
+{
+	bass_freq_ = freq;
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].bass_freq( bass_freq_ );
+}
+
+bool Voice_Buffer::copy_state( State_Copier& copier )
+{
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].copy_state( copier );
+	copier( samples_read );
+	return true;
+}
+
+void Voice_Buffer::clear()
+{
+	samples_read = 0;
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].clear();
+}
+
+Voice_Buffer::channel_t Voice_Buffer::channel( int i )
+{
+	require( (unsigned) i < (unsigned) channel_count() );
+	channel_t ch;
+	ch.center = &bufs [i * 3    ];
+	ch.left   = &bufs [i * 3 + 1];
+	ch.right  = &bufs [i * 3 + 2];
+	return ch;
+}
+
+void Voice_Buffer::end_frame( blip_time_t time )
+{
+	for ( int i = bufs_size; --i >= 0; )
+		bufs [i].end_frame( time );
+}
+
+int Voice_Buffer::samples_avail() const
+{
+	return bufs_size ? (bufs [0].samples_avail() - samples_read) * stereo : 0;
+}
+
+// Integrators are inherently serial, so they're run first, two at a time where
+// possible so that they overlap. Clamping and storing can then be done in
+// vector loops.
+
+// Stores count samples of b, starting offset samples into it, in out
+static void integrate( Tracked_Blip_Buffer& b, int offset, int count, int out [] )
+{
+	int const bass = b.highpass_shift();
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT in = b.read_pos() + offset;
+	int sum = b.integrator();
+	for ( int i = 0; i < count; i++ )
+	{
+		out [i] = sum >> Blip_Buffer::delta_bits;
+		sum -= sum >> bass;
+		sum += in [i];
+	}
+	b.set_integrator( sum );
+}
+
+// Same as integrate() for two buffers at once
+static void integrate2( Tracked_Blip_Buffer& a, Tracked_Blip_Buffer& b, int offset, int count,
+		int a_out [], int b_out [] )
+{
+	int const bass = a.highpass_shift();
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT a_in = a.read_pos() + offset;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT b_in = b.read_pos() + offset;
+	int a_sum = a.integrator();
+	int b_sum = b.integrator();
+	for ( int i = 0; i < count; i++ )
+	{
+		a_out [i] = a_sum >> Blip_Buffer::delta_bits;
+		b_out [i] = b_sum >> Blip_Buffer::delta_bits;
+		a_sum -= a_sum >> bass;
+		b_sum -= b_sum >> bass;
+		a_sum += a_in [i];
+		b_sum += b_in [i];
+	}
+	a.set_integrator( a_sum );
+	b.set_integrator( b_sum );
+}
+
+// Adds count samples of channel that only uses its center buffer to mono, and
+// stores them in both sides of out if it isn't NULL
+static void add_center( int const in [], int count, int mono [], blip_sample_t out [] )
+{
+	for ( int i = 0; i < count; i++ )
+		mono [i] += in [i];
+
+	if ( out )
+	{
+		blip_clamp_samples_( in, out,     count, 2 );
+		blip_clamp_samples_( in, out + 1, count, 2 );
+	}
+}
+
+void Voice_Buffer::read_center( buf_t& b, int offset, int count, int mono [], blip_sample_t out [] )
+{
+	int samples [mix_block];
+	integrate( b, offset, count, samples );
+	add_center( samples, count, mono, out );
+}
+
+void Voice_Buffer::read_centers( buf_t& a, buf_t& b, int offset, int count, int mono [],
+		blip_sample_t a_out [], blip_sample_t b_out [] )
+{
+	int a_samples [mix_block];
+	int b_samples [mix_block];
+	integrate2( a, b, offset, count, a_samples, b_samples );
+	add_center( a_samples, count, mono, a_out );
+	add_center( b_samples, count, mono, b_out );
+}
+
+void Voice_Buffer::read_sides( buf_t b [], int offset, int count, int stereo_mix [],
+		blip_sample_t out [] )
+{
+	int samples [mix_block * stereo];
+
+	int const bass = b [0].highpass_shift();
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT center = b [0].read_pos() + offset;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT left   = b [1].read_pos() + offset;
+	Blip_Buffer::delta_t const* BLARGG_RESTRICT right  = b [2].read_pos() + offset;
+	int center_sum = b [0].integrator();
+	int left_sum   = b [1].integrator();
+	int right_sum  = b [2].integrator();
+	for ( int i = 0; i < count; i++ )
+	{
+		samples [i * 2    ] = (center_sum + left_sum ) >> Blip_Buffer::delta_bits;
+		samples [i * 2 + 1] = (center_sum + right_sum) >> Blip_Buffer::delta_bits;
+
+		left_sum   -= left_sum   >> bass;
+		right_sum  -= right_sum  >> bass;
+		center_sum -= center_sum >> bass;
+
+		left_sum   += left   [i];
+		right_sum  += right  [i];
+		center_sum += center [i];
+	}
+	b [0].set_integrator( center_sum );
+	b [1].set_integrator( left_sum   );
+	b [2].set_integrator( right_sum  );
+
+	for ( int i = 0; i < count * stereo; i++ )
+		stereo_mix [i] += samples [i];
+
+	if ( out )
+		blip_clamp_samples_( samples, out, count * stereo, 1 );
+}
+
+int Voice_Buffer::read_voices( blip_sample_t out [], int count,
+		blip_sample_t* const outputs [], int pos )
+{
+	require( (count & 1) == 0 ); // must read an even number of samples
+	count = min( count, samples_avail() );
+
+	int const pair_count = count >> 1;
+	if ( !pair_count )
+		return 0;
+
+	for ( int start = 0; start < pair_count; start += mix_block )
+	{
+		int const n = min( pair_count - start, mix_block );
+
+		// Channels using only their center buffer are summed in mono, and
+		// others in stereo
+		int mono [mix_block];
+		int stereo_mix [mix_block * stereo];
+		memset( mono, 0, n * sizeof *mono );
+		bool any_sides = false;
+
+		// Centers are read in pairs, so a pending one waits for the next
+		buf_t* pending = NULL;
+		blip_sample_t* pending_out = NULL;
+		for ( int i = 0; i < channel_count(); i++ )
+		{
+			blip_sample_t* o = NULL;
+			if ( outputs && outputs [i] )
+				o = outputs [i] + pos + start * stereo;
+
+			buf_t* b = &bufs [i * 3];
+			if ( b [1].non_silent() | b [2].non_silent() )
+			{
+				if ( !any_sides )
+				{
+					memset( stereo_mix, 0, n * stereo * sizeof *stereo_mix );
+					any_sides = true;
+				}
+				read_sides( b, samples_read + start, n, stereo_mix, o );
+			}
+			else if ( b [0].non_silent() )
+			{
+				if ( !pending )
+				{
+					pending     = b;
+					pending_out = o;
+				}
+				else
+				{
+					read_centers( *pending, *b, samples_read + start, n, mono, pending_out, o );
+					pending = NULL;
+				}
+			}
+			else if ( o )
+			{
+				memset( o, 0, n * stereo * sizeof *o );
+			}
+		}
+
+		if ( pending )
+			read_center( *pending, samples_read + start, n, mono, pending_out );
+
+		blip_sample_t* mix = out + start * stereo;
+		if ( !any_sides )
+		{
+			blip_clamp_samples_( mono, mix,     n, 2 );
+			blip_clamp_samples_( mono, mix + 1, n, 2 );
+		}
+		else
+		{
+			for ( int i = 0; i < n; i++ )
+			{
+				stereo_mix [i * 2    ] += mono [i];
+				stereo_mix [i * 2 + 1] += mono [i];
+			}
+			blip_clamp_samples_( stereo_mix, mix, n * stereo, 1 );
+		}
+	}
+
+	samples_read += pair_count;
+	if ( samples_avail() <= 0 || immediate_removal() )
+	{
+		for ( int i = bufs_size; --i >= 0; )
+		{
+			buf_t& b = bufs [i];
+			if ( !b.non_silent() )
+				b.remove_silence( samples_read );
+			else
+				b.remove_samples( samples_read );
+		}
+		samples_read = 0;
+	}
+	return count;
+}
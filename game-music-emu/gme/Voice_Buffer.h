@@ -0,0 +1,56 @@
+// Multi-channel buffer that mixes channels to stereo and can also output each separately
+
+// Blip_Buffer $vers
+#ifndef VOICE_BUFFER_H
+#define VOICE_BUFFER_H
+
+#include "Multi_Buffer.h"
+
+// Gives each channel its own center, left, and right buffers, and mixes by
+// summing the channels' samples. Channels that haven't been written to recently
+// are skipped, and side buffers are only read for channels that use them.
+class Voice_Buffer : public Multi_Buffer {
+public:
+	// Reads at most count samples into out, as read_samples() does, and each
+	// channel's part of them into outputs [i] + pos, for each channel whose
+	// pointer isn't NULL. Outputs are in stereo like out. Returns number of
+	// samples read.
+	int read_voices( blip_sample_t out [], int count, blip_sample_t* const outputs [], int pos );
+
+// Implementation
+public:
+	Voice_Buffer();
+	~Voice_Buffer();
+	virtual blargg_err_t set_sample_rate( int, int msec = blip_default_length );
+	virtual blargg_err_t set_channel_count( int, int const types [] = NULL );
+	virtual void clock_rate( int );
+	virtual void bass_freq( int );
+	virtual void clear();
+	virtual channel_t channel( int );
+	virtual void end_frame( blip_time_t );
+	virtual int samples_avail() const;
+	virtual int read_samples( blip_sample_t out [], int count ) { return read_voices( out, count, NULL, 0 ); }
+	virtual bool copy_state( State_Copier& );
+
+private:
+	struct buf_t : Tracked_Blip_Buffer
+	{
+		void* operator new ( size_t, void* p ) { return p; }
+		void operator delete ( void* ) { }
+
+		~buf_t() { }
+	};
+	buf_t* bufs; // center, left, and right of each channel in turn
+	int bufs_size;
+	int clock_rate_;
+	int bass_freq_;
+	int samples_read;
+
+	blargg_err_t new_bufs( int size );
+	void delete_bufs();
+	void read_center( buf_t&, int offset, int count, int mono [], blip_sample_t out [] );
+	void read_centers( buf_t&, buf_t&, int offset, int count, int mono [], blip_sample_t [], blip_sample_t [] );
+	void read_sides( buf_t [], int offset, int count, int stereo_mix [], blip_sample_t out [] );
+};
+
+#endif
@@ -0,0 +1,200 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "Worker_Pool.h"
+
+#if !GME_DISABLE_THREADS
+	#include <atomic>
+	#include <condition_variable>
+	#include <mutex>
+	#include <thread>
+#endif
+
+#include "blargg_source.h"
+
+Worker_Pool::Worker_Pool()
+{
+	impl         = NULL;
+	thread_count = 0;
+}
+
+Worker_Pool::~Worker_Pool()
+{
+	stop();
+}
+
+bool Worker_Pool::supported()
+{
+	#if GME_DISABLE_THREADS
+		return false;
+	#else
+		return true;
+	#endif
+}
+
+#if GME_DISABLE_THREADS
+
+blargg_err_t Worker_Pool::start( int count )
+{
+	if ( count == 1 )
+		return blargg_ok;
+	return BLARGG_ERR( BLARGG_ERR_LIMITATION, "threads not supported" );
+}
+
+void Worker_Pool::stop() { }
+
+void Worker_Pool::run( job_t job, void* data, int count )
+{
+	for ( int i = 0; i < count; i++ )
+		job( data, i );
+}
+
+#else
+
+struct Worker_Pool::impl_t {
+	std::thread* threads;
+	int thread_count;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	unsigned batch;         // incremented for each run()
+	int busy;               // threads still working on current batch
+	bool stopping;
+	job_t job;
+	void* data;
+	int job_count;
+	std::atomic<int> next_job;
+
+	impl_t();
+	void stop();
+	void work( unsigned batch );
+	void run_jobs();
+};
+
+Worker_Pool::impl_t::impl_t()
+{
+	threads      = NULL;
+	thread_count = 0;
+	batch        = 0;
+	busy         = 0;
+	stopping     = false;
+	job          = NULL;
+	data         = NULL;
+	job_count    = 0;
+	next_job     = 0;
+}
+
+blargg_err_t Worker_Pool::start( int count )
+{
+	stop();
+
+	if ( count <= 0 )
+		count = std::thread::hardware_concurrency();
+	if ( count <= 1 )
+		return blargg_ok;
+
+	CHECK_ALLOC( impl = BLARGG_NEW impl_t );
+	impl_t& p = *impl;
+	if ( !(p.threads = BLARGG_NEW std::thread [count - 1]) )
+	{
+		stop();
+		return blargg_err_memory;
+	}
+	while ( p.thread_count < count - 1 )
+	{
+		#if __cpp_exceptions || __EXCEPTIONS || _CPPUNWIND
+			try {
+				p.threads [p.thread_count] = std::thread( &impl_t::work, impl, p.batch );
+			}
+			catch ( ... ) {
+				stop();
+				return BLARGG_ERR( BLARGG_ERR_GENERIC, "couldn't start thread" );
+			}
+		#else
+			p.threads [p.thread_count] = std::thread( &impl_t::work, impl, p.batch );
+		#endif
+		thread_count = ++p.thread_count;
+	}
+	return blargg_ok;
+}
+
+void Worker_Pool::impl_t::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		stopping = true;
+	}
+	wake.notify_all();
+	for ( int i = 0; i < thread_count; i++ )
+		threads [i].join();
+	delete [] threads;
+}
+
+void Worker_Pool::stop()
+{
+	if ( impl )
+	{
+		impl->stop();
+		delete impl;
+		impl = NULL;
+	}
+	thread_count = 0;
+}
+
+void Worker_Pool::impl_t::run_jobs()
+{
+	int i;
+	while ( (i = next_job++) < job_count )
+		job( data, i );
+}
+
+// Threads are given the batch count at their start, since run() might be called
+// before they get the lock
+void Worker_Pool::impl_t::work( unsigned last_batch )
+{
+	std::unique_lock<std::mutex> lock( mutex );
+	for ( ;; )
+	{
+		while ( !stopping && batch == last_batch )
+			wake.wait( lock );
+		if ( stopping )
+			break;
+		last_batch = batch;
+
+		lock.unlock();
+		run_jobs();
+		lock.lock();
+
+		if ( --busy == 0 )
+			done.notify_one();
+	}
+}
+
+void Worker_Pool::run( job_t job, void* data, int count )
+{
+	if ( !thread_count || count <= 1 )
+	{
+		for ( int i = 0; i < count; i++ )
+			job( data, i );
+		return;
+	}
+
+	impl_t& p = *impl;
+	{
+		std::lock_guard<std::mutex> lock( p.mutex );
+		p.job       = job;
+		p.data      = data;
+		p.job_count = count;
+		p.next_job  = 0;
+		p.busy      = p.thread_count;
+		p.batch++;
+	}
+	p.wake.notify_all();
+
+	p.run_jobs();
+
+	std::unique_lock<std::mutex> lock( p.mutex );
+	while ( p.busy )
+		p.done.wait( lock );
+}
+
+#endif
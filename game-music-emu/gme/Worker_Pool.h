@@ -0,0 +1,48 @@
+// Runs batches of small jobs on a set of threads that wait between batches
+
+// Game_Music_Emu $vers
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "blargg_common.h"
+
+class Worker_Pool {
+public:
+	typedef void (*job_t)( void* data, int index );
+
+	// Starts threads so that run() uses count threads, including the caller's,
+	// or one per processor if 0. Returns error if threads aren't supported.
+	blargg_err_t start( int count );
+
+	// Stops and waits for threads
+	void stop();
+
+	// Number of threads run() uses, including caller's
+	int size() const                { return thread_count + 1; }
+
+	// Calls job( data, index ) for each index from 0 to count - 1, spread across
+	// threads, and returns when all calls have returned. Calls might be made on
+	// any thread, in any order.
+	void run( job_t, void* data, int count );
+
+	// True if threads are available
+	static bool supported();
+
+public:
+	Worker_Pool();
+	~Worker_Pool();
+
+private:
+	// Threads and their synchronization are kept out of this header, since
+	// the standard thread headers include libc headers that break if
+	// included after blargg_source.h
+	struct impl_t;
+	impl_t* impl;           // NULL unless threads are running
+	int thread_count;
+
+	// noncopyable
+	Worker_Pool( const Worker_Pool& );
+	Worker_Pool& operator = ( const Worker_Pool& );
+};
+
+#endif
@@ -1,7 +1,383 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
 #include "Ym2612_Emu.h"
 
-#ifdef USE_GENS
-#include "Ym2612_Emu_Gens.cpp"
+#include "Ym2612_Nuked.h"
+#include "Ym2612_GENS.h"
+#include "fm.h"
+#include "chip_tables.h"
+#include <string.h>
+
+#if __cplusplus >= 201103L || (defined (_MSC_VER) && _MSC_VER >= 1900)
+	#include <chrono>
 #else
-#include "Ym2612_Emu_MAME.cpp"
+	#include <time.h>
 #endif
+
+#include "blargg_source.h"
+
+// With core_benchmark, fraction of real time the chip may take with the core chosen
+double const benchmark_budget = 0.25;
+
+// Rates each core's speed is measured at, and how much sound is timed. The
+// fastest of several runs is used, so a slow first run (cold caches, or
+// unoptimized code on JIT targets) doesn't decide the core.
+double const std_sample_rate = 44100;
+double const std_clock_rate  = 7670453;
+int const timed_pairs = 1024;
+int const timed_runs  = 4;
+
+static double now()
+{
+	#if __cplusplus >= 201103L || (defined (_MSC_VER) && _MSC_VER >= 1900)
+		using namespace std::chrono;
+		return duration<double>( steady_clock::now().time_since_epoch() ).count();
+	#else
+		return (double) clock() / CLOCKS_PER_SEC;
+	#endif
+}
+
+Ym2612_Emu::Ym2612_Emu()
+{
+	mame         = NULL;
+	nuked        = NULL;
+	gens         = NULL;
+	selected     = core_mame;
+	active       = core_mame;
+	sample_rate_ = 0;
+	clock_rate_  = 0;
+	mute_mask    = 0;
+	memset( written, 0, sizeof written );
+	memset( key_on,  0, sizeof key_on  );
+}
+
+Ym2612_Emu::~Ym2612_Emu()
+{
+	free_core();
+}
+
+void Ym2612_Emu::free_core()
+{
+	if ( mame )
+		ym2612_shutdown( mame );
+	mame = NULL;
+
+	delete nuked;
+	nuked = NULL;
+
+	delete gens;
+	gens = NULL;
+}
+
+const char* Ym2612_Emu::init_core()
+{
+	free_core();
+
+	switch ( active )
+	{
+	case core_mame:
+		mame = ym2612_init( (int) (clock_rate_ + 0.5), (int) (sample_rate_ + 0.5) );
+		CHECK_ALLOC( mame );
+		break;
+
+	case core_nuked:
+		CHECK_ALLOC( nuked = BLARGG_NEW Ym2612_Nuked_Emu );
+		RETURN_ERR( nuked->set_rate( sample_rate_, clock_rate_ ) );
+		break;
+
+	default:
+		CHECK_ALLOC( gens = BLARGG_NEW Ym2612_GENS_Emu );
+		RETURN_ERR( gens->set_rate( sample_rate_, clock_rate_ ) );
+		break;
+	}
+
+	mute_voices( mute_mask );
+	return blargg_ok;
+}
+
+const char* Ym2612_Emu::set_core( core_t c )
+{
+	if ( (unsigned) c >= core_count )
+		return BLARGG_ERR( BLARGG_ERR_CALLER, "invalid YM2612 core" );
+
+	selected = c;
+
+	// benchmark is resolved once rates are known
+	core_t const new_core = (c != core_benchmark ? c : sample_rate_ ? benchmark_core() : active);
+	if ( new_core == active && (mame || nuked || gens) )
+		return blargg_ok;
+
+	active = new_core;
+	if ( !sample_rate_ )
+		return blargg_ok;
+
+	RETURN_ERR( init_core() );
+	reset_core();
+	restore_regs();
+	return blargg_ok;
+}
+
+const char* Ym2612_Emu::set_rate( double sample_rate, double clock_rate )
+{
+	if ( !clock_rate )
+		clock_rate = sample_rate * 144.;
+
+	sample_rate_ = sample_rate;
+	clock_rate_  = clock_rate;
+	if ( selected == core_benchmark )
+		active = benchmark_core();
+	return init_core();
+}
+
+void Ym2612_Emu::reset_core()
+{
+	if ( mame )
+		ym2612_reset_chip( mame );
+
+	if ( nuked )
+		nuked->reset();
+
+	if ( gens )
+		gens->reset();
+}
+
+void Ym2612_Emu::reset()
+{
+	memset( written, 0, sizeof written );
+	memset( key_on,  0, sizeof key_on  );
+	reset_core();
+}
+
+void Ym2612_Emu::mute_voices( int mask )
+{
+	mute_mask = mask;
+
+	if ( mame )
+		ym2612_set_mutemask( mame, mask );
+
+	if ( nuked )
+		nuked->mute_voices( mask );
+
+	if ( gens )
+		gens->mute_voices( mask );
+}
+
+static stream_sample_t* DUMMYBUF[0x02] = {(stream_sample_t*)NULL, (stream_sample_t*)NULL};
+
+void Ym2612_Emu::write_core( int port, int addr, int data )
+{
+	if ( mame )
+	{
+		ym2612_update_one( mame, DUMMYBUF, 0 );
+		ym2612_write( mame, port * 2,     addr );
+		ym2612_write( mame, port * 2 + 1, data );
+	}
+
+	if ( nuked )
+	{
+		if ( port )
+			nuked->write1( addr, data );
+		else
+			nuked->write0( addr, data );
+	}
+
+	if ( gens )
+	{
+		if ( port )
+			gens->write1( addr, data );
+		else
+			gens->write0( addr, data );
+	}
+}
+
+void Ym2612_Emu::write_( int port, int addr, int data )
+{
+	addr &= 0xFF;
+	if ( addr == 0x28 && !port )
+	{
+		key_on [data & 7] = data & 0xF0;
+	}
+	else
+	{
+		regs    [port] [addr] = data;
+		written [port] [addr] = true;
+	}
+
+	write_core( port, addr, data );
+}
+
+void Ym2612_Emu::write0( int addr, int data ) { write_( 0, addr, data ); }
+
+void Ym2612_Emu::write1( int addr, int data ) { write_( 1, addr, data ); }
+
+void Ym2612_Emu::restore_regs()
+{
+	// Frequency MSB is latched and takes effect when LSB is written
+	static unsigned char const freqs [] = {
+		0xA4, 0xA0, 0xA5, 0xA1, 0xA6, 0xA2,
+		0xAC, 0xA8, 0xAD, 0xA9, 0xAE, 0xAA
+	};
+
+	for ( int port = 0; port < 2; port++ )
+	{
+		for ( int addr = (port ? 0x30 : 0x21); addr < 0x100; addr++ )
+		{
+			if ( written [port] [addr] && (addr & 0xF0) != 0xA0 )
+				write_core( port, addr, regs [port] [addr] );
+		}
+
+		for ( unsigned i = 0; i < sizeof freqs; i++ )
+		{
+			int const addr = freqs [i];
+			if ( written [port] [addr] )
+				write_core( port, addr, regs [port] [addr] );
+		}
+	}
+
+	for ( int i = 0; i < 8; i++ )
+	{
+		if ( key_on [i] )
+			write_core( 0, 0x28, key_on [i] | i );
+	}
+}
+
+void Ym2612_Emu::run_core( int pair_count, sample_t* out )
+{
+	if ( nuked || gens )
+	{
+		// Nuked and Gens output half the level MAME does, so are mixed in at
+		// double level, clamped as MAME is, and switching cores keeps loudness
+		sample_t buf [1024 * out_chan_count];
+		while ( pair_count > 0 )
+		{
+			int todo = min( pair_count, 1024 );
+			memset( buf, 0, todo * out_chan_count * sizeof buf [0] );
+			if ( nuked )
+				nuked->run( todo, buf );
+			else
+				gens->run( todo, buf );
+
+			for ( int i = 0; i < todo * out_chan_count; i++ )
+			{
+				int s = out [i] + buf [i] * 2;
+				if ( (short) s != s ) s = 0x7FFF ^ (s >> 31);
+				out [i] = s;
+			}
+			out += todo * out_chan_count;
+			pair_count -= todo;
+		}
+		return;
+	}
+
+	if ( !mame )
+		return;
+
+	stream_sample_t bufL[ 1024 ];
+	stream_sample_t bufR[ 1024 ];
+	stream_sample_t * buffers[2] = { bufL, bufR };
+
+	while (pair_count > 0)
+	{
+		int todo = pair_count;
+		if (todo > 1024) todo = 1024;
+		ym2612_update_one( mame, buffers, todo );
+
+		for (int i = 0; i < todo; i++)
+		{
+			int output_l = bufL [i];
+			int output_r = bufR [i];
+			output_l += out [0];
+			output_r += out [1];
+			if ( (short)output_l != output_l ) output_l = 0x7FFF ^ ( output_l >> 31 );
+			if ( (short)output_r != output_r ) output_r = 0x7FFF ^ ( output_r >> 31 );
+			out [0] = output_l;
+			out [1] = output_r;
+			out += 2;
+		}
+
+		pair_count -= todo;
+	}
+}
+
+void Ym2612_Emu::run( int pair_count, sample_t* out )
+{
+	run_core( pair_count, out );
+}
+
+// Seconds core takes to generate a second of sound at standard rates
+static double time_core( Ym2612_Emu::core_t c )
+{
+	Ym2612_Emu chip;
+	if ( chip.set_core( c ) || chip.set_rate( std_sample_rate, std_clock_rate ) )
+		return 1.0;
+	chip.reset();
+	
+	// sine-like patch on all channels, so every operator is working
+	for ( int port = 0; port < 2; port++ )
+	{
+		for ( int ch = 0; ch < 3; ch++ )
+		{
+			void (Ym2612_Emu::*write)( int, int ) = (port ? &Ym2612_Emu::write1 : &Ym2612_Emu::write0);
+			(chip.*write)( 0xB0 + ch, 0x07 ); // algorithm 7
+			(chip.*write)( 0xB4 + ch, 0xC0 ); // both speakers
+			for ( int op = 0; op < 16; op += 4 )
+			{
+				(chip.*write)( 0x30 + op + ch, 0x01 ); // multiple
+				(chip.*write)( 0x40 + op + ch, 0x10 ); // level
+				(chip.*write)( 0x50 + op + ch, 0x1F ); // attack
+				(chip.*write)( 0x80 + op + ch, 0x0F ); // sustain, release
+			}
+			(chip.*write)( 0xA4 + ch, 0x22 + ch );
+			(chip.*write)( 0xA0 + ch, 0x69 );
+			chip.write0( 0x28, 0xF0 | (port * 4 + ch) );
+		}
+	}
+	
+	Ym2612_Emu::sample_t buf [timed_pairs * Ym2612_Emu::out_chan_count];
+	memset( buf, 0, sizeof buf );
+	chip.run( 256, buf ); // warm up
+	double best = 1.0;
+	for ( int n = timed_runs; n--; )
+	{
+		memset( buf, 0, sizeof buf );
+		double const start = now();
+		chip.run( timed_pairs, buf );
+		best = min( best, (now() - start) * std_sample_rate / timed_pairs );
+	}
+	return best;
+}
+
+Ym2612_Emu::core_t Ym2612_Emu::benchmark_core() const
+{
+	// Speeds are measured the first time they're needed and kept, so every
+	// chip with the same rates picks the same core, and copies of an emulator
+	// sound the same
+	static double costs [core_gens]; // 0 until measured
+	
+	for ( int c = 0; c < core_gens; c++ )
+	{
+		chip_tables_lock();
+		double cost = costs [c];
+		chip_tables_unlock();
+		if ( !cost )
+		{
+			cost = time_core( (core_t) c );
+			if ( cost <= 0 )
+				cost = 1e-9; // clock too coarse to see; very fast
+			
+			// keep first measurement if another thread got there first
+			chip_tables_lock();
+			if ( !costs [c] )
+				costs [c] = cost;
+			cost = costs [c];
+			chip_tables_unlock();
+		}
+		
+		// Nuked emulates every chip clock, others generate output samples
+		double const scale = (c == core_nuked ? clock_rate_ / std_clock_rate :
+				sample_rate_ / std_sample_rate);
+		if ( cost * scale <= benchmark_budget )
+			return (core_t) c;
+	}
+	return core_gens;
+}
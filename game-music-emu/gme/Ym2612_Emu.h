@@ -1,44 +1,84 @@
-// YM2612 FM sound chip emulator
+// YM2612 FM sound chip emulator, using one of several cores selectable at run time
 
 // Game_Music_Emu $vers
 #ifndef YM2612_EMU_H
 #define YM2612_EMU_H
 
-// Gens is buggy and inaccurate, but faster
-// #define USE_GENS
-#ifdef USE_GENS
-struct Ym2612_Impl;
-#else
-typedef void Ym2612_Impl;
-#endif
+class Ym2612_Nuked_Emu;
+class Ym2612_GENS_Emu;
 
 class Ym2612_Emu  {
-	Ym2612_Impl* impl;
 public:
-	Ym2612_Emu() { impl = 0; }
-	~Ym2612_Emu();
-	
+	// Emulation cores, from most to least accurate. Nuked is cycle-accurate
+	// but slow, MAME is accurate and fast, and Gens is buggy and inaccurate,
+	// but fastest. All play at the same level. Benchmark picks the most
+	// accurate core that a short benchmark, run once per process the first
+	// time it's used, shows taking at most a quarter of real time at the rates
+	// set. It doesn't watch playing time, so the choice doesn't change while
+	// playing.
+	enum core_t { core_nuked, core_mame, core_gens, core_benchmark, core_count };
+
+	// Selects core. Can be changed while playing, at the cost of a click as
+	// the new core restarts any notes currently playing. Default is core_mame.
+	const char* set_core( core_t );
+
+	// Core currently being used. Never core_benchmark.
+	core_t core() const                 { return active; }
+
 	// Sets sample rate and chip clock rate, in Hz. Returns non-zero
 	// if error. If clock_rate=0, uses sample_rate*144
 	const char* set_rate( double sample_rate, double clock_rate = 0 );
-	
+
 	// Resets to power-up state
 	void reset();
-	
+
 	// Mutes voice n if bit n (1 << n) of mask is set
 	enum { channel_count = 6 };
 	void mute_voices( int mask );
-	
+
 	// Writes addr to register 0 then data to register 1
 	void write0( int addr, int data );
-	
+
 	// Writes addr to register 2 then data to register 3
 	void write1( int addr, int data );
-	
+
 	// Runs and adds pair_count*2 samples into current output buffer contents
 	typedef short sample_t;
 	enum { out_chan_count = 2 }; // stereo
 	void run( int pair_count, sample_t* out );
+
+public:
+	Ym2612_Emu();
+	~Ym2612_Emu();
+
+private:
+	void* mame;
+	Ym2612_Nuked_Emu* nuked;
+	Ym2612_GENS_Emu* gens;
+
+	core_t selected;
+	core_t active;
+	double sample_rate_;
+	double clock_rate_;
+	int mute_mask;
+
+	// Registers written since reset, so they can be replayed into a new core
+	unsigned char regs    [2] [0x100];
+	unsigned char written [2] [0x100];
+	unsigned char key_on  [8];
+
+	const char* init_core();
+	void free_core();
+	void reset_core();
+	void write_( int port, int addr, int data );
+	void write_core( int port, int addr, int data );
+	void restore_regs();
+	void run_core( int pair_count, sample_t* out );
+	core_t benchmark_core() const;
+
+	// noncopyable
+	Ym2612_Emu( const Ym2612_Emu& );
+	Ym2612_Emu& operator = ( const Ym2612_Emu& );
 };
 
 #endif
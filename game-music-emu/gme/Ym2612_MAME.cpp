@@ -141,6 +141,7 @@
 #include <stddef.h>	/* for NULL */
 #include <math.h>
 #include <stdint.h>
+#include "chip_tables.h"
 
 namespace Ym2612_MameImpl
 {
@@ -2377,7 +2378,7 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 }
 
 /* initialize generic tables */
-static void init_tables(void)
+static void build_tables(void)
 {
 	signed int i,x;
 	signed int n;
@@ -2480,6 +2481,20 @@ static void init_tables(void)
 #endif
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static void init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+	{
+		build_tables();
+		tables_built = 1;
+	}
+	chip_tables_unlock();
+}
+
 #endif /* BUILD_OPN */
 
 
@@ -3,6 +3,7 @@
 // Based on Nuked OPN2 ym3438.c and ym3438.h
 
 #include "Ym2612_Nuked.h"
+#include "chip_tables.h"
 
 /*
  * Copyright (C) 2017 Alexey Khokholov (Nuke.YKT)
@@ -1436,7 +1437,11 @@ void OPN2_Reset(ym3438_t *chip, Bit32u rate, Bit32u clock)
 
 void OPN2_SetChipType(Bit32u type)
 {
-    chip_type = type;
+    /* Only written when it changes, so running chips never see a write */
+    chip_tables_lock();
+    if (chip_type != type)
+        chip_type = type;
+    chip_tables_unlock();
 }
 
 void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
@@ -1839,7 +1844,7 @@ const char *Ym2612_Nuked_Emu::set_rate(double sample_rate, double clock_rate)
 void Ym2612_Nuked_Emu::reset()
 {
 	Ym2612_NukedImpl::ym3438_t *chip_r = reinterpret_cast<Ym2612_NukedImpl::ym3438_t*>(impl);
-	if ( !chip_r ) Ym2612_NukedImpl::OPN2_Reset( chip_r, static_cast<Bit32u>(prev_sample_rate), static_cast<Bit32u>(prev_clock_rate) );
+	if ( chip_r ) Ym2612_NukedImpl::OPN2_Reset( chip_r, static_cast<Bit32u>(prev_sample_rate), static_cast<Bit32u>(prev_clock_rate) );
 }
 
 void Ym2612_Nuked_Emu::mute_voices(int mask)
@@ -1868,5 +1873,5 @@ void Ym2612_Nuked_Emu::run(int pair_count, Ym2612_Nuked_Emu::sample_t *out)
 {
 	Ym2612_NukedImpl::ym3438_t *chip_r = reinterpret_cast<Ym2612_NukedImpl::ym3438_t*>(impl);
 	if ( !chip_r ) return;
-	Ym2612_NukedImpl::OPN2_GenerateStream(chip_r, out, pair_count);
+	Ym2612_NukedImpl::OPN2_GenerateStreamMix(chip_r, out, pair_count);
 }
@@ -3,7 +3,11 @@
 #include "Ymz280b_Emu.h"
 #include "ymz280b.h"
 
-Ymz280b_Emu::Ymz280b_Emu() { chip = 0; }
+Ymz280b_Emu::Ymz280b_Emu()
+{
+	chip = 0;
+	cache_budget = 0;
+}
 
 Ymz280b_Emu::~Ymz280b_Emu()
 {
@@ -22,6 +26,8 @@ int Ymz280b_Emu::set_rate( int clock_rate )
 	if ( !chip )
 		return 0;
 	
+	if ( cache_budget )
+		ymz280b_set_cache( chip, cache_budget );
 	reset();
 	return clock_rate * 2 / 384;
 }
@@ -43,6 +49,23 @@ void Ymz280b_Emu::write_rom( int size, int start, int length, void * data )
 	ymz280b_write_rom( chip, size, start, length, (const UINT8 *) data );
 }
 
+void Ymz280b_Emu::set_cache( int budget )
+{
+	cache_budget = budget;
+	if ( chip )
+		ymz280b_set_cache( chip, budget );
+}
+
+void Ymz280b_Emu::cache_stats( long* bytes, long* hits, long* misses ) const
+{
+	UINT32 b = 0, h = 0, m = 0;
+	if ( chip )
+		ymz280b_get_cache_stats( chip, &b, &h, &m );
+	*bytes  = b;
+	*hits   = h;
+	*misses = m;
+}
+
 void Ymz280b_Emu::mute_voices( int mask )
 {
 	ymz280b_set_mute_mask( chip, mask );
@@ -6,6 +6,7 @@
 
 class Ymz280b_Emu  {
 	void* chip;
+	int cache_budget;
 public:
 	Ymz280b_Emu();
 	~Ymz280b_Emu();
@@ -27,6 +28,14 @@ public:
 	// Scales ROM size, then writes length bytes from data at start offset
 	void write_rom( int size, int start, int length, void * data );
 	
+	// Plays ADPCM samples from cache of up to budget bytes of decoded samples,
+	// or decodes them as they're played if 0, the default
+	void set_cache( int budget );
+	
+	// Bytes of decoded samples cached, and number of times a keyed on sample
+	// was found in cache or not
+	void cache_stats( long* bytes, long* hits, long* misses ) const;
+	
 	// Runs and writes pair_count*2 samples to output
 	typedef short sample_t;
 	enum { out_chan_count = 2 }; // stereo
@@ -66,6 +66,7 @@ void Z80_Cpu::reset( void* unmapped_write, void const* unmapped_read )
 		set_page( i, unmapped_write, unmapped_read );
 	
 	memset( &r, 0, sizeof r );
+	spin.reset();
 }
 
 void Z80_Cpu::map_mem( addr_t start, int size, void* write, void const* read )
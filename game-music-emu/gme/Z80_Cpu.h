@@ -5,6 +5,8 @@
 #define Z80_CPU_H
 
 #include "blargg_endian.h"
+#include "State_Copier.h"
+#include "Spin_Detector.h"
 
 class Z80_Cpu {
 public:
@@ -72,6 +74,13 @@ public:
 	enum { page_padding = 4 };
 	
 	void set_end_time( time_t t );
+	
+	// Finds busy-wait loops so their time can be skipped. Cleared by reset().
+	Spin_Detector spin;
+	
+	// Saves/restores registers, memory mapping and timing. Must not be called
+	// during emulation.
+	void copy_state( State_Copier& );
 public:
 	Z80_Cpu();
 	
@@ -119,4 +128,12 @@ inline void Z80_Cpu::set_end_time( time_t t )
 	cpu_state->time += delta;
 }
 
+inline void Z80_Cpu::copy_state( State_Copier& copier )
+{
+	assert( cpu_state == &cpu_state_ );
+	copier( r );
+	copier( cpu_state_ );
+	copier( end_time_ );
+}
+
 #endif
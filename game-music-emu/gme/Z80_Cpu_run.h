@@ -28,6 +28,11 @@ CACHE_TIME() the normal time changing functions can be used.
 	// 0 <= port <= 0xFFFF (apparently upper 8 bits are output by hardware)
 	void OUT_PORT( int port, int data );
 	int  IN_PORT   int port );
+	
+	// True if reading any address from first to last has no side effects and gives
+	// the same value until CPU writes there, so busy-wait loops reading them can be
+	// skipped. Optional; defaults to true unless READ_MEM is defined.
+	bool CAN_SKIP_READS( addr_t first, addr_t last );
 
 	// Reference to Z80_Cpu object used for emulation
 	#define CPU cpu
@@ -113,6 +118,14 @@ int const C01 = 0x01;
 	#define INSTR( off, addr )      instr [off]
 #endif
 
+#ifndef CAN_SKIP_READS
+	#ifdef READ_MEM
+		#define CAN_SKIP_READS( first, last ) 0
+	#else
+		#define CAN_SKIP_READS( first, last ) 1
+	#endif
+#endif
+
 #ifndef READ_MEM
 	#define READ_MEM( addr )        RW_MEM( addr, read )
 #endif
@@ -181,6 +194,12 @@ bool warning = false;
 	int iy = R.iy;
 	int flags = R.b.flags;
 	
+	// Busy-wait loop detection. Any jump other than a short one backwards clears
+	// spin_key, so while it's unchanged, CPU has only run forward through loop.
+	int spin_end   = 0;  // end of last instruction that jumped back
+	int spin_key   = -1; // identifies loop CPU is in
+	int spin_count = 0;  // passes until its registers are checked
+	
 	//goto loop; // confuses optimizer
 	s_time += 7;
 	pc -= 2;
@@ -319,8 +338,11 @@ loop:
 	if ( !(cond) )\
 		goto loop;\
 	int offset = SBYTE( data );\
+	spin_end = pc;\
 	pc = WORD( pc + offset );\
 	s_time += clocks;\
+	if ( offset < 0 )\
+		goto jumped_back;\
 	goto loop;\
 }
 
@@ -342,7 +364,10 @@ loop:
 #define JP( cond ) \
 	if ( !(cond) )\
 		goto jp_not_taken;\
+	spin_end = pc + 2;\
 	pc = GET_ADDR();\
+	if ( pc < spin_end )\
+		goto jumped_back;\
 	goto loop;
 	
 	case 0xC2: JP( !ZERO  ) // JP NZ,addr
@@ -355,11 +380,62 @@ loop:
 	case 0xFA: JP(  MINUS ) // JP M,addr
 	
 	case 0xC3: // JP addr
+		spin_end = pc + 2;
 		pc = GET_ADDR();
+		if ( pc < spin_end )
+			goto jumped_back;
+		goto loop;
+	
+	jumped_back:
+		// Every few passes of a short loop, checks whether it's only waiting for the
+		// end of emulation, and if so skips its whole periods
+		if ( (unsigned) (spin_end - pc) <= Spin_Detector::max_size )
+		{
+			int key = (spin_end - pc) << 16 | pc;
+			if ( spin_key != key )
+			{
+				spin_key   = key;
+				spin_count = Spin_Detector::check_interval - 1;
+				CPU.spin.forget();
+			}
+			
+			if ( --spin_count < 0 )
+			{
+				spin_count = Spin_Detector::check_interval - 1;
+				int const regs [] = { r.w.bc, r.w.de, r.w.hl, r.b.a, flags, sp, ix, iy };
+				if ( CPU.spin.repeated( regs, sizeof regs / sizeof *regs, TIME() ) )
+				{
+					// Instructions must have no side effects, and branches within
+					// loop must go to one of them
+					int addr = pc;
+					unsigned starts  = 0;
+					unsigned targets = 0;
+					while ( addr < spin_end )
+					{
+						Spin_Detector::instr_t in = Spin_Detector::decode_z80( addr, &READ_CODE( addr ) );
+						if ( !in.size )
+							break;
+						if ( in.read == Spin_Detector::mem_read &&
+								!CAN_SKIP_READS( in.addr, in.addr + in.span - 1 ) )
+							break;
+						starts |= 1u << (addr - pc);
+						if ( (unsigned) (in.target - pc) < (unsigned) (spin_end - pc) )
+							targets |= 1u << (in.target - pc);
+						addr += in.size;
+					}
+					
+					if ( addr == spin_end && !(targets & ~starts) )
+						s_time += CPU.spin.skip( -s_time );
+					else
+						spin_count = INT_MAX; // don't check again
+				}
+			}
+		}
 		goto loop;
 	
 	case 0xE9: // JP HL
 		pc = r.w.hl;
+		spin_key = -1;
 		goto loop;
 
 // RET
@@ -382,6 +458,7 @@ loop:
 	ret_taken:
 		pc = READ_WORD( sp );
 		sp = WORD( sp + 2 );
+		spin_key = -1;
 		goto loop;
 	
 // CALL
@@ -405,6 +482,7 @@ loop:
 		pc = GET_ADDR();
 		sp = WORD( sp - 2 );
 		WRITE_WORD( sp, addr );
+		spin_key = -1;
 		goto loop;
 	}
 	
@@ -426,6 +504,7 @@ loop:
 		#ifdef RST_BASE
 			pc += RST_BASE;
 		#endif
+		spin_key = -1;
 		goto push_data;
 
 // PUSH/POP
@@ -1656,6 +1735,7 @@ loop:
 		
 		case 0xE9: // JP (IXY)
 			pc = ixy;
+			spin_key = -1;
 			goto loop;
 		
 		case 0xE3:{// EX (SP),IXY
@@ -0,0 +1,195 @@
+// Game_Music_Emu $vers. http://www.slack.net/~ant/
+
+#include "adpcm_cache.h"
+
+#include <stdlib.h>
+
+typedef struct
+{
+	UINT32 start;		/* first nibble in ROM */
+	UINT32 count;		/* nibbles, and decoded samples */
+	UINT32 refs;		/* voices playing region */
+	UINT32 last_use;
+	UINT8 stale;		/* ROM changed while region was in use */
+	INT16* data;
+} adpcm_region;
+
+struct _adpcm_cache
+{
+	adpcm_region* regions;
+	UINT32 region_count;
+	UINT32 region_alloc;
+	UINT32 budget;
+	UINT32 bytes;
+	UINT32 clock;
+	UINT32 hits;
+	UINT32 misses;
+};
+
+adpcm_cache* adpcm_cache_create(UINT32 budget)
+{
+	adpcm_cache* cache;
+
+	cache = (adpcm_cache*)calloc(1, sizeof(adpcm_cache));
+	if (cache == NULL)
+		return NULL;
+	cache->budget = budget;
+
+	return cache;
+}
+
+static void remove_region(adpcm_cache* cache, UINT32 index)
+{
+	adpcm_region* r = &cache->regions[index];
+
+	cache->bytes -= r->count * sizeof(INT16);
+	free(r->data);
+	*r = cache->regions[--cache->region_count];
+
+	return;
+}
+
+void adpcm_cache_free(adpcm_cache* cache)
+{
+	while (cache->region_count)
+		remove_region(cache, 0);
+	free(cache->regions);
+	free(cache);
+
+	return;
+}
+
+// Evicts least recently played regions not in use until needed more bytes fit.
+// Returns 0 if they can't.
+static UINT8 make_room(adpcm_cache* cache, UINT32 needed)
+{
+	while (cache->bytes + needed > cache->budget)
+	{
+		UINT32 oldest = cache->region_count;
+		UINT32 i;
+
+		for (i = 0; i < cache->region_count; i ++)
+		{
+			const adpcm_region* r = &cache->regions[i];
+			if (! r->refs && (oldest == cache->region_count ||
+				cache->clock - r->last_use > cache->clock - cache->regions[oldest].last_use))
+				oldest = i;
+		}
+		if (oldest == cache->region_count)
+			return 0;
+		remove_region(cache, oldest);
+	}
+
+	return 1;
+}
+
+void adpcm_cache_set_budget(adpcm_cache* cache, UINT32 budget)
+{
+	cache->budget = budget;
+	make_room(cache, 0);
+
+	return;
+}
+
+const INT16* adpcm_cache_find(adpcm_cache* cache, UINT32 start, UINT32 count)
+{
+	UINT32 i;
+
+	for (i = 0; i < cache->region_count; i ++)
+	{
+		adpcm_region* r = &cache->regions[i];
+		if (r->start == start && r->count >= count && ! r->stale)
+		{
+			r->refs ++;
+			r->last_use = ++cache->clock;
+			cache->hits ++;
+			return r->data;
+		}
+	}
+	cache->misses ++;
+
+	return NULL;
+}
+
+INT16* adpcm_cache_add(adpcm_cache* cache, UINT32 start, UINT32 count)
+{
+	UINT32 bytes = count * sizeof(INT16);
+	adpcm_region* r;
+
+	if (! count || count > cache->budget / sizeof(INT16) || ! make_room(cache, bytes))
+		return NULL;
+
+	if (cache->region_count >= cache->region_alloc)
+	{
+		UINT32 alloc = cache->region_alloc ? cache->region_alloc * 2 : 16;
+		adpcm_region* regions = (adpcm_region*)realloc(cache->regions,
+														alloc * sizeof(adpcm_region));
+		if (regions == NULL)
+			return NULL;
+		cache->regions = regions;
+		cache->region_alloc = alloc;
+	}
+
+	r = &cache->regions[cache->region_count];
+	r->data = (INT16*)malloc(bytes);
+	if (r->data == NULL)
+		return NULL;
+	r->start = start;
+	r->count = count;
+	r->refs = 1;
+	r->last_use = ++cache->clock;
+	r->stale = 0;
+	cache->region_count ++;
+	cache->bytes += bytes;
+
+	return r->data;
+}
+
+void adpcm_cache_release(adpcm_cache* cache, const INT16* data)
+{
+	UINT32 i;
+
+	for (i = 0; i < cache->region_count; i ++)
+	{
+		adpcm_region* r = &cache->regions[i];
+		if (r->data == data)
+		{
+			r->refs --;
+			if (! r->refs && r->stale)
+				remove_region(cache, i);
+			break;
+		}
+	}
+
+	return;
+}
+
+void adpcm_cache_clear(adpcm_cache* cache)
+{
+	UINT32 i = 0;
+
+	while (i < cache->region_count)
+	{
+		if (cache->regions[i].refs)
+		{
+			cache->regions[i].stale = 1;
+			i ++;
+		}
+		else
+		{
+			remove_region(cache, i);
+		}
+	}
+
+	return;
+}
+
+void adpcm_cache_stats(const adpcm_cache* cache, UINT32* bytes, UINT32* hits,
+					   UINT32* misses)
+{
+	*bytes = cache->bytes;
+	*hits = cache->hits;
+	*misses = cache->misses;
+
+	return;
+}
@@ -0,0 +1,44 @@
+#ifndef _ADPCM_CACHE_H_
+#define _ADPCM_CACHE_H_
+
+#include "mamedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cache of ADPCM sample ROM regions expanded to 16-bit PCM, so that a chip
+   decodes a sample the first time it's played and reads it back afterwards.
+   Regions are identified by the nibble they start at and how many nibbles
+   long they are, so the cache must be cleared whenever the ROM changes. */
+typedef struct _adpcm_cache adpcm_cache;
+
+adpcm_cache* adpcm_cache_create(UINT32 budget);
+void adpcm_cache_free(adpcm_cache* cache);
+
+/* Limits decoded samples to budget bytes, evicting least recently played
+   regions as needed */
+void adpcm_cache_set_budget(adpcm_cache* cache, UINT32 budget);
+
+/* Returns decoded region of count nibbles at start, or NULL if it isn't
+   cached. A region must be released when its voice stops using it. */
+const INT16* adpcm_cache_find(adpcm_cache* cache, UINT32 start, UINT32 count);
+
+/* Adds region of count nibbles at start, for caller to decode into. Returns
+   NULL if it doesn't fit in budget. */
+INT16* adpcm_cache_add(adpcm_cache* cache, UINT32 start, UINT32 count);
+
+void adpcm_cache_release(adpcm_cache* cache, const INT16* data);
+
+/* Removes all regions. Regions still in use are freed when released. */
+void adpcm_cache_clear(adpcm_cache* cache);
+
+/* Bytes of decoded samples, and number of times regions were found or not */
+void adpcm_cache_stats(const adpcm_cache* cache, UINT32* bytes, UINT32* hits,
+					   UINT32* misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ADPCM_CACHE_H_
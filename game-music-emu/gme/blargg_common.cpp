@@ -2,6 +2,12 @@
 
 #include "blargg_common.h"
 
+#include "chip_tables.h"
+
+#if !GME_DISABLE_THREADS
+	#include <mutex>
+#endif
+
 /* Copyright (C) 2008-2009 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -326,3 +332,13 @@ blargg_wchar_t* blargg_to_wide( const char* path )
 }
 
 BLARGG_NAMESPACE_END
+
+#if !GME_DISABLE_THREADS
+	static std::mutex chip_tables_mutex;
+
+	void chip_tables_lock()     { chip_tables_mutex.lock(); }
+	void chip_tables_unlock()   { chip_tables_mutex.unlock(); }
+#else
+	void chip_tables_lock()     { }
+	void chip_tables_unlock()   { }
+#endif
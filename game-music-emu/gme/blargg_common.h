@@ -90,6 +90,23 @@ arithmetic on smaller types. */
 	#define BLARGG_NAMESPACE_END
 #endif
 
+// Threads need C++11 and, under Emscripten, a pthreads build
+#ifndef GME_DISABLE_THREADS
+	#if defined (__EMSCRIPTEN__) && !defined (__EMSCRIPTEN_PTHREADS__)
+		#define GME_DISABLE_THREADS 1
+	#endif
+#endif
+
+// 6502 and HuC6280 cores jump to each instruction through a table of label
+// addresses where the compiler supports it (GCC and Clang). WebAssembly has no
+// indirect jumps, so there it would only turn back into a switch. Other cores
+// handle every opcode in their switch, which already compiles to the same jump.
+#if !defined (GME_COMPUTED_GOTO) && !GME_DISABLE_COMPUTED_GOTO
+	#if defined (__GNUC__) && !defined (__EMSCRIPTEN__)
+		#define GME_COMPUTED_GOTO 1
+	#endif
+#endif
+
 BLARGG_NAMESPACE_BEGIN
 
 /* BLARGG_DEPRECATED [_TEXT] for any declarations/text to be removed in a
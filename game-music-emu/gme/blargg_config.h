@@ -45,6 +45,18 @@
 // Reduce memory usage of gme.h by disabling gme_set_effects_config().
 //#define GME_DISABLE_EFFECTS 1
 
+// Disable use of background threads (gme_set_background_lookahead()). Always
+// disabled for Emscripten builds without pthreads support.
+//#define GME_DISABLE_THREADS 1
+
+// Disable per-chip profiling of VGM playback (gme_enable_profile()), removing
+// its checks from emulation loops.
+//#define GME_DISABLE_PROFILE 1
+
+// Dispatch CPU instructions with a switch statement even where computed goto
+// is available.
+//#define GME_DISABLE_COMPUTED_GOTO 1
+
 // Force library to use assume big-endian processor.
 //#define BLARGG_BIG_ENDIAN 1
 
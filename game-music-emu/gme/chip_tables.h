@@ -0,0 +1,20 @@
+/* Lock held while sound chip cores build their shared static tables, so that
+chips can be created from several threads at once. Cores build their tables
+only once, under this lock. */
+
+/* Game_Music_Emu $vers */
+#ifndef CHIP_TABLES_H
+#define CHIP_TABLES_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+void chip_tables_lock( void );
+void chip_tables_unlock( void );
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -135,6 +135,57 @@ INLINE UINT32 muldiv64round(UINT32 Multiplicand, UINT32 Multiplier, UINT32 Divis
 	return (UINT32)(((UINT64)Multiplicand * Multiplier + Multiplier / 2) / Divisor);
 }
 
+// Chips that take a whole run of commands at once through chip_stream_write_c
+INLINE UINT8 daccontrol_batched(dac_control *chip)
+{
+	switch(chip->DstChipType)
+	{
+	case 0x02:	// YM2612
+	case 0x11:	// PWM
+	case 0x17:	// OKIM6258
+		return 1;
+	}
+	return 0;
+}
+
+#define DCTRL_BATCH_SIZE	0x40
+
+// Same as the loop in daccontrol_update, but passes commands to the chip in
+// runs rather than one at a time
+static void daccontrol_update_batched(dac_control *chip, UINT32 base_clock, UINT32 NewPos)
+{
+	UINT32 Times[DCTRL_BATCH_SIZE];
+	const UINT8* Data = NULL;
+	UINT32 Count = 0;
+	UINT32 Sample = 0;
+	
+	while(chip->RemainCmds && chip->Pos < NewPos)
+	{
+		// commands past end of data are skipped, as by daccontrol_SendCommand
+		if (chip->DataStart + chip->Pos < chip->DataLen)
+		{
+			if (! Count)
+				Data = chip->Data + (chip->DataStart + chip->Pos);
+			Times[Count++] = base_clock + muldiv64round(Sample, chip->SampleRate, chip->Frequency);
+			if (Count >= DCTRL_BATCH_SIZE)
+			{
+				chip_stream_write_c(chip->context, chip->DstChipType, chip->DstChipID,
+						chip->DstCommand, Times, Data, chip->DataStep, Count);
+				Count = 0;
+			}
+		}
+		Sample++;
+		chip->Pos += chip->DataStep;
+		chip->RemainCmds --;
+	}
+	
+	if (Count)
+		chip_stream_write_c(chip->context, chip->DstChipType, chip->DstChipID,
+				chip->DstCommand, Times, Data, chip->DataStep, Count);
+	
+	return;
+}
+
 void daccontrol_update(void *_chip, UINT32 base_clock, UINT32 samples)
 {
 	dac_control *chip = (dac_control *) _chip;
@@ -163,13 +214,20 @@ void daccontrol_update(void *_chip, UINT32 base_clock, UINT32 samples)
 	// Formula: Step * Freq / SampleRate
 	NewPos = muldiv64round(chip->Step * chip->DataStep, chip->Frequency, chip->SampleRate);
 	
-	while(chip->RemainCmds && chip->Pos < NewPos)
+	if (daccontrol_batched(chip))
 	{
-		daccontrol_SendCommand(chip, base_clock + muldiv64round(Sample, chip->SampleRate, chip->Frequency));
-		Sample++;
-		chip->Pos += chip->DataStep;
-		chip->Running &= ~0x10;
-		chip->RemainCmds --;
+		daccontrol_update_batched(chip, base_clock, NewPos);
+	}
+	else
+	{
+		while(chip->RemainCmds && chip->Pos < NewPos)
+		{
+			daccontrol_SendCommand(chip, base_clock + muldiv64round(Sample, chip->SampleRate, chip->Frequency));
+			Sample++;
+			chip->Pos += chip->DataStep;
+			chip->Running &= ~0x10;
+			chip->RemainCmds --;
+		}
 	}
 	
 	if (! chip->RemainCmds && (chip->Running & 0x04))
@@ -291,6 +349,28 @@ void daccontrol_set_data(void *_chip, const UINT8* Data, UINT32 DataLen, UINT8 S
 	return;
 }
 
+void daccontrol_refresh_data(void *_chip, const UINT8* Data, UINT32 DataLen)
+{
+	// Should be called to fix the data pointer. (e.g. after a realloc)
+	dac_control *chip = (dac_control *) _chip;
+	
+	if (chip->Running & 0x80)
+		return;
+	
+	if (DataLen && Data != NULL)
+	{
+		chip->DataLen = DataLen;
+		chip->Data = Data;
+	}
+	else
+	{
+		chip->DataLen = 0x00;
+		chip->Data = NULL;
+	}
+	
+	return;
+}
+
 void daccontrol_set_frequency(void *_chip, UINT32 Frequency)
 {
 	dac_control *chip = (dac_control *) _chip;
@@ -27,11 +27,17 @@ void daccontrol_update(void * chip, UINT32 base_clock, UINT32 samples);
 void device_reset_daccontrol(void * chip);
 void daccontrol_setup_chip(void * chip, UINT8 ChType, UINT8 ChNum, UINT16 Command);
 void daccontrol_set_data(void *chip, const UINT8* Data, UINT32 DataLen, UINT8 StepSize, UINT8 StepBase);
+void daccontrol_refresh_data(void *chip, const UINT8* Data, UINT32 DataLen);
 void daccontrol_set_frequency(void *chip, UINT32 Frequency);
 void daccontrol_start(void *chip, UINT32 DataPos, UINT8 LenMode, UINT32 Length);
 void daccontrol_stop(void *chip);
 void chip_reg_write_c(void * context, UINT32 Sample, UINT8 ChipType, UINT8 ChipID, UINT8 Port, UINT8 Offset, UINT8 Data);
 
+// Sends Count stream commands to YM2612 DAC, PWM or OKIM6258. Command n is sent at
+// Samples[n], with its data at Data + n * DataStep.
+void chip_stream_write_c(void * context, UINT8 ChipType, UINT8 ChipID, UINT16 Command,
+		const UINT32* Samples, const UINT8* Data, UINT8 DataStep, UINT32 Count);
+
 #define DCTRL_LMODE_IGNORE	0x00
 #define DCTRL_LMODE_CMDS	0x01
 #define DCTRL_LMODE_MSEC	0x02
@@ -40,6 +40,7 @@
 #include <string.h>
 //#include "dosbox.h"
 #include "dbopl.h"
+#include "chip_tables.h"
 
 
 #ifndef PI
@@ -1335,11 +1336,7 @@ void Chip::Setup( Bit32u clock, Bit32u rate ) {
 	}
 }
 
-static bool doneTables = false;
-void InitTables( void ) {
-	if ( doneTables )
-		return;
-	doneTables = true;
+static void BuildTables( void ) {
 #if ( DBOPL_WAVE == WAVE_HANDLER ) || ( DBOPL_WAVE == WAVE_TABLELOG )
 	//Exponential volume table, same as the real adlib
 	for ( int i = 0; i < 256; i++ ) {
@@ -1491,6 +1488,17 @@ void InitTables( void ) {
 #endif
 }
 
+//Tables are built only once, even when chips are created from several threads
+static bool doneTables = false;
+void InitTables( void ) {
+	chip_tables_lock();
+	if ( !doneTables ) {
+		BuildTables();
+		doneTables = true;
+	}
+	chip_tables_unlock();
+}
+
 /*Bit32u Handler::WriteAddr( Bit32u port, Bit8u val ) {
 	return chip.WriteAddr( port, val );
 
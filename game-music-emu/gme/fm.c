@@ -127,6 +127,7 @@
 //#include "support.h"		/* use RAINE */
 //#endif
 #include "fm.h"
+#include "chip_tables.h"
 
 
 /* include external DELTA-T unit (when needed) */
@@ -1541,7 +1542,7 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 }
 
 /* initialize generic tables */
-static int init_tables(void)
+static int build_tables(void)
 {
 	signed int i,x;
 	signed int n;
@@ -1656,6 +1657,18 @@ static int init_tables(void)
 
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static int init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+		tables_built = build_tables();
+	chip_tables_unlock();
+	return tables_built;
+}
+
 
 
 static void FMCloseTable( void )
@@ -2452,10 +2465,19 @@ static const int step_inc[8] = { -1*16, -1*16, -1*16, -1*16, 2*16, 5*16, 7*16, 9
 static int jedi_table[ 49*16 ];
 
 
+static int jedi_table_built = 0;
+
 static void Init_ADPCMATable(void)
 {
 	int step, nib;
 
+	chip_tables_lock();
+	if (jedi_table_built)
+	{
+		chip_tables_unlock();
+		return;
+	}
+
 	for (step = 0; step < 49; step++)
 	{
 		/* loop over all nibbles and compute the difference */
@@ -2465,6 +2487,8 @@ static void Init_ADPCMATable(void)
 			jedi_table[step*16 + nib] = (nib&0x08) ? -value : value;
 		}
 	}
+	jedi_table_built = 1;
+	chip_tables_unlock();
 }
 
 /* ADPCM A (Non control type) : calculate one channel output */
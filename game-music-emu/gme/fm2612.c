@@ -134,6 +134,7 @@
 #include "mathdefs.h"
 #include "mamedef.h"
 #include "fm.h"
+#include "chip_tables.h"
 
 /* shared function building option */
 #define BUILD_OPN (BUILD_YM2203||BUILD_YM2608||BUILD_YM2610||BUILD_YM2610B||BUILD_YM2612||BUILD_YM3438)
@@ -2099,7 +2100,7 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 }
 
 /* initialize generic tables */
-static void init_tables(void)
+static void build_tables(void)
 {
 	signed int i,x;
 	signed int n;
@@ -2202,6 +2203,20 @@ static void init_tables(void)
 #endif
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static void init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+	{
+		build_tables();
+		tables_built = 1;
+	}
+	chip_tables_unlock();
+}
+
 #endif /* BUILD_OPN */
 
 #if (BUILD_YM2612||BUILD_YM3438)
@@ -73,6 +73,7 @@ Revision History:
 #include <math.h>
 #include "fmopl.h"
 #include "ymdeltat.h"
+#include "chip_tables.h"
 
 #ifndef INLINE
 #define INLINE __inline
@@ -1151,7 +1152,7 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static int build_tables(void)
 {
 	signed int i,x;
 	signed int n;
@@ -1257,6 +1258,18 @@ static int init_tables(void)
 	return 1;
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static int init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+		tables_built = build_tables();
+	chip_tables_unlock();
+	return tables_built;
+}
+
 static void OPLCloseTable( void )
 {
 #ifdef SAVE_SAMPLE
@@ -1,6 +1,7 @@
 // Game_Music_Emu https://bitbucket.org/mpyne/game-music-emu/
 
 #include "Music_Emu.h"
+#include "Gme_Batch.h"
 
 #if !GME_DISABLE_EFFECTS
 #include "Effects_Buffer.h"
@@ -114,7 +115,7 @@ BLARGG_EXPORT gme_err_t gme_identify_file( const char path [], gme_type_t* type_
 	return blargg_ok;   
 }
 
-BLARGG_EXPORT gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sample_rate )
+static gme_err_t open_data( void const* data, long size, Music_Emu** out, int sample_rate, bool borrow )
 {
 	require( (data || !size) && out );
 	*out = NULL;
@@ -130,16 +131,30 @@ BLARGG_EXPORT gme_err_t gme_open_data( void const* data, long size, Music_Emu**
 	Music_Emu* emu = gme_new_emu( file_type, sample_rate );
 	CHECK_ALLOC( emu );
 	
-	gme_err_t err = gme_load_data( emu, data, size );
+	gme_err_t err;
+	if ( borrow )
+		err = gme_load_data_borrowed( emu, data, size );
+	else
+		err = gme_load_data( emu, data, size );
 	
 	if ( err )
 		delete emu;
 	else
 		*out = emu;
-
+	
 	return err;
 }
 
+BLARGG_EXPORT gme_err_t gme_open_data( void const* data, long size, Music_Emu** out, int sample_rate )
+{
+	return open_data( data, size, out, sample_rate, false );
+}
+
+BLARGG_EXPORT gme_err_t gme_open_data_borrowed( void const* data, long size, Music_Emu** out, int sample_rate )
+{
+	return open_data( data, size, out, sample_rate, true );
+}
+
 BLARGG_EXPORT gme_err_t gme_open_file( const char path [], Music_Emu** out, int sample_rate )
 {
 	require( path && out );
@@ -214,10 +229,21 @@ BLARGG_EXPORT gme_err_t gme_load_file( Music_Emu* gme, const char path [] ) { re
 
 BLARGG_EXPORT gme_err_t gme_load_data( Music_Emu* gme, void const* data, long size )
 {
+	if ( Gzip_Stream::is_gzip( data, size ) )
+		return gme->load_gzip( data, size );
+	
 	Mem_File_Reader in( data, size );
 	return gme->load( in );
 }
 
+BLARGG_EXPORT gme_err_t gme_load_data_borrowed( Music_Emu* gme, void const* data, long size )
+{
+	if ( Gzip_Stream::is_gzip( data, size ) )
+		return gme->load_gzip_borrowed( data, size );
+	
+	return gme->load_mem( data, size );
+}
+
 BLARGG_EXPORT gme_err_t gme_load_custom( Music_Emu* gme, gme_reader_t func, long size, void* data )
 { /* wyatt */
 	Callback_Reader in( func, size, data );
@@ -226,6 +252,28 @@ BLARGG_EXPORT gme_err_t gme_load_custom( Music_Emu* gme, gme_reader_t func, long
 
 BLARGG_EXPORT void gme_delete( Music_Emu* gme ) { delete gme; }
 
+BLARGG_EXPORT gme_err_t gme_analyze_batch( gme_batch_file_t const files [], int file_count,
+		int sample_rate, int max_length_msec, int thread_count,
+		gme_track_analysis_t** out, int* count )
+{
+	require( (files || !file_count) && out && count );
+	*out   = NULL;
+	*count = 0;
+	
+	Gme_Batch::setup_t s;
+	s.files        = files;
+	s.file_count   = file_count;
+	s.sample_rate  = sample_rate;
+	s.max_length   = max_length_msec;
+	s.thread_count = thread_count;
+	
+	Gme_Batch batch;
+	RETURN_ERR( batch.run( s ) );
+	return batch.take_results( out, count );
+}
+
+BLARGG_EXPORT void gme_free_analysis( gme_track_analysis_t* p ) { free( p ); }
+
 BLARGG_EXPORT gme_type_t gme_type( Music_Emu const* gme ) { return gme->type(); }
 
 BLARGG_EXPORT const char* gme_type_system( gme_type_t_ const* type ) { return type->system; }
@@ -343,12 +391,20 @@ BLARGG_EXPORT void gme_free_info( gme_info_t* info )
 	delete STATIC_CAST(gme_info_t_*,info);
 }
 
+BLARGG_EXPORT gme_err_t gme_estimate_length( Music_Emu* gme, int track, int max_length_msec,
+		gme_length_estimate_t* out )
+{
+	return gme->estimate_length( track, max_length_msec, out );
+}
+
 BLARGG_EXPORT void*     gme_user_data      ( Music_Emu const* gme )                   { return gme->user_data(); }
 BLARGG_EXPORT void      gme_set_user_data  ( Music_Emu* gme, void* new_user_data )    { gme->set_user_data( new_user_data ); }
 BLARGG_EXPORT void      gme_set_user_cleanup(Music_Emu* gme, gme_user_cleanup_t func ){ gme->set_user_cleanup( func ); }
 
 BLARGG_EXPORT gme_err_t gme_start_track    ( Music_Emu* gme, int index )              { return gme->start_track( index ); }
 BLARGG_EXPORT gme_err_t gme_play           ( Music_Emu* gme, int n, short p [] )      { return gme->play( n, p ); }
+BLARGG_EXPORT gme_err_t gme_play_float     ( Music_Emu* gme, int n, float l [], float r [] ) { return gme->play_float( n, l, r ); }
+BLARGG_EXPORT void      gme_set_float_scale( Music_Emu* gme, double s )               { gme->set_float_scale( s ); }
 BLARGG_EXPORT void      gme_set_fade       ( Music_Emu* gme, int start_msec, int length_msec ) { gme->set_fade( start_msec, length_msec ); }
 BLARGG_EXPORT gme_bool  gme_track_ended    ( Music_Emu const* gme )                   { return gme->track_ended(); }
 BLARGG_EXPORT int       gme_tell           ( Music_Emu const* gme )                   { return gme->tell(); }
@@ -356,24 +412,47 @@ BLARGG_EXPORT int       gme_tell_scaled    ( Music_Emu const* gme )
 BLARGG_EXPORT gme_err_t gme_seek           ( Music_Emu* gme, int msec )               { return gme->seek( msec ); }
 BLARGG_EXPORT gme_err_t gme_seek_scaled    ( Music_Emu* gme, int msec )               { return gme->seek_scaled( msec ); }
 BLARGG_EXPORT gme_err_t gme_skip           ( Music_Emu* gme, int samples )            { return gme->skip( samples ); }
+BLARGG_EXPORT void      gme_set_seek_checkpoints( Music_Emu* gme, int interval_msec, int max_bytes ) { gme->set_seek_checkpoints( interval_msec, max_bytes ); }
 BLARGG_EXPORT int       gme_voice_count    ( Music_Emu const* gme )                   { return gme->voice_count(); }
 BLARGG_EXPORT void      gme_ignore_silence ( Music_Emu* gme, gme_bool disable )       { gme->ignore_silence( disable != 0 ); }
+BLARGG_EXPORT gme_err_t gme_set_background_lookahead( Music_Emu* gme, gme_bool enable ) { return gme->set_background_lookahead( enable != 0 ); }
 BLARGG_EXPORT void      gme_set_tempo      ( Music_Emu* gme, double t )               { gme->set_tempo( t ); }
 BLARGG_EXPORT void      gme_mute_voice     ( Music_Emu* gme, int index, gme_bool mute ){ gme->mute_voice( index, mute != 0 ); }
 BLARGG_EXPORT void      gme_mute_voices    ( Music_Emu* gme, int mask )               { gme->mute_voices( mask ); }
 BLARGG_EXPORT void      gme_set_equalizer  ( Music_Emu* gme, gme_equalizer_t const* eq ) { gme->set_equalizer( *eq ); }
 BLARGG_EXPORT void      gme_equalizer      ( Music_Emu const* gme, gme_equalizer_t* o )  { *o = gme->equalizer(); }
 BLARGG_EXPORT const char* gme_voice_name   ( Music_Emu const* gme, int i )            { return gme->voice_name( i ); }
+BLARGG_EXPORT int       gme_output_count   ( Music_Emu const* gme )                   { return gme->output_count(); }
+BLARGG_EXPORT const char* gme_output_name  ( Music_Emu const* gme, int i )            { return gme->output_name( i ); }
+BLARGG_EXPORT gme_err_t gme_play_outputs   ( Music_Emu* gme, int n, short mix [], short* const outs [] ) { return gme->play_outputs( n, mix, outs ); }
 BLARGG_EXPORT gme_err_t gme_save           ( Music_Emu const* gme, gme_writer_t writer, void* your_data ) { return gme->save( writer, your_data ); }
 /* this function is no longer needed, apparently, but a stub is kept to avoid ABI breakage.  --Wyatt */
 BLARGG_EXPORT void      gme_enable_accuracy( Music_Emu* gme, int enabled ){return;}
 
+BLARGG_EXPORT gme_err_t gme_set_ym2612_core( Music_Emu* gme, int core ) { return gme->set_ym2612_core( core ); }
+
+BLARGG_EXPORT gme_err_t gme_set_chip_threads( Music_Emu* gme, int count ) { return gme->set_chip_threads( count ); }
+
+BLARGG_EXPORT gme_err_t gme_enable_profile( Music_Emu* gme, gme_bool enabled ) { return gme->enable_profile( enabled != 0 ); }
+
+BLARGG_EXPORT int gme_get_profile( Music_Emu* gme, gme_chip_profile_t out [], int max ) { return gme->get_profile( out, max ); }
+
+BLARGG_EXPORT gme_err_t gme_set_sample_cache( Music_Emu* gme, long max_bytes ) { return gme->set_sample_cache( max_bytes ); }
+
+BLARGG_EXPORT gme_err_t gme_set_qsound_rate( Music_Emu* gme, int rate ) { return gme->set_qsound_rate( rate ); }
+
+BLARGG_EXPORT gme_err_t gme_enable_fast_dsp( Music_Emu* gme, gme_bool enabled ) { return gme->enable_fast_dsp( enabled != 0 ); }
+
+BLARGG_EXPORT gme_err_t gme_set_resampler_quality( Music_Emu* gme, int quality ) { return gme->set_resampler_quality( quality ); }
+
+BLARGG_EXPORT void gme_spin_stats( Music_Emu const* gme, long* hits, double* clocks_skipped ) { gme->spin_stats( hits, clocks_skipped ); }
+
 
 BLARGG_EXPORT void gme_effects( Music_Emu const* gme, gme_effects_t* out )
 {
 	static gme_effects_t const zero = { 0, 0, 0,0,0,0,0,0, 0, 0, 0,0,0,0,0,0 };
 	*out = zero;
-
+	
 	#if !GME_DISABLE_EFFECTS
 	{
 		Simple_Effects_Buffer* b = STATIC_CAST(Simple_Effects_Buffer*,gme->effects_buffer_);
@@ -404,6 +483,10 @@ BLARGG_EXPORT void gme_set_effects( Music_Emu* gme, gme_effects_t const* in )
 				b->config().surround = in->surround;
 			}
 			b->apply_config();
+			
+			// echo changes when track goes silent
+			if ( gme->current_track_ >= 0 )
+				gme->start_lookahead( gme->current_track_ );
 		}
 	}
 	#endif
@@ -36,6 +36,14 @@ gme_err_t gme_start_track( gme_t*, int index );
 must be even. */
 gme_err_t gme_play( gme_t*, int count, short out [] );
 
+/* Generates 'count' samples for each channel as floats from -1.0 to 1.0, with left
+and right channels written to separate buffers. */
+gme_err_t gme_play_float( gme_t*, int count, float left [], float right [] );
+
+/* Scales output of gme_play_float() by 'scale', which is 1.0 by default. Costs
+nothing extra, since samples are scaled during conversion anyway. */
+void gme_set_float_scale( gme_t*, double scale );
+
 /* Closes file and frees memory. OK to pass NULL. */
 void gme_delete( gme_t* );
 
@@ -64,6 +72,11 @@ gme_err_t gme_seek_scaled( gme_t*, int msec );
 /* Skips the specified number of samples. */
 gme_err_t gme_skip( gme_t*, int samples );
 
+/* Saves emulator state every interval_msec while playing, using at most max_bytes
+of memory, so that seeking backwards or to a time already played is fast. An interval
+of 0 disables (the default). Has no effect on emulators that can't save state. */
+void gme_set_seek_checkpoints( gme_t*, int interval_msec, int max_bytes );
+
 
 /******** Informational ********/
 
@@ -117,6 +130,33 @@ struct gme_info_t
 	const char *s7,*s8,*s9,*s10,*s11,*s12,*s13,*s14,*s15; /* reserved */
 };
 
+/* How gme_estimate_length() found a track's length */
+enum {
+	gme_length_tagged  = 0, /* from file's track information */
+	gme_length_looped  = 1, /* sound chip writes started repeating */
+	gme_length_ended   = 2, /* emulator ended track, or sound chip writes stopped */
+	gme_length_silence = 3, /* played track until silence (no dry run support) */
+	gme_length_limit   = 4  /* none of the above before max_length_msec */
+};
+
+typedef struct gme_length_estimate_t
+{
+	/* times in milliseconds; -1 if unknown */
+	int length;         /* time track ends or, if it loops, first reaches end of loop */
+	int loop_start;     /* start of looping section */
+	int loop_length;    /* length of looping section */
+	int method;         /* gme_length_* value */
+} gme_length_estimate_t;
+
+/* Estimates length of track without tags many times faster than playing it, by
+emulating the CPU and sound chip register writes without generating sound, and
+finding where the writes start repeating. Supported by NSF, NSFE, GBS, KSS, HES, SAP,
+AY, SGC and SPC; others play the track until silence. Tagged lengths are returned
+as-is. Times are from the start of emulation, so include any initial silence that
+gme_start_track() would skip. Stops current track. */
+gme_err_t gme_estimate_length( gme_t*, int track, int max_length_msec,
+		gme_length_estimate_t* out );
+
 
 /******** Advanced playback ********/
 
@@ -124,6 +164,11 @@ struct gme_info_t
 if ignore is true */
 void gme_ignore_silence( gme_t*, gme_bool ignore );
 
+/* Detects end of track by playing a copy of the emulator on a background thread,
+instead of running ahead within gme_play() during silence. Should be enabled before
+loading file. Returns error if threads aren't supported. */
+gme_err_t gme_set_background_lookahead( gme_t*, gme_bool enable );
+
 /* Adjusts song tempo, where 1.0 = normal, 0.5 = half speed, 2.0 = double speed, etc.
 Track length as returned by track_info() ignores tempo (assumes it's 1.0). */
 void gme_set_tempo( gme_t*, double tempo );
@@ -141,6 +186,24 @@ void gme_mute_voice( gme_t*, int index, gme_bool mute );
 voices, 0 unmutes them all, 0x01 mutes just the first voice, etc. */
 void gme_mute_voices( gme_t*, int muting_mask );
 
+/* Number of outputs gme_play_outputs() generates separately, or 0 if it isn't
+supported. These are the voices, except for VGM files using FM or PCM chips, which
+mix their voices internally. Those have one output per kind of PSG chip used, then
+one per group of FM and PCM chips running at the same rate, named by its first
+chip. */
+int gme_output_count( const gme_t* );
+
+/* Name of output i, from 0 to gme_output_count() - 1 */
+const char* gme_output_name( const gme_t*, int i );
+
+/* Generates count samples into mix as gme_play() does, and the part of them that
+came from output i into outs [i], for each output whose pointer isn't NULL. Each
+output is count stereo samples like mix, faded along with it, so an oscilloscope or
+level meter per voice doesn't need the track played again with other voices muted.
+Silence isn't looked ahead for while using this, so tracks don't end on silence.
+Effects set with gme_set_effects() aren't applied to mix. */
+gme_err_t gme_play_outputs( gme_t*, int count, short mix [], short* const outs [] );
+
 /* Frequency equalizer parameters (see gme.txt) */
 typedef struct gme_equalizer_t
 {
@@ -159,6 +222,88 @@ void gme_set_equalizer( gme_t*, gme_equalizer_t const* eq );
 /* stub to avoid ABI breakage, I think --Wyatt */
 void gme_enable_accuracy( gme_t*, int enabled );
 
+/* YM2612 FM chip emulators for VGM and GYM files, which all play at the same level.
+Nuked is most accurate but slowest, MAME is accurate and fast, and Gens is inaccurate
+but fastest. Benchmark times each one briefly the first time it's used in a process,
+then uses the most accurate one that took at most a quarter of real time per chip.
+Playing time isn't measured, so the choice is the same for every file with the same
+chip clock and sample rate, and doesn't change while playing. */
+enum {
+	gme_ym2612_nuked     = 0,
+	gme_ym2612_mame      = 1, /* default */
+	gme_ym2612_gens      = 2,
+	gme_ym2612_benchmark = 3
+};
+
+/* Selects YM2612 emulator. Can be changed while playing, which restarts any notes
+currently sounding. Has no effect on other music types. */
+gme_err_t gme_set_ym2612_core( gme_t*, int core );
+
+/* Renders the sound chips of VGM files using several FM or PCM chips on count
+threads, including the calling one, or one per processor if 0. Output is identical
+to rendering on one thread, which is the default and the best choice on single-core
+machines. Returns error if threads aren't supported. Has no effect on other music
+types. */
+gme_err_t gme_set_chip_threads( gme_t*, int count );
+
+/* Time spent emulating a sound chip of a VGM file, and the work it did */
+typedef struct gme_chip_profile_t
+{
+	const char* name;   /* chip, such as "YM2612" */
+	int index;          /* 0, or 1 for second chip of same type */
+	double nanoseconds; /* spent running chip */
+	long samples;       /* generated by chip, at its own rate */
+	long writes;        /* to chip's registers */
+	long cache_bytes;   /* of decoded samples, if chip has sample cache */
+	long cache_hits;    /* samples played that were already decoded */
+	long cache_misses;  /* samples played that weren't */
+} gme_chip_profile_t;
+
+/* Starts collecting time and work of each sound chip of VGM files, or stops if
+enabled is 0. Either way clears profile collected so far, as does loading a file.
+Costs nothing while disabled. Returns error if library was built with
+GME_DISABLE_PROFILE. Has no effect on other music types. */
+gme_err_t gme_enable_profile( gme_t*, gme_bool enabled );
+
+/* Copies profile of up to max chips to out, and returns number of chips profiled,
+which can be more than max. Returns 0 if profiling isn't enabled. */
+int gme_get_profile( gme_t*, gme_chip_profile_t out [], int max );
+
+/* Has OKIM6295 and YMZ280B chips of VGM files decode an ADPCM sample the first
+time it's played and keep it for when it's played again, using up to max_bytes
+per chip, or decode samples every time they're played if 0, the default. Output
+is the same either way. Cache size and hit rate are reported by gme_get_profile().
+Has no effect on other music types. */
+gme_err_t gme_set_sample_cache( gme_t*, long max_bytes );
+
+/* Mixes QSound chips of VGM files at rate Hz rather than the output rate, which
+takes less time but loses treble, for slow machines. 24000 is close to the chip's
+own rate. 0 restores the default of mixing at output rate, as does a rate higher
+than it. Takes effect immediately. Has no effect on other music types. */
+gme_err_t gme_set_qsound_rate( gme_t*, int rate );
+
+/* Runs the SNES sound DSP of SPC files a voice at a time for whole samples rather
+than a clock at a time for all voices, or a clock at a time if enabled is 0, the
+default. Fast DSP takes less time, especially when voices are silent or echo is
+off, and output is the same either way. Can be changed while playing. Has no
+effect on other music types. */
+gme_err_t gme_enable_fast_dsp( gme_t*, gme_bool enabled );
+
+/* Sets quality of the resampling of VGM and GYM sound chips to the output rate:
+0 for the default, or 1 to 3 for filters of 8, 16 or 32 points. Higher quality
+passes less aliasing and takes longer. 2 is the same as the default. Ratios that
+are a fraction with a denominator up to 512, such as 44100 to 48000 Hz, are
+resampled exactly at any quality. Takes effect immediately. Has no effect on
+other music types. */
+gme_err_t gme_set_resampler_quality( gme_t*, int quality );
+
+/* Number of times the CPU of NSF, KSS, GBS, HES, AY, SGC, or SAP music was found
+in a busy-wait loop that nothing could end before its next interrupt or the end of
+the frame, and skipped straight there, and number of CPU clocks skipped, since the
+track started. Output is the same as running every pass of the loop. Both are zero
+for other music types. */
+void gme_spin_stats( gme_t const*, long* hits, double* clocks_skipped );
+
 /******** Effects processor ********/
 
 /* Adds stereo surround and echo to music that's usually mono or has little
@@ -212,6 +357,10 @@ gme_bool gme_type_multitrack( gme_type_t );
 /* Same as gme_open_file(), but uses file data already in memory. Makes copy of data. */
 gme_err_t gme_open_data( void const* data, long size, gme_t** emu_out, int sample_rate );
 
+/* Same as gme_open_data(), but uses data in place rather than copying it, so data
+MUST NOT be changed or freed until emulator is deleted or loads another file. */
+gme_err_t gme_open_data_borrowed( void const* data, long size, gme_t** emu_out, int sample_rate );
+
 /* Determines likely game music type based on first four bytes of file. Returns
 string containing proper file suffix ("NSF", "SPC", etc.) or "" if file header
 is not recognized. */
@@ -231,9 +380,16 @@ gme_t* gme_new_emu( gme_type_t, int sample_rate );
 /* Loads music file into emulator */
 gme_err_t gme_load_file( gme_t*, const char path [] );
 
-/* Loads music file from memory into emulator. Makes a copy of data passed. */
+/* Loads music file from memory into emulator. Makes a copy of data passed.
+Gzipped VGM data is inflated as playback reaches it, rather than all at once. */
 gme_err_t gme_load_data( gme_t*, void const* data, long size );
 
+/* Same as gme_load_data(), but uses data in place rather than copying it, so data
+MUST NOT be changed or freed until emulator is deleted or loads another file.
+Saves memory and time with large files. Gzipped data is inflated into a
+separate buffer, but is also read in place. */
+gme_err_t gme_load_data_borrowed( gme_t*, void const* data, long size );
+
 /* Loads music file using custom data reader function that will be called to
 read file data. Most emulators load the entire file in one read call. */
 typedef gme_err_t (*gme_reader_t)( void* your_data, void* out, long count );
@@ -242,6 +398,46 @@ gme_err_t gme_load_custom( gme_t*, gme_reader_t, long file_size, void* your_data
 /* Loads m3u playlist file from memory (must be done after loading music) */
 gme_err_t gme_load_m3u_data( gme_t*, void const* data, long size );
 
+
+
+/******** Batch analysis ********/
+
+/* File in memory for gme_analyze_batch() */
+typedef struct gme_batch_file_t
+{
+	void const* data;
+	long size;
+} gme_batch_file_t;
+
+/* Measurements of one track by gme_analyze_batch() */
+typedef struct gme_track_analysis_t
+{
+	int file;           /* index into files passed to gme_analyze_batch() */
+	int track;          /* 0 is first track; -1 if file couldn't be loaded */
+	gme_err_t error;    /* NULL if file loaded and track played without error */
+	
+	/* times in milliseconds; -1 if unknown */
+	int length;         /* time track played before ending, not counting final silence */
+	int loop_start;     /* start of looping section, from file's track information, */
+	int loop_length;    /* or else found as gme_estimate_length() does, if supported */
+	
+	gme_bool ended_on_silence;  /* ended by silence detection, not by emulator */
+	gme_bool reached_limit;     /* hadn't ended by max_length_msec; length is limit */
+} gme_track_analysis_t;
+
+/* Plays every track of every file until it ends or reaches max_length_msec, using
+thread_count threads (0 for one per processor), and sets *out to an array of *count
+results, ordered by file then track. Free results with gme_free_analysis(). Files must
+remain valid until this returns. Problems with individual files and tracks are
+reported in their results; the returned error is only for running out of memory.
+Without thread support, plays everything on the calling thread. */
+gme_err_t gme_analyze_batch( gme_batch_file_t const files [], int file_count,
+		int sample_rate, int max_length_msec, int thread_count,
+		gme_track_analysis_t** out, int* count );
+
+/* Frees results from gme_analyze_batch() */
+void gme_free_analysis( gme_track_analysis_t* );
+
         
 /******** Saving ********/
 typedef gme_err_t (*gme_writer_t)( void* your_data, void const* in, long count );
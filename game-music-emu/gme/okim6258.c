@@ -18,6 +18,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include "okim6258.h"
+#include "chip_tables.h"
 
 #define COMMAND_STOP		(1 << 0)
 #define COMMAND_PLAY		(1 << 1)
@@ -97,9 +98,13 @@ static void compute_tables(void)
 
 	int step, nib;
 
+	chip_tables_lock();
 	if (tables_computed)
+	{
+		chip_tables_unlock();
 		return;
-	
+	}
+
 	/* loop over all possible steps */
 	for (step = 0; step <= 48; step++)
 	{
@@ -118,6 +123,7 @@ static void compute_tables(void)
 	}
 
 	tables_computed = 1;
+	chip_tables_unlock();
 }
 
 
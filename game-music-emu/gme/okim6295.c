@@ -30,6 +30,8 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include "okim6295.h"
+#include "adpcm_cache.h"
+#include "chip_tables.h"
 
 #define FALSE	0
 #define TRUE	1
@@ -50,6 +52,8 @@ struct ADPCMVoice
 	struct adpcm_state adpcm;/* current ADPCM state */
 	UINT32 volume;			/* output volume */
 	UINT8 Muted;
+	
+	const INT16* cached;	/* decoded samples, or NULL to decode as played */
 };
 
 typedef struct _okim6295_state okim6295_state;
@@ -67,6 +71,7 @@ struct _okim6295_state
 	
 	UINT32				ROMSize;
 	UINT8*				ROM;
+	adpcm_cache*		cache;
 };
 
 /* step size index shift table */
@@ -140,6 +145,13 @@ static void compute_tables(void)
 
 	int step, nib;
 
+	chip_tables_lock();
+	if (tables_computed)
+	{
+		chip_tables_unlock();
+		return;
+	}
+
 	/* loop over all possible steps */
 	for (step = 0; step <= 48; step++)
 	{
@@ -158,6 +170,7 @@ static void compute_tables(void)
 	}
 
 	tables_computed = 1;
+	chip_tables_unlock();
 }
 
 
@@ -170,10 +183,6 @@ static void compute_tables(void)
 
 void reset_adpcm(struct adpcm_state *state)
 {
-	/* make sure we have our tables */
-	if (!tables_computed)
-		compute_tables();
-
 	/* reset the signal/step */
 	state->signal = -2;
 	state->step = 0;
@@ -227,10 +236,81 @@ static UINT8 memory_raw_read_byte(okim6295_state *info, offs_t offset)
 		return 0x00;
 }
 
+static UINT8 read_nibble(okim6295_state *chip, struct ADPCMVoice *voice, int sample)
+{
+	return memory_raw_read_byte(chip, voice->base_offset + sample / 2) >> (((sample & 1) << 2) ^ 4);
+}
+
+/* plays voice from decoded samples if it's cached, otherwise decodes and caches it */
+static void cache_voice(okim6295_state *chip, struct ADPCMVoice *voice)
+{
+	UINT32 start = (chip->bank_offs | voice->base_offset) * 2;
+	const INT16* data;
+
+	data = adpcm_cache_find(chip->cache, start, voice->count);
+	if (data == NULL)
+	{
+		INT16* out = adpcm_cache_add(chip->cache, start, voice->count);
+		struct adpcm_state state;
+		UINT32 i;
+
+		if (out == NULL)
+			return;
+		reset_adpcm(&state);
+		for (i = 0; i < voice->count; i++)
+			out[i] = clock_adpcm(&state, read_nibble(chip, voice, i));
+		data = out;
+	}
+	voice->cached = data;
+}
+
+/* stops using cached samples, first decoding up to the current sample if voice
+   is to continue playing without them */
+static void uncache_voice(okim6295_state *chip, struct ADPCMVoice *voice)
+{
+	if (voice->cached == NULL)
+		return;
+
+	if (voice->playing)
+	{
+		UINT32 i;
+
+		reset_adpcm(&voice->adpcm);
+		for (i = 0; i < voice->sample; i++)
+			clock_adpcm(&voice->adpcm, read_nibble(chip, voice, i));
+	}
+	adpcm_cache_release(chip->cache, voice->cached);
+	voice->cached = NULL;
+}
+
 static void generate_adpcm(okim6295_state *chip, struct ADPCMVoice *voice, INT16 *buffer, int samples)
 {
+	/* if this voice is playing decoded samples */
+	if (voice->playing && voice->cached)
+	{
+		const INT16* in = voice->cached;
+		int sample = voice->sample;
+		int count = voice->count;
+
+		while (samples)
+		{
+			*buffer++ = in[sample] * voice->volume / 2;
+			samples--;
+
+			if (++sample >= count)
+			{
+				voice->playing = 0;
+				break;
+			}
+		}
+
+		voice->sample = sample;
+		if (! voice->playing)
+			uncache_voice(chip, voice);
+	}
+
 	/* if this voice is active */
-	if (voice->playing)
+	else if (voice->playing)
 	{
 		offs_t base = voice->base_offset;
 		int sample = voice->sample;
@@ -420,6 +500,8 @@ void device_stop_okim6295(void *_chip)
 {
 	okim6295_state* chip = (okim6295_state *) _chip;
 	
+	if (chip->cache != NULL)
+		adpcm_cache_free(chip->cache);
 	free(chip->ROM);	chip->ROM = NULL;
 	chip->ROMSize = 0x00;
 	
@@ -440,10 +522,11 @@ void device_reset_okim6295(void *chip)
 
 	for (voice = 0; voice < OKIM6295_VOICES; voice++)
 	{
+		info->voice[voice].playing = 0;
+		uncache_voice(info, &info->voice[voice]);
+		
 		info->voice[voice].volume = 0;
 		reset_adpcm(&info->voice[voice].adpcm);
-		
-		info->voice[voice].playing = 0;
 	}
 }
 
@@ -472,6 +555,12 @@ void okim6295_set_bank_base(okim6295_state *info, int base)
 	/* if we have a bank number, set the base pointer */
 	if (info->bank_installed)
 	{
+		int voice;
+		
+		/* cached samples are from old bank */
+		for (voice = 0; voice < OKIM6295_VOICES; voice++)
+			uncache_voice(info, &info->voice[voice]);
+		
 		info->bank_offs = base;
 		//memory_set_bankptr(device->machine, device->tag(), device->region->base.u8 + base);
 	}
@@ -593,6 +682,10 @@ void okim6295_write_command(okim6295_state *info, UINT8 data)
 						/* also reset the ADPCM parameters */
 						reset_adpcm(&voice->adpcm);
 						voice->volume = volume_table[data & 0x0f];
+						
+						uncache_voice(info, voice);
+						if (info->cache != NULL)
+							cache_voice(info, voice);
 					}
 					else
 					{
@@ -607,6 +700,7 @@ void okim6295_write_command(okim6295_state *info, UINT8 data)
 					//logerror("OKIM6295:'%s' requested to play invalid sample %02x\n",device->tag(),info->command);
 					/*logerror("OKIM6295: Voice %u  requested to play invalid sample %02x\n",i,info->command);*/
 					voice->playing = 0;
+					uncache_voice(info, voice);
 				}
 			}
 		}
@@ -637,6 +731,7 @@ void okim6295_write_command(okim6295_state *info, UINT8 data)
 				struct ADPCMVoice *voice = &info->voice[i];
 
 				voice->playing = 0;
+				uncache_voice(info, voice);
 			}
 		}
 	}
@@ -683,6 +778,12 @@ void okim6295_write_rom(void *_chip, offs_t ROMSize, offs_t DataStart, offs_t Da
 						const UINT8* ROMData)
 {
 	okim6295_state *chip = (okim6295_state *) _chip;
+	int voice;
+	
+	for (voice = 0; voice < OKIM6295_VOICES; voice++)
+		uncache_voice(chip, &chip->voice[voice]);
+	if (chip->cache != NULL)
+		adpcm_cache_clear(chip->cache);
 	
 	if (chip->ROMSize != ROMSize)
 	{
@@ -698,6 +799,39 @@ void okim6295_write_rom(void *_chip, offs_t ROMSize, offs_t DataStart, offs_t Da
 	memcpy(chip->ROM + DataStart, ROMData, DataLength);
 }
 
+void okim6295_set_cache(void *_chip, UINT32 Budget)
+{
+	okim6295_state *chip = (okim6295_state *) _chip;
+	int voice;
+	
+	if (! Budget)
+	{
+		for (voice = 0; voice < OKIM6295_VOICES; voice++)
+			uncache_voice(chip, &chip->voice[voice]);
+		if (chip->cache != NULL)
+			adpcm_cache_free(chip->cache);
+		chip->cache = NULL;
+	}
+	else if (chip->cache != NULL)
+	{
+		adpcm_cache_set_budget(chip->cache, Budget);
+	}
+	else
+	{
+		chip->cache = adpcm_cache_create(Budget);
+	}
+}
+
+void okim6295_get_cache_stats(void *_chip, UINT32* Bytes, UINT32* Hits, UINT32* Misses)
+{
+	okim6295_state *chip = (okim6295_state *) _chip;
+	
+	if (chip->cache != NULL)
+		adpcm_cache_stats(chip->cache, Bytes, Hits, Misses);
+	else
+		*Bytes = *Hits = *Misses = 0;
+}
+
 
 void okim6295_set_mute_mask(void *_chip, UINT32 MuteMask)
 {
@@ -39,6 +39,11 @@ void okim6295_write_rom(void *, offs_t ROMSize, offs_t DataStart, offs_t DataLen
 						const UINT8* ROMData);
 void okim6295_set_mute_mask(void *, UINT32 MuteMask);
 
+/* Plays samples from a cache of up to Budget bytes of decoded ADPCM, or
+   decodes them as played if 0 */
+void okim6295_set_cache(void *, UINT32 Budget);
+void okim6295_get_cache_stats(void *, UINT32* Bytes, UINT32* Hits, UINT32* Misses);
+
 
 /*
     To help the various custom ADPCM generators out there,
@@ -15,6 +15,22 @@
 
 #define RENDERMAX (200)
 
+/////////////////////////////////////////////////////////////////////////////
+//
+// Vector versions of the mixing loops, for SSE2 and NEON. Define QMIX_NO_SIMD
+// to use only the plain C versions, which are also the reference the vector
+// ones must match. The WebAssembly build uses the plain C versions.
+//
+#if !QMIX_NO_SIMD
+  #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define QMIX_SSE2 1
+  #elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+    #include <arm_neon.h>
+    #define QMIX_NEON 1
+  #endif
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 
 static const sint32 gauss_shuffled_reverse_table[1024] = {
@@ -83,6 +99,7 @@ struct QMIX_CHAN {
   uint32 curend;
   uint32 phase;
   uint32 pitch;
+  uint32 pitch_data;
   uint32 vol;
   uint32 pan;
   sint32 current_mix_l;
@@ -327,6 +344,7 @@ void EMU_CALL _qmix_command(void *state, uint8 cmd, uint16 data) {
     break;
   case 2: // pitch
     //printf("qmix: pitch ch%X = %04X\n",ch,data);
+    chan->pitch_data = data;
     chan->pitch = (((uint32)(data & 0xFFFF)) * QMIXSTATE->pitchscaler) / 0x10000;
     if (chan->pitch == 0) {
       chan->on = 0;
@@ -392,10 +410,177 @@ void EMU_CALL _qmix_command(void *state, uint8 cmd, uint16 data) {
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//
+// Mixing kernels
+//
+// Adds (in[s] * vol_l) / 0x8000 to buf_l[s], and likewise for the right
+// channel. Resampled voice output fits in 16 bits and volumes are at most
+// 0x7FFF, so the products can't overflow.
+//
+static void mix_voice_c(
+  sint32 *buf_l, sint32 *buf_r, const sint32 *in, uint32 samples,
+  sint32 vol_l, sint32 vol_r
+) {
+  uint32 s;
+  for(s = 0; s < samples; s++) {
+    buf_l[s] += (in[s] * vol_l) / 0x8000;
+    buf_r[s] += (in[s] * vol_r) / 0x8000;
+  }
+}
+
+//
+// Writes l[s] * 8 and r[s] * 8 as clamped stereo pairs
+//
+static void write_output_c(
+  sint16 *buf, const sint32 *l, const sint32 *r, uint32 samples
+) {
+  uint32 s;
+  for(s = 0; s < samples; s++) {
+    sint32 outl = l[s] * 8;
+    sint32 outr = r[s] * 8;
+    if(outl > ( 32767)) outl = ( 32767);
+    if(outl < (-32768)) outl = (-32768);
+    if(outr > ( 32767)) outr = ( 32767);
+    if(outr < (-32768)) outr = (-32768);
+    *buf++ = outl;
+    *buf++ = outr;
+  }
+}
+
+#if QMIX_SSE2
+
+// Low 32 bits of products, since SSE2 has only 32x32->64 multiply
+static EMU_INLINE __m128i mul_lo32(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Divides by 0x8000, rounding toward zero like C division
+static EMU_INLINE __m128i div_8000(__m128i p) {
+  __m128i bias = _mm_and_si128(_mm_srai_epi32(p, 31), _mm_set1_epi32(0x7FFF));
+  return _mm_srai_epi32(_mm_add_epi32(p, bias), 15);
+}
+
+static void mix_voice(
+  sint32 *buf_l, sint32 *buf_r, const sint32 *in, uint32 samples,
+  sint32 vol_l, sint32 vol_r
+) {
+  __m128i const vl = _mm_set1_epi32(vol_l);
+  __m128i const vr = _mm_set1_epi32(vol_r);
+  uint32 s;
+  for(s = 0; s + 4 <= samples; s += 4) {
+    __m128i x = _mm_loadu_si128((__m128i const*) &in[s]);
+    __m128i *pl = (__m128i*) &buf_l[s];
+    __m128i *pr = (__m128i*) &buf_r[s];
+    _mm_storeu_si128(pl, _mm_add_epi32(_mm_loadu_si128(pl), div_8000(mul_lo32(x, vl))));
+    _mm_storeu_si128(pr, _mm_add_epi32(_mm_loadu_si128(pr), div_8000(mul_lo32(x, vr))));
+  }
+  mix_voice_c(buf_l + s, buf_r + s, in + s, samples - s, vol_l, vol_r);
+}
+
+static void write_output(
+  sint16 *buf, const sint32 *l, const sint32 *r, uint32 samples
+) {
+  uint32 s;
+  for(s = 0; s + 4 <= samples; s += 4) {
+    __m128i vl = _mm_slli_epi32(_mm_loadu_si128((__m128i const*) &l[s]), 3);
+    __m128i vr = _mm_slli_epi32(_mm_loadu_si128((__m128i const*) &r[s]), 3);
+    _mm_storeu_si128((__m128i*) &buf[s * 2], _mm_packs_epi32(
+      _mm_unpacklo_epi32(vl, vr), _mm_unpackhi_epi32(vl, vr)));
+  }
+  write_output_c(buf + s * 2, l + s, r + s, samples - s);
+}
+
+#elif QMIX_NEON
+
+static EMU_INLINE int32x4_t div_8000(int32x4_t p) {
+  int32x4_t bias = vandq_s32(vshrq_n_s32(p, 31), vdupq_n_s32(0x7FFF));
+  return vshrq_n_s32(vaddq_s32(p, bias), 15);
+}
+
+static void mix_voice(
+  sint32 *buf_l, sint32 *buf_r, const sint32 *in, uint32 samples,
+  sint32 vol_l, sint32 vol_r
+) {
+  uint32 s;
+  for(s = 0; s + 4 <= samples; s += 4) {
+    int32x4_t x = vld1q_s32(&in[s]);
+    vst1q_s32(&buf_l[s], vaddq_s32(vld1q_s32(&buf_l[s]), div_8000(vmulq_n_s32(x, vol_l))));
+    vst1q_s32(&buf_r[s], vaddq_s32(vld1q_s32(&buf_r[s]), div_8000(vmulq_n_s32(x, vol_r))));
+  }
+  mix_voice_c(buf_l + s, buf_r + s, in + s, samples - s, vol_l, vol_r);
+}
+
+static void write_output(
+  sint16 *buf, const sint32 *l, const sint32 *r, uint32 samples
+) {
+  uint32 s;
+  for(s = 0; s + 4 <= samples; s += 4) {
+    int16x4x2_t pair;
+    pair.val[0] = vqmovn_s32(vshlq_n_s32(vld1q_s32(&l[s]), 3));
+    pair.val[1] = vqmovn_s32(vshlq_n_s32(vld1q_s32(&r[s]), 3));
+    vst2_s16(&buf[s * 2], pair);
+  }
+  write_output_c(buf + s * 2, l + s, r + s, samples - s);
+}
+
+#else
+
+#define mix_voice    mix_voice_c
+#define write_output write_output_c
+
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 //
 // Rendering
 //
+// Voices don't key on or off during a render, so each voice's samples are
+// resampled in one pass and mixed in another. Anticlick ramps still run one
+// sample at a time, and a voice that is off is skipped once its ramp ends.
+//
+static void render_voice(
+  struct QMIX_STATE *state,
+  struct QMIX_CHAN *chan,
+  sint32 *buf_l,
+  sint32 *buf_r,
+  uint32 samples
+) {
+  sint32 out[RENDERMAX];
+  sint32 l, r;
+  uint32 s;
+
+  if(chan->on) {
+    for(s = 0; s < samples; s++) {
+      out[s] = chan_get_resampled(state, chan);
+    }
+  } else {
+    chan->sample_last_l = 0;
+    chan->sample_last_r = 0;
+  }
+
+  for(s = 0; s < samples; s++) {
+    if(!chan->sample_anticlick_remaining_l && !chan->sample_anticlick_remaining_r) break;
+    if(chan->on) {
+      chan->sample_last_l = (out[s] * chan->current_mix_l) / 0x8000;
+      chan->sample_last_r = (out[s] * chan->current_mix_r) / 0x8000;
+    }
+    get_anticlicked_samples(chan, &l, &r);
+    buf_l[s] += l;
+    buf_r[s] += r;
+  }
+
+  if(chan->on && s < samples) {
+    mix_voice(buf_l + s, buf_r + s, out + s, samples - s,
+      chan->current_mix_l, chan->current_mix_r);
+    chan->sample_last_l = (out[samples - 1] * chan->current_mix_l) / 0x8000;
+    chan->sample_last_r = (out[samples - 1] * chan->current_mix_r) / 0x8000;
+  }
+}
+
 static void render(
   struct QMIX_STATE *state,
   sint16 *buf,
@@ -409,14 +594,11 @@ static void render(
   memset(buf_l, 0, 4 * samples);
   memset(buf_r, 0, 4 * samples);
   for(ch = 0; ch < 16; ch++) {
-    struct QMIX_CHAN *chan = state->chan + ch;
-    for(s = 0; s < samples; s++) {
-      chan_get_stereo_anticlicked(state, chan, &l, &r);
-      buf_l[s] += l;
-      buf_r[s] += r;
-    }
+    render_voice(state, state->chan + ch, buf_l, buf_r, samples);
   }
   if(!buf) return;
+  // the high-pass filter is a recurrence, so it runs in place before the
+  // results are scaled and clamped
   for(s = 0; s < samples; s++) {
     sint32 diff_l = buf_l[s] - state->last_in_l;
     sint32 diff_r = buf_r[s] - state->last_in_r;
@@ -426,17 +608,10 @@ static void render(
     r = ((state->last_out_r * 255) / 256) + diff_r;
     state->last_out_l = l;
     state->last_out_r = r;
-//    l /= 2;
-//    r /= 2;
-    l *= 8;
-    r *= 8;
-    if(l > ( 32767)) l = ( 32767);
-    if(l < (-32768)) l = (-32768);
-    if(r > ( 32767)) r = ( 32767);
-    if(r < (-32768)) r = (-32768);
-    *buf++ = l;
-    *buf++ = r;
+    buf_l[s] = l;
+    buf_r[s] = r;
   }
+  write_output(buf, buf_l, buf_r, samples);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -455,8 +630,14 @@ void EMU_CALL _qmix_render(void *state, sint16 *buf, uint32 samples) {
 /////////////////////////////////////////////////////////////////////////////
 
 void EMU_CALL _qmix_set_sample_rate(void *state, uint32 rate) {
+  int ch;
   if(rate < 1) rate = 1;
   QMIXSTATE->pitchscaler = (65536 * 24000) / rate;
+  // rescale pitches of voices already playing
+  for(ch = 0; ch < 16; ch++) {
+    struct QMIX_CHAN *chan = QMIXSTATE->chan + ch;
+    chan->pitch = (((uint32)(chan->pitch_data & 0xFFFF)) * QMIXSTATE->pitchscaler) / 0x10000;
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 
 #include "scd_pcm.h"
+#include "chip_tables.h"
 int  PCM_Init(void *chip, int Rate);
 void PCM_Set_Rate(void *chip, int Rate);
 void PCM_Reset(void *chip);
@@ -38,6 +39,7 @@ int PCM_Init(void *_chip, int Rate)
 	struct pcm_chip_ *chip = (struct pcm_chip_ *) _chip;
 	int i, j, out;
 	
+	chip_tables_lock();
 	if (! VolTabIsInit)
 	{
 		for (i = 0; i < 0x100; i++)
@@ -59,6 +61,7 @@ int PCM_Init(void *_chip, int Rate)
 		}
 		VolTabIsInit = 0x01;
 	}
+	chip_tables_unlock();
 	
 	for (i = 0; i < 8; i ++)
 		chip->Channel[i].Muted = 0x00;
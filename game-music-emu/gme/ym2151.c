@@ -10,6 +10,7 @@
 #include <string.h>
 #include "mamedef.h"
 #include "ym2151.h"
+#include "chip_tables.h"
 
 #ifndef logerror
 #define logerror (void)
@@ -463,7 +464,7 @@ static FILE *sample[9];
 
 
 
-static void init_tables(void)
+static void build_tables(void)
 {
 	signed int i,x,n;
 	double o,m;
@@ -551,6 +552,20 @@ static void init_tables(void)
 #endif
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static void init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+	{
+		build_tables();
+		tables_built = 1;
+	}
+	chip_tables_unlock();
+}
+
 
 static void init_chip_tables(YM2151 *chip)
 {
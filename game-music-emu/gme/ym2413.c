@@ -43,6 +43,7 @@ to do:
 #include <string.h>
 #include "mamedef.h"
 #include "ym2413.h"
+#include "chip_tables.h"
 
 #ifndef INLINE
 #define INLINE static __inline
@@ -1126,7 +1127,7 @@ INLINE void rhythm_calc( YM2413 *chip, OPLL_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static int build_tables(void)
 {
 	signed int i,x;
 	signed int n;
@@ -1216,6 +1217,18 @@ static int init_tables(void)
 	return 1;
 }
 
+static int tables_built = 0;
+
+/* builds tables only once, even when chips are created from several threads */
+static int init_tables(void)
+{
+	chip_tables_lock();
+	if (!tables_built)
+		tables_built = build_tables();
+	chip_tables_unlock();
+	return tables_built;
+}
+
 static void OPLL_initalize(YM2413 *chip)
 {
 	int i;
@@ -1806,6 +1819,10 @@ static void OPLLResetChip(YM2413 *chip)
 	chip->eg_cnt   = 0;
 
 	chip->noise_rng = 1;	/* noise shift register */
+	chip->noise_p   = 0;
+
+	chip->lfo_am_cnt = 0;
+	chip->lfo_pm_cnt = 0;
 
 	chip->mask = 0;
 
@@ -1848,6 +1865,11 @@ static void OPLLResetChip(YM2413 *chip)
 			CH->SLOT[s].wavetable = 0;
 			CH->SLOT[s].state     = EG_OFF;
 			CH->SLOT[s].volume    = MAX_ATT_INDEX;
+			/* phase and feedback would otherwise carry over from before the reset */
+			CH->SLOT[s].key       = 0;
+			CH->SLOT[s].phase     = 0;
+			CH->SLOT[s].op1_out[0] = 0;
+			CH->SLOT[s].op1_out[1] = 0;
 		}
 	}
 }
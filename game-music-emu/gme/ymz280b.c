@@ -32,6 +32,8 @@
 #include <memory.h>
 #include <stdlib.h>
 #include "ymz280b.h"
+#include "adpcm_cache.h"
+#include "chip_tables.h"
 
 static void update_irq_state_timer_common(void *param, int voicenum);
 
@@ -92,6 +94,10 @@ struct YMZ280BVoice
 	INT16 curr_sample;		/* current sample target */
 	UINT8 irq_schedule;		/* 1 if the IRQ state is updated by timer */
 	UINT8 Muted;			/* used for muting */
+
+	const INT16 *cached;	/* decoded samples, or NULL to decode as played */
+	UINT32 cached_start;	/* position of first decoded sample */
+	UINT32 cached_count;	/* number of decoded samples */
 };
 
 typedef struct _ymz280b_state ymz280b_state;
@@ -121,6 +127,7 @@ struct _ymz280b_state
 
 	INT16 *scratch;
 	//const device_config *device;
+	adpcm_cache *cache;
 };
 
 static void write_to_register(ymz280b_state *chip, int data);
@@ -276,8 +283,12 @@ static void compute_tables(void)
 {
 	int nib;
 
+	chip_tables_lock();
 	if (lookup_init)
+	{
+		chip_tables_unlock();
 		return;
+	}
 
 	/* loop over all nibbles and compute the difference */
 	for (nib = 0; nib < 16; nib++)
@@ -287,6 +298,7 @@ static void compute_tables(void)
 	}
 	
 	lookup_init = 0x01;
+	chip_tables_unlock();
 }
 
 
@@ -297,6 +309,25 @@ static void compute_tables(void)
 
 ***********************************************************************************************/
 
+INLINE void decode_adpcm(int *signal, int *step, int val)
+{
+	/* compute the new amplitude and update the current step */
+	*signal += (*step * diff_lookup[val & 15]) / 8;
+
+	/* clamp to the maximum */
+	if (*signal > 32767)
+		*signal = 32767;
+	else if (*signal < -32768)
+		*signal = -32768;
+
+	/* adjust the step size and clamp */
+	*step = (*step * index_scale[val & 7]) >> 8;
+	if (*step > 0x6000)
+		*step = 0x6000;
+	else if (*step < 0x7f)
+		*step = 0x7f;
+}
+
 static int generate_adpcm(struct YMZ280BVoice *voice, UINT8 *base, UINT32 size, INT16 *buffer, int samples)
 {
 	UINT32 position = voice->position;
@@ -322,20 +353,7 @@ static int generate_adpcm(struct YMZ280BVoice *voice, UINT8 *base, UINT32 size,
 			/* compute the new amplitude and update the current step */
 			//val = base[position / 2] >> ((~position & 1) << 2);
 			val = ymz280b_read_memory(base, size, position / 2) >> ((~position & 1) << 2);
-			signal += (step * diff_lookup[val & 15]) / 8;
-
-			/* clamp to the maximum */
-			if (signal > 32767)
-				signal = 32767;
-			else if (signal < -32768)
-				signal = -32768;
-
-			/* adjust the step size and clamp */
-			step = (step * index_scale[val & 7]) >> 8;
-			if (step > 0x6000)
-				step = 0x6000;
-			else if (step < 0x7f)
-				step = 0x7f;
+			decode_adpcm(&signal, &step, val);
 
 			/* output to the buffer, scaling by the volume */
 			*buffer++ = signal;
@@ -362,20 +380,7 @@ static int generate_adpcm(struct YMZ280BVoice *voice, UINT8 *base, UINT32 size,
 			/* compute the new amplitude and update the current step */
 			//val = base[position / 2] >> ((~position & 1) << 2);
 			val = ymz280b_read_memory(base, size, position / 2) >> ((~position & 1) << 2);
-			signal += (step * diff_lookup[val & 15]) / 8;
-
-			/* clamp to the maximum */
-			if (signal > 32767)
-				signal = 32767;
-			else if (signal < -32768)
-				signal = -32768;
-
-			/* adjust the step size and clamp */
-			step = (step * index_scale[val & 7]) >> 8;
-			if (step > 0x6000)
-				step = 0x6000;
-			else if (step < 0x7f)
-				step = 0x7f;
+			decode_adpcm(&signal, &step, val);
 
 			/* output to the buffer, scaling by the volume */
 			*buffer++ = signal;
@@ -417,6 +422,107 @@ static int generate_adpcm(struct YMZ280BVoice *voice, UINT8 *base, UINT32 size,
 }
 
 
+/**********************************************************************************************
+
+     generate_cached -- plays ADPCM voice from samples decoded when it was keyed on
+
+***********************************************************************************************/
+
+INLINE int read_nibble(ymz280b_state *chip, UINT32 position)
+{
+	return ymz280b_read_memory(chip->region_base, chip->region_size, position / 2) >> ((~position & 1) << 2);
+}
+
+static void cache_voice(ymz280b_state *chip, struct YMZ280BVoice *voice)
+{
+	UINT32 count = voice->stop - voice->start;
+	const INT16 *data;
+
+	data = adpcm_cache_find(chip->cache, voice->start, count);
+	if (data == NULL)
+	{
+		INT16 *out = adpcm_cache_add(chip->cache, voice->start, count);
+		int signal = 0;
+		int step = 0x7f;
+		UINT32 i;
+
+		if (out == NULL)
+			return;
+		for (i = 0; i < count; i++)
+		{
+			decode_adpcm(&signal, &step, read_nibble(chip, voice->start + i));
+			out[i] = signal;
+		}
+		data = out;
+	}
+	voice->cached = data;
+	voice->cached_start = voice->start;
+	voice->cached_count = count;
+}
+
+/* stops using cached samples, first decoding up to the current position if
+   voice is to continue playing without them */
+static void uncache_voice(ymz280b_state *chip, struct YMZ280BVoice *voice)
+{
+	if (voice->cached == NULL)
+		return;
+
+	if (voice->playing)
+	{
+		UINT32 position;
+
+		voice->signal = 0;
+		voice->step = 0x7f;
+		for (position = voice->cached_start; position != voice->position; position++)
+			decode_adpcm(&voice->signal, &voice->step, read_nibble(chip, position));
+	}
+	adpcm_cache_release(chip->cache, voice->cached);
+	voice->cached = NULL;
+}
+
+static int generate_cached(ymz280b_state *chip, struct YMZ280BVoice *voice, INT16 *buffer, int samples)
+{
+	UINT32 position = voice->position;
+
+	/* loops restart decoding with the state they had at loop start */
+	if (voice->looping)
+	{
+		uncache_voice(chip, voice);
+		return generate_adpcm(voice, chip->region_base, chip->region_size, buffer, samples);
+	}
+
+	while (samples)
+	{
+		UINT32 index = position - voice->cached_start;
+
+		/* stop address was moved past decoded samples */
+		if (index >= voice->cached_count)
+		{
+			voice->position = position;
+			uncache_voice(chip, voice);
+			return generate_adpcm(voice, chip->region_base, chip->region_size, buffer, samples);
+		}
+
+		*buffer++ = voice->cached[index];
+		samples--;
+
+		/* next! */
+		position++;
+		if (position >= voice->stop)
+		{
+			if (!samples)
+				samples |= 0x10000;
+
+			break;
+		}
+	}
+
+	voice->position = position;
+
+	return samples;
+}
+
+
 
 /**********************************************************************************************
 
@@ -674,7 +780,9 @@ void ymz280b_update(void *_chip, stream_sample_t **outputs, int samples)
 		/* generate them into our buffer */
 		switch (voice->playing << 7 | voice->mode)
 		{
-			case 0x81:	samples_left = generate_adpcm(voice, chip->region_base, chip->region_size, chip->scratch, new_samples);		break;
+			case 0x81:	samples_left = voice->cached ?
+							generate_cached(chip, voice, chip->scratch, new_samples) :
+							generate_adpcm(voice, chip->region_base, chip->region_size, chip->scratch, new_samples);		break;
 			case 0x82:	samples_left = generate_pcm8(voice, chip->region_base, chip->region_size, chip->scratch, new_samples);		break;
 			case 0x83:	samples_left = generate_pcm16(voice, chip->region_base, chip->region_size, chip->scratch, new_samples);		break;
 			default:	samples_left = 0; memset(chip->scratch, 0, new_samples * sizeof(chip->scratch[0]));							break;
@@ -703,6 +811,7 @@ void ymz280b_update(void *_chip, stream_sample_t **outputs, int samples)
 			if (base != 0)
 			{
 				voice->playing = 0;
+				uncache_voice(chip, voice);
 
 				/* set update_irq_state_timer. IRQ is signaled on next CPU execution. */
 				//timer_set(chip->device->machine, attotime_zero, chip, 0, update_irq_state_cb[v]);
@@ -879,6 +988,8 @@ void device_stop_ymz280b(void *_chip)
 {
 	//ymz280b_state *chip = get_safe_token(device);
 	ymz280b_state *chip = (ymz280b_state *) _chip;
+	if (chip->cache != NULL)
+		adpcm_cache_free(chip->cache);
 	free(chip->region_base);	chip->region_base = NULL;
 	free(chip->scratch);
 	
@@ -954,6 +1065,7 @@ void device_reset_ymz280b(void *_chip)
 		voice->last_sample = 0;
 		voice->output_pos = FRAC_ONE;
 		voice->playing = 0;
+		uncache_voice(chip, voice);
 	}
 }
 
@@ -1011,12 +1123,18 @@ static void write_to_register(ymz280b_state *chip, int data)
 				
 				if (!voice->keyon && (data & 0x80) && chip->keyon_enable)
 				{
+					voice->playing = 0;
+					uncache_voice(chip, voice);
+
 					voice->playing = 1;
 					voice->position = voice->start;
 					voice->signal = voice->loop_signal = 0;
 					voice->step = voice->loop_step = 0x7f;
 					voice->loop_count = 0;
 
+					if (chip->cache != NULL && voice->mode == 1 && !voice->looping && voice->stop > voice->start)
+						cache_voice(chip, voice);
+
 					/* if update_irq_state_timer is set, cancel it. */
 					voice->irq_schedule = 0;
 				}
@@ -1037,6 +1155,7 @@ static void write_to_register(ymz280b_state *chip, int data)
 				else if (voice->keyon && !(data & 0x80))
 				{
 					voice->playing = 0;
+					uncache_voice(chip, voice);
 
 					// if update_irq_state_timer is set, cancel it.
 					voice->irq_schedule = 0;
@@ -1273,6 +1392,12 @@ void ymz280b_write_rom(void *_chip, offs_t ROMSize, offs_t DataStart, offs_t Dat
 					   const UINT8* ROMData)
 {
 	ymz280b_state *chip = (ymz280b_state *) _chip;
+	int v;
+	
+	for (v = 0; v < 8; v++)
+		uncache_voice(chip, &chip->voice[v]);
+	if (chip->cache != NULL)
+		adpcm_cache_clear(chip->cache);
 	
 	if (chip->region_size != ROMSize)
 	{
@@ -1290,6 +1415,43 @@ void ymz280b_write_rom(void *_chip, offs_t ROMSize, offs_t DataStart, offs_t Dat
 	return;
 }
 
+void ymz280b_set_cache(void *_chip, UINT32 Budget)
+{
+	ymz280b_state *chip = (ymz280b_state *) _chip;
+	int v;
+	
+	if (! Budget)
+	{
+		for (v = 0; v < 8; v++)
+			uncache_voice(chip, &chip->voice[v]);
+		if (chip->cache != NULL)
+			adpcm_cache_free(chip->cache);
+		chip->cache = NULL;
+	}
+	else if (chip->cache != NULL)
+	{
+		adpcm_cache_set_budget(chip->cache, Budget);
+	}
+	else
+	{
+		chip->cache = adpcm_cache_create(Budget);
+	}
+	
+	return;
+}
+
+void ymz280b_get_cache_stats(void *_chip, UINT32* Bytes, UINT32* Hits, UINT32* Misses)
+{
+	ymz280b_state *chip = (ymz280b_state *) _chip;
+	
+	if (chip->cache != NULL)
+		adpcm_cache_stats(chip->cache, Bytes, Hits, Misses);
+	else
+		*Bytes = *Hits = *Misses = 0;
+	
+	return;
+}
+
 
 void ymz280b_set_mute_mask(void *_chip, UINT32 MuteMask)
 {
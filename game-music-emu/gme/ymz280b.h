@@ -42,6 +42,11 @@ void ymz280b_write_rom(void *, offs_t ROMSize, offs_t DataStart, offs_t DataLeng
 
 void ymz280b_set_mute_mask(void *, UINT32 MuteMask);
 
+/* Plays ADPCM samples from a cache of up to Budget bytes of decoded samples,
+   or decodes them as played if 0 */
+void ymz280b_set_cache(void *, UINT32 Budget);
+void ymz280b_get_cache_stats(void *, UINT32* Bytes, UINT32* Hits, UINT32* Misses);
+
 #ifdef __cplusplus
 }
 #endif
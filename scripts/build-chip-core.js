@@ -73,6 +73,7 @@ const chipModules = [
     name: 'gme',
     enabled: true,
     sourceFiles: [
+      'adpcm_cache.c',
       'Ay_Apu.cpp',
       'Ay_Core.cpp',
       'Ay_Cpu.cpp',
@@ -83,6 +84,8 @@ const chipModules = [
       'Bml_Parser.cpp',
       'c140.c',
       'C140_Emu.cpp',
+      'Chip_Profile.cpp',
+      'Chip_Resampler.cpp',
       'Classic_Emu.cpp',
       'dac_control.c',
       'Data_Reader.cpp',
@@ -101,8 +104,10 @@ const chipModules = [
       'Gbs_Cpu.cpp',
       'Gbs_Emu.cpp',
       'gme.cpp',
+      'Gme_Batch.cpp',
       'Gme_File.cpp',
       'Gme_Loader.cpp',
+      'Gzip_Stream.cpp',
       'Gym_Emu.cpp',
       'Hes_Apu.cpp',
       'Hes_Apu_Adpcm.cpp',
@@ -125,6 +130,7 @@ const chipModules = [
       'Kss_Cpu.cpp',
       'Kss_Emu.cpp',
       'Kss_Scc_Apu.cpp',
+      'Loop_Detector.cpp',
       'M3u_Playlist.cpp',
       'Multi_Buffer.cpp',
       'Music_Emu.cpp',
@@ -174,10 +180,14 @@ const chipModules = [
       'Spc_Emu.cpp',
       'Spc_Filter.cpp',
       // 'Spc_Sfm.cpp',
+      'Spin_Detector.cpp',
       'Track_Filter.cpp',
+      'Track_Lookahead.cpp',
       'Upsampler.cpp',
       'Vgm_Core.cpp',
       'Vgm_Emu.cpp',
+      'Voice_Buffer.cpp',
+      'Worker_Pool.cpp',
       'ym2151.c',
       'Ym2151_Emu.cpp',
       'Ym2203_Emu.cpp',
@@ -186,8 +196,8 @@ const chipModules = [
       'Ym2608_Emu.cpp',
       'Ym2610b_Emu.cpp',
       'Ym2612_Emu.cpp',
-      // 'Ym2612_Emu_MAME.cpp',
-      // 'Ym2612_Emu_Gens.cpp',
+      'Ym2612_GENS.cpp',
+      'Ym2612_Nuked.cpp',
       'Ym3812_Emu.cpp',
       'ymdeltat.cpp',
       'Ymf262_Emu.cpp',
@@ -197,26 +207,41 @@ const chipModules = [
     ].map(file => 'game-music-emu/gme/' + file),
     exportedFunctions: [
       '_gme_open_data',
+      '_gme_open_data_borrowed',
+      '_malloc',
+      '_free',
       '_gme_play',
+      '_gme_play_float',
+      '_gme_set_float_scale',
       '_gme_delete',
       '_gme_mute_voices',
       '_gme_track_count',
       '_gme_track_ended',
       '_gme_voice_count',
       '_gme_track_info',
+      '_gme_estimate_length',
       '_gme_start_track',
       '_gme_open_data',
       '_gme_ignore_silence',
       '_gme_set_tempo',
       '_gme_seek_scaled',
+      '_gme_set_seek_checkpoints',
       '_gme_tell_scaled',
       '_gme_set_fade',
+      '_gme_set_ym2612_core',
+      '_gme_enable_profile',
+      '_gme_get_profile',
+      '_gme_set_sample_cache',
+      '_gme_set_qsound_rate',
+      '_gme_enable_fast_dsp',
+      '_gme_set_resampler_quality',
+      '_gme_spin_stats',
       '_gme_voice_name',
+      '_gme_output_count',
+      '_gme_output_name',
+      '_gme_play_outputs',
     ],
     flags: [
-      '-DVGM_YM2612_MAME=1',     // fast and accurate, but suffers on some GYM files
-      // '-DVGM_YM2612_NUKED=1', // slow but very accurate
-      // '-DVGM_YM2612_GENS=1',  // very fast but inaccurate
       '-DHAVE_ZLIB_H',           // used by game_music_emu for vgz and lazyusf2 for psf
       '-DHAVE_STDINT_H',
     ],
@@ -441,6 +466,8 @@ const wasmMapDir = path.resolve(paths.appPublic, '..');
 const runtimeMethods = [
   'ALLOC_NORMAL',
   'FS',
+  'HEAPF32',
+  'HEAPU8',
   'UTF8ToString',
   'allocate',
   'ccall',
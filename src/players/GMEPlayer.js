@@ -67,8 +67,11 @@ export default class GMEPlayer extends Player {
     this.seekTargetMs = null;
     this.currentFileExt = null;
 
-    this.buffer = libgme.allocate(this.bufferSize * 16, 'i16', libgme.ALLOC_NORMAL);
+    // Planar float buffers: left channel followed by right channel
+    this.buffer = libgme.allocate(this.bufferSize * 2 * 4, 'float', libgme.ALLOC_NORMAL);
     this.emuPtr = libgme.allocate(1, 'i32', libgme.ALLOC_NORMAL);
+    this.dataPtr = null;
+    this.metadataPending = false;
 
     this.subBass = new SubBass(audioCtx.sampleRate);
 
@@ -89,23 +92,18 @@ export default class GMEPlayer extends Player {
       return;
     }
 
-    if (this.getPositionMs() >= this.getDurationMs() && this.fadingOut === false) {
+    if (!this.metadataPending && this.getPositionMs() >= this.getDurationMs() && this.fadingOut === false) {
       console.log('Fading out at %d ms.', this.getPositionMs());
       this.setFadeout(this.getPositionMs());
       this.fadingOut = true;
     }
 
     if (libgme._gme_track_ended(emu) !== 1) {
-      libgme._gme_play(emu, this.bufferSize * 2, this.buffer);
+      libgme._gme_play_float(emu, this.bufferSize, this.buffer, this.buffer + this.bufferSize * 4);
 
       for (channel = 0; channel < channels.length; channel++) {
-        for (i = 0; i < this.bufferSize; i++) {
-          channels[channel][i] = libgme.getValue(this.buffer +
-            // Interleaved channel format
-            i * 2 * 2 +             // frame offset   * bytes per sample * num channels +
-            channel * 2,            // channel offset * bytes per sample
-            'i16') / INT16_MAX;     // convert int16 to float
-        }
+        const start = (this.buffer >> 2) + channel * this.bufferSize;
+        channels[channel].set(libgme.HEAPF32.subarray(start, start + this.bufferSize));
       }
 
       // A hacky fade to prevent pops during timeslice seeking
@@ -133,6 +131,15 @@ export default class GMEPlayer extends Player {
           }
         }
       }
+
+      // Parse after this buffer is handed back, so first audio isn't held up by it
+      if (this.metadataPending) {
+        this.metadataPending = false;
+        const subtune = this.subtune;
+        setTimeout(() => {
+          if (emu && this.subtune === subtune) this._updateMetadata();
+        }, 0);
+      }
     } else {
       this.subtune++;
 
@@ -152,16 +159,32 @@ export default class GMEPlayer extends Player {
   playSubtune(subtune) {
     this.fadingOut = false;
     this.subtune = subtune;
-    this.metadata = this._parseMetadata(subtune);
     console.debug('GMEPlayer.playSubtune(subtune=%s)', subtune);
+    const err = libgme._gme_start_track(emu, subtune);
+
+    // Track info is read once audio starts. A VGZ's GD3 tag is at the end
+    // of the file, so reading it inflates the whole file. Until then, show
+    // what the file path gives.
+    this.metadata = { ...this.filepathMeta };
+    this.metadataPending = true;
+    this.emit('playerStateUpdate', {
+      ...this.getBasePlayerState(),
+      isStopped: false,
+    });
+    return err;
+  }
+
+  _updateMetadata() {
+    this.metadata = this._parseMetadata(this.subtune);
     this.emit('playerStateUpdate', {
       ...this.getBasePlayerState(),
       isStopped: false,
     });
-    return libgme._gme_start_track(emu, subtune);
   }
 
   loadData(data, filepath) {
+    // Sequencer only suspends before loading the next file
+    this._closeFile();
     this.subtune = 0;
     this.fadingOut = false;
     this.seekTargetMs = null;
@@ -173,16 +196,23 @@ export default class GMEPlayer extends Player {
     );
     this.params.subbass = formatNeedsBass ? 1 : 0;
 
+    // The emulator uses file data in place, so this copy must outlive it
+    const dataPtr = libgme._malloc(data.length);
+    libgme.HEAPU8.set(data, dataPtr);
     if (libgme.ccall(
-      "gme_open_data",
+      "gme_open_data_borrowed",
       "number",
-      ["array", "number", "number", "number"],
-      [data, data.length, this.emuPtr, this.audioCtx.sampleRate]
+      ["number", "number", "number", "number"],
+      [dataPtr, data.length, this.emuPtr, this.audioCtx.sampleRate]
     ) !== 0) {
+      libgme._free(dataPtr);
       this.stop();
-      throw Error('gme_open_data failed');
+      throw Error('gme_open_data_borrowed failed');
     }
+    this.dataPtr = dataPtr;
     emu = libgme.getValue(this.emuPtr, "i32");
+    // Scale to level of players that divide int16 by INT16_MAX
+    libgme._gme_set_float_scale(emu, 32768 / INT16_MAX);
     this.voiceMask = Array(libgme._gme_voice_count(emu)).fill(true);
 
     this.connect();
@@ -278,7 +308,7 @@ export default class GMEPlayer extends Player {
   }
 
   getDurationMs() {
-    if (emu) return this.metadata.play_length;
+    if (emu && !this.metadataPending) return this.metadata.play_length;
     return 0;
   }
 
@@ -383,10 +413,17 @@ export default class GMEPlayer extends Player {
     }
   }
 
-  stop() {
-    this.suspend();
+  // Deletes emulator, then the file data it was using in place
+  _closeFile() {
     if (emu) libgme._gme_delete(emu);
     emu = null;
+    if (this.dataPtr) libgme._free(this.dataPtr);
+    this.dataPtr = null;
+  }
+
+  stop() {
+    this.suspend();
+    this._closeFile();
     console.debug('GMEPlayer.stop()');
     this.emit('playerStateUpdate', { isStopped: true });
   }